@@ -568,6 +568,9 @@ ham_get_version(uint32_t *major, uint32_t *minor,
  *      Transactions and writes them to the Btree. Disabled by default. If
  *      disabled then hamsterdb buffers committed Transactions and only starts
  *      flushing when too many Transactions were committed.  
+ *     <li>@ref HAM_ENABLE_CRC32</li> Stores a CRC32C checksum in each
+ *      index page and verifies it when the page is read from disk. Pages
+ *      with an invalid checksum return @ref HAM_INTEGRITY_VIOLATED.
  *    </ul>
  *
  * @param mode File access rights for the new file. This is the @a mode
@@ -593,6 +596,8 @@ ham_get_version(uint32_t *major, uint32_t *minor,
  *    <li>@ref HAM_PARAM_LOG_DIRECTORY</li> The path of the log file
  *      and the journal files; default is the same path as the database
  *      file. Ignored for remote Environments.
+ *    <li>@ref HAM_PARAM_JOURNAL_COMPRESSION</li> Compresses the
+ *      entries of the journal. hamsterdb supports @ref HAM_COMPRESSOR_LZF.
  *    <li>@ref HAM_PARAM_NETWORK_TIMEOUT_SEC</li> Timeout (in seconds) when
  *      waiting for data from a remote server. By default, no timeout is set.
  *    </ul>
@@ -692,6 +697,8 @@ ham_env_create(ham_env_t **env, const char *filename,
  *    <li>@ref HAM_PARAM_LOG_DIRECTORY</li> The path of the log file
  *      and the journal files; default is the same path as the database
  *      file. Ignored for remote Environments.
+ *    <li>@ref HAM_PARAM_JOURNAL_COMPRESSION</li> Compresses the
+ *      entries of the journal. hamsterdb supports @ref HAM_COMPRESSOR_LZF.
  *    <li>@ref HAM_PARAM_NETWORK_TIMEOUT_SEC</li> Timeout (in seconds) when
  *      waiting for data from a remote server. By default, no timeout is set.
  *    </ul>
@@ -867,6 +874,16 @@ ham_env_get_parameters(ham_env_t *env, ham_parameter_t *param);
  *    <li>@ref HAM_PARAM_RECORD_SIZE </li> The (fixed) size of the records;
  *      or @ref HAM_RECORD_SIZE_UNLIMITED if there was no fixed record size
  *      specified (this is the default).
+ *    <li>@ref HAM_PARAM_KEY_COMPRESSION </li> Enables key compression;
+ *      @ref HAM_COMPRESSOR_PREFIX stores common key prefixes only once
+ *      per B+Tree node. Requires variable length keys of type
+ *      @ref HAM_TYPE_BINARY.
+ *      @ref HAM_COMPRESSOR_FOR bit-packs integer keys of type
+ *      @ref HAM_TYPE_UINT32 or @ref HAM_TYPE_UINT64.
+ *    <li>@ref HAM_PARAM_INLINE_RECORD_THRESHOLD </li> Records up to this
+ *      size are stored in the B+Tree leaf instead of a separate blob.
+ *    <li>@ref HAM_PARAM_RECORD_COMPRESSION </li> Enables record
+ *      compression; @ref HAM_COMPRESSOR_LZF is supported.
  *    </ul>
  *
  * @return @ref HAM_SUCCESS upon success
@@ -1256,8 +1273,9 @@ ham_txn_abort(ham_txn_t *txn, uint32_t flags);
  * This flag is non persistent. */
 #define HAM_FLUSH_WHEN_COMMITTED                    0x01000000
 
-/** Pro: Flag for @ref ham_env_open, @ref ham_env_create.
- * This flag is non persistent. */
+/** Flag for @ref ham_env_create. Stores a CRC32C checksum in each index
+ * page, which is verified when the page is read from disk.
+ * This flag is persistent; it is ignored by @ref ham_env_open. */
 #define HAM_ENABLE_CRC32                            0x02000000
 
 /**
@@ -1350,6 +1368,11 @@ ham_db_set_compare_func(ham_db_t *db, ham_compare_func_t foo);
  * bytes is returned in <b>record->partial_size</b>. The original size of
  * the record is stored in <b>record->size</b>.
  *
+ * Records of 64 kb or more are read directly from the file and are not
+ * added to the page cache. Large records can therefore be streamed in
+ * chunks by combining @ref HAM_PARTIAL and @ref HAM_RECORD_USER_ALLOC
+ * without evicting the index pages from the cache.
+ *
  * @ref HAM_PARTIAL is not allowed if record->size is <= 8 or if Transactions
  * are enabled. In such a case, @ref HAM_INV_PARAMETER is returned.
  *
@@ -1644,6 +1667,69 @@ HAM_EXPORT ham_status_t HAM_CALLCONV
 ham_db_get_key_count(ham_db_t *db, ham_txn_t *txn, uint32_t flags,
             uint64_t *keycount);
 
+/**
+ * A callback function which supplies the key/record pairs for
+ * @ref ham_db_bulk_load
+ *
+ * The function fills in @a key and @a record with the next key/record
+ * pair and returns 0. The data has to remain valid till the function is
+ * called again. If there are no more keys then the function returns
+ * @ref HAM_KEY_NOT_FOUND. Any other return value aborts the bulk load,
+ * and @ref ham_db_bulk_load returns this value.
+ *
+ * @param key The key structure which receives the next key
+ * @param record The record structure which receives the next record
+ * @param context The user-supplied context pointer of @ref ham_db_bulk_load
+ */
+typedef ham_status_t HAM_CALLCONV (*ham_bulk_load_func_t)(ham_key_t *key,
+                  ham_record_t *record, void *context);
+
+/**
+ * Loads a sorted stream of key/record pairs into an empty Database
+ *
+ * This function is much faster than inserting the keys with
+ * @ref ham_db_insert or @ref ham_cursor_insert. The Btree is built
+ * bottom-up: the leaf nodes are filled with the keys, then the internal
+ * nodes are created. The nodes are written directly to the file and are not
+ * stored in the cache.
+ *
+ * The keys are retrieved with the callback function @a func, and they
+ * have to be sorted in ascending order (according to the Database's sort
+ * order). If the Database was created with
+ * @ref HAM_ENABLE_DUPLICATE_KEYS then a key can be returned multiple times;
+ * the records are then stored as duplicates in the order they are
+ * retrieved.
+ *
+ * The Database must be empty. Record number Databases are not supported.
+ *
+ * If the function fails then the Database remains empty, but the file
+ * space which was allocated for the loaded keys is not reclaimed.
+ *
+ * @param db A valid Database handle
+ * @param func The callback function which returns the key/record pairs
+ * @param context A user-supplied pointer which is forwarded to @a func
+ * @param fill_factor The fill factor of the leaf nodes in percent (1 - 100).
+ *        If 0 then the leaf nodes are filled completely. A lower fill
+ *        factor leaves room for future inserts.
+ * @param flags Optional flags; unused, set to 0
+ *
+ * @return @ref HAM_SUCCESS upon success
+ * @return @ref HAM_INV_PARAMETER if @a db or @a func is NULL, if
+ *        @a fill_factor is > 100, if the Database is not empty, if it is
+ *        a record number Database or if the keys are not sorted
+ * @return @ref HAM_WRITE_PROTECTED if the Database is read-only
+ * @return @ref HAM_DUPLICATE_KEY if a key was returned twice, but
+ *        the Database does not support duplicate keys
+ * @return @ref HAM_INV_KEY_SIZE if the key size does not match the
+ *        Database's fixed key size
+ * @return @ref HAM_INV_RECORD_SIZE if the record size does not match the
+ *        Database's fixed record size
+ * @return @ref HAM_NOT_IMPLEMENTED if the Database is a remote Database
+ */
+HAM_EXPORT ham_status_t HAM_CALLCONV
+ham_db_bulk_load(ham_db_t *db, ham_bulk_load_func_t func, void *context,
+            uint32_t fill_factor, uint32_t flags);
+
 /**
  * Retrieve the current value for a given Database setting
  *
@@ -1670,6 +1756,9 @@ ham_db_get_key_count(ham_db_t *db, ham_txn_t *txn, uint32_t flags,
  *    <li>@ref HAM_PARAM_KEY_COMPRESSION</li> Returns the
  *        selected algorithm for key compression, or 0 if compression
  *        is disabled
+ *    <li>@ref HAM_PARAM_INLINE_RECORD_THRESHOLD</li> Returns the
+ *        size up to which records are stored in the B+Tree leaf, or 0
+ *        if the threshold is not used
  *    </ul>
  *
  * @param db A valid Database handle
@@ -1739,6 +1828,133 @@ ham_db_get_parameters(ham_db_t *db, ham_parameter_t *param);
 /** Value for @ref HAM_PARAM_POSIX_FADVISE */
 #define HAM_POSIX_FADVICE_RANDOM                 1
 
+/** Parameter name for @ref ham_env_create, @ref ham_env_open; selects
+ * the replacement policy of the page cache */
+#define HAM_PARAM_CACHE_POLICY          0x00000111
+
+/** Value for @ref HAM_PARAM_CACHE_POLICY: purges the least recently used
+ * pages (the default) */
+#define HAM_CACHE_POLICY_LRU                     0
+
+/** Value for @ref HAM_PARAM_CACHE_POLICY: a scan-resistant policy with two
+ * queues. New pages are stored in a "cold" queue, and only pages which
+ * are accessed a second time are promoted to the "hot" queue. Internal
+ * Btree nodes are always promoted. A table scan therefore does not evict
+ * the working set. */
+#define HAM_CACHE_POLICY_2Q                      1
+
+/** Parameter name for @ref ham_env_create, @ref ham_env_open; sets the
+ * number of Btree leaf pages which are read ahead when the leaves are
+ * traversed sequentially (i.e. by a Cursor or by the hola functions).
+ * The default is 0 (read-ahead is disabled). */
+#define HAM_PARAM_READAHEAD_PAGES       0x00000112
+
+/** Parameter name for @ref ham_env_create, @ref ham_env_open; enables
+ * "group commit" for Environments with @ref HAM_ENABLE_TRANSACTIONS and
+ * @ref HAM_ENABLE_FSYNC. Transactions which are committed concurrently
+ * (within this time window, in microseconds) share a single write and
+ * fsync of the journal. @ref ham_txn_commit still returns after the
+ * Transaction is durable. The default is 0 (disabled; every commit
+ * is flushed with a separate fsync). */
+#define HAM_PARAM_JOURNAL_COMMIT_WINDOW 0x00000113
+
+/** Parameter name for @ref ham_env_create, @ref ham_env_open; selects the
+ * instruction set for searching Btree nodes with numeric keys
+ * (@ref HAM_TYPE_UINT8 ... @ref HAM_TYPE_REAL64). If the CPU does not
+ * support the requested instruction set then the fastest supported one
+ * is used. The default is @ref HAM_SIMD_AUTO. */
+#define HAM_PARAM_SIMD_SEARCH           0x00000114
+
+/** Value for @ref HAM_PARAM_SIMD_SEARCH: use the fastest instruction set
+ * which is supported by the CPU (default) */
+#define HAM_SIMD_AUTO                            0
+
+/** Value for @ref HAM_PARAM_SIMD_SEARCH: binary search without SIMD */
+#define HAM_SIMD_NONE                            1
+
+/** Value for @ref HAM_PARAM_SIMD_SEARCH: use SSE2 */
+#define HAM_SIMD_SSE2                            2
+
+/** Value for @ref HAM_PARAM_SIMD_SEARCH: use AVX2 */
+#define HAM_SIMD_AVX2                            3
+
+/** Parameter name for @ref ham_env_create, @ref ham_env_open; when searching
+ * Btree nodes with numeric keys, a binary search is performed till less
+ * than this number of keys are left; the remaining keys are then compared
+ * with SIMD instructions. The default is 0 (256 bytes worth of keys,
+ * i.e. 32 keys of type @ref HAM_TYPE_UINT64). */
+#define HAM_PARAM_LINEAR_SEARCH_THRESHOLD 0x00000115
+
+/** Parameter name for @ref ham_env_create, @ref ham_env_open; selects
+ * the I/O backend of a file-based Environment. If the operating system
+ * does not support the requested backend then the default backend is
+ * used. The default is @ref HAM_IO_BACKEND_POSIX. */
+#define HAM_PARAM_IO_BACKEND            0x00000116
+
+/** Value for @ref HAM_PARAM_IO_BACKEND: synchronous pread/pwrite, one
+ * page at a time (the default) */
+#define HAM_IO_BACKEND_POSIX                     0
+
+/** Value for @ref HAM_PARAM_IO_BACKEND: Linux io_uring. Dirty pages are
+ * flushed in batches; adjacent pages are written with a single vectored
+ * write */
+#define HAM_IO_BACKEND_URING                     1
+
+/** Value for @ref HAM_PARAM_IO_BACKEND: like @ref HAM_IO_BACKEND_URING,
+ * but pages are read and written with O_DIRECT, bypassing the file cache
+ * of the operating system. Disables mmap. */
+#define HAM_IO_BACKEND_URING_DIRECT              2
+
+/** Parameter name for @ref ham_env_create, @ref ham_env_open; sets the
+ * number of background threads which flush dirty pages when the cache
+ * is purged. The file is split into regions of 1 MB, and each region is
+ * always flushed by the same thread. The default is 1; the maximum is
+ * @ref HAM_MAX_FLUSH_WORKERS. */
+#define HAM_PARAM_FLUSH_WORKERS         0x00000117
+
+/** The maximum value for @ref HAM_PARAM_FLUSH_WORKERS */
+#define HAM_MAX_FLUSH_WORKERS                    8
+
+/** Parameter name for @ref ham_env_create, @ref ham_env_open; if the
+ * number of dirty pages which are waiting for the flush threads exceeds
+ * this percentage of the cache capacity, then write operations are
+ * stalled until the flush threads catch up. The default is 50; 0 disables
+ * the stalls. */
+#define HAM_PARAM_FLUSH_STALL_PERCENT   0x00000118
+
+/** Parameter name for @ref ham_env_create, @ref ham_env_open; a background
+ * thread writes dirty pages to disk if they exceed this percentage of the
+ * cache capacity, even if the cache is not full. The default is 0
+ * (disabled). */
+#define HAM_PARAM_CHECKPOINT_DIRTY_PERCENT 0x00000119
+
+/** Parameter name for @ref ham_env_create, @ref ham_env_open; a background
+ * thread writes pages which are dirty for longer than this time (in
+ * milliseconds). With @ref HAM_ENABLE_RECOVERY, committed Transactions are
+ * flushed at the same interval, and a checkpoint is appended to the
+ * journal; the recovery then skips all older journal entries. The
+ * default is 0 (disabled). */
+#define HAM_PARAM_CHECKPOINT_AGE_LIMIT  0x0000011a
+
+/** Parameter name for @ref ham_env_create, @ref ham_env_open; reserves
+ * this many bytes of virtual address space for the memory mapped file.
+ * The mapping then grows with the file, and pages which are allocated
+ * later are memory mapped as well. Without this parameter only the
+ * file size at the time of @ref ham_env_open is mapped. Ignored on Win32,
+ * with @ref HAM_READ_ONLY, @ref HAM_DISABLE_MMAP or if the page size is
+ * not a multiple of the operating system's page size. The default is 0
+ * (disabled). */
+#define HAM_PARAM_MMAP_RESERVE          0x0000011b
+
+/** Parameter name for @ref ham_env_create_db; records up to this size
+ * (in bytes) are stored directly in the B+Tree leaf, larger records are
+ * stored in a separate blob. A lookup of a small record therefore only
+ * fetches a single page. The threshold is persisted. It is ignored for
+ * fixed length records (@ref HAM_PARAM_RECORD_SIZE) and for Databases
+ * with duplicate keys. The maximum is 250. The default is 0 (only records
+ * with 8 bytes or less are stored in the leaf). */
+#define HAM_PARAM_INLINE_RECORD_THRESHOLD 0x0000011c
+
 /** Value for unlimited record sizes */
 #define HAM_RECORD_SIZE_UNLIMITED       ((uint32_t)-1)
 
@@ -1776,22 +1992,34 @@ ham_db_get_parameters(ham_db_t *db, ham_parameter_t *param);
 #define HAM_PARAM_MAX_KEYS_PER_PAGE     0x00000204
 
 /**
- * hamsterdb pro: Parameter name for @ref ham_env_create, @ref ham_env_open;
- * enables compression for the journal.
+ * Parameter name for @ref ham_env_create, @ref ham_env_open; enables
+ * compression for the journal. hamsterdb supports @ref HAM_COMPRESSOR_LZF,
+ * the other algorithms are only available in hamsterdb pro.
+ *
+ * Keys, records and changeset pages of at least 64 bytes are compressed.
+ * The setting is not persisted; a journal with compressed entries is
+ * recovered even if the parameter is not specified when opening the
+ * Environment.
  */
 #define HAM_PARAM_JOURNAL_COMPRESSION   0x00001000
 
 /**
- * hamsterdb pro: Parameter name for @ref ham_env_create_db,
- * @ref ham_env_open_db; enables compression for the records of
- * a Database.
+ * Parameter name for @ref ham_env_create_db; enables compression for the
+ * records of a Database. The algorithm is persisted. hamsterdb supports
+ * @ref HAM_COMPRESSOR_LZF, the other algorithms are only available
+ * in hamsterdb pro.
+ *
+ * Only records which are stored as blobs are compressed, and only if the
+ * compressed data is smaller than the original record. Records are not
+ * compressed in an In-Memory Environment.
  */
 #define HAM_PARAM_RECORD_COMPRESSION    0x00001001
 
 /**
- * hamsterdb pro: Parameter name for @ref ham_env_create_db,
- * @ref ham_env_open_db; enables compression for the records of
- * a Database.
+ * Parameter name for @ref ham_env_create_db; enables compression for the
+ * keys of a Database. The algorithm is persisted. hamsterdb supports
+ * @ref HAM_COMPRESSOR_PREFIX and @ref HAM_COMPRESSOR_FOR, the other
+ * algorithms are only available in hamsterdb pro.
  */
 #define HAM_PARAM_KEY_COMPRESSION       0x00001002
 
@@ -1811,7 +2039,8 @@ ham_db_get_parameters(ham_db_t *db, ham_parameter_t *param);
 #define HAM_COMPRESSOR_SNAPPY       2
 
 /**
- * hamsterdb pro: selects lzf compression
+ * Selects lzf compression (@ref HAM_PARAM_RECORD_COMPRESSION,
+ * @ref HAM_PARAM_JOURNAL_COMPRESSION)
  * http://oldhome.schmorp.de/marc/liblzf.html
  */
 #define HAM_COMPRESSOR_LZF          3
@@ -1822,6 +2051,24 @@ ham_db_get_parameters(ham_db_t *db, ham_parameter_t *param);
  */
 #define HAM_COMPRESSOR_LZO          4
 
+/**
+ * Selects prefix compression for keys (@ref HAM_PARAM_KEY_COMPRESSION).
+ * Keys sharing a common prefix with the other keys of a btree node only
+ * store their suffix. Requires variable length keys of type
+ * @ref HAM_TYPE_BINARY.
+ */
+#define HAM_COMPRESSOR_PREFIX       5
+
+/**
+ * Selects frame-of-reference compression for integer keys
+ * (@ref HAM_PARAM_KEY_COMPRESSION). The keys of a btree node are split
+ * into blocks; each block stores the difference to its first key with
+ * the minimum number of bits. Requires keys of type @ref HAM_TYPE_UINT32
+ * or @ref HAM_TYPE_UINT64, and works best for sequential keys (i.e.
+ * record numbers or time stamps).
+ */
+#define HAM_COMPRESSOR_FOR          6
+
 /**
  * Retrieves the Environment handle of a Database
  *
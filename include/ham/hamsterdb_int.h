@@ -123,6 +123,28 @@ typedef struct min_max_avg_u32_t {
   uint32_t _instances;  /* for calculating the average */
 } min_max_avg_u32_t;
 
+/* latency percentiles of an operation, in microseconds; the percentiles
+ * are approximations with a relative error of less than 12.5% */
+typedef struct latency_metrics_t {
+  /* number of recorded operations */
+  uint64_t count;
+
+  /* total time of all operations (for calculating the average) */
+  uint64_t total_usec;
+
+  /* the median */
+  uint64_t p50_usec;
+
+  /* the 99th percentile */
+  uint64_t p99_usec;
+
+  /* the 99.9th percentile */
+  uint64_t p999_usec;
+
+  /* the slowest operation */
+  uint64_t max_usec;
+} latency_metrics_t;
+
 /* btree metrics */
 typedef struct btree_metrics_t {
   /* the database name of the btree */
@@ -230,12 +252,74 @@ typedef struct ham_env_metrics_t {
   /* number of cache misses */
   uint64_t cache_misses;
 
+  /* the cache replacement policy (HAM_CACHE_POLICY_*) */
+  uint32_t cache_policy;
+
+  /* number of cache hits in the "hot" queue (HAM_CACHE_POLICY_2Q) */
+  uint64_t cache_hits_hot;
+
+  /* number of cache hits in the "cold" queue (HAM_CACHE_POLICY_2Q) */
+  uint64_t cache_hits_cold;
+
+  /* number of pages promoted to the "hot" queue (HAM_CACHE_POLICY_2Q) */
+  uint64_t cache_promotions;
+
+  /* number of pages which were read ahead (HAM_PARAM_READAHEAD_PAGES) */
+  uint64_t readahead_issued;
+
+  /* number of read-ahead pages which were fetched afterwards */
+  uint64_t readahead_hits;
+
+  /* number of read-ahead pages which were not required */
+  uint64_t readahead_wasted;
+
+  /* number of dirty pages which are waiting for the flush threads
+   * (HAM_PARAM_FLUSH_WORKERS) */
+  uint64_t flush_queue_depth;
+
+  /* number of pages written by each flush thread */
+  uint64_t flush_worker_pages[HAM_MAX_FLUSH_WORKERS];
+
+  /* number of times that a writer was stalled because too many pages were
+   * waiting for the flush threads (HAM_PARAM_FLUSH_STALL_PERCENT) */
+  uint64_t flush_stalls;
+
+  /* total time (in microseconds) that writers were stalled */
+  uint64_t flush_stall_usec;
+
+  /* number of checkpoints (HAM_PARAM_CHECKPOINT_DIRTY_PERCENT,
+   * HAM_PARAM_CHECKPOINT_AGE_LIMIT) */
+  uint64_t checkpoint_count;
+
+  /* number of dirty pages written by the checkpoints */
+  uint64_t checkpoint_pages;
+
+  /* the lsn of the last checkpoint in the journal */
+  uint64_t checkpoint_lsn;
+
+  /* number of page checksums calculated when flushing (HAM_ENABLE_CRC32) */
+  uint64_t page_checksums_computed;
+
+  /* number of page checksums verified when fetching (HAM_ENABLE_CRC32) */
+  uint64_t page_checksums_verified;
+
+  /* number of mapped pages which were fetched again, but not verified
+   * again (HAM_ENABLE_CRC32) */
+  uint64_t page_checksums_skipped;
+
+  /* number of pages with an invalid checksum (HAM_ENABLE_CRC32) */
+  uint64_t page_checksum_failures;
+
   /* number of blobs allocated */
   uint64_t blob_total_allocated;
 
   /* number of blobs read */
   uint64_t blob_total_read;
 
+  /* number of bytes of large blobs which were read directly from the
+   * file, bypassing the cache */
+  uint64_t blob_bytes_read_uncached;
+
   /* (global) number of btree page splits */
   uint64_t btree_smo_split;
 
@@ -257,20 +341,53 @@ typedef struct ham_env_metrics_t {
   /* PRO: log/journal bytes after compression */
   uint64_t journal_bytes_after_compression;
 
-  /* PRO: record bytes before compression */
+  /* number of fsync calls of the log/journal */
+  uint64_t journal_fsyncs;
+
+  /* number of group commits (HAM_PARAM_JOURNAL_COMMIT_WINDOW) */
+  uint64_t journal_group_commits;
+
+  /* histogram of the group commit batch sizes; slot i counts the batches
+   * with 2^i to 2^(i+1)-1 Transactions, the last slot counts all larger
+   * batches */
+  uint64_t journal_group_commit_sizes[8];
+
+  /* record bytes before compression */
   uint64_t record_bytes_before_compression;
 
-  /* PRO: record bytes after compression */
+  /* record bytes after compression */
   uint64_t record_bytes_after_compression;
 
-  /* PRO: key bytes before compression */
+  /* key bytes before compression */
   uint64_t key_bytes_before_compression;
 
-  /* PRO: key bytes after compression */
+  /* key bytes after compression */
   uint64_t key_bytes_after_compression;
 
   /* PRO: set to the max. SIMD lane width (0 if SIMD is not available) */
   int simd_lane_width;
+
+  /* latency of ham_db_find and ham_cursor_find */
+  latency_metrics_t latency_find;
+
+  /* latency of ham_db_insert and ham_cursor_insert */
+  latency_metrics_t latency_insert;
+
+  /* latency of ham_db_erase and ham_cursor_erase */
+  latency_metrics_t latency_erase;
+
+  /* latency of ham_txn_commit (without waiting for the group commit) */
+  latency_metrics_t latency_commit;
+
+  /* (global) latency of reading a page from the device */
+  latency_metrics_t latency_page_fetch;
+
+  /* (global) latency of writing a page (or a batch of pages) to the
+   * device */
+  latency_metrics_t latency_page_flush;
+
+  /* latency of the fsync calls of the log/journal */
+  latency_metrics_t latency_journal_fsync;
  
   /* btree metrics for leaf nodes */
   btree_metrics_t btree_leaf_metrics;
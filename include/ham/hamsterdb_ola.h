@@ -233,6 +233,58 @@ HAM_EXPORT ham_status_t HAM_CALLCONV
 hola_sum_if(ham_db_t *db, ham_txn_t *txn, hola_bool_predicate_t *pred,
                 hola_result_t *result);
 
+/** Function codes for @ref hola_aggregate: @ref hola_count */
+#define HOLA_COUNT                      1
+
+/** Function codes for @ref hola_aggregate: @ref hola_count_if */
+#define HOLA_COUNT_IF                   2
+
+/** Function codes for @ref hola_aggregate: @ref hola_count_distinct */
+#define HOLA_COUNT_DISTINCT             3
+
+/** Function codes for @ref hola_aggregate: @ref hola_count_distinct_if */
+#define HOLA_COUNT_DISTINCT_IF          4
+
+/** Function codes for @ref hola_aggregate: @ref hola_average */
+#define HOLA_AVERAGE                    5
+
+/** Function codes for @ref hola_aggregate: @ref hola_average_if */
+#define HOLA_AVERAGE_IF                 6
+
+/** Function codes for @ref hola_aggregate: @ref hola_sum */
+#define HOLA_SUM                        7
+
+/** Function codes for @ref hola_aggregate: @ref hola_sum_if */
+#define HOLA_SUM_IF                     8
+
+/**
+ * Runs one of the functions above with multiple threads.
+ *
+ * The leaf level of the B-Tree is split in key ranges which are scanned
+ * in parallel; the partial results are merged when all threads are
+ * finished. Keys of Transactions which are not yet flushed are merged
+ * by the calling thread.
+ *
+ * @a function is one of the @a HOLA_* function codes. @a pred is required
+ * for the @a *_IF functions and ignored otherwise. Since the predicate
+ * function is called from multiple threads it has to be thread-safe.
+ *
+ * @a threads is the number of threads. If it is 0 then one thread per
+ * CPU core is used; if it is 1 then no additional threads are started and
+ * the result is identical to the one of the other hola_* functions.
+ *
+ * @return @ref HAM_SUCCESS upon success
+ * @return @ref HAM_INV_PARAMETER if @a db or @a result is NULL, if
+ *          @a function is unknown or if @a pred is NULL for a *_IF
+ *          function
+ * @return @ref HAM_INV_PARAMETER if the function requires numeric keys
+ *          but the database is not numeric
+ */
+HAM_EXPORT ham_status_t HAM_CALLCONV
+hola_aggregate(ham_db_t *db, ham_txn_t *txn, int function,
+                hola_bool_predicate_t *pred, uint32_t threads,
+                hola_result_t *result);
+
 /**
  * @}
  */
@@ -1466,6 +1466,7 @@ inithamsterdb()
   add_const(d, "HAM_COMPRESSOR_SNAPPY", HAM_COMPRESSOR_SNAPPY);
   add_const(d, "HAM_COMPRESSOR_LZF", HAM_COMPRESSOR_LZF);
   add_const(d, "HAM_COMPRESSOR_LZO", HAM_COMPRESSOR_LZO);
+  add_const(d, "HAM_COMPRESSOR_PREFIX", HAM_COMPRESSOR_PREFIX);
   add_const(d, "HAM_TXN_AUTO_ABORT", HAM_TXN_AUTO_ABORT);
   add_const(d, "HAM_TXN_AUTO_COMMIT", HAM_TXN_AUTO_COMMIT);
   add_const(d, "HAM_CURSOR_FIRST", HAM_CURSOR_FIRST);
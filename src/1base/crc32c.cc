@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2005-2015 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "0root/root.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && !defined(__clang__) \
+        && (defined(__x86_64__) || defined(__i386__)) \
+        && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#  include <immintrin.h>
+#  define HAM_HW_CRC32C 1
+#  define HAM_TARGET_SSE42 __attribute__((target("sse4.2")))
+#endif
+
+// Always verify that a file of level N does not include headers > N!
+#include "1base/crc32c.h"
+#include "1os/os.h"
+
+#ifndef HAM_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace hamsterdb {
+
+// The (reflected) Castagnoli polynomial
+static const uint32_t kPolynomial = 0x82f63b78;
+
+// Lookup table for the software implementation
+struct Crc32cTable {
+  Crc32cTable() {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t crc = i;
+      for (int j = 0; j < 8; j++)
+        crc = (crc >> 1) ^ ((crc & 1) ? kPolynomial : 0);
+      table[i] = crc;
+    }
+  }
+
+  uint32_t table[256];
+};
+
+static uint32_t
+crc32c_sw(uint32_t crc, const uint8_t *p, size_t len)
+{
+  static Crc32cTable t;
+
+  while (len--)
+    crc = t.table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+  return (crc);
+}
+
+#ifdef HAM_HW_CRC32C
+HAM_TARGET_SSE42 static uint32_t
+crc32c_hw(uint32_t crc, const uint8_t *p, size_t len)
+{
+  // align the pointer
+  while (len > 0 && ((uintptr_t)p & 7) != 0) {
+    crc = _mm_crc32_u8(crc, *p++);
+    len--;
+  }
+
+#  ifdef __x86_64__
+  uint64_t crc64 = crc;
+  for (; len >= 8; len -= 8, p += 8)
+    crc64 = _mm_crc32_u64(crc64, *(const uint64_t *)p);
+  crc = (uint32_t)crc64;
+#  endif
+  for (; len >= 4; len -= 4, p += 4)
+    crc = _mm_crc32_u32(crc, *(const uint32_t *)p);
+
+  while (len--)
+    crc = _mm_crc32_u8(crc, *p++);
+  return (crc);
+}
+#endif
+
+uint32_t
+crc32c(uint32_t crc, const void *buffer, size_t len)
+{
+  const uint8_t *p = (const uint8_t *)buffer;
+
+#ifdef HAM_HW_CRC32C
+  if (os_has_sse42())
+    return (~crc32c_hw(~crc, p, len));
+#endif
+  return (~crc32c_sw(~crc, p, len));
+}
+
+} // namespace hamsterdb
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2005-2015 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * CRC32C (Castagnoli) checksums. Uses the SSE4.2 crc32 instruction if it
+ * is supported by the CPU, otherwise a lookup table.
+ *
+ * @exception_safe: nothrow
+ * @thread_safe: yes
+ */
+
+#ifndef HAM_CRC32C_H
+#define HAM_CRC32C_H
+
+#include "0root/root.h"
+
+#include "ham/types.h"
+
+// Always verify that a file of level N does not include headers > N!
+
+#ifndef HAM_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace hamsterdb {
+
+// Updates the checksum |crc| with |len| bytes of |buffer| and returns the
+// new checksum. The initial value of |crc| is 0. A checksum can be
+// computed incrementally:
+//
+//     uint32_t crc = crc32c(0, p1, len1);
+//     crc = crc32c(crc, p2, len2);
+//
+extern uint32_t
+crc32c(uint32_t crc, const void *buffer, size_t len);
+
+} // namespace hamsterdb
+
+#endif /* HAM_CRC32C_H */
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2005-2015 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A histogram of latencies (in microseconds), similar to an HdrHistogram.
+ * Each power of two is split into kSubBuckets linear buckets, therefore
+ * the relative error of the reported percentiles is below 12.5%.
+ *
+ * Threads record into one of several stripes (selected by the thread id),
+ * so that concurrent threads (e.g. the flush workers) do not contend for
+ * the same cache lines. The stripes are merged when the metrics are
+ * retrieved.
+ *
+ * @exception_safe: nothrow
+ * @thread_safe: yes
+ */
+
+#ifndef HAM_LATENCY_HISTOGRAM_H
+#define HAM_LATENCY_HISTOGRAM_H
+
+#include "0root/root.h"
+
+#include <string.h>
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#include <boost/functional/hash.hpp>
+
+#include "ham/hamsterdb_int.h"
+
+// Always verify that a file of level N does not include headers > N!
+#include "1os/os.h"
+
+#ifndef HAM_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace hamsterdb {
+
+class LatencyHistogram
+{
+  public:
+    enum {
+      // each power of two is split into 2^kSubBucketBits buckets
+      kSubBucketBits = 3,
+      kSubBuckets = 1 << kSubBucketBits,
+
+      // latencies >= 2^kMaxBits microseconds (~71 minutes) are counted
+      // in the last bucket
+      kMaxBits = 32,
+
+      // the total number of buckets
+      kBuckets = (kMaxBits - kSubBucketBits + 1) * kSubBuckets,
+
+      // the number of stripes
+      kStripes = 4
+    };
+
+    LatencyHistogram() {
+      for (int s = 0; s < kStripes; s++) {
+        m_stripes[s].total.store(0, boost::memory_order_relaxed);
+        for (int i = 0; i < kBuckets; i++)
+          m_stripes[s].buckets[i].store(0, boost::memory_order_relaxed);
+      }
+    }
+
+    // Records a single latency
+    void record(uint64_t usec) {
+      Stripe &stripe = m_stripes[get_stripe()];
+      stripe.buckets[get_bucket(usec)].fetch_add(1,
+                      boost::memory_order_relaxed);
+      stripe.total.fetch_add(usec, boost::memory_order_relaxed);
+    }
+
+    // Merges the stripes and fills |metrics| with the percentiles
+    void fill_metrics(latency_metrics_t *metrics) const {
+      uint64_t buckets[kBuckets] = {0};
+      uint64_t count = 0;
+      uint64_t total = 0;
+      for (int s = 0; s < kStripes; s++) {
+        const Stripe &stripe = m_stripes[s];
+        for (int i = 0; i < kBuckets; i++) {
+          uint32_t c = stripe.buckets[i].load(boost::memory_order_relaxed);
+          buckets[i] += c;
+          count += c;
+        }
+        total += stripe.total.load(boost::memory_order_relaxed);
+      }
+
+      ::memset(metrics, 0, sizeof(*metrics));
+      metrics->count = count;
+      metrics->total_usec = total;
+      if (count == 0)
+        return;
+
+      // the percentiles are rounded up
+      uint64_t p50 = (count * 500 + 999) / 1000;
+      uint64_t p99 = (count * 990 + 999) / 1000;
+      uint64_t p999 = (count * 999 + 999) / 1000;
+      uint64_t seen = 0;
+      for (int i = 0; i < kBuckets; i++) {
+        if (buckets[i] == 0)
+          continue;
+        seen += buckets[i];
+        uint64_t upper = get_upper_bound(i);
+        if (metrics->p50_usec == 0 && seen >= p50)
+          metrics->p50_usec = upper;
+        if (metrics->p99_usec == 0 && seen >= p99)
+          metrics->p99_usec = upper;
+        if (metrics->p999_usec == 0 && seen >= p999)
+          metrics->p999_usec = upper;
+        metrics->max_usec = upper;
+      }
+    }
+
+    // Returns the bucket index of a latency
+    static int get_bucket(uint64_t usec) {
+      if (usec < 2 * kSubBuckets)
+        return ((int)usec);
+      if (usec >= (1ull << kMaxBits))
+        return (kBuckets - 1);
+      int msb = kSubBucketBits + 1;
+      while ((usec >> (msb + 1)) != 0)
+        msb++;
+      int sub = (int)(usec >> (msb - kSubBucketBits)) & (kSubBuckets - 1);
+      return ((msb - kSubBucketBits + 1) * kSubBuckets + sub);
+    }
+
+    // Returns the highest latency which is counted in a bucket
+    static uint64_t get_upper_bound(int bucket) {
+      if (bucket < 2 * kSubBuckets)
+        return ((uint64_t)bucket);
+      int shift = bucket / kSubBuckets - 1;
+      uint64_t sub = (uint64_t)(bucket % kSubBuckets);
+      return (((kSubBuckets + sub + 1) << shift) - 1);
+    }
+
+  private:
+    struct Stripe {
+      boost::atomic<uint64_t> total;
+      boost::atomic<uint32_t> buckets[kBuckets];
+    };
+
+    // Returns the stripe of the current thread
+    static int get_stripe() {
+      boost::hash<boost::thread::id> hash;
+      return ((int)(hash(boost::this_thread::get_id()) % kStripes));
+    }
+
+    // The stripes
+    Stripe m_stripes[kStripes];
+};
+
+// Measures the time between its construction and destruction, and records
+// it in a LatencyHistogram
+class ScopedLatency
+{
+  public:
+    ScopedLatency(LatencyHistogram *histogram)
+      : m_histogram(histogram), m_start(os_now_usec()) {
+    }
+
+    ~ScopedLatency() {
+      m_histogram->record(os_now_usec() - m_start);
+    }
+
+  private:
+    LatencyHistogram *m_histogram;
+    uint64_t m_start;
+};
+
+} // namespace hamsterdb
+
+#endif // HAM_LATENCY_HISTOGRAM_H
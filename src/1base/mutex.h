@@ -47,6 +47,7 @@ typedef boost::thread Thread;
 typedef boost::condition Condition;
 typedef boost::mutex Mutex;
 typedef boost::recursive_mutex RecursiveMutex;
+typedef boost::recursive_mutex::scoped_lock ScopedRecursiveLock;
 
 } // namespace hamsterdb
 
@@ -33,8 +33,6 @@ uint32_t Globals::ms_extended_threshold;
 
 uint32_t Globals::ms_duplicate_threshold;
 
-int Globals::ms_linear_threshold;
-
 int Globals::ms_error_level;
 
 const char *Globals::ms_error_file;
@@ -54,7 +52,5 @@ uint64_t Globals::ms_bytes_before_compression;
 
 uint64_t Globals::ms_bytes_after_compression;
 
-bool Globals::ms_is_simd_enabled = true;
-
 } // namespace hamsterdb
 
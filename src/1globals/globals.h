@@ -53,9 +53,6 @@ struct Globals {
   // TODO currently gets assigned at runtime
   static uint32_t ms_duplicate_threshold;
 
-  // linear search threshold for the PAX layout
-  static int ms_linear_threshold;
-
   // used in error.h/error.cc
   static int ms_error_level;
 
@@ -74,14 +71,11 @@ struct Globals {
   // used in error.h/error.cc
   static ham_errhandler_fun ms_error_handler;
 
-  // PRO: Tracking key bytes before compression
+  // Tracking key bytes before compression
   static uint64_t ms_bytes_before_compression;
 
-  // PRO: Tracking key bytes after compression
+  // Tracking key bytes after compression
   static uint64_t ms_bytes_after_compression;
-
-  // PRO: enable/disable SIMD
-  static bool ms_is_simd_enabled;
 };
 
 } // namespace hamsterdb
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2005-2015 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * An arena ("region") allocator
+ *
+ * @exception_safe: strong
+ * @thread_safe: no
+ */
+
+#ifndef HAM_ARENA_H
+#define HAM_ARENA_H
+
+#include "0root/root.h"
+
+// Always verify that a file of level N does not include headers > N!
+#include "1mem/mem.h"
+#include "1mem/memory_pool.h"
+
+#ifndef HAM_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace hamsterdb {
+
+/*
+ * The Arena hands out memory from larger chunks, which are taken from a
+ * MemoryPool. Single allocations cannot be released; instead all memory
+ * is released at once (with |release| or in the destructor), and the
+ * chunks are returned to the pool.
+ *
+ * Allocations which do not fit into a chunk get a chunk of their own,
+ * which is allocated on the heap.
+ */
+class Arena
+{
+  enum {
+    // all allocations are aligned to this boundary
+    kAlignment = 8
+  };
+
+  // The header of each chunk
+  struct Chunk {
+    // the next chunk in the linked list
+    Chunk *next;
+
+    // true if this chunk was taken from the pool
+    uint64_t is_pooled;
+  };
+
+  public:
+    // Constructor; no memory is allocated till the first call to |allocate|
+    Arena(MemoryPool *pool)
+      : m_pool(pool), m_chunks(0), m_ptr(0), m_end(0) {
+    }
+
+    // Destructor; releases all memory
+    ~Arena() {
+      release();
+    }
+
+    // Allocates |size| bytes
+    void *allocate(size_t size) {
+      size = (size + kAlignment - 1) & ~(size_t)(kAlignment - 1);
+      if (size > (size_t)(m_end - m_ptr)) {
+        size_t capacity = m_pool->get_block_size() - sizeof(Chunk);
+        // a large allocation gets its own chunk; the current chunk is
+        // still used for the following allocations
+        if (size > capacity)
+          return (add_chunk(Memory::allocate<uint8_t>(sizeof(Chunk) + size),
+                                  false));
+        m_ptr = add_chunk(m_pool->allocate(), true);
+        m_end = m_ptr + capacity;
+      }
+      void *p = m_ptr;
+      m_ptr += size;
+      return (p);
+    }
+
+    // Releases all memory; the chunks are returned to the pool
+    void release() {
+      while (m_chunks) {
+        Chunk *next = m_chunks->next;
+        if (m_chunks->is_pooled)
+          m_pool->release(m_chunks);
+        else
+          Memory::release(m_chunks);
+        m_chunks = next;
+      }
+      m_ptr = 0;
+      m_end = 0;
+    }
+
+  private:
+    // Adds a chunk to the linked list; returns a pointer to its payload
+    uint8_t *add_chunk(void *ptr, bool is_pooled) {
+      Chunk *chunk = (Chunk *)ptr;
+      chunk->next = m_chunks;
+      chunk->is_pooled = is_pooled ? 1 : 0;
+      m_chunks = chunk;
+      return ((uint8_t *)(chunk + 1));
+    }
+
+    // The pool for the chunks
+    MemoryPool *m_pool;
+
+    // The linked list of chunks
+    Chunk *m_chunks;
+
+    // The free space in the current chunk starts here...
+    uint8_t *m_ptr;
+
+    // ... and ends here
+    uint8_t *m_end;
+};
+
+} // namespace hamsterdb
+
+#endif /* HAM_ARENA_H */
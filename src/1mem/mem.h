@@ -77,6 +77,31 @@ class Memory {
       return (t);
     }
 
+    // allocates |size| bytes, aligned to |alignment| bytes (a power of
+    // two); the memory is released with |release|. On Win32 the memory
+    // is not aligned.
+    template<typename T>
+    static T *allocate_aligned(size_t size, size_t alignment) {
+      ms_total_allocations++;
+      ms_current_allocations++;
+#ifdef HAM_OS_WIN32
+      T *t = (T *)::malloc(size);
+#else
+      void *p = 0;
+#  ifdef HAM_USE_TCMALLOC
+      if (::tc_posix_memalign(&p, alignment, size) != 0)
+        p = 0;
+#  else
+      if (::posix_memalign(&p, alignment, size) != 0)
+        p = 0;
+#  endif
+      T *t = (T *)p;
+#endif
+      if (!t)
+        throw Exception(HAM_OUT_OF_MEMORY);
+      return (t);
+    }
+
     // allocates |size| bytes; returns null if out of memory. initializes
     // the allocated memory with zeroes.
     // usage:
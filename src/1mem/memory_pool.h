@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2005-2015 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A pool for memory blocks of a fixed size
+ *
+ * @exception_safe: strong
+ * @thread_safe: no
+ */
+
+#ifndef HAM_MEMORY_POOL_H
+#define HAM_MEMORY_POOL_H
+
+#include "0root/root.h"
+
+// Always verify that a file of level N does not include headers > N!
+#include "1mem/mem.h"
+
+#ifndef HAM_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace hamsterdb {
+
+/*
+ * The MemoryPool allocates blocks of a single size class. Released blocks
+ * are not returned to the heap but stored in a free list, and are
+ * recycled by the next allocation. At most |max_free| blocks are kept
+ * in the free list; they are released when the pool is destroyed.
+ */
+class MemoryPool
+{
+  // A released block; the free list is stored in the blocks themselves
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  public:
+    // Constructor
+    MemoryPool(size_t block_size, size_t max_free)
+      : m_block_size(block_size < sizeof(FreeBlock)
+                        ? sizeof(FreeBlock)
+                        : block_size),
+        m_max_free(max_free), m_free_list(0), m_free_count(0) {
+    }
+
+    // Destructor; releases all cached blocks
+    ~MemoryPool() {
+      while (m_free_list) {
+        FreeBlock *next = m_free_list->next;
+        Memory::release(m_free_list);
+        m_free_list = next;
+      }
+    }
+
+    // Returns the size of the blocks
+    size_t get_block_size() const {
+      return (m_block_size);
+    }
+
+    // Returns the number of cached blocks
+    size_t get_free_count() const {
+      return (m_free_count);
+    }
+
+    // Returns a block; recycles a cached block, if available
+    void *allocate() {
+      if (m_free_list) {
+        FreeBlock *block = m_free_list;
+        m_free_list = block->next;
+        m_free_count--;
+        return (block);
+      }
+      return (Memory::allocate<uint8_t>(m_block_size));
+    }
+
+    // Releases a block which was allocated with |allocate|
+    void release(void *ptr) {
+      if (!ptr)
+        return;
+      if (m_free_count >= m_max_free) {
+        Memory::release(ptr);
+        return;
+      }
+      FreeBlock *block = (FreeBlock *)ptr;
+      block->next = m_free_list;
+      m_free_list = block;
+      m_free_count++;
+    }
+
+  private:
+    // The size of each block
+    size_t m_block_size;
+
+    // The maximum number of cached blocks
+    size_t m_max_free;
+
+    // The list of cached blocks
+    FreeBlock *m_free_list;
+
+    // The number of cached blocks
+    size_t m_free_count;
+};
+
+} // namespace hamsterdb
+
+#endif /* HAM_MEMORY_POOL_H */
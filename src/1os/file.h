@@ -42,6 +42,27 @@
 
 namespace hamsterdb {
 
+// A single read or write request of a batch (see Device::write_batch)
+struct IoRequest
+{
+  // the file offset
+  uint64_t address;
+
+  // the buffer which is read or written
+  void *buffer;
+
+  // the size of the buffer
+  size_t size;
+};
+
+// Sorts IoRequests by their file offset
+struct IoRequestComparator
+{
+  bool operator()(const IoRequest &lhs, const IoRequest &rhs) const {
+    return (lhs.address < rhs.address);
+  }
+};
+
 class File
 {
   public:
@@ -59,6 +80,11 @@ class File
 #endif
     };
 
+    enum {
+      // the maximum number of buffers of a vectored write (IOV_MAX)
+      kMaxBuffers = 1024
+    };
+
     // Constructor: creates an empty File handle
     File()
       : m_fd(HAM_INVALID_FD), m_mmaph(HAM_INVALID_FD), m_posix_advice(0) {
@@ -90,11 +116,22 @@ class File
     // Opens an existing file
     void open(const char *filename, bool read_only);
 
+    // Opens an existing file for unbuffered I/O (O_DIRECT), bypassing the
+    // file cache of the operating system. The file is not locked; it must
+    // already be opened (and locked) by another File handle. Returns false
+    // if unbuffered I/O is not supported.
+    bool open_direct(const char *filename, bool read_only);
+
     // Returns true if the file is open
     bool is_open() const {
       return (m_fd != HAM_INVALID_FD);
     }
 
+    // Returns the file handle
+    ham_fd_t get_handle() const {
+      return (m_fd);
+    }
+
     // Flushes a file
     void flush();
 
@@ -112,12 +149,30 @@ class File
     // Unmaps a buffer
     void munmap(void *buffer, size_t size);
 
+    // Reserves |size| bytes of virtual address space; the memory is not
+    // accessible until a file is mapped into it with mmap_fixed()
+    static void reserve_address_space(size_t size, uint8_t **buffer);
+
+    // Maps a file range to |address|, which must be in a range returned
+    // by reserve_address_space(). Uses MAP_PRIVATE, like mmap().
+    void mmap_fixed(uint8_t *address, uint64_t position, size_t size,
+                    bool readonly);
+
+    // Returns a range which was mapped with mmap_fixed() to the
+    // reservation; the file is no longer mapped at |address|
+    static void release_address_space(uint8_t *address, size_t size);
+
     // Positional read from a file
     void pread(uint64_t addr, void *buffer, size_t len);
 
     // Positional write to a file
     void pwrite(uint64_t addr, const void *buffer, size_t len);
 
+    // Positional write of |count| buffers (up to kMaxBuffers) to adjacent
+    // areas of a file, starting at |addr|; the addresses of the requests
+    // are ignored
+    void pwritev(uint64_t addr, const IoRequest *requests, size_t count);
+
     // Write data to a file; uses the current file position
     void write(const void *buffer, size_t len);
 
@@ -14,15 +14,125 @@
  * limitations under the License.
  */
 
+#include "0root/root.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  include <cpuid.h>
+#  define HAM_HAVE_CPUID 1
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#  include <intrin.h>
+#  define HAM_HAVE_CPUID 1
+#endif
+
+#ifdef HAM_OS_WIN32
+#  include <windows.h>
+#else
+#  include <time.h>
+#  include <sys/time.h>
+#endif
+
 #include "1os/os.h"
 
 namespace hamsterdb {
 
+#ifdef HAM_HAVE_CPUID
+static void
+cpuid(uint32_t leaf, uint32_t regs[4])
+{
+#  ifdef _MSC_VER
+  int r[4];
+  __cpuidex(r, (int)leaf, 0);
+  for (int i = 0; i < 4; i++)
+    regs[i] = (uint32_t)r[i];
+#  else
+  __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#  endif
+}
+
+// Returns true if the operating system saves the AVX registers
+// on a context switch
+static bool
+os_supports_avx()
+{
+#  ifdef _MSC_VER
+  return ((_xgetbv(0) & 6) == 6);
+#  else
+  uint32_t eax, edx;
+  __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return ((eax & 6) == 6);
+#  endif
+}
+
+static int
+detect_simd_lane_width()
+{
+  uint32_t regs[4];
+  cpuid(0, regs);
+  uint32_t max_leaf = regs[0];
+
+  cpuid(1, regs);
+  bool sse2 = (regs[3] & (1u << 26)) != 0;
+  bool osxsave = (regs[2] & (1u << 27)) != 0;
+  bool avx = (regs[2] & (1u << 28)) != 0;
+
+  if (max_leaf >= 7 && osxsave && avx && os_supports_avx()) {
+    cpuid(7, regs);
+    if (regs[1] & (1u << 5)) // AVX2
+      return (8);
+  }
+  return (sse2 ? 4 : 0);
+}
+
+static bool
+detect_sse42()
+{
+  uint32_t regs[4];
+  cpuid(1, regs);
+  return ((regs[2] & (1u << 20)) != 0);
+}
+#endif
+
 int
 os_get_simd_lane_width()
 {
-  // only supported in hamsterdb pro
+#ifdef HAM_HAVE_CPUID
+  static int width = detect_simd_lane_width();
+  return (width);
+#else
   return (0);
+#endif
+}
+
+bool
+os_has_sse42()
+{
+#ifdef HAM_HAVE_CPUID
+  static bool sse42 = detect_sse42();
+  return (sse42);
+#else
+  return (false);
+#endif
+}
+
+uint64_t
+os_now_usec()
+{
+#ifdef HAM_OS_WIN32
+  static LARGE_INTEGER frequency;
+  if (frequency.QuadPart == 0)
+    ::QueryPerformanceFrequency(&frequency);
+  LARGE_INTEGER now;
+  ::QueryPerformanceCounter(&now);
+  return ((uint64_t)(now.QuadPart / (frequency.QuadPart / 1000000.0)));
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  ::clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+#else
+  struct timeval tv;
+  ::gettimeofday(&tv, 0);
+  return ((uint64_t)tv.tv_sec * 1000000 + tv.tv_usec);
+#endif
 }
 
 } // namespace hamsterdb
@@ -64,10 +64,21 @@ typedef SOCKET             ham_socket_t;
 #endif
 
 // Returns the number of 32bit integers that the CPU can process in
-// parallel (the SIMD lane width) 
+// parallel (the SIMD lane width): 8 if AVX2 is available, 4 for SSE2,
+// otherwise 0
 extern int
 os_get_simd_lane_width();
 
+// Returns true if the CPU supports the SSE4.2 instructions (i.e. the
+// hardware CRC32C instruction)
+extern bool
+os_has_sse42();
+
+// Returns a monotonic timestamp in microseconds; only useful for
+// measuring time intervals
+extern uint64_t
+os_now_usec();
+
 } // namespace hamsterdb
 
 #endif /* HAM_OS_H */
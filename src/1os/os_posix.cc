@@ -213,6 +213,88 @@ File::munmap(void *buffer, size_t size)
 #endif
 }
 
+void
+File::reserve_address_space(size_t size, uint8_t **buffer)
+{
+  os_log(("File::reserve_address_space: size=%lld", size));
+
+#if HAVE_MMAP
+#  ifdef MAP_ANONYMOUS
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#  else
+  int flags = MAP_PRIVATE | MAP_ANON;
+#  endif
+#  ifdef MAP_NORESERVE
+  flags |= MAP_NORESERVE;
+#  endif
+  *buffer = (uint8_t *)::mmap(0, size, PROT_NONE, flags, -1, 0);
+  if (*buffer == (void *)-1) {
+    *buffer = 0;
+    ham_log(("mmap failed with status %d (%s)", errno, strerror(errno)));
+    throw Exception(HAM_IO_ERROR);
+  }
+#else
+  throw Exception(HAM_NOT_IMPLEMENTED);
+#endif
+}
+
+void
+File::mmap_fixed(uint8_t *address, uint64_t position, size_t size,
+                bool readonly)
+{
+  os_log(("File::mmap_fixed: fd=%d, position=%lld, size=%lld", m_fd,
+              position, size));
+
+  int prot = PROT_READ;
+  if (!readonly)
+    prot |= PROT_WRITE;
+
+#if HAVE_MMAP
+  void *p = ::mmap(address, size, prot, MAP_PRIVATE | MAP_FIXED, m_fd,
+                  position);
+  if (p == (void *)-1) {
+    ham_log(("mmap failed with status %d (%s)", errno, strerror(errno)));
+    throw Exception(HAM_IO_ERROR);
+  }
+#else
+  throw Exception(HAM_NOT_IMPLEMENTED);
+#endif
+
+#if HAVE_MADVISE
+  if (m_posix_advice == HAM_POSIX_FADVICE_RANDOM) {
+    int r = ::madvise(address, size, MADV_RANDOM);
+    if (r != 0) {
+      ham_log(("madvise failed with status %d (%s)", errno, strerror(errno)));
+      throw Exception(HAM_IO_ERROR);
+    }
+  }
+#endif
+}
+
+void
+File::release_address_space(uint8_t *address, size_t size)
+{
+  os_log(("File::release_address_space: size=%lld", size));
+
+#if HAVE_MMAP
+#  ifdef MAP_ANONYMOUS
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED;
+#  else
+  int flags = MAP_PRIVATE | MAP_ANON | MAP_FIXED;
+#  endif
+#  ifdef MAP_NORESERVE
+  flags |= MAP_NORESERVE;
+#  endif
+  void *p = ::mmap(address, size, PROT_NONE, flags, -1, 0);
+  if (p == (void *)-1) {
+    ham_log(("mmap failed with status %d (%s)", errno, strerror(errno)));
+    throw Exception(HAM_IO_ERROR);
+  }
+#else
+  throw Exception(HAM_NOT_IMPLEMENTED);
+#endif
+}
+
 void
 File::pread(uint64_t addr, void *buffer, size_t len)
 {
@@ -276,6 +358,51 @@ File::pwrite(uint64_t addr, const void *buffer, size_t len)
 #endif
 }
 
+void
+File::pwritev(uint64_t addr, const IoRequest *requests, size_t count)
+{
+  os_log(("File::pwritev: fd=%d, address=%lld, count=%d", m_fd, addr,
+          (int)count));
+  ham_assert(count <= kMaxBuffers);
+
+#if HAVE_PWRITE && HAVE_WRITEV && (defined(__linux__) || defined(__FreeBSD__))
+  struct iovec iov[kMaxBuffers];
+  size_t total = 0;
+  for (size_t i = 0; i < count; i++) {
+    iov[i].iov_base = requests[i].buffer;
+    iov[i].iov_len = requests[i].size;
+    total += requests[i].size;
+  }
+
+  ssize_t s = ::pwritev(m_fd, &iov[0], (int)count, addr);
+  if (s < 0) {
+    ham_log(("pwritev() failed with status %u (%s)", errno, strerror(errno)));
+    throw Exception(HAM_IO_ERROR);
+  }
+  if ((size_t)s == total)
+    return;
+
+  // short write: write the remaining data buffer by buffer
+  size_t written = (size_t)s;
+  for (size_t i = 0; i < count; i++) {
+    size_t size = requests[i].size;
+    if (written >= size)
+      written -= size;
+    else {
+      pwrite(addr + written, (const uint8_t *)requests[i].buffer + written,
+                      size - written);
+      written = 0;
+    }
+    addr += size;
+  }
+#else
+  for (size_t i = 0; i < count; i++) {
+    pwrite(addr, requests[i].buffer, requests[i].size);
+    addr += requests[i].size;
+  }
+#endif
+}
+
 void
 File::write(const void *buffer, size_t len)
 {
@@ -388,6 +515,32 @@ File::open(const char *filename, bool read_only)
   m_fd = fd;
 }
 
+bool
+File::open_direct(const char *filename, bool read_only)
+{
+#ifdef O_DIRECT
+  int osflags = (read_only ? O_RDONLY : O_RDWR) | O_DIRECT;
+#if HAVE_O_NOATIME
+  osflags |= O_NOATIME;
+#endif
+
+  ham_fd_t fd = ::open(filename, osflags);
+  if (fd < 0) {
+    ham_log(("opening file %s with O_DIRECT failed with status %u (%s)",
+        filename, errno, strerror(errno)));
+    return (false);
+  }
+
+  /* enable O_LARGEFILE support */
+  enable_largefile(fd);
+
+  m_fd = fd;
+  return (true);
+#else
+  return (false);
+#endif
+}
+
 void
 File::close()
 {
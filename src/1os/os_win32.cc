@@ -167,6 +167,26 @@ File::munmap(void *buffer, size_t size)
   m_mmaph = HAM_INVALID_FD;
 }
 
+void
+File::reserve_address_space(size_t size, uint8_t **buffer)
+{
+  // not supported: a view of a file mapping can not be extended
+  throw Exception(HAM_NOT_IMPLEMENTED);
+}
+
+void
+File::mmap_fixed(uint8_t *address, uint64_t position, size_t size,
+                bool readonly)
+{
+  throw Exception(HAM_NOT_IMPLEMENTED);
+}
+
+void
+File::release_address_space(uint8_t *address, size_t size)
+{
+  throw Exception(HAM_NOT_IMPLEMENTED);
+}
+
 void
 File::pread(uint64_t addr, void *buffer, size_t len)
 {
@@ -229,6 +249,17 @@ File::pwrite(uint64_t addr, const void *buffer, size_t len)
     throw Exception(HAM_IO_ERROR);
 }
 
+void
+File::pwritev(uint64_t addr, const IoRequest *requests, size_t count)
+{
+  // there's no vectored write for synchronous handles; write the buffers
+  // one by one
+  for (size_t i = 0; i < count; i++) {
+    pwrite(addr, requests[i].buffer, requests[i].size);
+    addr += requests[i].size;
+  }
+}
+
 void
 File::write(const void *buffer, size_t len)
 {
@@ -428,6 +459,13 @@ File::open(const char *filename, bool read_only)
   m_fd = fd;
 }
 
+bool
+File::open_direct(const char *filename, bool read_only)
+{
+  // not yet supported
+  return (false);
+}
+
 void
 File::close()
 {
@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2005-2015 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "0root/root.h"
+
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+
+// Always verify that a file of level N does not include headers > N!
+#include "1base/error.h"
+#include "1os/uring.h"
+
+#ifdef HAM_HAVE_IO_URING
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <sys/uio.h>
+#  include <linux/io_uring.h>
+#endif
+
+#ifndef HAM_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace hamsterdb {
+
+IoUring::IoUring()
+  : m_ring_fd(-1), m_entries(0), m_sq_ring(0), m_sq_ring_size(0),
+    m_cq_ring(0), m_cq_ring_size(0), m_sqes(0), m_sqes_size(0),
+    m_sq_tail(0), m_sq_mask(0), m_sq_array(0), m_cq_head(0), m_cq_tail(0),
+    m_cq_mask(0), m_cqes(0)
+{
+}
+
+#ifdef HAM_HAVE_IO_URING
+
+bool
+IoUring::setup(uint32_t entries)
+{
+  ham_assert(m_ring_fd < 0);
+
+  struct io_uring_params params;
+  ::memset(&params, 0, sizeof(params));
+  int fd = (int)::syscall(__NR_io_uring_setup, entries, &params);
+  if (fd < 0) {
+    ham_log(("io_uring_setup failed with status %u (%s)", errno,
+                strerror(errno)));
+    return (false);
+  }
+  m_ring_fd = fd;
+  m_entries = params.sq_entries;
+
+  m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  m_cq_ring_size = params.cq_off.cqes
+                        + params.cq_entries * sizeof(struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+    m_sq_ring_size = m_cq_ring_size
+                = std::max(m_sq_ring_size, m_cq_ring_size);
+
+  m_sq_ring = ::mmap(0, m_sq_ring_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (m_sq_ring == MAP_FAILED) {
+    m_sq_ring = 0;
+    close();
+    return (false);
+  }
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+    m_cq_ring = m_sq_ring;
+  else {
+    m_cq_ring = ::mmap(0, m_cq_ring_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (m_cq_ring == MAP_FAILED) {
+      m_cq_ring = 0;
+      close();
+      return (false);
+    }
+  }
+
+  m_sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  void *sqes = ::mmap(0, m_sqes_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    close();
+    return (false);
+  }
+  m_sqes = (struct io_uring_sqe *)sqes;
+
+  uint8_t *sq = (uint8_t *)m_sq_ring;
+  m_sq_tail = (unsigned *)(sq + params.sq_off.tail);
+  m_sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+  m_sq_array = (unsigned *)(sq + params.sq_off.array);
+
+  uint8_t *cq = (uint8_t *)m_cq_ring;
+  m_cq_head = (unsigned *)(cq + params.cq_off.head);
+  m_cq_tail = (unsigned *)(cq + params.cq_off.tail);
+  m_cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+  m_cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+  return (true);
+}
+
+void
+IoUring::close()
+{
+  if (m_sqes)
+    ::munmap(m_sqes, m_sqes_size);
+  if (m_cq_ring && m_cq_ring != m_sq_ring)
+    ::munmap(m_cq_ring, m_cq_ring_size);
+  if (m_sq_ring)
+    ::munmap(m_sq_ring, m_sq_ring_size);
+  if (m_ring_fd >= 0)
+    ::close(m_ring_fd);
+
+  m_ring_fd = -1;
+  m_sq_ring = m_cq_ring = 0;
+  m_sqes = 0;
+  m_operations.clear();
+  m_requests.clear();
+}
+
+void
+IoUring::prepare(ham_fd_t fd, bool write, const IoRequest *requests,
+                size_t count)
+{
+  ham_assert(count > 0);
+
+  Operation op;
+  op.fd = fd;
+  op.write = write;
+  op.address = requests[0].address;
+  op.first = m_requests.size();
+  op.count = count;
+  op.size = 0;
+  for (size_t i = 0; i < count; i++) {
+    ham_assert(i == 0 || requests[i].address
+                    == requests[i - 1].address + requests[i - 1].size);
+    op.size += requests[i].size;
+    m_requests.push_back(requests[i]);
+  }
+  m_operations.push_back(op);
+}
+
+void
+IoUring::submit()
+{
+  ham_assert(is_active());
+
+  std::vector<struct iovec> iov(m_requests.size());
+  for (size_t i = 0; i < m_requests.size(); i++) {
+    iov[i].iov_base = m_requests[i].buffer;
+    iov[i].iov_len = m_requests[i].size;
+  }
+
+  bool success = true;
+  for (size_t i = 0; i < m_operations.size(); i += m_entries) {
+    size_t count = std::min((size_t)m_entries, m_operations.size() - i);
+    if (!submit_range(i, count, &iov[0]))
+      success = false;
+  }
+
+  m_operations.clear();
+  m_requests.clear();
+
+  if (!success)
+    throw Exception(HAM_IO_ERROR);
+}
+
+bool
+IoUring::submit_range(size_t first, size_t count, void *iov)
+{
+  struct iovec *iovec = (struct iovec *)iov;
+
+  // fill the submission queue; this thread is the only producer
+  unsigned tail = *m_sq_tail;
+  unsigned mask = *m_sq_mask;
+  for (size_t i = first; i < first + count; i++, tail++) {
+    Operation &op = m_operations[i];
+    unsigned index = tail & mask;
+    struct io_uring_sqe *sqe = &m_sqes[index];
+    ::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = op.write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = op.fd;
+    sqe->off = op.address;
+    sqe->addr = (uint64_t)(uintptr_t)&iovec[op.first];
+    sqe->len = (uint32_t)op.count;
+    sqe->user_data = i;
+    m_sq_array[index] = index;
+  }
+  __atomic_store_n(m_sq_tail, tail, __ATOMIC_RELEASE);
+
+  // submit and reap the completions
+  bool success = true;
+  size_t to_submit = count;
+  size_t completed = 0;
+  while (completed < count) {
+    int r = (int)::syscall(__NR_io_uring_enter, m_ring_fd, to_submit,
+                    count - completed, IORING_ENTER_GETEVENTS, 0, 0);
+    if (r < 0) {
+      if (errno == EINTR)
+        continue;
+      ham_log(("io_uring_enter failed with status %u (%s)", errno,
+                  strerror(errno)));
+      // the state of the ring is unknown; release it. Afterwards the
+      // caller falls back to synchronous I/O.
+      close();
+      throw Exception(HAM_IO_ERROR);
+    }
+    to_submit -= std::min(to_submit, (size_t)r);
+
+    unsigned head = *m_cq_head;
+    unsigned cq_tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != cq_tail; head++, completed++) {
+      struct io_uring_cqe *cqe = &m_cqes[head & *m_cq_mask];
+      Operation &op = m_operations[(size_t)cqe->user_data];
+      if (cqe->res < 0) {
+        ham_log(("%s failed with status %u (%s)",
+                    op.write ? "writev" : "readv", -cqe->res,
+                    strerror(-cqe->res)));
+        success = false;
+      }
+      else if ((size_t)cqe->res != op.size) {
+        ham_log(("%s failed with short %s", op.write ? "writev" : "readv",
+                    op.write ? "write" : "read"));
+        success = false;
+      }
+    }
+    __atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+  }
+
+  return (success);
+}
+
+#else /* !HAM_HAVE_IO_URING */
+
+bool
+IoUring::setup(uint32_t entries)
+{
+  return (false);
+}
+
+void
+IoUring::close()
+{
+}
+
+void
+IoUring::prepare(ham_fd_t fd, bool write, const IoRequest *requests,
+                size_t count)
+{
+  throw Exception(HAM_NOT_IMPLEMENTED);
+}
+
+void
+IoUring::submit()
+{
+  throw Exception(HAM_NOT_IMPLEMENTED);
+}
+
+bool
+IoUring::submit_range(size_t first, size_t count, void *iov)
+{
+  return (false);
+}
+
+#endif /* HAM_HAVE_IO_URING */
+
+} // namespace hamsterdb
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2005-2015 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A minimal wrapper for Linux' io_uring, based on the raw system calls.
+ * Requests are queued with |prepare| and submitted with |submit|, which
+ * waits till all of them are completed.
+ *
+ * On other platforms (or if the kernel does not support io_uring)
+ * |setup| returns false, and the caller falls back to synchronous I/O.
+ *
+ * @exception_safe: basic
+ * @thread_safe: no
+ */
+
+#ifndef HAM_URING_H
+#define HAM_URING_H
+
+#include "0root/root.h"
+
+#include <vector>
+
+#include "ham/types.h"
+
+// Always verify that a file of level N does not include headers > N!
+#include "1os/file.h"
+
+#ifndef HAM_ROOT_H
+#  error "root.h was not included"
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#  if __has_include(<linux/io_uring.h>)
+#    define HAM_HAVE_IO_URING 1
+#  endif
+#endif
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace hamsterdb {
+
+class IoUring
+{
+    // A queued (vectored) request
+    struct Operation {
+      // the file handle
+      ham_fd_t fd;
+
+      // true for a write, false for a read
+      bool write;
+
+      // the file offset
+      uint64_t address;
+
+      // index of the first buffer in |m_requests|
+      size_t first;
+
+      // number of buffers
+      size_t count;
+
+      // the total number of bytes
+      size_t size;
+    };
+
+  public:
+    // Constructor; the ring is not yet initialized
+    IoUring();
+
+    // Destructor; releases the ring
+    ~IoUring() {
+      close();
+    }
+
+    // Initializes the ring with up to |entries| submission slots. Returns
+    // false if io_uring is not supported.
+    bool setup(uint32_t entries);
+
+    // Returns true if the ring was initialized
+    bool is_active() const {
+      return (m_ring_fd >= 0);
+    }
+
+    // Releases the ring; queued requests are discarded
+    void close();
+
+    // Queues a read or write of |count| buffers; the buffers are adjacent
+    // in the file and transferred with a single vectored request, starting
+    // at the file offset of |requests[0]|. The buffers must remain valid
+    // till |submit| returns.
+    void prepare(ham_fd_t fd, bool write, const IoRequest *requests,
+                    size_t count);
+
+    // Submits all queued requests and waits till they are completed.
+    // Throws HAM_IO_ERROR if a request failed or was incomplete.
+    void submit();
+
+  private:
+    // Submits the operations [first, first + count) and waits for their
+    // completion; |iov| are the buffers of all queued operations. Returns
+    // false if one of the operations failed.
+    bool submit_range(size_t first, size_t count, void *iov);
+
+    // Disallow copying
+    IoUring(const IoUring &);
+    IoUring &operator=(const IoUring &);
+
+    // the io_uring file descriptor
+    int m_ring_fd;
+
+    // the number of submission slots
+    uint32_t m_entries;
+
+    // the mapped submission and completion rings; both are identical if
+    // the kernel supports IORING_FEAT_SINGLE_MMAP
+    void *m_sq_ring;
+    size_t m_sq_ring_size;
+    void *m_cq_ring;
+    size_t m_cq_ring_size;
+
+    // the mapped submission queue entries
+    io_uring_sqe *m_sqes;
+    size_t m_sqes_size;
+
+    // pointers into the submission ring
+    unsigned *m_sq_tail;
+    unsigned *m_sq_mask;
+    unsigned *m_sq_array;
+
+    // pointers into the completion ring
+    unsigned *m_cq_head;
+    unsigned *m_cq_tail;
+    unsigned *m_cq_mask;
+    io_uring_cqe *m_cqes;
+
+    // the queued operations
+    std::vector<Operation> m_operations;
+
+    // the buffers of the queued operations
+    std::vector<IoRequest> m_requests;
+};
+
+} // namespace hamsterdb
+
+#endif /* HAM_URING_H */
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2005-2015 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Abstract base class for compressors. A compressor is created with the
+ * CompressorFactory.
+ *
+ * @exception_safe: strong
+ * @thread_safe: no; decompress() is thread safe
+ */
+
+#ifndef HAM_COMPRESSOR_H
+#define HAM_COMPRESSOR_H
+
+#include "0root/root.h"
+
+#include "ham/types.h"
+
+// Always verify that a file of level N does not include headers > N!
+#include "1base/dynamic_array.h"
+#include "1base/error.h"
+
+#ifndef HAM_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace hamsterdb {
+
+class Compressor
+{
+  public:
+    virtual ~Compressor() {
+    }
+
+    // Compresses |length| bytes of |data|. The compressed data is stored
+    // in |arena|. Returns the compressed length, or 0 if the compressed
+    // data would not be smaller than the original data.
+    uint32_t compress(const uint8_t *data, uint32_t length, ByteArray *arena) {
+      if (length < 2)
+        return (0);
+      uint8_t *out = arena->resize(length - 1);
+      return (do_compress(data, length, out, length - 1));
+    }
+
+    // Decompresses |length| bytes of |data| to |out|. |out_length| is the
+    // size of the original data; |out| must be large enough to hold it.
+    // Throws HAM_INTEGRITY_VIOLATED if the data is corrupt.
+    void decompress(const uint8_t *data, uint32_t length, uint8_t *out,
+                    uint32_t out_length) const {
+      if (!do_decompress(data, length, out, out_length)) {
+        ham_log(("failed to decompress %u bytes", length));
+        throw Exception(HAM_INTEGRITY_VIOLATED);
+      }
+    }
+
+  protected:
+    // Compresses |length| bytes of |data| to |out|, which has room for
+    // |out_length| bytes. Returns the compressed length, or 0 if |out| is
+    // too small.
+    virtual uint32_t do_compress(const uint8_t *data, uint32_t length,
+                    uint8_t *out, uint32_t out_length) = 0;
+
+    // Decompresses |length| bytes of |data| to |out|. Returns false if the
+    // data is corrupt or does not decompress to exactly |out_length| bytes.
+    virtual bool do_decompress(const uint8_t *data, uint32_t length,
+                    uint8_t *out, uint32_t out_length) const = 0;
+};
+
+} // namespace hamsterdb
+
+#endif /* HAM_COMPRESSOR_H */
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2005-2015 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A factory for compressors. New algorithms are added here.
+ *
+ * @exception_safe: strong
+ * @thread_safe: yes
+ */
+
+#ifndef HAM_COMPRESSOR_FACTORY_H
+#define HAM_COMPRESSOR_FACTORY_H
+
+#include "0root/root.h"
+
+#include "ham/hamsterdb.h"
+
+// Always verify that a file of level N does not include headers > N!
+#include "2compressor/compressor.h"
+#include "2compressor/compressor_lzf.h"
+
+#ifndef HAM_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace hamsterdb {
+
+struct CompressorFactory {
+  // Returns true if the compression algorithm |algo| is available
+  static bool is_available(int algo) {
+    switch (algo) {
+      case HAM_COMPRESSOR_LZF:
+        return (true);
+      default:
+        return (false);
+    }
+  }
+
+  // Creates a new Compressor instance for the algorithm |algo|; returns
+  // null if the algorithm is not available
+  static Compressor *create(int algo) {
+    switch (algo) {
+      case HAM_COMPRESSOR_LZF:
+        return (new LzfCompressor());
+      default:
+        return (0);
+    }
+  }
+};
+
+} // namespace hamsterdb
+
+#endif /* HAM_COMPRESSOR_FACTORY_H */
@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2005-2015 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A compressor for the LZF format (http://oldhome.schmorp.de/marc/liblzf.html).
+ * LZF is a very fast LZ77 variant; it trades compression ratio for speed.
+ *
+ * The compressed data is a sequence of runs. Each run starts with a
+ * control byte:
+ *
+ *   000LLLLL             a literal run of L + 1 bytes (1..32) follows
+ *   LLLooooo oooooooo    a back reference of L + 2 bytes (3..8)
+ *   111ooooo LLLLLLLL oooooooo
+ *                        a back reference of L + 9 bytes (9..264)
+ *
+ * The offset of a back reference is relative to the current output
+ * position minus 1 (up to 8192 bytes).
+ *
+ * @exception_safe: nothrow
+ * @thread_safe: no; do_decompress() is thread safe
+ */
+
+#ifndef HAM_COMPRESSOR_LZF_H
+#define HAM_COMPRESSOR_LZF_H
+
+#include "0root/root.h"
+
+#include <string.h>
+
+// Always verify that a file of level N does not include headers > N!
+#include "2compressor/compressor.h"
+
+#ifndef HAM_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace hamsterdb {
+
+class LzfCompressor : public Compressor
+{
+  enum {
+    // log2 of the size of the hash table
+    kHashLog = 14,
+
+    // size of the hash table
+    kHashSize = 1 << kHashLog,
+
+    // the longest literal run
+    kMaxLiteral = 32,
+
+    // the longest back reference
+    kMaxMatch = 264,
+
+    // the largest offset of a back reference
+    kMaxOffset = 8192
+  };
+
+  public:
+    LzfCompressor() {
+      m_table.resize(kHashSize);
+    }
+
+  protected:
+    virtual uint32_t do_compress(const uint8_t *data, uint32_t length,
+                    uint8_t *out, uint32_t out_length) {
+      // the table stores the position + 1 of the last occurrence of
+      // each 3-byte sequence; 0 is an empty slot
+      uint32_t *table = m_table.get_ptr();
+      ::memset(table, 0, kHashSize * sizeof(uint32_t));
+
+      uint32_t ip = 0;
+      uint32_t op = 1; // reserve space for the first control byte
+      uint32_t lit = 0;
+
+      if (out_length < 2)
+        return (0);
+
+      while (ip + 2 < length) {
+        uint32_t h = hash(&data[ip]);
+        uint32_t ref = table[h];
+        table[h] = ip + 1;
+
+        if (ref > 0
+              && ip - ref < kMaxOffset
+              && data[ref - 1] == data[ip]
+              && data[ref] == data[ip + 1]
+              && data[ref + 1] == data[ip + 2]) {
+          const uint8_t *p = &data[ref - 1];
+          uint32_t off = ip - ref;
+          uint32_t max = length - ip;
+          if (max > kMaxMatch)
+            max = kMaxMatch;
+          uint32_t len = 3;
+          while (len < max && p[len] == data[ip + len])
+            len++;
+
+          // a back reference requires up to 3 bytes, and the next literal
+          // run needs a control byte
+          if (op + 3 + 1 > out_length)
+            return (0);
+
+          // close the current literal run; if it is empty then remove its
+          // control byte
+          if (lit)
+            out[op - lit - 1] = (uint8_t)(lit - 1);
+          else
+            op--;
+
+          len -= 2;
+          if (len < 7)
+            out[op++] = (uint8_t)((off >> 8) + (len << 5));
+          else {
+            out[op++] = (uint8_t)((off >> 8) + (7 << 5));
+            out[op++] = (uint8_t)(len - 7);
+          }
+          out[op++] = (uint8_t)off;
+          len += 2;
+
+          // start a new literal run
+          lit = 0;
+          op++;
+
+          // add the positions of the match to the hash table
+          for (uint32_t i = 1; i < len && ip + i + 2 < length; i++)
+            table[hash(&data[ip + i])] = ip + i + 1;
+          ip += len;
+          continue;
+        }
+
+        if (!append_literal(data[ip++], out, out_length, &op, &lit))
+          return (0);
+      }
+
+      // the remaining bytes are literals
+      while (ip < length) {
+        if (!append_literal(data[ip++], out, out_length, &op, &lit))
+          return (0);
+      }
+
+      // close the last literal run
+      if (lit)
+        out[op - lit - 1] = (uint8_t)(lit - 1);
+      else
+        op--;
+      return (op);
+    }
+
+    virtual bool do_decompress(const uint8_t *data, uint32_t length,
+                    uint8_t *out, uint32_t out_length) const {
+      uint32_t ip = 0;
+      uint32_t op = 0;
+
+      while (ip < length) {
+        uint32_t ctrl = data[ip++];
+
+        // literal run
+        if (ctrl < kMaxLiteral) {
+          ctrl++;
+          if (op + ctrl > out_length || ip + ctrl > length)
+            return (false);
+          ::memcpy(&out[op], &data[ip], ctrl);
+          op += ctrl;
+          ip += ctrl;
+          continue;
+        }
+
+        // back reference
+        uint32_t len = ctrl >> 5;
+        if (len == 7) {
+          if (ip >= length)
+            return (false);
+          len += data[ip++];
+        }
+        if (ip >= length)
+          return (false);
+        uint32_t off = ((ctrl & 0x1f) << 8) + data[ip++] + 1;
+        len += 2;
+        if (off > op || op + len > out_length)
+          return (false);
+
+        // the source and destination can overlap; copy byte by byte
+        const uint8_t *ref = &out[op - off];
+        for (uint32_t i = 0; i < len; i++)
+          out[op + i] = ref[i];
+        op += len;
+      }
+
+      return (op == out_length);
+    }
+
+  private:
+    // Returns the hash of the 3 bytes at |p|
+    static uint32_t hash(const uint8_t *p) {
+      uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+      return (((v * 2654435761u) >> (32 - kHashLog)) & (kHashSize - 1));
+    }
+
+    // Appends a literal byte; starts a new run if the current run is full
+    static bool append_literal(uint8_t c, uint8_t *out, uint32_t out_length,
+                    uint32_t *op, uint32_t *lit) {
+      if (*op >= out_length)
+        return (false);
+      out[(*op)++] = c;
+      if (++(*lit) == kMaxLiteral) {
+        out[*op - kMaxLiteral - 1] = (uint8_t)(kMaxLiteral - 1);
+        *lit = 0;
+        (*op)++;
+      }
+      return (true);
+    }
+
+    // The hash table
+    DynamicArray<uint32_t> m_table;
+};
+
+} // namespace hamsterdb
+
+#endif /* HAM_COMPRESSOR_LZF_H */
@@ -42,7 +42,7 @@ struct DatabaseConfiguration
   DatabaseConfiguration()
     : db_name(0), flags(0), key_type(HAM_TYPE_BINARY),
       key_size(HAM_KEY_SIZE_UNLIMITED), record_size(HAM_RECORD_SIZE_UNLIMITED),
-      key_compressor(0), record_compressor(0) {
+      key_compressor(0), record_compressor(0), inline_record_threshold(0) {
   }
 
   // the database name
@@ -66,6 +66,9 @@ struct DatabaseConfiguration
   // the algorithm for record compression
   int record_compressor;
 
+  // variable length records up to this size are stored in the leaf
+  size_t inline_record_threshold;
+
 };
 
 } // namespace hamsterdb
@@ -51,7 +51,13 @@ struct EnvironmentConfiguration
       file_size_limit_bytes(std::numeric_limits<size_t>::max()), 
       remote_timeout_sec(0), journal_compressor(0),
       is_encryption_enabled(false), journal_switch_threshold(0),
-      posix_advice(HAM_POSIX_FADVICE_NORMAL) {
+      posix_advice(HAM_POSIX_FADVICE_NORMAL),
+      cache_policy(HAM_CACHE_POLICY_LRU), readahead_pages(0),
+      journal_commit_window(0), simd_search(HAM_SIMD_AUTO),
+      linear_search_threshold(0), io_backend(HAM_IO_BACKEND_POSIX),
+      flush_workers(1), flush_stall_percent(50),
+      checkpoint_dirty_percent(0), checkpoint_age_limit(0),
+      mmap_reserve_bytes(0) {
   }
 
   // the environment's flags
@@ -95,6 +101,44 @@ struct EnvironmentConfiguration
 
   // parameter for posix_fadvise()
   int posix_advice;
+
+  // the replacement policy of the cache (HAM_CACHE_POLICY_*)
+  int cache_policy;
+
+  // the number of leaf pages which are read ahead
+  size_t readahead_pages;
+
+  // the time window for group commits, in microseconds (0: disabled)
+  uint32_t journal_commit_window;
+
+  // the instruction set for searching numeric keys (HAM_SIMD_*)
+  int simd_search;
+
+  // switch from binary search to linear search if less than this number
+  // of keys are left (0: use the default)
+  size_t linear_search_threshold;
+
+  // the I/O backend of the DiskDevice (HAM_IO_BACKEND_*)
+  int io_backend;
+
+  // the number of threads which flush dirty pages
+  int flush_workers;
+
+  // stall writers if this percentage of the cache is waiting to be
+  // flushed (0: never stall)
+  int flush_stall_percent;
+
+  // the checkpointer writes dirty pages if they exceed this percentage
+  // of the cache (0: disabled)
+  int checkpoint_dirty_percent;
+
+  // the checkpointer writes pages which are dirty for longer than this
+  // time, in milliseconds (0: disabled)
+  uint32_t checkpoint_age_limit;
+
+  // the size of the address space which is reserved for mapping the
+  // file (0: only the file size at open time is mapped)
+  uint64_t mmap_reserve_bytes;
 };
 
 } // namespace hamsterdb
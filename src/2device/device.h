@@ -30,6 +30,7 @@
 #include "ham/hamsterdb.h"
 
 // Always verify that a file of level N does not include headers > N!
+#include "1os/file.h"
 #include "2config/env_config.h"
 
 #ifndef HAM_ROOT_H
@@ -51,6 +52,11 @@ class Device {
     virtual ~Device() {
     }
 
+    // Returns the Environment's configuration
+    const EnvironmentConfiguration &config() const {
+      return (m_config);
+    }
+
     // Returns the current page size
     size_t page_size() const {
       return (m_config.page_size_bytes);
@@ -89,6 +95,20 @@ class Device {
     // Writes to the device; this function does not use mmap
     virtual void write(uint64_t offset, void *buffer, size_t len) = 0;
 
+    // Reads a batch of buffers from the device; the default implementation
+    // reads them one by one. This function does not use mmap.
+    virtual void read_batch(IoRequest *requests, size_t count) {
+      for (size_t i = 0; i < count; i++)
+        read(requests[i].address, requests[i].buffer, requests[i].size);
+    }
+
+    // Writes a batch of buffers to the device; the default implementation
+    // writes them one by one. This function does not use mmap.
+    virtual void write_batch(IoRequest *requests, size_t count) {
+      for (size_t i = 0; i < count; i++)
+        write(requests[i].address, requests[i].buffer, requests[i].size);
+    }
+
     // Allocate storage from this device; this function
     // will *NOT* use mmap. returns the offset of the allocated storage.
     virtual uint64_t alloc(size_t len) = 0;
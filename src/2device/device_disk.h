@@ -28,6 +28,8 @@
 
 #include "0root/root.h"
 
+#include <algorithm>
+
 // Always verify that a file of level N does not include headers > N!
 #include "1os/file.h"
 #include "1mem/mem.h"
@@ -54,6 +56,10 @@ class DiskDevice : public Device {
       // the size of mmapptr as used in mmap
       uint64_t mapped_size;
 
+      // the size of the reserved address space (see
+      // HAM_PARAM_MMAP_RESERVE); 0 if no address space is reserved
+      uint64_t reserved_size;
+
       // the (cached) size of the file
       uint64_t file_size;
 
@@ -67,6 +73,7 @@ class DiskDevice : public Device {
       State state;
       state.mmapptr = 0;
       state.mapped_size = 0;
+      state.reserved_size = 0;
       state.file_size = 0;
       state.excess_at_end = 0;
       std::swap(m_state, state);
@@ -74,10 +81,17 @@ class DiskDevice : public Device {
 
     // Create a new device
     virtual void create() {
-      File file;
-      file.create(m_config.filename.c_str(), m_config.file_mode);
-      file.set_posix_advice(m_config.posix_advice);
-      m_state.file = file;
+      State state = m_state;
+      state.file.create(m_config.filename.c_str(), m_config.file_mode);
+      state.file.set_posix_advice(m_config.posix_advice);
+      state.file_size = 0;
+
+      // the file is empty; the mapping grows with the file
+      if (use_mmap() && use_mmap_reserve()) {
+        state.reserved_size = get_reserve_size();
+        File::reserve_address_space(state.reserved_size, &state.mmapptr);
+      }
+      std::swap(m_state, state);
     }
 
     // opens an existing device
@@ -93,11 +107,21 @@ class DiskDevice : public Device {
       // the file size which backs the mapped ptr
       state.file_size = state.file.get_file_size();
 
-      if (m_config.flags & HAM_DISABLE_MMAP) {
+      if (!use_mmap()) {
         std::swap(m_state, state);
         return;
       }
 
+      // reserve the address space and map as much of the file as possible;
+      // the mapping is extended when the file grows
+      if (use_mmap_reserve()) {
+        state.reserved_size = get_reserve_size();
+        File::reserve_address_space(state.reserved_size, &state.mmapptr);
+        std::swap(m_state, state);
+        resize_mapping();
+        return;
+      }
+
       // make sure we do not exceed the "real" size of the file, otherwise
       // we crash when accessing memory which exceeds the mapping (at least
       // on Win32)
@@ -120,9 +144,14 @@ class DiskDevice : public Device {
     // closes the device
     virtual void close() {
       State state = m_state;
-      if (state.mmapptr)
+      if (state.reserved_size)
+        state.file.munmap(state.mmapptr, state.reserved_size);
+      else if (state.mmapptr)
         state.file.munmap(state.mmapptr, state.mapped_size);
       state.file.close();
+      state.mmapptr = 0;
+      state.mapped_size = 0;
+      state.reserved_size = 0;
 
       std::swap(m_state, state);
     }
@@ -138,6 +167,8 @@ class DiskDevice : public Device {
         throw Exception(HAM_LIMITS_REACHED);
       m_state.file.truncate(new_file_size);
       m_state.file_size = new_file_size;
+      if (m_state.reserved_size)
+        resize_mapping();
     }
 
     // get the current file/storage size
@@ -168,6 +199,28 @@ class DiskDevice : public Device {
       m_state.file.pwrite(offset, buffer, len);
     }
 
+    // Writes a batch of buffers; the requests are sorted by address (in
+    // place), and runs of adjacent requests are written with a single
+    // vectored write
+    virtual void write_batch(IoRequest *requests, size_t count) {
+      std::sort(requests, requests + count, IoRequestComparator());
+
+      size_t first = 0;
+      for (size_t i = 1; i <= count; i++) {
+        if (i < count && i - first < File::kMaxBuffers
+                && requests[i].address
+                      == requests[i - 1].address + requests[i - 1].size)
+          continue;
+        if (i - first == 1)
+          m_state.file.pwrite(requests[first].address,
+                          requests[first].buffer, requests[first].size);
+        else
+          m_state.file.pwritev(requests[first].address, &requests[first],
+                          i - first);
+        first = i;
+      }
+    }
+
     // allocate storage from this device; this function
     // will *NOT* return mmapped memory
     virtual uint64_t alloc(size_t len) {
@@ -225,24 +278,33 @@ class DiskDevice : public Device {
 
       // this page is not in the mapped area; allocate a buffer
       if (page->get_data() == 0) {
-        // note that |p| will not leak if file.pread() throws; |p| is stored
+        // note that |p| will not leak if read() throws; |p| is stored
         // in the |page| object and will be cleaned up by the caller in
         // case of an exception.
-        uint8_t *p = Memory::allocate<uint8_t>(m_config.page_size_bytes);
+        uint8_t *p = allocate_page_buffer();
         page->assign_allocated_buffer(p, address);
       }
 
-      m_state.file.pread(address, page->get_data(), m_config.page_size_bytes);
+      read(address, page->get_data(), m_config.page_size_bytes);
     }
 
     // Allocates storage for a page from this device; this function
-    // will *NOT* return mmapped memory
+    // only returns mmapped memory if the address space was reserved
     virtual void alloc_page(Page *page) {
       uint64_t address = alloc(m_config.page_size_bytes);
       page->set_address(address);
 
+      // the mapping grows with the file; pages in the mapped area must
+      // use the mapped memory, otherwise read_page() would return stale
+      // data after the page was flushed and purged from the cache
+      if (m_state.reserved_size
+            && address + m_config.page_size_bytes <= m_state.mapped_size) {
+        page->assign_mapped_buffer(&m_state.mmapptr[address], address);
+        return;
+      }
+
       // allocate a memory buffer
-      uint8_t *p = Memory::allocate<uint8_t>(m_config.page_size_bytes);
+      uint8_t *p = allocate_page_buffer();
       page->assign_allocated_buffer(p, address);
     }
 
@@ -263,7 +325,60 @@ class DiskDevice : public Device {
         truncate(m_state.file_size - m_state.excess_at_end);
     }
 
-  private:
+  protected:
+    // Returns true if the file is mapped when it is opened
+    virtual bool use_mmap() const {
+      return ((m_config.flags & HAM_DISABLE_MMAP) == 0);
+    }
+
+    // Returns true if the address space is reserved and the mapping grows
+    // with the file. Requires pages which are a multiple of the OS page
+    // size; otherwise a mapped page and a page which is written with
+    // pwrite() could share the same (copy-on-write) OS page.
+    bool use_mmap_reserve() const {
+#ifdef WIN32
+      return (false);
+#else
+      return (get_reserve_size() > 0
+              && (m_config.flags & HAM_READ_ONLY) == 0
+              && m_config.page_size_bytes % File::get_granularity() == 0);
+#endif
+    }
+
+    // Returns the size of the reserved address space, rounded down to
+    // the allocation granularity
+    size_t get_reserve_size() const {
+      size_t granularity = File::get_granularity();
+      return ((size_t)(m_config.mmap_reserve_bytes
+                  - m_config.mmap_reserve_bytes % granularity));
+    }
+
+    // Extends (or shrinks) the mapping in the reserved address space to
+    // the current file size
+    void resize_mapping() {
+      uint64_t end = m_state.file_size
+                - m_state.file_size % File::get_granularity();
+      if (end > m_state.reserved_size)
+        end = m_state.reserved_size;
+
+      if (end > m_state.mapped_size) {
+        m_state.file.mmap_fixed(&m_state.mmapptr[m_state.mapped_size],
+                        m_state.mapped_size, end - m_state.mapped_size,
+                        false);
+        m_state.mapped_size = end;
+      }
+      else if (end < m_state.mapped_size) {
+        File::release_address_space(&m_state.mmapptr[end],
+                        m_state.mapped_size - end);
+        m_state.mapped_size = end;
+      }
+    }
+
+    // Allocates the memory buffer of a page
+    virtual uint8_t *allocate_page_buffer() {
+      return (Memory::allocate<uint8_t>(m_config.page_size_bytes));
+    }
+
     State m_state;
 };
 
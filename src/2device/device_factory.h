@@ -30,6 +30,7 @@
 #include "2config/env_config.h"
 #include "2device/device_disk.h"
 #include "2device/device_inmem.h"
+#include "2device/device_uring.h"
 
 #ifndef HAM_ROOT_H
 #  error "root.h was not included"
@@ -42,8 +43,9 @@ struct DeviceFactory {
   static Device *create(const EnvironmentConfiguration &config) {
     if (config.flags & HAM_IN_MEMORY)
       return (new InMemoryDevice(config));
-    else
-      return (new DiskDevice(config));
+    if (config.io_backend != HAM_IO_BACKEND_POSIX)
+      return (new UringDevice(config));
+    return (new DiskDevice(config));
   }
 };
 
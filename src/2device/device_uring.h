@@ -0,0 +1,229 @@
+/*
+ * Copyright (C) 2005-2015 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Device-implementation for disk-based files, based on Linux' io_uring.
+ * Batches of reads and writes are submitted with a single system call;
+ * adjacent pages are transferred with a single vectored request.
+ *
+ * With HAM_IO_BACKEND_URING_DIRECT, aligned pages are read and written
+ * through a second file handle which was opened with O_DIRECT. All other
+ * requests (e.g. blobs, or page copies which are not aligned) use the
+ * buffered file handle of the DiskDevice.
+ *
+ * If io_uring is not available then the DiskDevice's synchronous I/O
+ * is used.
+ *
+ * @exception_safe: basic/strong
+ * @thread_safe: yes (for the batch functions)
+ */
+
+#ifndef HAM_DEVICE_URING_H
+#define HAM_DEVICE_URING_H
+
+#include "0root/root.h"
+
+#include <vector>
+#include <algorithm>
+
+// Always verify that a file of level N does not include headers > N!
+#include "1base/mutex.h"
+#include "1os/file.h"
+#include "1os/uring.h"
+#include "1mem/mem.h"
+#include "2device/device_disk.h"
+
+#ifndef HAM_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace hamsterdb {
+
+/*
+ * a File-based device using io_uring
+ */
+class UringDevice : public DiskDevice {
+    enum {
+      // the number of submission slots of the ring
+      kRingEntries = 64,
+
+      // the alignment of O_DIRECT requests (addresses, sizes and buffers)
+      kDirectAlignment = 4096
+    };
+
+  public:
+    UringDevice(const EnvironmentConfiguration &config)
+      : DiskDevice(config) {
+    }
+
+    // Create a new device
+    virtual void create() {
+      DiskDevice::create();
+      setup();
+    }
+
+    // opens an existing device
+    virtual void open() {
+      DiskDevice::open();
+      setup();
+    }
+
+    // closes the device
+    virtual void close() {
+      {
+        ScopedLock lock(m_mutex);
+        m_ring.close();
+      }
+      m_direct_file.close();
+      DiskDevice::close();
+    }
+
+    // Returns true if io_uring is used
+    bool is_ring_active() {
+      ScopedLock lock(m_mutex);
+      return (m_ring.is_active());
+    }
+
+    // Returns true if O_DIRECT is used
+    bool is_direct() const {
+      return (m_direct_file.is_open());
+    }
+
+    // reads from the device; this function does NOT use mmap
+    virtual void read(uint64_t offset, void *buffer, size_t len) {
+      if (is_aligned(offset, buffer, len))
+        m_direct_file.pread(offset, buffer, len);
+      else
+        DiskDevice::read(offset, buffer, len);
+    }
+
+    // writes to the device; this function does not use mmap
+    virtual void write(uint64_t offset, void *buffer, size_t len) {
+      if (is_aligned(offset, buffer, len))
+        m_direct_file.pwrite(offset, buffer, len);
+      else
+        DiskDevice::write(offset, buffer, len);
+    }
+
+    // Reads a batch of buffers with a single submission
+    virtual void read_batch(IoRequest *requests, size_t count) {
+      submit(false, requests, count);
+    }
+
+    // Writes a batch of buffers with a single submission
+    virtual void write_batch(IoRequest *requests, size_t count) {
+      submit(true, requests, count);
+    }
+
+  protected:
+    // O_DIRECT does not go well with mmap
+    virtual bool use_mmap() const {
+      return (m_config.io_backend != HAM_IO_BACKEND_URING_DIRECT
+              && DiskDevice::use_mmap());
+    }
+
+    // O_DIRECT requires aligned buffers
+    virtual uint8_t *allocate_page_buffer() {
+      if (m_config.io_backend == HAM_IO_BACKEND_URING_DIRECT)
+        return (Memory::allocate_aligned<uint8_t>(m_config.page_size_bytes,
+                                kDirectAlignment));
+      return (DiskDevice::allocate_page_buffer());
+    }
+
+  private:
+    // Initializes the ring and (optionally) the O_DIRECT file handle
+    void setup() {
+      {
+        ScopedLock lock(m_mutex);
+        if (!m_ring.setup(kRingEntries))
+          ham_trace(("io_uring is not available; using synchronous I/O"));
+      }
+
+      if (m_config.io_backend == HAM_IO_BACKEND_URING_DIRECT) {
+        bool read_only = (m_config.flags & HAM_READ_ONLY) != 0;
+        if (!m_direct_file.open_direct(m_config.filename.c_str(), read_only))
+          ham_trace(("O_DIRECT is not available; using buffered I/O"));
+      }
+    }
+
+    // Returns true if a request can use the O_DIRECT file handle
+    bool is_aligned(uint64_t offset, const void *buffer, size_t len) const {
+      return (m_direct_file.is_open()
+              && offset % kDirectAlignment == 0
+              && len % kDirectAlignment == 0
+              && (uintptr_t)buffer % kDirectAlignment == 0);
+    }
+
+    // Returns true if |rhs| directly follows |lhs| and both use the same
+    // file handle
+    bool can_merge(const IoRequest &lhs, const IoRequest &rhs) const {
+      return (rhs.address == lhs.address + lhs.size
+              && is_aligned(lhs.address, lhs.buffer, lhs.size)
+                    == is_aligned(rhs.address, rhs.buffer, rhs.size));
+    }
+
+    // Sorts the requests by address and submits them; runs of adjacent
+    // requests are merged into a single vectored request
+    void submit(bool write, IoRequest *requests, size_t count) {
+      if (count == 0)
+        return;
+
+      ScopedLock lock(m_mutex);
+      if (!m_ring.is_active()) {
+        lock.unlock();
+        if (write)
+          Device::write_batch(requests, count);
+        else
+          Device::read_batch(requests, count);
+        return;
+      }
+
+      m_sorted.assign(requests, requests + count);
+      std::sort(m_sorted.begin(), m_sorted.end(), IoRequestComparator());
+
+      size_t first = 0;
+      for (size_t i = 1; i <= count; i++) {
+        if (i < count && i - first < File::kMaxBuffers
+                && can_merge(m_sorted[i - 1], m_sorted[i]))
+          continue;
+        const IoRequest &r = m_sorted[first];
+        ham_fd_t fd = is_aligned(r.address, r.buffer, r.size)
+                        ? m_direct_file.get_handle()
+                        : m_state.file.get_handle();
+        m_ring.prepare(fd, write, &m_sorted[first], i - first);
+        first = i;
+      }
+
+      m_ring.submit();
+    }
+
+    // the ring; protected by |m_mutex|, because pages are flushed by the
+    // worker thread and by the caller's thread
+    IoUring m_ring;
+
+    // a mutex for |m_ring| and |m_sorted|
+    Mutex m_mutex;
+
+    // the file handle for O_DIRECT; not open if O_DIRECT is not used
+    File m_direct_file;
+
+    // the sorted requests of the current batch
+    std::vector<IoRequest> m_sorted;
+};
+
+} // namespace hamsterdb
+
+#endif /* HAM_DEVICE_URING_H */
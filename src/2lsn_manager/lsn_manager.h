@@ -37,7 +37,7 @@ class LsnManager
   public:
     // Constructor
     LsnManager()
-      : m_state(1) {
+      : m_state(1), m_checkpoint(0) {
     }
 
     // Returns the next lsn
@@ -45,11 +45,26 @@ class LsnManager
       return (m_state++);
     }
 
+    // Returns the lsn of the last checkpoint; all modifications with an
+    // older lsn are persisted in the database file
+    uint64_t checkpoint() const {
+      return (m_checkpoint);
+    }
+
+    // Advances the checkpoint to |lsn|
+    void set_checkpoint(uint64_t lsn) {
+      if (lsn > m_checkpoint)
+        m_checkpoint = lsn;
+    }
+
   private:
     friend struct LsnManagerTest;
 
     // the actual lsn
     uint64_t m_state;
+
+    // the lsn of the last checkpoint
+    uint64_t m_checkpoint;
 };
 
 } // namespace hamsterdb
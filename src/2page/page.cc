@@ -17,8 +17,10 @@
 #include "0root/root.h"
 
 #include <string.h>
+#include <vector>
 
 #include "1base/error.h"
+#include "1base/crc32c.h"
 #include "1os/os.h"
 #include "2page/page.h"
 #include "2device/device.h"
@@ -26,18 +28,34 @@
 
 namespace hamsterdb {
 
-uint64_t Page::ms_page_count_flushed = 0;
+boost::atomic<uint64_t> Page::ms_page_count_flushed(0);
+LatencyHistogram Page::ms_fetch_latency;
+LatencyHistogram Page::ms_flush_latency;
+boost::atomic<uint64_t> Page::ms_page_checksums_computed(0);
+
+// Stores the checksum of a page which is about to be flushed
+static inline void
+store_checksum(Device *device, Page::PersistedData *page_data)
+{
+  if ((device->config().flags & HAM_ENABLE_CRC32)
+        && Page::has_checksum(page_data)) {
+    page_data->raw_data->header.crc32 = Page::calculate_checksum(page_data);
+    Page::ms_page_checksums_computed++;
+  }
+}
 
 Page::Page(Device *device, LocalDatabase *db)
   : m_device(device), m_db(db), m_is_allocated(false),
-    m_is_without_header(false), m_cursor_list(0),
-    m_node_proxy(0), m_datap(&m_data_inline)
+    m_cursor_list(0), m_changeset(0),
+    m_pin_count(0), m_node_proxy(0), m_datap(&m_data_inline)
 {
   ::memset(&m_prev[0], 0, sizeof(m_prev));
   ::memset(&m_next[0], 0, sizeof(m_next));
 
   m_data_inline.raw_data = 0;
   m_data_inline.is_dirty = false;
+  m_data_inline.is_without_header = false;
+  m_data_inline.is_aged = false;
   m_data_inline.address  = 0;
   m_data_inline.size     = device->page_size();
 }
@@ -72,6 +90,7 @@ Page::alloc(uint32_t type, uint32_t flags)
 void
 Page::fetch(uint64_t address)
 {
+  ScopedLatency latency(&ms_fetch_latency);
   m_device->read_page(this, address);
   set_address(address);
 }
@@ -80,12 +99,65 @@ void
 Page::flush(Device *device, PersistedData *page_data)
 {
   if (page_data->is_dirty) {
-    device->write(page_data->address, page_data->raw_data, page_data->size);
+    store_checksum(device, page_data);
+    {
+      ScopedLatency latency(&ms_flush_latency);
+      device->write(page_data->address, page_data->raw_data, page_data->size);
+    }
     page_data->is_dirty = false;
+    page_data->is_aged = false;
     ms_page_count_flushed++;
   }
 }
 
+void
+Page::flush(Device *device, std::vector<PersistedData *> &list)
+{
+  std::vector<IoRequest> requests;
+  requests.reserve(list.size());
+
+  std::vector<PersistedData *>::iterator it;
+  for (it = list.begin(); it != list.end(); ++it) {
+    PersistedData *page_data = *it;
+    if (page_data->is_dirty && page_data->raw_data != 0) {
+      store_checksum(device, page_data);
+      IoRequest request;
+      request.address = page_data->address;
+      request.buffer = page_data->raw_data;
+      request.size = page_data->size;
+      requests.push_back(request);
+    }
+  }
+
+  if (requests.empty())
+    return;
+
+  {
+    ScopedLatency latency(&ms_flush_latency);
+    device->write_batch(&requests[0], requests.size());
+  }
+
+  for (it = list.begin(); it != list.end(); ++it) {
+    PersistedData *page_data = *it;
+    if (page_data->is_dirty && page_data->raw_data != 0) {
+      page_data->is_dirty = false;
+      page_data->is_aged = false;
+    }
+  }
+  ms_page_count_flushed += requests.size();
+}
+
+uint32_t
+Page::calculate_checksum(const PersistedData *page_data)
+{
+  const uint8_t *p = page_data->raw_data->payload;
+  const size_t offset = OFFSETOF(PPageHeader, crc32);
+  const size_t skip = offset + sizeof(uint32_t);
+
+  uint32_t crc = crc32c(0, p, offset);
+  return (crc32c(crc, p + skip, page_data->size - skip));
+}
+
 Page::PersistedData *
 Page::deep_copy_data()
 {
@@ -118,6 +190,7 @@ Page::free_buffer()
     Memory::release(m_datap->raw_data);
 
   if (m_datap != &m_data_inline) {
+    m_data_inline.is_without_header = m_datap->is_without_header;
     delete m_datap;
     m_datap = &m_data_inline;
   }
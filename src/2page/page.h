@@ -23,15 +23,18 @@
 #define HAM_PAGE_H
 
 #include <string.h>
+#include <vector>
 #include <boost/atomic.hpp>
 
 #include "1base/error.h"
+#include "1base/latency_histogram.h"
 #include "1base/spinlock.h"
 #include "1mem/mem.h"
 
 namespace hamsterdb {
 
 class Device;
+class Changeset;
 class BtreeCursor;
 class BtreeNodeProxy;
 class LocalDatabase;
@@ -46,8 +49,9 @@ typedef HAM_PACK_0 struct HAM_PACK_1 PPageHeader {
   // flags of this page - currently only used for the Page::kType* codes
   uint32_t flags;
 
-  // reserved
-  uint32_t reserved;
+  // CRC32C checksum of the page; only used if the Environment was
+  // created with HAM_ENABLE_CRC32
+  uint32_t crc32;
 
   // the lsn of the last operation
   uint64_t lsn;
@@ -85,7 +89,7 @@ typedef HAM_PACK_0 union HAM_PACK_1 PPageData {
  * Each Page instance is a node in several linked lists.
  * In order to avoid multiple memory allocations, the previous/next pointers
  * are part of the Page class (m_prev and m_next). Both fields are arrays
- * of pointers and can be used i.e. with m_prev[Page::kListBucket] etc.
+ * of pointers and can be used i.e. with m_prev[Page::kListCache] etc.
  * (or with the methods defined below).
  */
 class Page {
@@ -104,6 +108,13 @@ class Page {
       // is this page dirty and needs to be flushed to disk?
       bool is_dirty;
 
+      // Page does not have a persistent header
+      bool is_without_header;
+
+      // set by the checkpointer if the page was already dirty when the
+      // previous checkpoint ran
+      bool is_aged;
+
       // the persistent data of this page
       PPageData *raw_data;
     };
@@ -125,8 +136,8 @@ class Page {
       // list of all pages in a changeset
       kListChangeset          = 1,
 
-      // a bucket in the hash table of the cache
-      kListBucket             = 2,
+      // list of "hot" cached pages (used by the 2Q replacement policy)
+      kListCacheHot           = 2,
 
       // array limit
       kListMax                = 3
@@ -197,6 +208,34 @@ class Page {
       return (m_datap->mutex);
     }
 
+    // Returns the Changeset which currently holds the lock of this page
+    // (or null)
+    Changeset *get_changeset() const {
+      return (m_changeset);
+    }
+
+    // Sets the Changeset which holds the lock of this page
+    void set_changeset(Changeset *changeset) {
+      m_changeset = changeset;
+    }
+
+    // Pins the page; a pinned page is not removed from the cache, even if
+    // it is not yet locked
+    void pin() {
+      m_pin_count++;
+    }
+
+    // Releases a pin
+    void unpin() {
+      ham_assert(m_pin_count > 0);
+      m_pin_count--;
+    }
+
+    // Returns true if the page is pinned
+    bool is_pinned() const {
+      return (m_pin_count.load() > 0);
+    }
+
     // Returns the device
     Device *device() {
       return (m_device);
@@ -225,6 +264,8 @@ class Page {
     // Sets this page dirty/not dirty
     void set_dirty(bool dirty) {
       m_datap->is_dirty = dirty;
+      if (!dirty)
+        m_datap->is_aged = false;
     }
 
     // Returns true if the page's buffer was allocated with malloc
@@ -234,12 +275,38 @@ class Page {
 
     // Returns true if the page has no persistent header
     bool is_without_header() const {
-      return (m_is_without_header);
+      return (m_datap->is_without_header);
     }
 
     // Sets a flag whether the page has no persistent header
     void set_without_header(bool without_header) {
-      m_is_without_header = without_header;
+      m_datap->is_without_header = without_header;
+    }
+
+    // Returns true if the page is protected by a checksum (if checksums
+    // are enabled). Blob pages are not protected.
+    static bool has_checksum(const PersistedData *page_data) {
+      if (page_data->is_without_header)
+        return (false);
+      switch (page_data->raw_data->header.flags) {
+        case kTypeHeader:
+        case kTypeBroot:
+        case kTypeBindex:
+        case kTypePageManager:
+          return (true);
+        default:
+          return (false);
+      }
+    }
+
+    // Calculates the checksum of the page; the checksum field itself is
+    // skipped
+    static uint32_t calculate_checksum(const PersistedData *page_data);
+
+    // Returns true if the stored checksum of the page is valid
+    bool verify_checksum() const {
+      return (m_datap->raw_data->header.crc32
+                      == calculate_checksum(m_datap));
     }
 
     // Assign a buffer which was allocated with malloc()
@@ -335,6 +402,11 @@ class Page {
     // Writes a page to the device
     static void flush(Device *device, PersistedData *page_data);
 
+    // Writes a batch of pages to the device with a single call to
+    // Device::write_batch; pages which are not dirty are skipped. The
+    // caller is responsible for locking the pages.
+    static void flush(Device *device, std::vector<PersistedData *> &list);
+
     // Writes the page to the device
     // TODO remove this
     void flush() {
@@ -412,8 +484,18 @@ class Page {
       m_node_proxy = proxy;
     }
 
-    // tracks number of flushed pages
-    static uint64_t ms_page_count_flushed;
+    // tracks number of flushed pages; pages are flushed by the worker
+    // thread and by the caller's thread
+    static boost::atomic<uint64_t> ms_page_count_flushed;
+
+    // tracks number of calculated checksums of flushed pages
+    static boost::atomic<uint64_t> ms_page_checksums_computed;
+
+    // the latencies of reading pages from the device
+    static LatencyHistogram ms_fetch_latency;
+
+    // the latencies of writing pages (or batches of pages) to the device
+    static LatencyHistogram ms_flush_latency;
 
   private:
     friend class PageCollection;
@@ -438,12 +520,15 @@ class Page {
     // with mmap)
     bool m_is_allocated;
 
-    // Page does not have a persistent header
-    bool m_is_without_header;
-
     // linked list of all cursors which are coupled to that page
     BtreeCursor *m_cursor_list;
 
+    // the Changeset which currently holds the lock of this page
+    Changeset *m_changeset;
+
+    // number of threads which are about to lock this page
+    boost::atomic<int> m_pin_count;
+
     // linked lists of pages - see comments above
     Page *m_prev[Page::kListMax];
     Page *m_next[Page::kListMax];
@@ -15,11 +15,13 @@
  */
 
 /*
- * A thread-safe message queue. Producers can insert at the front, Consumers
- * pick messages from the tail.
+ * A thread-safe message queue for many producers and a single consumer.
  *
- * The queue uses a Spinlock for synchronization, but locks it only very,
- * very briefly.
+ * Producers push messages to the head of a singly linked list with an
+ * atomic compare-and-swap; no lock is required. The consumer takes the
+ * whole list with a single atomic exchange and reverses it to restore the
+ * order of insertion. All messages of this batch are then handed out
+ * without further synchronization.
  */
 
 #ifndef HAM_QUEUE_H
@@ -27,10 +29,11 @@
 
 #include "0root/root.h"
 
+#include <boost/atomic.hpp>
+
 #include <ham/types.h>
 
 // Always verify that a file of level N does not include headers > N!
-#include "1base/spinlock.h"
 
 #ifndef HAM_ROOT_H
 #  error "root.h was not included"
@@ -49,7 +52,7 @@ struct MessageBase
   };
 
   MessageBase(int type_, int flags_)
-    : type(type_), flags(flags_), previous(0), next(0) {
+    : type(type_), flags(flags_), next(0) {
   }
 
   virtual ~MessageBase() {
@@ -57,7 +60,6 @@ struct MessageBase
 
   int type;
   int flags;
-  MessageBase *previous;
   MessageBase *next;
 };
 
@@ -76,54 +78,46 @@ class Queue
     };
 
     Queue()
-      : m_head(0), m_tail(0) {
+      : m_head(0), m_batch(0) {
     }
 
-    // Pushes a |message| object to the queue
+    // Pushes a |message| object to the queue; can be called by any thread
     void push(MessageBase *message) {
-      ScopedSpinlock lock(m_mutex);
-      if (!m_tail) {
-        ham_assert(m_head == 0);
-        m_head = m_tail = message;
-      }
-      else if (m_tail == m_head) {
-        m_tail->previous = message;
-        message->next = m_tail;
-        m_head = message;
-      }
-      else {
-        message->next = m_head;
-        m_head->previous = message;
-        m_head = message;
-      }
+      MessageBase *head = m_head.load(boost::memory_order_relaxed);
+      do {
+        message->next = head;
+      } while (!m_head.compare_exchange_weak(head, message));
     }
 
-    // Pops a message from the tail of the queue. Returns null if the queue
-    // is empty.
+    // Pops the oldest message from the queue. Returns null if the queue
+    // is empty. Must only be called by a single (consumer) thread at a time.
     MessageBase *pop() {
-      ScopedSpinlock lock(m_mutex);
-      if (!m_tail) {
-        ham_assert(m_head == 0);
-        return (0);
+      if (!m_batch) {
+        MessageBase *list = m_head.exchange(0);
+        while (list) {
+          MessageBase *next = list->next;
+          list->next = m_batch;
+          m_batch = list;
+          list = next;
+        }
+        if (!m_batch)
+          return (0);
       }
 
-      MessageBase *msg = m_tail;
-      if (m_tail == m_head)
-        m_head = m_tail = 0;
-      else
-        m_tail = m_tail->previous;
-      return (msg);
+      MessageBase *message = m_batch;
+      m_batch = message->next;
+      message->next = 0;
+      return (message);
     }
 
   private:
-    // For synchronization
-    Spinlock m_mutex;
-
-    // The head of the linked list (and newest MessageBase)
-    MessageBase *m_head;
+    // The head of the linked list (and newest MessageBase); shared by all
+    // threads
+    boost::atomic<MessageBase *> m_head;
 
-    // The tail of the linked list (and oldest MessageBase)
-    MessageBase *m_tail;
+    // The messages which were already taken from |m_head|, oldest first;
+    // only accessed by the consumer
+    MessageBase *m_batch;
 };
 
 } // namespace hamsterdb
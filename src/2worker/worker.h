@@ -25,6 +25,7 @@
 #include "0root/root.h"
 
 #include <boost/thread.hpp>
+#include <boost/atomic.hpp>
 
 // Always verify that a file of level N does not include headers > N!
 #include "2queue/queue.h"
@@ -40,14 +41,19 @@ class Worker
 {
   public:
     Worker()
-      : m_stop_requested(false), m_thread(&Worker::run, this) {
+      : m_stop_requested(false), m_sleeping(false),
+        m_thread(&Worker::run, this) {
     }
 
+    // Adds a message to the queue. The thread is only signalled if it is
+    // waiting for new messages.
     void add_to_queue(MessageBase *message) {
       m_queue.push(message);
 
-      ScopedLock lock(m_mutex);
-      m_cond.notify_one();
+      if (m_sleeping.load()) {
+        ScopedLock lock(m_mutex);
+        m_cond.notify_one();
+      }
     }
 
     void stop_and_join() {
@@ -59,35 +65,42 @@ class Worker
       m_thread.join();
     }
 
+  protected:
+    // Releases a message after it was handled; can be overridden to
+    // recycle message objects
+    virtual void release_message(MessageBase *message) {
+      delete message;
+    }
+
   private:
     // The thread function
     void run() {
-      MessageBase *message = 0;
+      MessageBase *message;
 
       while (true) {
-        {
+        message = m_queue.pop();
+
+        // no message available? then wait for the next one. |m_sleeping| is
+        // set before the queue is checked again; a producer which does not
+        // see the flag pushed its message before the check.
+        if (!message) {
           ScopedLock lock(m_mutex);
-          if (m_stop_requested)
-            break;
-          message = m_queue.pop();
-          if (!message) {
+          m_sleeping.store(true);
+          while (!m_stop_requested && !(message = m_queue.pop()))
             m_cond.wait(lock); // will unlock m_mutex while waiting
-            message = m_queue.pop();
-          }
+          m_sleeping.store(false);
+          if (!message)
+            break;
         }
 
-        do {
-          if (message) {
-            handle_message(message);
-            delete message;
-          }
-        } while ((message = m_queue.pop()));
+        handle_message(message);
+        release_message(message);
       }
 
       // pick up remaining messages
       while ((message = m_queue.pop())) {
         handle_message(message);
-        delete message;
+        release_message(message);
       }
     }
 
@@ -100,6 +113,9 @@ class Worker
     // true if the Environment is closed
     bool m_stop_requested;
 
+    // true if the thread is waiting for new messages
+    boost::atomic<bool> m_sleeping;
+
     // A mutex for protecting |m_cond|
     boost::mutex m_mutex;
 
@@ -60,8 +60,8 @@ HAM_PACK_0 struct HAM_PACK_1 PBlobHeader
     return (PBlobHeader *)&page->get_raw_payload()[readstart];
   }
 
-  // Flags; currently only used in hamsterdb-pro to store compression
-  // information
+  // Flags; stores whether the blob is compressed (see
+  // BlobManager::kIsCompressed)
   uint32_t flags;
 
   // The blob ID - which is the absolute address/offset of this
@@ -72,7 +72,8 @@ HAM_PACK_0 struct HAM_PACK_1 PBlobHeader
   // by the blob and it's header and maybe additional padding
   uint64_t allocated_size;
 
-  // The size of the blob from the user's point of view (excluding the header)
+  // The size of the blob from the user's point of view (excluding the header);
+  // if the blob is compressed then this is the uncompressed size
   uint64_t size;
 
 } HAM_PACK_2;
@@ -104,7 +105,8 @@ class BlobManager
                     PageManager *page_manager, Device *device)
       : m_config(config), m_page_manager(page_manager), m_device(device),
         m_metric_before_compression(0),
-        m_metric_after_compression(0), m_metric_total_allocated(0),
+        m_metric_after_compression(0), m_metric_uncached_bytes(0),
+        m_metric_total_allocated(0),
         m_metric_total_read(0) {
     }
 
@@ -142,6 +144,7 @@ class BlobManager
       metrics->blob_total_read = m_metric_total_read;
       metrics->record_bytes_before_compression = m_metric_before_compression;
       metrics->record_bytes_after_compression = m_metric_after_compression;
+      metrics->blob_bytes_read_uncached = m_metric_uncached_bytes;
     }
 
   protected:
@@ -187,10 +190,13 @@ class BlobManager
     // Usage tracking - number of bytes after compression
     uint64_t m_metric_after_compression;
 
-  private:
+    // Usage tracking - number of bytes which were read without the cache
+    uint64_t m_metric_uncached_bytes;
+
     // Usage tracking - number of blobs allocated
     uint64_t m_metric_total_allocated;
 
+  private:
     // Usage tracking - number of blobs read
     uint64_t m_metric_total_read;
 };
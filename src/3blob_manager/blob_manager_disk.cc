@@ -22,6 +22,7 @@
 // Always verify that a file of level N does not include headers > N!
 #include "1base/error.h"
 #include "1base/dynamic_array.h"
+#include "2compressor/compressor.h"
 #include "2device/device.h"
 #include "3blob_manager/blob_manager_disk.h"
 #include "3page_manager/page_manager.h"
@@ -36,6 +37,21 @@ using namespace hamsterdb;
 uint64_t
 DiskBlobManager::do_allocate(Context *context, ham_record_t *record,
                 uint32_t flags)
+{
+  ByteArray arena;
+  uint32_t length;
+  if (compress(context, record, flags, &arena, &length)) {
+    ham_record_t compressed = ham_make_record(arena.get_ptr(), length);
+    return (allocate_blob(context, &compressed, flags & ~HAM_PARTIAL,
+                            record->size, kIsCompressed));
+  }
+
+  return (allocate_blob(context, record, flags, record->size, 0));
+}
+
+uint64_t
+DiskBlobManager::allocate_blob(Context *context, ham_record_t *record,
+                uint32_t flags, uint64_t size, uint32_t blob_flags)
 {
   uint8_t *chunk_data[2];
   uint32_t chunk_size[2];
@@ -102,8 +118,9 @@ DiskBlobManager::do_allocate(Context *context, ham_record_t *record,
 
   // initialize the blob header
   blob_header.allocated_size = alloc_size;
-  blob_header.size = record->size;
+  blob_header.size = size;
   blob_header.blob_id = address;
+  blob_header.flags = blob_flags;
 
   // PARTIAL WRITE
   //
@@ -207,6 +224,10 @@ DiskBlobManager::do_read(Context *context, uint64_t blob_id,
   uint32_t blobsize = (uint32_t)blob_header->size;
   record->size = blobsize;
 
+  // large blobs are not loaded into the cache, otherwise they would evict
+  // the index pages; this also applies to partial reads of large blobs
+  bool bypass_cache = blobsize >= kUncachedReadThreshold;
+
   if (flags & HAM_PARTIAL) {
     if (record->partial_offset > blobsize) {
       ham_trace(("partial offset is greater than the total record size"));
@@ -225,6 +246,11 @@ DiskBlobManager::do_read(Context *context, uint64_t blob_id,
     return;
   }
 
+  if (blob_header->flags & kIsCompressed) {
+    read_compressed(context, page, blob_header, record, flags, arena);
+    return;
+  }
+
   // if the blob is in memory-mapped storage (and the user does not require
   // a copy of the data): simply return a pointer
   if ((flags & HAM_FORCE_DEEP_COPY) == 0
@@ -242,11 +268,14 @@ DiskBlobManager::do_read(Context *context, uint64_t blob_id,
       record->data = arena->get_ptr();
     }
 
-    copy_chunk(context, page, 0,
-                  blob_id + sizeof(PBlobHeader) + (flags & HAM_PARTIAL
-                          ? record->partial_offset
-                          : 0),
-                  (uint8_t *)record->data, blobsize, true);
+    uint64_t address = blob_id + sizeof(PBlobHeader)
+                + (flags & HAM_PARTIAL ? record->partial_offset : 0);
+    if (bypass_cache)
+      copy_chunk_uncached(context, page, address, (uint8_t *)record->data,
+                      blobsize);
+    else
+      copy_chunk(context, page, 0, address, (uint8_t *)record->data,
+                      blobsize, true);
   }
 }
 
@@ -270,6 +299,38 @@ DiskBlobManager::do_overwrite(Context *context, uint64_t old_blobid,
   PBlobHeader *old_blob_header, new_blob_header;
   Page *page;
 
+  // PARTIAL WRITE
+  //
+  // Compressed blobs cannot be modified in place. Instead, the old record
+  // is merged with the partial data, and the full record is written.
+  ByteArray merged;
+  ham_record_t full_record;
+  if ((flags & HAM_PARTIAL) && get_compressor(context, flags)) {
+    ham_record_t old_record = {0};
+    do_read(context, old_blobid, &old_record, HAM_FORCE_DEEP_COPY, &merged);
+
+    uint8_t *p = merged.resize(record->size);
+    if (record->size > old_record.size)
+      ::memset(p + old_record.size, 0, record->size - old_record.size);
+    ::memcpy(p + record->partial_offset, record->data, record->partial_size);
+
+    full_record = ham_make_record(p, record->size);
+    record = &full_record;
+    flags &= ~HAM_PARTIAL;
+  }
+
+  // compress the new record, if possible
+  ByteArray arena;
+  ham_record_t compressed;
+  uint32_t blob_flags = 0;
+  uint64_t size = record->size;
+  uint32_t length;
+  if (compress(context, record, flags, &arena, &length)) {
+    compressed = ham_make_record(arena.get_ptr(), length);
+    record = &compressed;
+    blob_flags = kIsCompressed;
+  }
+
   uint32_t alloc_size = sizeof(PBlobHeader) + record->size;
 
   // first, read the blob header; if the new blob fits into the
@@ -291,9 +352,9 @@ DiskBlobManager::do_overwrite(Context *context, uint64_t old_blobid,
 
     // setup the new blob header
     new_blob_header.blob_id = old_blob_header->blob_id;
-    new_blob_header.size = record->size;
+    new_blob_header.size = size;
     new_blob_header.allocated_size = alloc_size;
-    new_blob_header.flags = 0; // disable compression, just in case...
+    new_blob_header.flags = blob_flags;
 
     // PARTIAL WRITE
     //
@@ -340,7 +401,9 @@ DiskBlobManager::do_overwrite(Context *context, uint64_t old_blobid,
 
   // if the new data is larger: allocate a fresh space for it
   // and discard the old; 'overwrite' has become (delete + insert) now.
-  uint64_t new_blobid = allocate(context, record, flags);
+  m_metric_total_allocated++;
+  uint64_t new_blobid = allocate_blob(context, record, flags, size,
+                  blob_flags);
   erase(context, old_blobid, 0, 0);
 
   return (new_blobid);
@@ -379,6 +442,96 @@ DiskBlobManager::do_erase(Context *context, uint64_t blob_id, Page *page,
                   (uint32_t)blob_header->allocated_size);
 }
 
+Compressor *
+DiskBlobManager::get_compressor(Context *context, uint32_t flags) const
+{
+  if (flags & kDisableCompression)
+    return (0);
+  if (!context->db)
+    return (0);
+  return (context->db->record_compressor());
+}
+
+bool
+DiskBlobManager::compress(Context *context, ham_record_t *record,
+                uint32_t flags, ByteArray *arena, uint32_t *plength)
+{
+  Compressor *compressor = get_compressor(context, flags);
+  if (!compressor || record->size < kCompressionThreshold)
+    return (false);
+
+  // a partial record is merged with zeroes (the gaps), then compressed
+  ByteArray merged;
+  const uint8_t *data = (const uint8_t *)record->data;
+  if (flags & HAM_PARTIAL) {
+    uint8_t *p = merged.resize(record->size, 0);
+    ::memcpy(p + record->partial_offset, record->data, record->partial_size);
+    data = p;
+  }
+
+  uint32_t length = compressor->compress(data, record->size, arena);
+
+  m_metric_before_compression += record->size;
+  m_metric_after_compression += length ? length : record->size;
+
+  // the data was not compressible; store it uncompressed
+  if (length == 0)
+    return (false);
+
+  *plength = length;
+  return (true);
+}
+
+void
+DiskBlobManager::read_compressed(Context *context, Page *page,
+                PBlobHeader *blob_header, ham_record_t *record,
+                uint32_t flags, ByteArray *arena)
+{
+  Compressor *compressor = get_compressor(context, 0);
+  if (!compressor) {
+    ham_log(("blob %lld is compressed, but record compression is disabled",
+                blob_header->blob_id));
+    throw Exception(HAM_INTEGRITY_VIOLATED);
+  }
+
+  uint64_t address = blob_header->blob_id + sizeof(PBlobHeader);
+  uint32_t length = (uint32_t)(blob_header->allocated_size
+                          - sizeof(PBlobHeader));
+  uint32_t size = (uint32_t)blob_header->size;
+
+  // read the compressed data; |blob_header| is no longer valid afterwards
+  // because copy_chunk() might fetch other pages
+  ByteArray compressed;
+  compressed.resize(length);
+  if (length >= kUncachedReadThreshold)
+    copy_chunk_uncached(context, page, address, compressed.get_ptr(), length);
+  else
+    copy_chunk(context, page, 0, address, compressed.get_ptr(), length, true);
+
+  // a full record is decompressed directly to the record's buffer
+  if (!(flags & HAM_PARTIAL)) {
+    if (!(record->flags & HAM_RECORD_USER_ALLOC)) {
+      arena->resize(size);
+      record->data = arena->get_ptr();
+    }
+    compressor->decompress(compressed.get_ptr(), length,
+                    (uint8_t *)record->data, size);
+    return;
+  }
+
+  // otherwise decompress the full record, then copy the requested range
+  ByteArray full;
+  full.resize(size);
+  compressor->decompress(compressed.get_ptr(), length, full.get_ptr(), size);
+
+  if (!(record->flags & HAM_RECORD_USER_ALLOC)) {
+    arena->resize(record->partial_size);
+    record->data = arena->get_ptr();
+  }
+  ::memcpy(record->data, full.get_ptr() + record->partial_offset,
+                  record->partial_size);
+}
+
 bool
 DiskBlobManager::alloc_from_freelist(PBlobPageHeader *header, uint32_t size,
                 uint64_t *poffset)
@@ -609,6 +762,61 @@ DiskBlobManager::copy_chunk(Context *context, Page *page, Page **ppage,
     *ppage = page;
 }
 
+void
+DiskBlobManager::copy_chunk_uncached(Context *context, Page *page,
+                uint64_t address, uint8_t *data, uint32_t size)
+{
+  uint32_t page_size = m_config->page_size_bytes;
+
+  // adjacent pages which are not cached are read with a single call
+  uint64_t pending_address = 0;
+  uint8_t *pending_data = 0;
+  uint32_t pending_size = 0;
+
+  while (size) {
+    uint64_t pageid = address - (address % page_size);
+
+    // a cached page is used because it might be newer than the file;
+    // pages which are not cached are up to date on disk
+    if (page && page->get_address() != pageid)
+      page = 0;
+    if (!page)
+      page = m_page_manager->fetch(context, pageid,
+                      PageManager::kOnlyFromCache | PageManager::kReadOnly
+                            | PageManager::kNoHeader);
+
+    uint32_t read_start = (uint32_t)(address - pageid);
+    uint32_t read_size = (uint32_t)(page_size - read_start);
+    if (read_size > size)
+      read_size = size;
+
+    if (page) {
+      if (pending_size) {
+        m_device->read(pending_address, pending_data, pending_size);
+        m_metric_uncached_bytes += pending_size;
+        pending_size = 0;
+      }
+      memcpy(data, &page->get_raw_payload()[read_start], read_size);
+    }
+    else {
+      if (pending_size == 0) {
+        pending_address = address;
+        pending_data = data;
+      }
+      pending_size += read_size;
+    }
+
+    address += read_size;
+    data += read_size;
+    size -= read_size;
+  }
+
+  if (pending_size) {
+    m_device->read(pending_address, pending_data, pending_size);
+    m_metric_uncached_bytes += pending_size;
+  }
+}
+
 uint8_t *
 DiskBlobManager::read_chunk(Context *context, Page *page, Page **ppage,
                 uint64_t address, bool fetch_read_only)
@@ -20,6 +20,7 @@
 #include "0root/root.h"
 
 // Always verify that a file of level N does not include headers > N!
+#include "2compressor/compressor.h"
 #include "3blob_manager/blob_manager.h"
 
 #ifndef HAM_ROOT_H
@@ -120,7 +121,14 @@ class DiskBlobManager : public BlobManager
 {
   enum {
     // Overhead per page
-    kPageOverhead = Page::kSizeofPersistentHeader + sizeof(PBlobPageHeader)
+    kPageOverhead = Page::kSizeofPersistentHeader + sizeof(PBlobPageHeader),
+
+    // Blobs of this size (or larger) are read without loading their pages
+    // into the cache
+    kUncachedReadThreshold = 64 * 1024,
+
+    // Records smaller than this are not compressed
+    kCompressionThreshold = 64
   };
 
   public:
@@ -160,6 +168,30 @@ class DiskBlobManager : public BlobManager
     friend class DuplicateManager;
     friend struct BlobManagerFixture;
 
+    // Allocates a new blob and writes |record|. |size| is stored in the
+    // blob header; it differs from |record->size| if the record is
+    // compressed
+    uint64_t allocate_blob(Context *context, ham_record_t *record,
+                    uint32_t flags, uint64_t size, uint32_t blob_flags);
+
+    // Compresses |record| if record compression is enabled for the current
+    // database, and the record is large enough. On success, the compressed
+    // data is stored in |arena|, its length in |plength| and true is
+    // returned. A partial record is merged with zeroes before it is
+    // compressed.
+    bool compress(Context *context, ham_record_t *record, uint32_t flags,
+                    ByteArray *arena, uint32_t *plength);
+
+    // Reads and decompresses a compressed blob. |record->partial_offset|
+    // and |record->partial_size| are already validated.
+    void read_compressed(Context *context, Page *page,
+                    PBlobHeader *blob_header, ham_record_t *record,
+                    uint32_t flags, ByteArray *arena);
+
+    // Returns the record compressor of the current database, or null if
+    // compression is disabled
+    Compressor *get_compressor(Context *context, uint32_t flags) const;
+
     // write a series of data chunks to storage at file offset 'addr'.
     //
     // The chunks are assumed to be stored in sequential order, adjacent
@@ -174,6 +206,11 @@ class DiskBlobManager : public BlobManager
                     uint64_t addr, uint8_t *data, uint32_t size,
                     bool fetch_read_only);
 
+    // Same as |copy_chunk|, but pages which are not cached are read
+    // directly from the device and are not added to the cache
+    void copy_chunk_uncached(Context *context, Page *page, uint64_t addr,
+                    uint8_t *data, uint32_t size);
+
     // Same as |copy_chunk|, but does not copy the data
     uint8_t *read_chunk(Context *context, Page *page, Page **fpage,
                     uint64_t addr, bool fetch_read_only);
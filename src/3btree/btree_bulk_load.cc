@@ -0,0 +1,373 @@
+/*
+ * Copyright (C) 2005-2015 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * btree bulk loading
+ *
+ * The btree is built bottom-up from a sorted stream of keys. The keys are
+ * appended to the current leaf; when the leaf is full, a new leaf is
+ * allocated and the first key of the new leaf is appended to the parent
+ * level. Internal nodes are filled in the same way. Each level therefore
+ * only has one "open" node; all other nodes are complete and are written
+ * to the device immediately, without going through the cache.
+ *
+ * The leaf nodes are filled to the requested fill factor. The capacity
+ * of a leaf is determined by filling the first leaf completely; it is
+ * then split till the remaining leaves have the requested number of keys.
+ * Internal nodes are always filled completely.
+ */
+
+#include "0root/root.h"
+
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+// Always verify that a file of level N does not include headers > N!
+#include "1base/error.h"
+#include "1base/dynamic_array.h"
+#include "2device/device.h"
+#include "2page/page.h"
+#include "3page_manager/page_manager.h"
+#include "3btree/btree_index.h"
+#include "3btree/btree_node_proxy.h"
+#include "4context/context.h"
+#include "4db/db_local.h"
+#include "4env/env_local.h"
+
+#ifndef HAM_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace hamsterdb {
+
+class BtreeBulkLoadAction
+{
+  public:
+    // Constructor
+    BtreeBulkLoadAction(BtreeIndex *btree, Context *context,
+                    BtreeBulkLoadSource &source, uint32_t fill_factor)
+      : m_btree(btree), m_context(context), m_source(source),
+        m_fill_factor(fill_factor), m_leaf_capacity(0),
+        m_separator_pending(false) {
+      memset(&m_left_key, 0, sizeof(m_left_key));
+      m_env = btree->get_db()->lenv();
+      m_in_memory = (m_env->get_flags() & HAM_IN_MEMORY) != 0;
+    }
+
+    // Destructor; releases the open nodes if the load failed
+    ~BtreeBulkLoadAction() {
+      if (!m_in_memory) {
+        for (size_t i = 0; i < m_levels.size(); i++)
+          delete m_levels[i];
+      }
+    }
+
+    // Loads all keys from the source, then replaces the (empty) root
+    // with the new tree
+    void run() {
+      LocalDatabase *db = m_btree->get_db();
+      PageManager *page_manager = m_env->page_manager();
+
+      uint64_t old_root_address = m_btree->root_address();
+      Page *old_root = page_manager->fetch(m_context, old_root_address);
+      BtreeNodeProxy *old_root_node = m_btree->get_node_from_page(old_root);
+      if (!old_root_node->is_leaf() || old_root_node->get_count() > 0) {
+        ham_trace(("bulk loading requires an empty database"));
+        throw Exception(HAM_INV_PARAMETER);
+      }
+
+      bool duplicates = (db->get_flags() & HAM_ENABLE_DUPLICATE_KEYS) != 0;
+
+      ham_key_t key = {0};
+      ham_record_t record = {0};
+      while (m_source.next(&key, &record))
+        append(&key, &record, duplicates);
+
+      // nothing was loaded? then keep the current root
+      if (m_levels.empty())
+        return;
+
+      // write the open nodes; the top-most node is the new root
+      Page *root = m_levels.back();
+      root->set_type(Page::kTypeBroot);
+      uint64_t root_address = root->get_address();
+      for (size_t i = 0; i < m_levels.size(); i++) {
+        Page *page = m_levels[i];
+        m_levels[i] = 0;
+        write_node(page);
+      }
+      m_levels.clear();
+
+      // the nodes must be persistent before the header references them
+      if (!m_in_memory && m_env->get_flags() & HAM_ENABLE_RECOVERY)
+        m_env->device()->flush();
+
+      // replace the old root
+      old_root = page_manager->fetch(m_context, old_root_address);
+      m_btree->get_statistics()->reset_page(old_root);
+      m_btree->set_root_address(m_context, root_address);
+      Page *header = page_manager->fetch(m_context, 0);
+      header->set_dirty(true);
+      page_manager->del(m_context, old_root);
+
+      flush_changeset();
+    }
+
+  private:
+    // Appends a key/record pair to the current leaf
+    void append(ham_key_t *key, ham_record_t *record, bool duplicates) {
+      if (m_levels.empty())
+        m_levels.push_back(allocate_node(0));
+
+      BtreeNodeProxy *node = m_btree->get_node_from_page(m_levels[0]);
+      size_t count = node->get_count();
+
+      if (count > 0) {
+        int cmp = node->compare(m_context, key, count - 1);
+        if (cmp < 0) {
+          ham_trace(("keys are not sorted"));
+          throw Exception(HAM_INV_PARAMETER);
+        }
+
+        // a duplicate key is always the last key of the current leaf. If
+        // the leaf is full then the key (with all its duplicates) is moved
+        // to a new leaf.
+        if (cmp == 0) {
+          if (!duplicates)
+            throw Exception(HAM_DUPLICATE_KEY);
+          if (count > 1 && node->requires_split(m_context, key))
+            node = append_leaf(count - 1);
+          uint32_t new_duplicate_index;
+          node->set_record(m_context, node->get_count() - 1, record, 0,
+                          HAM_DUPLICATE | HAM_DUPLICATE_INSERT_LAST,
+                          &new_duplicate_index);
+          return;
+        }
+
+        if (m_leaf_capacity > 0 && count >= m_leaf_capacity)
+          node = append_leaf(count);
+      }
+
+      PBtreeNode::InsertResult result = node->insert(m_context, key,
+                      PBtreeNode::kInsertAppend);
+
+      // the leaf is full? then continue with a new leaf
+      if (result.status == HAM_LIMITS_REACHED) {
+        node = leaf_is_full(node);
+        result = node->insert(m_context, key, PBtreeNode::kInsertAppend);
+      }
+      if (result.status)
+        throw Exception(result.status);
+      uint32_t new_duplicate_index;
+      node->set_record(m_context, result.slot, record, 0, 0,
+                      &new_duplicate_index);
+
+      if (m_separator_pending) {
+        m_separator_pending = false;
+        append_separator(m_levels[0]);
+      }
+    }
+
+    // Called if the current leaf |node| has no space for the next key.
+    // The capacity of the leaves is learned from the first leaf, which is
+    // then split according to the fill factor. Returns the leaf which
+    // receives the next key.
+    BtreeNodeProxy *leaf_is_full(BtreeNodeProxy *node) {
+      if (m_leaf_capacity > 0)
+        return (append_leaf(node->get_count()));
+
+      m_leaf_capacity = std::max((size_t)1,
+                      node->get_count() * m_fill_factor / 100);
+      if (node->get_count() == m_leaf_capacity)
+        return (append_leaf(node->get_count()));
+
+      while (node->get_count() > m_leaf_capacity)
+        node = append_leaf(m_leaf_capacity);
+      if (node->get_count() == m_leaf_capacity)
+        node = append_leaf(node->get_count());
+      return (node);
+    }
+
+    // Allocates a new leaf and moves the keys at and after |pivot| from
+    // the current leaf to the new leaf. The current leaf is then written.
+    // Returns the new leaf.
+    BtreeNodeProxy *append_leaf(size_t pivot) {
+      Page *page = m_levels[0];
+      BtreeNodeProxy *node = m_btree->get_node_from_page(page);
+
+      Page *new_page = allocate_node(0);
+      BtreeNodeProxy *new_node = m_btree->get_node_from_page(new_page);
+      if (pivot < node->get_count())
+        node->split(m_context, new_node, (int)pivot);
+
+      node->set_right(new_page->get_address());
+      new_node->set_left(page->get_address());
+      m_levels[0] = new_page;
+
+      // the last key of the completed leaf is required to truncate the
+      // separator
+      node->get_key(m_context, node->get_count() - 1, &m_left_key_arena,
+                      &m_left_key);
+      write_node(page);
+
+      // the separator is the first key of the new leaf; if the leaf is
+      // still empty then it is added after the next key was inserted
+      if (new_node->get_count() > 0)
+        append_separator(new_page);
+      else
+        m_separator_pending = true;
+      return (new_node);
+    }
+
+    // Adds the first key of a new leaf to the parent level. The key is
+    // truncated to the shortest prefix which is still greater than the last
+    // key of the previous leaf.
+    void append_separator(Page *leaf) {
+      BtreeNodeProxy *node = m_btree->get_node_from_page(leaf);
+      ham_key_t key = {0};
+      node->get_key(m_context, 0, &m_separator_arena, &key);
+      key.size = m_btree->get_separator_size(&m_left_key, &key);
+      append_internal(1, &key, leaf->get_address());
+    }
+
+    // Appends |key| and the address of its |child| to the internal node
+    // of |level|. If the node is full then a new node is started, and
+    // |key| moves up to the next level.
+    void append_internal(size_t level, ham_key_t *key, uint64_t child) {
+      // the first node of a level points to the first node of the level
+      // below
+      if (level == m_levels.size()) {
+        Page *page = allocate_node(level);
+        m_btree->get_node_from_page(page)->set_ptr_down(m_first[level - 1]);
+        m_levels.push_back(page);
+      }
+
+      Page *page = m_levels[level];
+      BtreeNodeProxy *node = m_btree->get_node_from_page(page);
+
+      if (node->requires_split(m_context, key)) {
+        Page *new_page = allocate_node(level);
+        BtreeNodeProxy *new_node = m_btree->get_node_from_page(new_page);
+        new_node->set_ptr_down(child);
+        node->set_right(new_page->get_address());
+        new_node->set_left(page->get_address());
+        m_levels[level] = new_page;
+        write_node(page);
+        append_internal(level + 1, key, new_page->get_address());
+        return;
+      }
+
+      PBtreeNode::InsertResult result = node->insert(m_context, key,
+                      PBtreeNode::kInsertAppend);
+      if (result.status)
+        throw Exception(result.status);
+      node->set_record_id(m_context, result.slot, child);
+    }
+
+    // Allocates and initializes a new node
+    Page *allocate_node(size_t level) {
+      PageManager *page_manager = m_env->page_manager();
+      Page *page;
+      if (m_in_memory)
+        page = page_manager->alloc(m_context, Page::kTypeBindex,
+                        PageManager::kClearWithZero);
+      else
+        page = page_manager->alloc_uncached(m_context, Page::kTypeBindex);
+
+      PBtreeNode *node = PBtreeNode::from_page(page);
+      node->set_flags(level == 0 ? PBtreeNode::kLeafNode : 0);
+
+      if (level == m_first.size())
+        m_first.push_back(page->get_address());
+      return (page);
+    }
+
+    // Writes a completed node to the device and releases it. In-memory
+    // nodes remain in the cache.
+    void write_node(Page *page) {
+      page->set_dirty(true);
+      if (!m_in_memory) {
+        page->flush();
+        delete page;
+      }
+
+      flush_changeset();
+    }
+
+    // Releases the pages in the Changeset (i.e. blob pages); if recovery
+    // is enabled then they are flushed
+    void flush_changeset() {
+      if (m_env->get_flags() & HAM_ENABLE_RECOVERY)
+        m_context->changeset.flush(m_env->next_lsn());
+      else {
+        m_context->changeset.clear();
+        m_env->page_manager()->purge_cache(m_context);
+      }
+    }
+
+    // the btree
+    BtreeIndex *m_btree;
+
+    // the current Context
+    Context *m_context;
+
+    // the source of the keys
+    BtreeBulkLoadSource &m_source;
+
+    // the fill factor of the leaf nodes, in percent
+    uint32_t m_fill_factor;
+
+    // the Environment
+    LocalEnvironment *m_env;
+
+    // true if the Environment is in-memory
+    bool m_in_memory;
+
+    // the number of keys per leaf; 0 till the first leaf is full
+    size_t m_leaf_capacity;
+
+    // true if the separator of the current leaf was not yet added to the
+    // parent level, because the leaf was empty
+    bool m_separator_pending;
+
+    // the open node of each level; level 0 are the leaves
+    std::vector<Page *> m_levels;
+
+    // the address of the first node of each level
+    std::vector<uint64_t> m_first;
+
+    // storage for the separator keys
+    ByteArray m_separator_arena;
+
+    // the last key of the previous leaf
+    ham_key_t m_left_key;
+
+    // storage for |m_left_key|
+    ByteArray m_left_key_arena;
+};
+
+void
+BtreeIndex::bulk_load(Context *context, BtreeBulkLoadSource &source,
+                uint32_t fill_factor)
+{
+  context->db = get_db();
+
+  BtreeBulkLoadAction bla(this, context, source, fill_factor);
+  bla.run();
+}
+
+} // namespace hamsterdb
@@ -277,6 +277,55 @@ class BtreeCheckAction
           }
           m_children.insert(child_id);
        }
+
+        verify_separators(page);
+      }
+    }
+
+    // Verifies that the keys of an internal node separate its children,
+    // i.e. each key is greater than the last key of the left child and
+    // not greater than the first key of the right child. The keys can be
+    // shorter than the keys in the leaf nodes (see
+    // BtreeIndex::get_separator_size).
+    void verify_separators(Page *page) {
+      LocalEnvironment *env = m_btree->get_db()->lenv();
+      BtreeNodeProxy *node = m_btree->get_node_from_page(page);
+      ham_key_t separator = {0};
+      ham_key_t key = {0};
+
+      uint64_t left_id = node->get_ptr_down();
+      for (uint32_t i = 0; i < node->get_count(); i++) {
+        uint64_t right_id = node->get_record_id(m_context, i);
+        node->get_key(m_context, i, &m_barray1, &separator);
+
+        Page *child = env->page_manager()->fetch(m_context, left_id,
+                        PageManager::kReadOnly);
+        BtreeNodeProxy *child_node = m_btree->get_node_from_page(child);
+        if (child_node->get_count() > 0) {
+          child_node->get_key(m_context, child_node->get_count() - 1,
+                          &m_barray2, &key);
+          if (node->compare(&key, &separator) >= 0) {
+            ham_log(("integrity check failed in page 0x%llx: item #%d "
+                    "<= last item of child 0x%llx", page->get_address(), i,
+                    left_id));
+            throw Exception(HAM_INTEGRITY_VIOLATED);
+          }
+        }
+
+        child = env->page_manager()->fetch(m_context, right_id,
+                        PageManager::kReadOnly);
+        child_node = m_btree->get_node_from_page(child);
+        if (child_node->get_count() > 0) {
+          child_node->get_key(m_context, 0, &m_barray2, &key);
+          if (node->compare(&key, &separator) < 0) {
+            ham_log(("integrity check failed in page 0x%llx: item #%d "
+                    "> first item of child 0x%llx", page->get_address(), i,
+                    right_id));
+            throw Exception(HAM_INTEGRITY_VIOLATED);
+          }
+        }
+
+        left_id = right_id;
       }
     }
 
@@ -220,7 +220,7 @@ BtreeCursor::move_to_next_page(Context *context)
   }
 
   Page *page = env->page_manager()->fetch(context, node->get_right(),
-                        PageManager::kReadOnly);
+                        PageManager::kReadOnly | PageManager::kReadAhead);
   couple_to_page(page, 0, 0);
   return (0);
 }
@@ -349,7 +349,7 @@ BtreeCursor::move_next(Context *context, uint32_t flags)
     return (HAM_KEY_NOT_FOUND);
 
   Page *page = env->page_manager()->fetch(context, node->get_right(),
-                    PageManager::kReadOnly);
+                    PageManager::kReadOnly | PageManager::kReadAhead);
   node = m_btree->get_node_from_page(page);
 
   // if the right node is empty then continue searching for the next
@@ -358,7 +358,7 @@ BtreeCursor::move_next(Context *context, uint32_t flags)
     if (!node->get_right())
       return (HAM_KEY_NOT_FOUND);
     page = env->page_manager()->fetch(context, node->get_right(),
-                    PageManager::kReadOnly);
+                    PageManager::kReadOnly | PageManager::kReadAhead);
     node = m_btree->get_node_from_page(page);
   }
 
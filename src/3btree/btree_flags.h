@@ -45,6 +45,10 @@ struct BtreeKey
     // key is extended with overflow area
     kExtendedKey          = 0x01,
 
+    // key shares a prefix with the node; the size of the shared prefix
+    // is stored in the payload
+    kPrefixCompressed     = 0x04,
+
     // PRO: key is compressed; the original size is stored in the payload
     kCompressed           = 0x08
   };
@@ -84,6 +88,10 @@ struct BtreeRecord
     // record size == 0; key->ptr == 0
     kBlobSizeEmpty        = 0x04,
 
+    // record is stored inline with a variable length; the size is stored
+    // in the first byte of the record data (see btree_records_varlen.h)
+    kBlobSizeInline       = 0x08,
+
     // key has duplicates in an overflow area; this is the msb of 1 byte;
     // the lower bits are the counter for the inline duplicate list
     kExtendedDuplicates   = 0x80
@@ -45,9 +45,11 @@ BtreeIndex::BtreeIndex(LocalDatabase *db, PBtreeHeader *btree_header,
     m_btree_header(btree_header), m_flags(flags), m_root_address(0)
 {
   m_leaf_traits = BtreeIndexFactory::create(db, flags, key_type,
-                  key_size, true);
+                  key_size, btree_header->key_compression(),
+                  btree_header->inline_record_threshold(), true);
   m_internal_traits = BtreeIndexFactory::create(db, flags, key_type,
-                  key_size, false);
+                  key_size, btree_header->key_compression(),
+                  btree_header->inline_record_threshold(), false);
 }
 
 void
@@ -194,11 +196,25 @@ class CalcKeysVisitor : public BtreeVisitor {
 };
 
 uint64_t
-BtreeIndex::count(Context *context, bool distinct)
+BtreeIndex::count(Context *context, bool distinct, uint32_t threads)
 {
-  CalcKeysVisitor visitor(m_db, distinct);
-  visit_nodes(context, visitor, false);
-  return (visitor.get_result());
+  if (threads <= 1) {
+    CalcKeysVisitor visitor(m_db, distinct);
+    visit_nodes(context, visitor, false);
+    return (visitor.get_result());
+  }
+
+  std::vector<CalcKeysVisitor> visitors(threads,
+                  CalcKeysVisitor(m_db, distinct));
+  std::vector<BtreeVisitor *> pointers;
+  for (size_t i = 0; i < visitors.size(); i++)
+    pointers.push_back(&visitors[i]);
+  visit_leaves_parallel(context, pointers);
+
+  uint64_t count = 0;
+  for (size_t i = 0; i < visitors.size(); i++)
+    count += visitors[i].get_result();
+  return (count);
 }
 
 //
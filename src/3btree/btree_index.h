@@ -25,6 +25,7 @@
 #include "0root/root.h"
 
 #include <algorithm>
+#include <vector>
 
 // Always verify that a file of level N does not include headers > N!
 #include "1globals/globals.h"
@@ -123,17 +124,29 @@ HAM_PACK_0 class HAM_PACK_1 PBtreeHeader
 
     // PRO: Sets the record compression
     void set_record_compression(int algorithm) {
-      m_compression |= algorithm << 4;
+      m_compression = (m_compression & 0xf) | (algorithm << 4);
     }
 
-    // PRO: Returns the key compression
+    // Returns the key compression
     uint8_t key_compression() const {
       return (m_compression & 0xf);
     }
 
-    // PRO: Sets the key compression
+    // Sets the key compression
     void set_key_compression(int algorithm) {
-      m_compression |= algorithm & 0xf;
+      m_compression = (m_compression & 0xf0) | (algorithm & 0xf);
+    }
+
+    // Returns the threshold for variable length records which are stored
+    // in the leaf (or 0 if disabled)
+    uint8_t inline_record_threshold() const {
+      return (m_inline_record_threshold);
+    }
+
+    // Sets the threshold for variable length records which are stored
+    // in the leaf
+    void set_inline_record_threshold(uint8_t threshold) {
+      m_inline_record_threshold = threshold;
     }
 
   private:
@@ -155,8 +168,8 @@ HAM_PACK_0 class HAM_PACK_1 PBtreeHeader
     // PRO: for storing key and record compression algorithm */
     uint8_t m_compression;
 
-    // reserved
-    uint8_t m_reserved1;
+    // variable length records up to this size are stored in the leaf
+    uint8_t m_inline_record_threshold;
 
     // the record size
     uint32_t m_rec_size;
@@ -171,6 +184,19 @@ class BtreeNodeProxy;
 struct PDupeEntry;
 struct BtreeVisitor;
 
+//
+// Supplies the sorted key/record pairs for BtreeIndex::bulk_load()
+//
+struct BtreeBulkLoadSource
+{
+  // virtual destructor
+  virtual ~BtreeBulkLoadSource() { }
+
+  // Retrieves the next key/record pair. Returns false if there are no
+  // more keys; throws an Exception on error
+  virtual bool next(ham_key_t *key, ham_record_t *record) = 0;
+};
+
 //
 // Abstract base class, overwritten by a templated version
 //
@@ -295,15 +321,34 @@ class BtreeIndex
     ham_status_t erase(Context *context, LocalCursor *cursor, ham_key_t *key,
                     int duplicate_index, uint32_t flags);
 
+    // Builds the btree bottom-up from the sorted keys of |source|; the btree
+    // must be empty. The leaf nodes are filled to |fill_factor| percent.
+    // The nodes are written directly to the device and bypass the cache
+    // (unless the Environment is in-memory).
+    void bulk_load(Context *context, BtreeBulkLoadSource &source,
+                    uint32_t fill_factor);
+
     // Iterates over the whole index and calls |visitor| on every node
     void visit_nodes(Context *context, BtreeVisitor &visitor,
                     bool visit_internal_nodes);
 
+    // Visits all leaf nodes with one thread per visitor. The leaf level
+    // is split in key ranges; each thread scans its ranges with its own
+    // visitor and Context. The caller must hold the Environment's lock
+    // and must not modify the tree. The changeset of |context| is cleared.
+    void visit_leaves_parallel(Context *context,
+                    std::vector<BtreeVisitor *> &visitors);
+
+    // Same as above, but only visits the leaf nodes stored at |pages|
+    void visit_pages_parallel(Context *context,
+                    const std::vector<uint64_t> &pages,
+                    std::vector<BtreeVisitor *> &visitors);
+
     // Checks the integrity of the btree (ham_db_check_integrity)
     void check_integrity(Context *context, uint32_t flags);
 
-    // Counts the keys in the btree
-    uint64_t count(Context *context, bool distinct);
+    // Counts the keys in the btree; uses |threads| threads if |threads| > 1
+    uint64_t count(Context *context, bool distinct, uint32_t threads = 1);
 
     // Drops this index. Deletes all records, overflow areas, extended
     // keys etc from the index; also used to avoid memory leaks when closing
@@ -318,6 +363,25 @@ class BtreeIndex
       return (m_leaf_traits->compare_keys(m_db, lhs, rhs));
     }
 
+    // Returns the size of the shortest separator key which is a prefix of
+    // |rhs| and still greater than |lhs| (with |lhs| < |rhs|). Only
+    // variable length binary keys are compared lexicographically and can
+    // be truncated; for all other keys the full size of |rhs| is returned.
+    uint16_t get_separator_size(const ham_key_t *lhs,
+                    const ham_key_t *rhs) const {
+      if (m_key_type != HAM_TYPE_BINARY
+              || m_key_size != HAM_KEY_SIZE_UNLIMITED)
+        return (rhs->size);
+
+      const uint8_t *l = (const uint8_t *)lhs->data;
+      const uint8_t *r = (const uint8_t *)rhs->data;
+      uint16_t size = std::min(lhs->size, rhs->size);
+      uint16_t i = 0;
+      while (i < size && l[i] == r[i])
+        i++;
+      return (i < rhs->size ? i + 1 : rhs->size);
+    }
+
     // Returns a BtreeNodeProxy for a Page
     BtreeNodeProxy *get_node_from_page(Page *page) {
       if (page->get_node_proxy())
@@ -357,6 +421,7 @@ class BtreeIndex
     }
 
   private:
+    friend class BtreeBulkLoadAction;
     friend class BtreeUpdateAction;
     friend class BtreeCheckAction;
     friend class BtreeEnumAction;
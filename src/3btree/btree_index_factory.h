@@ -31,10 +31,13 @@
 #include "3btree/btree_keys_pod.h"
 #include "3btree/btree_keys_binary.h"
 #include "3btree/btree_keys_varlen.h"
+#include "3btree/btree_keys_prefix.h"
+#include "3btree/btree_keys_for.h"
 #include "3btree/btree_records_default.h"
 #include "3btree/btree_records_inline.h"
 #include "3btree/btree_records_internal.h"
 #include "3btree/btree_records_duplicate.h"
+#include "3btree/btree_records_varlen.h"
 #include "3btree/btree_node_proxy.h"
 #include "4db/db_local.h"
 
@@ -79,11 +82,18 @@ class BtreeIndexTraitsImpl : public BtreeIndexTraits
 struct BtreeIndexFactory
 {
   static BtreeIndexTraits *create(LocalDatabase *db, uint32_t flags,
-                uint16_t key_type, uint16_t key_size, bool is_leaf) {
+                uint16_t key_type, uint16_t key_size, int key_compression,
+                int inline_record_threshold, bool is_leaf) {
     bool inline_records = (is_leaf && (flags & HAM_FORCE_RECORDS_INLINE));
     bool fixed_keys = (key_size != HAM_KEY_SIZE_UNLIMITED);
     bool use_duplicates = (flags & HAM_ENABLE_DUPLICATES) != 0;
 
+    // variable length records are stored in the leaf
+    if (is_leaf && inline_record_threshold > 0 && !inline_records
+          && !use_duplicates)
+      return (create_varlen_records(key_type, fixed_keys, key_size,
+                              key_compression));
+
     switch (key_type) {
       // 8bit unsigned integer
       case HAM_TYPE_UINT8:
@@ -159,6 +169,9 @@ struct BtreeIndexFactory
         }
       // 32bit unsigned integer
       case HAM_TYPE_UINT32:
+        if (key_compression == HAM_COMPRESSOR_FOR)
+          return (create_for_keys<uint32_t>(is_leaf, inline_records,
+                                  use_duplicates));
         if (use_duplicates) {
           if (!is_leaf)
             return (new BtreeIndexTraitsImpl<
@@ -195,6 +208,9 @@ struct BtreeIndexFactory
         }
       // 64bit unsigned integer
       case HAM_TYPE_UINT64:
+        if (key_compression == HAM_COMPRESSOR_FOR)
+          return (create_for_keys<uint64_t>(is_leaf, inline_records,
+                                  use_duplicates));
         if (use_duplicates) {
           if (!is_leaf)
             return (new BtreeIndexTraitsImpl<
@@ -368,41 +384,54 @@ struct BtreeIndexFactory
         ham_assert(!"shouldn't be here");
       // BINARY is the default:
       case HAM_TYPE_BINARY:
-        // Fixed keys, no duplicates
-        if (fixed_keys && !use_duplicates) {
-          if (!is_leaf)
-            return (new BtreeIndexTraitsImpl
-                      <PaxNodeImpl<PaxLayout::BinaryKeyList,
-                            PaxLayout::InternalRecordList>,
-                      FixedSizeCompare>());
-          if (inline_records)
-            return (new BtreeIndexTraitsImpl
-                      <PaxNodeImpl<PaxLayout::BinaryKeyList,
-                            PaxLayout::InlineRecordList>,
-                      FixedSizeCompare>());
-          else
-            return (new BtreeIndexTraitsImpl
-                      <PaxNodeImpl<PaxLayout::BinaryKeyList,
-                            PaxLayout::DefaultRecordList>,
-                      FixedSizeCompare>());
+        // fixed length keys; the common key sizes (e.g. hashes) use a
+        // comparator which is specialized for the key size
+        if (fixed_keys) {
+          switch (key_size) {
+            case 8:
+              return (create_fixed_binary<FixedWidthCompare<8> >(is_leaf,
+                              inline_records, use_duplicates));
+            case 16:
+              return (create_fixed_binary<FixedWidthCompare<16> >(is_leaf,
+                              inline_records, use_duplicates));
+            case 20:
+              return (create_fixed_binary<FixedWidthCompare<20> >(is_leaf,
+                              inline_records, use_duplicates));
+            case 32:
+              return (create_fixed_binary<FixedWidthCompare<32> >(is_leaf,
+                              inline_records, use_duplicates));
+            default:
+              return (create_fixed_binary<FixedSizeCompare>(is_leaf,
+                              inline_records, use_duplicates));
+          }
         }
-        // fixed keys with duplicates
-        if (fixed_keys && use_duplicates) {
+        // prefix compressed variable length keys
+        if (key_compression == HAM_COMPRESSOR_PREFIX) {
           if (!is_leaf)
             return (new BtreeIndexTraitsImpl<
-                    PaxNodeImpl<PaxLayout::BinaryKeyList,
+                    DefaultNodeImpl<DefLayout::PrefixCompressedKeyList,
                           PaxLayout::InternalRecordList>,
-                    FixedSizeCompare >());
+                    VariableSizeCompare >());
+          if (inline_records && !use_duplicates)
+            return (new BtreeIndexTraitsImpl<
+                    DefaultNodeImpl<DefLayout::PrefixCompressedKeyList,
+                          PaxLayout::InlineRecordList>,
+                    VariableSizeCompare >());
           if (inline_records && use_duplicates)
             return (new BtreeIndexTraitsImpl<
-                    DefaultNodeImpl<PaxLayout::BinaryKeyList,
+                    DefaultNodeImpl<DefLayout::PrefixCompressedKeyList,
                           DefLayout::DuplicateInlineRecordList>,
-                    FixedSizeCompare >());
+                    VariableSizeCompare >());
+          if (!inline_records && !use_duplicates)
+            return (new BtreeIndexTraitsImpl<
+                    DefaultNodeImpl<DefLayout::PrefixCompressedKeyList,
+                          PaxLayout::DefaultRecordList>,
+                    VariableSizeCompare >());
           if (!inline_records && use_duplicates)
             return (new BtreeIndexTraitsImpl<
-                    DefaultNodeImpl<PaxLayout::BinaryKeyList,
+                    DefaultNodeImpl<DefLayout::PrefixCompressedKeyList,
                           DefLayout::DuplicateDefaultRecordList>,
-                    FixedSizeCompare >());
+                    VariableSizeCompare >());
         }
         // variable length keys, with and without duplicates
         if (!is_leaf)
@@ -438,6 +467,149 @@ struct BtreeIndexFactory
     ham_assert(!"shouldn't be here");
     return (0);
   }
+
+  // Creates the Traits for leaf nodes which store variable length
+  // records inline (without duplicates)
+  static BtreeIndexTraits *create_varlen_records(uint16_t key_type,
+                bool fixed_keys, uint16_t key_size, int key_compression) {
+    switch (key_type) {
+      case HAM_TYPE_UINT8:
+        return (create_varlen_records<PaxLayout::PodKeyList<uint8_t>,
+                        NumericCompare<uint8_t> >());
+      case HAM_TYPE_UINT16:
+        return (create_varlen_records<PaxLayout::PodKeyList<uint16_t>,
+                        NumericCompare<uint16_t> >());
+      case HAM_TYPE_UINT32:
+        if (key_compression == HAM_COMPRESSOR_FOR)
+          return (create_varlen_records<DefLayout::ForKeyList<uint32_t>,
+                          NumericCompare<uint32_t> >());
+        return (create_varlen_records<PaxLayout::PodKeyList<uint32_t>,
+                        NumericCompare<uint32_t> >());
+      case HAM_TYPE_UINT64:
+        if (key_compression == HAM_COMPRESSOR_FOR)
+          return (create_varlen_records<DefLayout::ForKeyList<uint64_t>,
+                          NumericCompare<uint64_t> >());
+        return (create_varlen_records<PaxLayout::PodKeyList<uint64_t>,
+                        NumericCompare<uint64_t> >());
+      case HAM_TYPE_REAL32:
+        return (create_varlen_records<PaxLayout::PodKeyList<float>,
+                        NumericCompare<float> >());
+      case HAM_TYPE_REAL64:
+        return (create_varlen_records<PaxLayout::PodKeyList<double>,
+                        NumericCompare<double> >());
+      case HAM_TYPE_CUSTOM:
+        if (fixed_keys)
+          return (create_varlen_records<PaxLayout::BinaryKeyList,
+                          CallbackCompare>());
+        return (create_varlen_records<DefLayout::VariableLengthKeyList,
+                        CallbackCompare>());
+      case HAM_TYPE_BINARY:
+        if (fixed_keys) {
+          switch (key_size) {
+            case 8:
+              return (create_varlen_records<PaxLayout::BinaryKeyList,
+                              FixedWidthCompare<8> >());
+            case 16:
+              return (create_varlen_records<PaxLayout::BinaryKeyList,
+                              FixedWidthCompare<16> >());
+            case 20:
+              return (create_varlen_records<PaxLayout::BinaryKeyList,
+                              FixedWidthCompare<20> >());
+            case 32:
+              return (create_varlen_records<PaxLayout::BinaryKeyList,
+                              FixedWidthCompare<32> >());
+            default:
+              return (create_varlen_records<PaxLayout::BinaryKeyList,
+                              FixedSizeCompare>());
+          }
+        }
+        if (key_compression == HAM_COMPRESSOR_PREFIX)
+          return (create_varlen_records<DefLayout::PrefixCompressedKeyList,
+                          VariableSizeCompare>());
+        return (create_varlen_records<DefLayout::VariableLengthKeyList,
+                        VariableSizeCompare>());
+      default:
+        break;
+    }
+
+    ham_assert(!"shouldn't be here");
+    return (0);
+  }
+
+  template<class KeyList, class Comparator>
+  static BtreeIndexTraits *create_varlen_records() {
+    return (new BtreeIndexTraitsImpl<
+              DefaultNodeImpl<KeyList, DefLayout::VariableLengthRecordList>,
+              Comparator>());
+  }
+
+  // Creates the Traits for frame-of-reference compressed integer keys,
+  // with and without duplicates
+  template<typename T>
+  static BtreeIndexTraits *create_for_keys(bool is_leaf,
+                bool inline_records, bool use_duplicates) {
+    if (!is_leaf)
+      return (new BtreeIndexTraitsImpl<
+              DefaultNodeImpl<DefLayout::ForKeyList<T>,
+                    PaxLayout::InternalRecordList>,
+              NumericCompare<T> >());
+    if (use_duplicates) {
+      if (inline_records)
+        return (new BtreeIndexTraitsImpl<
+                DefaultNodeImpl<DefLayout::ForKeyList<T>,
+                      DefLayout::DuplicateInlineRecordList>,
+                NumericCompare<T> >());
+      else
+        return (new BtreeIndexTraitsImpl<
+                DefaultNodeImpl<DefLayout::ForKeyList<T>,
+                      DefLayout::DuplicateDefaultRecordList>,
+                NumericCompare<T> >());
+    }
+    if (inline_records)
+      return (new BtreeIndexTraitsImpl<
+              DefaultNodeImpl<DefLayout::ForKeyList<T>,
+                    PaxLayout::InlineRecordList>,
+              NumericCompare<T> >());
+    else
+      return (new BtreeIndexTraitsImpl<
+              DefaultNodeImpl<DefLayout::ForKeyList<T>,
+                    PaxLayout::DefaultRecordList>,
+              NumericCompare<T> >());
+  }
+
+  // Creates the Traits for fixed length binary keys, with and without
+  // duplicates
+  template<class Comparator>
+  static BtreeIndexTraits *create_fixed_binary(bool is_leaf,
+                bool inline_records, bool use_duplicates) {
+    if (!is_leaf)
+      return (new BtreeIndexTraitsImpl
+                <PaxNodeImpl<PaxLayout::BinaryKeyList,
+                      PaxLayout::InternalRecordList>,
+                Comparator>());
+    if (use_duplicates) {
+      if (inline_records)
+        return (new BtreeIndexTraitsImpl<
+                DefaultNodeImpl<PaxLayout::BinaryKeyList,
+                      DefLayout::DuplicateInlineRecordList>,
+                Comparator>());
+      else
+        return (new BtreeIndexTraitsImpl<
+                DefaultNodeImpl<PaxLayout::BinaryKeyList,
+                      DefLayout::DuplicateDefaultRecordList>,
+                Comparator>());
+    }
+    if (inline_records)
+      return (new BtreeIndexTraitsImpl
+                <PaxNodeImpl<PaxLayout::BinaryKeyList,
+                      PaxLayout::InlineRecordList>,
+                Comparator>());
+    else
+      return (new BtreeIndexTraitsImpl
+                <PaxNodeImpl<PaxLayout::BinaryKeyList,
+                      PaxLayout::DefaultRecordList>,
+                Comparator>());
+  }
 };
 
 } // namespace hamsterdb
@@ -0,0 +1,798 @@
+/*
+ * Copyright (C) 2005-2015 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Frame-of-reference compressed integer keys
+ *
+ * A KeyList for unsigned integers (uint32_t, uint64_t) which splits the
+ * sorted keys into blocks of up to kMaxKeysPerBlock keys. Each block
+ * stores its first key (the "base") in a block index; the remaining keys
+ * are stored as the difference to the base, bit-packed with the minimum
+ * number of bits that is required for the largest difference. Sequential
+ * keys (i.e. record numbers or time stamps) therefore only need a few bits
+ * per key.
+ *
+ * The key range has the following layout:
+ *
+ *   |Header|BlockIndex...|Payload...|
+ *
+ * The Payload stores the packed data of all blocks without gaps, in the
+ * same order as the BlockIndex.
+ *
+ * A lookup performs a binary search on the bases in the BlockIndex, and
+ * then a binary search in a single block. Since all values of a block
+ * have the same bit width, each value can be unpacked without decoding
+ * the whole block.
+ *
+ * Inserting or erasing a key re-encodes its block and shifts the Payload
+ * of the following blocks. Full blocks are split.
+ *
+ * @exception_safe: unknown
+ * @thread_safe: unknown
+ */
+
+#ifndef HAM_BTREE_KEYS_FOR_H
+#define HAM_BTREE_KEYS_FOR_H
+
+#include "0root/root.h"
+
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+// Always verify that a file of level N does not include headers > N!
+#include "1globals/globals.h"
+#include "1base/dynamic_array.h"
+#include "3btree/btree_node.h"
+#include "3btree/btree_keys_base.h"
+
+#ifndef HAM_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace hamsterdb {
+
+namespace DefLayout {
+
+#include "1base/packstart.h"
+
+// The header of the key range
+HAM_PACK_0 struct HAM_PACK_1 PForHeader
+{
+  // The number of blocks
+  uint32_t block_count;
+
+  // The number of entries that the BlockIndex can store
+  uint32_t index_capacity;
+
+  // The used size of the Payload (in bytes)
+  uint32_t payload_size;
+
+  // Reserved for future use
+  uint32_t reserved;
+} HAM_PACK_2;
+
+// An entry of the BlockIndex
+HAM_PACK_0 struct HAM_PACK_1 PForBlock
+{
+  // The first (and lowest) key of the block
+  uint64_t base;
+
+  // The offset of the packed data, relative to the start of the Payload
+  uint32_t offset;
+
+  // The number of keys in this block
+  uint16_t key_count;
+
+  // The number of bits per packed value
+  uint8_t bits;
+
+  // Reserved for future use
+  uint8_t reserved;
+} HAM_PACK_2;
+
+#include "1base/packstop.h"
+
+template<typename T>
+class ForKeyList : public BaseKeyList
+{
+  public:
+    enum {
+      // A flag whether this KeyList has sequential data
+      kHasSequentialData = 0,
+
+      // A flag whether this KeyList supports the scan() call
+      kSupportsBlockScans = 1,
+
+      // This KeyList can reduce its capacity in order to release storage
+      kCanReduceCapacity = 1,
+
+      // This KeyList has a custom find() implementation
+      kCustomFind = 1,
+
+      // This KeyList has a custom find_lower_bound() implementation
+      kCustomFindLowerBound = 1,
+
+      // The maximum number of keys in a block; this also limits the
+      // worst case growth of a single insert
+      kMaxKeysPerBlock = 32,
+
+      // The BlockIndex grows by this number of entries
+      kIndexIncrement = 4,
+    };
+
+    // Constructor
+    ForKeyList(LocalDatabase *db)
+      : m_data(0), m_key(0) {
+    }
+
+    // Creates a new KeyList starting at |data|, total size is
+    // |range_size| (in bytes)
+    void create(uint8_t *data, size_t range_size) {
+      m_data = data;
+      m_range_size = range_size;
+      ::memset(get_header(), 0, sizeof(PForHeader));
+    }
+
+    // Opens an existing KeyList
+    void open(uint8_t *data, size_t range_size, size_t node_count) {
+      m_data = data;
+      m_range_size = range_size;
+    }
+
+    // Returns the required size for the current set of keys
+    size_t get_required_range_size(size_t node_count) const {
+      return (get_used_size());
+    }
+
+    // Returns the number of bytes that are required to insert |key|. If
+    // |key| is null then the uncompressed key size is returned; the node
+    // uses it to distribute its space between the KeyList and the
+    // RecordList, and adjusts the ranges when they are full.
+    size_t get_full_key_size(const ham_key_t *key = 0) const {
+      if (!key)
+        return (sizeof(T));
+      return (get_insert_growth(*(T *)key->data));
+    }
+
+    // Finds a key
+    template<typename Cmp>
+    int find(Context *context, size_t node_count, const ham_key_t *hkey,
+                    Cmp &comparator) {
+      int cmp;
+      int slot = find_lower_bound(context, node_count, hkey, comparator, &cmp);
+      if (slot == -1 || cmp != 0)
+        return (-1);
+      return (slot);
+    }
+
+    // Performs a lower-bound search for a key. Only the BlockIndex and
+    // a single block are searched.
+    template<typename Cmp>
+    int find_lower_bound(Context *context, size_t node_count,
+                    const ham_key_t *hkey, Cmp &comparator, int *pcmp) {
+      if (node_count == 0 || get_header()->block_count == 0) {
+        *pcmp = -1;
+        return (-1);
+      }
+
+      T key = *(T *)hkey->data;
+      int b = find_block(key);
+      const PForBlock *block = get_block(b);
+      const uint8_t *data = get_block_data(block);
+
+      // binary search in the block
+      size_t left = 0;
+      size_t right = block->key_count;
+      while (left < right) {
+        size_t middle = (left + right) / 2;
+        if (get_value(block, data, middle) < key)
+          left = middle + 1;
+        else
+          right = middle;
+      }
+
+      int slot = get_first_slot(b) + (int)left;
+      if (left < block->key_count && get_value(block, data, left) == key) {
+        *pcmp = 0;
+        return (slot);
+      }
+      if (slot == 0) {
+        *pcmp = -1;
+        return (-1);
+      }
+      *pcmp = +1;
+      return (slot - 1);
+    }
+
+    // Copies a key into |dest|. The key is decoded in the |arena|, even
+    // if |deep_copy| is false.
+    void get_key(Context *context, int slot, ByteArray *arena, ham_key_t *dest,
+                    bool deep_copy = true) const {
+      T value = get_key_value(slot);
+      dest->size = sizeof(T);
+
+      // allocate memory (if required)
+      if (deep_copy == false || !(dest->flags & HAM_KEY_USER_ALLOC)) {
+        arena->resize(dest->size);
+        dest->data = arena->get_ptr();
+      }
+
+      memcpy(dest->data, &value, sizeof(T));
+    }
+
+    // Iterates all keys, calls the |visitor| on each. The keys are decoded
+    // and passed to the visitor in a single array.
+    void scan(Context *context, ScanVisitor *visitor, uint32_t start,
+                    size_t length) {
+      if (length == 0)
+        return;
+
+      T *out = m_scan_buffer.resize(length);
+      int first;
+      int b = find_block_by_slot(start, &first);
+      size_t i = start - first;
+      size_t n = 0;
+
+      for (; n < length; b++, i = 0) {
+        const PForBlock *block = get_block(b);
+        const uint8_t *data = get_block_data(block);
+        for (; i < block->key_count && n < length; i++)
+          out[n++] = get_value(block, data, i);
+      }
+
+      (*visitor)(out, length);
+    }
+
+    // Erases a key. The block is re-encoded, or removed if it was the
+    // last key of the block.
+    void erase(Context *context, size_t node_count, int slot) {
+      int first;
+      int b = find_block_by_slot(slot, &first);
+      PForBlock *block = get_block(b);
+
+      if (block->key_count == 1) {
+        remove_block(b);
+        return;
+      }
+
+      T values[kMaxKeysPerBlock + 1];
+      size_t count = decode_block(b, values);
+      size_t pos = slot - first;
+      ::memmove(&values[pos], &values[pos + 1],
+                      sizeof(T) * (count - pos - 1));
+      write_block(b, values, count - 1);
+    }
+
+    // Inserts a key. The |slot| is not required because the block is
+    // located with the key itself.
+    template<typename Cmp>
+    PBtreeNode::InsertResult insert(Context *context, size_t node_count,
+                    const ham_key_t *key, uint32_t flags, Cmp &comparator,
+                    int slot) {
+      T value = *(T *)key->data;
+      size_t required = get_insert_growth(value);
+      if (get_used_size() + required > m_range_size)
+        throw Exception(HAM_LIMITS_REACHED);
+
+      if (get_header()->block_count == 0) {
+        add_block(0);
+        write_block(0, &value, 1);
+      }
+      else {
+        int b = find_block(value);
+        T values[kMaxKeysPerBlock + 1];
+        size_t count = decode_block(b, values);
+        size_t pos = std::lower_bound(values, values + count, value) - values;
+        ::memmove(&values[pos + 1], &values[pos], sizeof(T) * (count - pos));
+        values[pos] = value;
+        count++;
+
+        if (count > kMaxKeysPerBlock) {
+          size_t pivot = get_split_pivot(pos, count);
+          write_block(b, values, pivot);
+          add_block(b + 1);
+          write_block(b + 1, values + pivot, count - pivot);
+        }
+        else
+          write_block(b, values, count);
+      }
+
+      // update the statistics
+      Globals::ms_bytes_before_compression += sizeof(T);
+      Globals::ms_bytes_after_compression += required;
+      return (PBtreeNode::InsertResult(0, slot));
+    }
+
+    // Copies all keys from this[sstart] to |dest|. The first block is
+    // re-encoded, all following blocks are copied without decoding them.
+    void copy_to(int sstart, size_t node_count, ForKeyList<T> &dest,
+                    size_t other_node_count, int dstart) {
+      int first;
+      int b = find_block_by_slot(sstart, &first);
+      int block_count = (int)get_header()->block_count;
+
+      // reserve the BlockIndex, otherwise the index of |dest| might grow
+      // beyond the size of the source
+      dest.set_index_capacity(std::max(dest.get_header()->index_capacity,
+                  dest.get_header()->block_count + (block_count - b)));
+
+      T values[kMaxKeysPerBlock + 1];
+      size_t count = decode_block(b, values);
+      size_t skip = sstart - first;
+      ham_assert(skip < count);
+      int d = (int)dest.get_header()->block_count;
+      dest.add_block(d);
+      dest.write_block(d, values + skip, count - skip);
+
+      for (b++; b < block_count; b++)
+        dest.append_packed_block(get_block(b), get_block_data(get_block(b)));
+    }
+
+    // Returns true if the |key| no longer fits into the node. If |key| is
+    // null then the worst case is assumed.
+    bool requires_split(size_t node_count, const ham_key_t *key) const {
+      size_t required;
+      if (key)
+        required = get_insert_growth(*(T *)key->data);
+      else
+        required = kMaxKeysPerBlock * sizeof(T)
+                + kIndexIncrement * sizeof(PForBlock);
+      return (get_used_size() + required > m_range_size);
+    }
+
+    // Rearranges the list; discards keys which are no longer part of the
+    // node (i.e. after a split). If |force| is true then unused entries
+    // of the BlockIndex are released.
+    void vacuumize(size_t node_count, bool force) {
+      truncate(node_count);
+      if (force)
+        set_index_capacity(get_header()->block_count);
+    }
+
+    // Change the range size; just copy the data from one place to the other
+    void change_range_size(size_t node_count, uint8_t *new_data_ptr,
+            size_t new_range_size, size_t capacity_hint) {
+      if (!new_data_ptr)
+        new_data_ptr = m_data;
+      ::memmove(new_data_ptr, m_data, get_used_size());
+      m_data = new_data_ptr;
+      m_range_size = new_range_size;
+    }
+
+    // Checks the integrity of this node. Throws an exception if there is a
+    // violation.
+    void check_integrity(Context *context, size_t node_count) const {
+      const PForHeader *header = get_header();
+      if (header->block_count > header->index_capacity) {
+        ham_log(("block count %u exceeds index capacity %u",
+                    (unsigned)header->block_count,
+                    (unsigned)header->index_capacity));
+        throw Exception(HAM_INTEGRITY_VIOLATED);
+      }
+      if (get_used_size() > m_range_size) {
+        ham_log(("used size %u exceeds range size %u",
+                    (unsigned)get_used_size(), (unsigned)m_range_size));
+        throw Exception(HAM_INTEGRITY_VIOLATED);
+      }
+
+      size_t total = 0;
+      uint32_t offset = 0;
+      T previous = 0;
+      for (int b = 0; b < (int)header->block_count; b++) {
+        const PForBlock *block = get_block(b);
+        if (block->key_count == 0 || block->key_count > kMaxKeysPerBlock
+              || block->bits > sizeof(T) * 8) {
+          ham_log(("block %d has invalid size %u or bit width %u", b,
+                    (unsigned)block->key_count, (unsigned)block->bits));
+          throw Exception(HAM_INTEGRITY_VIOLATED);
+        }
+        if (block->offset != offset) {
+          ham_log(("block %d has offset %u, expected %u", b,
+                    (unsigned)block->offset, (unsigned)offset));
+          throw Exception(HAM_INTEGRITY_VIOLATED);
+        }
+
+        const uint8_t *data = get_block_data(block);
+        for (size_t i = 0; i < block->key_count; i++) {
+          T value = get_value(block, data, i);
+          if ((b > 0 || i > 0) && value <= previous) {
+            ham_log(("block %d: key %u is not sorted", b, (unsigned)i));
+            throw Exception(HAM_INTEGRITY_VIOLATED);
+          }
+          previous = value;
+        }
+
+        offset += get_block_size(block);
+        total += block->key_count;
+      }
+
+      if (offset != header->payload_size) {
+        ham_log(("payload size %u, expected %u",
+                    (unsigned)header->payload_size, (unsigned)offset));
+        throw Exception(HAM_INTEGRITY_VIOLATED);
+      }
+      if (total != node_count) {
+        ham_log(("blocks store %u keys, but node has %u keys",
+                    (unsigned)total, (unsigned)node_count));
+        throw Exception(HAM_INTEGRITY_VIOLATED);
+      }
+    }
+
+    // Fills the btree_metrics structure
+    void fill_metrics(btree_metrics_t *metrics, size_t node_count) {
+      const PForHeader *header = get_header();
+      BaseKeyList::fill_metrics(metrics, node_count);
+      BtreeStatistics::update_min_max_avg(&metrics->keylist_index,
+              (uint32_t)(sizeof(PForHeader)
+                    + header->index_capacity * sizeof(PForBlock)));
+      BtreeStatistics::update_min_max_avg(&metrics->keylist_unused,
+              m_range_size - (uint32_t)get_used_size());
+      BtreeStatistics::update_min_max_avg(&metrics->keylist_blocks_per_page,
+              header->block_count);
+      for (int b = 0; b < (int)header->block_count; b++)
+        BtreeStatistics::update_min_max_avg(&metrics->keylist_block_sizes,
+                (uint32_t)get_block_size(get_block(b)));
+    }
+
+    // Prints a slot to |out| (for debugging)
+    void print(Context *context, int slot, std::stringstream &out) const {
+      out << get_key_value(slot);
+    }
+
+    // Returns the size of a key
+    size_t get_key_size(int slot) const {
+      return (sizeof(T));
+    }
+
+    // Returns a pointer to the key's data. The key is decoded to a
+    // temporary buffer which is overwritten by the next call.
+    uint8_t *get_key_data(int slot) {
+      m_key = get_key_value(slot);
+      return ((uint8_t *)&m_key);
+    }
+
+  private:
+    // Returns the header
+    PForHeader *get_header() const {
+      return ((PForHeader *)m_data);
+    }
+
+    // Returns an entry of the BlockIndex
+    PForBlock *get_block(int b) const {
+      return ((PForBlock *)(m_data + sizeof(PForHeader)) + b);
+    }
+
+    // Returns a pointer to the Payload
+    uint8_t *get_payload() const {
+      return (m_data + sizeof(PForHeader)
+                      + get_header()->index_capacity * sizeof(PForBlock));
+    }
+
+    // Returns a pointer to the packed data of a block
+    uint8_t *get_block_data(const PForBlock *block) const {
+      return (get_payload() + block->offset);
+    }
+
+    // Returns the number of bytes which are used in the range
+    size_t get_used_size() const {
+      const PForHeader *header = get_header();
+      return (sizeof(PForHeader) + header->index_capacity * sizeof(PForBlock)
+                      + header->payload_size);
+    }
+
+    // Returns the size of the packed data of |count| keys with |bits| bits
+    // per key (the base is not packed)
+    static size_t get_packed_size(size_t count, size_t bits) {
+      return (((count - 1) * bits + 7) / 8);
+    }
+
+    // Returns the size of the packed data of a block
+    static size_t get_block_size(const PForBlock *block) {
+      return (get_packed_size(block->key_count, block->bits));
+    }
+
+    // Returns the number of bits which are required to store |value|
+    static uint8_t get_bit_width(T value) {
+      uint8_t bits = 0;
+      while (value) {
+        bits++;
+        value >>= 1;
+      }
+      return (bits);
+    }
+
+    // Returns the size of the packed data of the sorted |values|
+    static size_t get_packed_size(const T *values, size_t count) {
+      return (get_packed_size(count,
+                      get_bit_width(values[count - 1] - values[0])));
+    }
+
+    // Reads a bit-packed value of |bits| bits, starting at bit |position|
+    static T read_bits(const uint8_t *data, size_t position, size_t bits) {
+      const uint8_t *p = data + position / 8;
+      size_t shift = position % 8;
+      size_t filled = 0;
+      uint64_t value = 0;
+      while (filled < bits) {
+        value |= (uint64_t)(*p++ >> shift) << filled;
+        filled += 8 - shift;
+        shift = 0;
+      }
+      if (bits < 64)
+        value &= ((uint64_t)1 << bits) - 1;
+      return ((T)value);
+    }
+
+    // Writes a value of |bits| bits, starting at bit |position|. The
+    // target bits must be zeroed.
+    static void write_bits(uint8_t *data, size_t position, size_t bits,
+                    uint64_t value) {
+      uint8_t *p = data + position / 8;
+      size_t shift = position % 8;
+      size_t written = 0;
+      while (written < bits) {
+        *p++ |= (uint8_t)((value >> written) << shift);
+        written += 8 - shift;
+        shift = 0;
+      }
+    }
+
+    // Returns the value at position |i| of a block; |data| is the packed
+    // data of the block
+    static T get_value(const PForBlock *block, const uint8_t *data,
+                    size_t i) {
+      if (i == 0)
+        return ((T)block->base);
+      return ((T)block->base
+                      + read_bits(data, (i - 1) * block->bits, block->bits));
+    }
+
+    // Returns the key at |slot|
+    T get_key_value(int slot) const {
+      int first;
+      int b = find_block_by_slot(slot, &first);
+      const PForBlock *block = get_block(b);
+      return (get_value(block, get_block_data(block), slot - first));
+    }
+
+    // Returns the block that contains |key| (or would contain it). This is
+    // the last block with a base <= |key|, or the first block.
+    int find_block(T key) const {
+      int left = 0;
+      int right = (int)get_header()->block_count - 1;
+      while (left < right) {
+        int middle = (left + right + 1) / 2;
+        if ((T)get_block(middle)->base <= key)
+          left = middle;
+        else
+          right = middle - 1;
+      }
+      return (left);
+    }
+
+    // Returns the block which stores |slot|; the slot of its first key
+    // is returned in |pfirst|. If |slot| is beyond the last key then the
+    // last block is returned.
+    int find_block_by_slot(int slot, int *pfirst) const {
+      int block_count = (int)get_header()->block_count;
+      int first = 0;
+      int b = 0;
+      for (; b < block_count - 1; b++) {
+        int key_count = get_block(b)->key_count;
+        if (slot < first + key_count)
+          break;
+        first += key_count;
+      }
+      *pfirst = first;
+      return (b);
+    }
+
+    // Returns the slot of the first key of block |b|
+    int get_first_slot(int b) const {
+      int first = 0;
+      for (int i = 0; i < b; i++)
+        first += get_block(i)->key_count;
+      return (first);
+    }
+
+    // Decodes a block to |values|; returns the number of keys
+    size_t decode_block(int b, T *values) const {
+      const PForBlock *block = get_block(b);
+      const uint8_t *data = get_block_data(block);
+      for (size_t i = 0; i < block->key_count; i++)
+        values[i] = get_value(block, data, i);
+      return (block->key_count);
+    }
+
+    // Returns the position where a full block is split after |value| was
+    // inserted at |pos|. Appending keys (the most common case for
+    // sequential keys) leaves the full block untouched.
+    static size_t get_split_pivot(size_t pos, size_t count) {
+      if (pos == count - 1)
+        return (count - 1);
+      if (pos == 0)
+        return (1);
+      return (count / 2);
+    }
+
+    // Returns the number of bytes that the range grows if |value| is
+    // inserted
+    size_t get_insert_growth(T value) const {
+      const PForHeader *header = get_header();
+      size_t index_growth = 0;
+      if (header->block_count == header->index_capacity)
+        index_growth = kIndexIncrement * sizeof(PForBlock);
+
+      if (header->block_count == 0)
+        return (index_growth);
+
+      int b = find_block(value);
+      T values[kMaxKeysPerBlock + 1];
+      size_t count = decode_block(b, values);
+      size_t old_size = get_packed_size(values, count);
+      size_t pos = std::lower_bound(values, values + count, value) - values;
+      ::memmove(&values[pos + 1], &values[pos], sizeof(T) * (count - pos));
+      values[pos] = value;
+      count++;
+
+      size_t new_size;
+      if (count > kMaxKeysPerBlock) {
+        size_t pivot = get_split_pivot(pos, count);
+        new_size = get_packed_size(values, pivot)
+                + get_packed_size(values + pivot, count - pivot)
+                + index_growth;
+      }
+      else
+        new_size = get_packed_size(values, count);
+      return (new_size > old_size ? new_size - old_size : 0);
+    }
+
+    // Encodes the sorted |values| and stores them in block |b|
+    void write_block(int b, const T *values, size_t count) {
+      PForBlock *block = get_block(b);
+      uint8_t bits = get_bit_width(values[count - 1] - values[0]);
+      resize_block(b, get_block_size(block), get_packed_size(count, bits));
+
+      block->base = values[0];
+      block->key_count = (uint16_t)count;
+      block->bits = bits;
+
+      uint8_t *data = get_block_data(block);
+      ::memset(data, 0, get_block_size(block));
+      for (size_t i = 1; i < count; i++)
+        write_bits(data, (i - 1) * bits, bits, values[i] - values[0]);
+    }
+
+    // Changes the size of the packed data of block |b| from |old_size| to
+    // |new_size|; shifts the data of the following blocks
+    void resize_block(int b, size_t old_size, size_t new_size) {
+      if (new_size == old_size)
+        return;
+
+      PForHeader *header = get_header();
+      PForBlock *block = get_block(b);
+      uint8_t *payload = get_payload();
+      uint32_t end = block->offset + (uint32_t)old_size;
+      ::memmove(payload + block->offset + new_size, payload + end,
+                      header->payload_size - end);
+
+      for (int i = b + 1; i < (int)header->block_count; i++) {
+        PForBlock *next = get_block(i);
+        next->offset = next->offset + (uint32_t)new_size - (uint32_t)old_size;
+      }
+      header->payload_size = header->payload_size + (uint32_t)new_size
+              - (uint32_t)old_size;
+    }
+
+    // Inserts an empty block at position |b| of the BlockIndex
+    void add_block(int b) {
+      PForHeader *header = get_header();
+      if (header->block_count == header->index_capacity)
+        set_index_capacity(header->index_capacity + kIndexIncrement);
+
+      PForBlock *block = get_block(b);
+      uint32_t offset = header->payload_size;
+      if (b < (int)header->block_count) {
+        offset = block->offset;
+        ::memmove(block + 1, block,
+                      sizeof(PForBlock) * (header->block_count - b));
+      }
+
+      ::memset(block, 0, sizeof(PForBlock));
+      block->offset = offset;
+      block->key_count = 1;
+      header->block_count++;
+    }
+
+    // Removes block |b| from the BlockIndex
+    void remove_block(int b) {
+      PForHeader *header = get_header();
+      PForBlock *block = get_block(b);
+      resize_block(b, get_block_size(block), 0);
+      ::memmove(block, block + 1,
+                      sizeof(PForBlock) * (header->block_count - b - 1));
+      header->block_count--;
+    }
+
+    // Appends a block which was already encoded
+    void append_packed_block(const PForBlock *source, const uint8_t *data) {
+      int b = (int)get_header()->block_count;
+      add_block(b);
+      size_t size = get_block_size(source);
+      resize_block(b, 0, size);
+
+      PForBlock *block = get_block(b);
+      block->base = source->base;
+      block->key_count = source->key_count;
+      block->bits = source->bits;
+      ::memcpy(get_block_data(block), data, size);
+    }
+
+    // Changes the capacity of the BlockIndex; moves the Payload
+    void set_index_capacity(size_t capacity) {
+      PForHeader *header = get_header();
+      if (capacity == header->index_capacity)
+        return;
+      ham_assert(capacity >= header->block_count);
+      uint8_t *payload = get_payload();
+      header->index_capacity = (uint32_t)capacity;
+      ::memmove(get_payload(), payload, header->payload_size);
+    }
+
+    // Discards all keys at and after |node_count|
+    void truncate(size_t node_count) {
+      PForHeader *header = get_header();
+      int block_count = (int)header->block_count;
+      size_t first = 0;
+      int b = 0;
+      for (; b < block_count; b++) {
+        size_t key_count = get_block(b)->key_count;
+        if (first + key_count > node_count)
+          break;
+        first += key_count;
+      }
+      if (b == block_count)
+        return;
+
+      // the first block is shortened, all following blocks are discarded
+      if (node_count > first) {
+        T values[kMaxKeysPerBlock + 1];
+        decode_block(b, values);
+        write_block(b, values, node_count - first);
+        b++;
+      }
+
+      if (b < block_count)
+        header->payload_size = get_block(b)->offset;
+      header->block_count = b;
+    }
+
+    // The serialized key data
+    uint8_t *m_data;
+
+    // A temporary buffer for get_key_data()
+    T m_key;
+
+    // A temporary buffer for scan()
+    DynamicArray<T> m_scan_buffer;
+};
+
+} // namespace DefLayout
+
+} // namespace hamsterdb
+
+#endif /* HAM_BTREE_KEYS_FOR_H */
@@ -41,6 +41,7 @@
 #include "2page/page.h"
 #include "3btree/btree_node.h"
 #include "3btree/btree_keys_base.h"
+#include "3btree/btree_keys_simd.h"
 
 #ifndef HAM_ROOT_H
 #  error "root.h was not included"
@@ -79,6 +80,11 @@ class PodKeyList : public BaseKeyList
     // Constructor
     PodKeyList(LocalDatabase *db)
       : m_data(0) {
+      const EnvironmentConfiguration &config = db->lenv()->config();
+      m_isa = SimdSearch::select_isa(config.simd_search);
+      m_linear_threshold = config.linear_search_threshold;
+      if (m_linear_threshold == 0)
+        m_linear_threshold = SimdSearch::kDefaultThresholdBytes / sizeof(T);
     }
 
     // Creates a new PodKeyList starting at |ptr|, total size is
@@ -109,7 +115,8 @@ class PodKeyList : public BaseKeyList
     int find(Context *context, size_t node_count, const ham_key_t *hkey,
                     Cmp &comparator) {
       T key = *(T *)hkey->data;
-      T *result = std::lower_bound(&m_data[0], &m_data[node_count], key);
+      T *result = &m_data[SimdSearch::lower_bound(m_isa, m_linear_threshold,
+                              m_data, node_count, key)];
       if (result == &m_data[node_count] || *result != key)
         return (-1);
       return (result - &m_data[0]);
@@ -120,7 +127,8 @@ class PodKeyList : public BaseKeyList
     int find_lower_bound(Context *context, size_t node_count,
                     const ham_key_t *hkey, Cmp &comparator, int *pcmp) {
       T key = *(T *)hkey->data;
-      T *result = std::lower_bound(&m_data[0], &m_data[node_count], key);
+      T *result = &m_data[SimdSearch::lower_bound(m_isa, m_linear_threshold,
+                              m_data, node_count, key)];
       if (result == &m_data[node_count]) {
         if (key > m_data[node_count - 1]) {
           *pcmp = +1;
@@ -245,6 +253,12 @@ class PodKeyList : public BaseKeyList
 
     // The actual array of T's
     T *m_data;
+
+    // The instruction set for searching (HAM_SIMD_*)
+    int m_isa;
+
+    // Switch to linear search if less than this number of keys are left
+    size_t m_linear_threshold;
 };
 
 } // namespace PaxLayout
@@ -0,0 +1,659 @@
+/*
+ * Copyright (C) 2005-2015 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Prefix compressed variable length keys
+ *
+ * A VariableLengthKeyList which stores a common prefix once per node.
+ * The key range starts with a small header:
+ *
+ *   |PrefixSize|Prefix...|Padding|UpfrontIndex...|
+ *
+ * PrefixSize is 8 bit; the header is padded to a multiple of 4 bytes.
+ *
+ * Each key remembers how many bytes it shares with the node's prefix; only
+ * the remaining suffix is stored. Keys which do not share (enough) bytes
+ * with the prefix are stored uncompressed, exactly like in the
+ * VariableLengthKeyList. The format of a compressed key is:
+ *
+ *   |Flags|SharedSize|Suffix...|
+ *
+ * where Flags has BtreeKey::kPrefixCompressed set, and SharedSize is 8 bit.
+ *
+ * The prefix is (re-)calculated whenever the node is rearranged, i.e.
+ * when it is full, split or merged. It is the longest common prefix of
+ * the first and the last key, and therefore shared by all keys in between.
+ *
+ * Since every key stores its shared length, the binary search does not
+ * have to decompress any key: the search key is compared against the
+ * prefix only once, and then against the suffixes.
+ *
+ * Extended keys are never compressed. The threshold for extended keys
+ * is applied to the full key size; a compressed key can therefore always
+ * be stored uncompressed if its node is re-encoded.
+ *
+ * This KeyList requires a lexicographical comparator (VariableSizeCompare).
+ *
+ * @exception_safe: unknown
+ * @thread_safe: unknown
+ */
+
+#ifndef HAM_BTREE_KEYS_PREFIX_H
+#define HAM_BTREE_KEYS_PREFIX_H
+
+#include "0root/root.h"
+
+#include <vector>
+
+// Always verify that a file of level N does not include headers > N!
+#include "1globals/globals.h"
+#include "1base/dynamic_array.h"
+#include "3btree/btree_flags.h"
+#include "3btree/btree_keys_varlen.h"
+
+#ifndef HAM_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace hamsterdb {
+
+namespace DefLayout {
+
+class PrefixCompressedKeyList : public VariableLengthKeyList
+{
+    // A key which was collected for re-encoding; |offset| is relative to
+    // the arena of the KeyBuffer
+    struct CollectedKey {
+      uint8_t flags;
+      uint32_t offset;
+      uint32_t size;
+    };
+
+    // A set of keys which is re-encoded with a different prefix
+    struct KeyBuffer {
+      const uint8_t *get_data(size_t i) const {
+        return (arena.get_ptr() + keys[i].offset);
+      }
+
+      ByteArray arena;
+      std::vector<CollectedKey> keys;
+    };
+
+  public:
+    enum {
+      // A flag whether this KeyList has sequential data
+      kHasSequentialData = 0,
+
+      // A flag whether this KeyList supports the scan() call
+      kSupportsBlockScans = 0,
+
+      // This KeyList can reduce its capacity in order to release storage
+      kCanReduceCapacity = 1,
+
+      // This KeyList has a custom find() implementation
+      kCustomFind = 1,
+
+      // This KeyList has a custom find_lower_bound() implementation
+      kCustomFindLowerBound = 1,
+
+      // Keys sharing less bytes with the prefix are stored uncompressed
+      kMinSharedSize = 4,
+
+      // The maximum size of the prefix (SharedSize is 8 bit)
+      kMaxPrefixSize = 255,
+    };
+
+    // Constructor
+    PrefixCompressedKeyList(LocalDatabase *db)
+      : VariableLengthKeyList(db) {
+    }
+
+    // Creates a new KeyList starting at |ptr|, total size is
+    // |range_size| (in bytes)
+    void create(uint8_t *data, size_t range_size) {
+      m_data = data;
+      m_range_size = range_size;
+      m_data[0] = 0;
+      size_t header_size = get_header_size();
+      m_index.create(m_data + header_size, range_size - header_size,
+                      (range_size - header_size) / get_full_key_size());
+    }
+
+    // Opens an existing KeyList
+    void open(uint8_t *data, size_t range_size, size_t node_count) {
+      m_data = data;
+      m_range_size = range_size;
+      size_t header_size = get_header_size();
+      m_index.open(m_data + header_size, range_size - header_size);
+    }
+
+    // Calculates the required size for a range
+    size_t get_required_range_size(size_t node_count) const {
+      return (get_header_size() + m_index.get_required_range_size(node_count));
+    }
+
+    // Copies a key into |dest|. Compressed keys are assembled in the |arena|,
+    // even if |deep_copy| is false.
+    void get_key(Context *context, int slot, ByteArray *arena, ham_key_t *dest,
+                    bool deep_copy = true) {
+      uint8_t *p = get_chunk(slot);
+      if (likely((*p & BtreeKey::kPrefixCompressed) == 0)) {
+        VariableLengthKeyList::get_key(context, slot, arena, dest, deep_copy);
+        return;
+      }
+
+      size_t shared = p[1];
+      size_t size = shared + m_index.get_chunk_size(slot) - 2;
+      dest->size = size;
+
+      // allocate memory (if required)
+      if (deep_copy == false || !(dest->flags & HAM_KEY_USER_ALLOC)) {
+        arena->resize(size);
+        dest->data = arena->get_ptr();
+      }
+      memcpy(dest->data, get_prefix(), shared);
+      memcpy((uint8_t *)dest->data + shared, p + 2, size - shared);
+    }
+
+    // Inserts the |key| at the position identified by |slot|. The key
+    // is compressed if it shares enough bytes with the prefix.
+    template<typename Cmp>
+    PBtreeNode::InsertResult insert(Context *context, size_t node_count,
+                                const ham_key_t *key, uint32_t flags,
+                                Cmp &comparator, int slot) {
+      if (key->size <= m_extkey_threshold) {
+        size_t shared = get_shared_size(get_prefix(), get_prefix_size(),
+                        (const uint8_t *)key->data, key->size);
+        if (shared >= kMinSharedSize
+              && m_index.can_allocate_space(node_count,
+                        key->size - shared + 2)) {
+          m_index.insert(node_count, slot);
+          store_key(node_count + 1, slot, 0, (const uint8_t *)key->data,
+                          key->size, shared);
+
+          // update the statistics
+          Globals::ms_bytes_before_compression += key->size;
+          Globals::ms_bytes_after_compression += key->size - shared + 1;
+          return (PBtreeNode::InsertResult(0, slot));
+        }
+      }
+
+      Globals::ms_bytes_before_compression += key->size;
+      Globals::ms_bytes_after_compression += key->size;
+      return (VariableLengthKeyList::insert(context, node_count, key, flags,
+                              comparator, slot));
+    }
+
+    // Performs a lower-bound search for a key; the keys are not
+    // decompressed
+    template<typename Cmp>
+    int find_lower_bound(Context *context, size_t node_count,
+                    const ham_key_t *key, Cmp &comparator, int *pcmp) {
+      size_t matched;
+      int prefix_cmp = compare_prefix(key, &matched);
+
+      int right = (int)node_count;
+      int left = 0;
+      int last = right + 1;
+
+      *pcmp = -1;
+
+      while (right - left > 0) {
+        /* get the median item; if it's identical with the "last" item,
+         * we've found the slot */
+        int middle = (left + right) / 2;
+
+        if (middle == last) {
+          *pcmp = 1;
+          return (middle);
+        }
+
+        /* compare it against the key */
+        *pcmp = compare(context, key, matched, prefix_cmp, middle,
+                        comparator);
+
+        /* found it? */
+        if (*pcmp == 0)
+          return (middle);
+
+        /* if the key is bigger than the item: search "to the left" */
+        if (*pcmp < 0) {
+          if (right == 0) {
+            ham_assert(middle == 0);
+            return (-1);
+          }
+          right = middle;
+        }
+        /* otherwise search "to the right" */
+        else {
+          last = middle;
+          left = middle;
+        }
+      }
+
+      return (-1);
+    }
+
+    // Finds a key
+    template<typename Cmp>
+    int find(Context *context, size_t node_count, const ham_key_t *key,
+                    Cmp &comparator) {
+      int cmp = 0;
+      int slot = find_lower_bound(context, node_count, key, comparator, &cmp);
+      if (slot == -1 || cmp != 0)
+        return (-1);
+      return (slot);
+    }
+
+    // Copies |count| key from this[sstart] to dest[dstart]. If |dest| is
+    // empty (i.e. after a split) then it will use the common prefix of the
+    // copied keys.
+    void copy_to(int sstart, size_t node_count,
+                    PrefixCompressedKeyList &dest, size_t other_node_count,
+                    int dstart) {
+      size_t to_copy = node_count - sstart;
+      ham_assert(to_copy > 0);
+
+      // make sure that the other node has sufficient capacity in its
+      // UpfrontIndex
+      dest.m_index.change_range_size(other_node_count, 0, 0,
+                      m_index.get_capacity());
+
+      KeyBuffer buffer;
+      collect_keys(sstart, to_copy, &buffer);
+
+      bool encoded = false;
+      if (other_node_count == 0) {
+        uint8_t prefix[kMaxPrefixSize];
+        size_t prefix_size = calculate_prefix(sstart, to_copy, prefix);
+        size_t capacity = dest.m_index.get_capacity();
+        encoded = dest.encode_keys(buffer, prefix, prefix_size, capacity);
+        // the source prefix always fits if both nodes have the same layout
+        if (!encoded)
+          encoded = dest.encode_keys(buffer, get_prefix(), get_prefix_size(),
+                          capacity);
+      }
+
+      // otherwise append the keys, compressed with the prefix of |dest|
+      if (!encoded) {
+        for (size_t i = 0; i < to_copy; i++) {
+          const CollectedKey &key = buffer.keys[i];
+          dest.m_index.insert(other_node_count + i, dstart + i);
+          dest.store_key(other_node_count + i + 1, dstart + i, key.flags,
+                          buffer.get_data(i), key.size);
+        }
+      }
+
+      // A lot of keys will be invalidated after copying, therefore make
+      // sure that the next_offset is recalculated when it's required
+      m_index.invalidate_next_offset();
+    }
+
+    // Checks the integrity of this node. Throws an exception if there is a
+    // violation.
+    void check_integrity(Context *context, size_t node_count) const {
+      VariableLengthKeyList::check_integrity(context, node_count);
+
+      size_t prefix_size = get_prefix_size();
+      for (size_t i = 0; i < node_count; i++) {
+        const uint8_t *p = get_chunk(i);
+        if (!(*p & BtreeKey::kPrefixCompressed))
+          continue;
+        if (*p & BtreeKey::kExtendedKey) {
+          ham_log(("key %u is extended and compressed", (unsigned)i));
+          throw Exception(HAM_INTEGRITY_VIOLATED);
+        }
+        if (p[1] > prefix_size || p[1] < kMinSharedSize) {
+          ham_log(("key %u has invalid shared size %u (prefix size %u)",
+                          (unsigned)i, (unsigned)p[1], (unsigned)prefix_size));
+          throw Exception(HAM_INTEGRITY_VIOLATED);
+        }
+        if (get_key_size(i) > m_extkey_threshold) {
+          ham_log(("key size %d, but key is not extended", get_key_size(i)));
+          throw Exception(HAM_INTEGRITY_VIOLATED);
+        }
+      }
+    }
+
+    // Rearranges the list. Re-encodes all keys if a different prefix
+    // saves space (or, if |force| is true, does not waste space).
+    void vacuumize(size_t node_count, bool force) {
+      if (node_count == 0) {
+        if (force && get_prefix_size() > 0)
+          reset_prefix();
+      }
+      else if (recompress(node_count, force))
+        return;
+
+      VariableLengthKeyList::vacuumize(node_count, force);
+    }
+
+    // Change the range size; the capacity will be adjusted, the data is
+    // copied as necessary
+    void change_range_size(size_t node_count, uint8_t *new_data_ptr,
+            size_t new_range_size, size_t capacity_hint) {
+      size_t header_size = get_header_size();
+      if (!new_data_ptr)
+        new_data_ptr = m_data;
+
+      // no capacity given? then try to find a good default one
+      if (capacity_hint == 0) {
+        capacity_hint = (new_range_size - header_size
+                - m_index.get_next_offset(node_count)
+                - get_full_key_size()) / m_index.get_full_index_size();
+        if (capacity_hint <= node_count)
+          capacity_hint = node_count + 1;
+      }
+
+      // if there's not enough space for the new capacity then try to reduce
+      // the capacity
+      if (header_size + m_index.get_next_offset(node_count)
+                      + get_full_key_size(0)
+                      + capacity_hint * m_index.get_full_index_size()
+                      + UpfrontIndex::kPayloadOffset
+                > new_range_size)
+        capacity_hint = node_count + 1;
+
+      // the header is moved before the index if the range moves "to the
+      // left", otherwise afterwards
+      if (new_data_ptr < m_data)
+        memmove(new_data_ptr, m_data, header_size);
+      m_index.change_range_size(node_count, new_data_ptr + header_size,
+                      new_range_size - header_size, capacity_hint);
+      if (new_data_ptr > m_data)
+        memmove(new_data_ptr, m_data, header_size);
+
+      m_data = new_data_ptr;
+      m_range_size = new_range_size;
+    }
+
+    // Fills the btree_metrics structure
+    void fill_metrics(btree_metrics_t *metrics, size_t node_count) {
+      BaseKeyList::fill_metrics(metrics, node_count);
+      BtreeStatistics::update_min_max_avg(&metrics->keylist_index,
+              (uint32_t)(get_header_size() + m_index.get_capacity()
+                    * m_index.get_full_index_size()));
+      BtreeStatistics::update_min_max_avg(&metrics->keylist_unused,
+              m_range_size - (uint32_t)get_required_range_size(node_count));
+    }
+
+    // Prints a slot to |out| (for debugging)
+    void print(Context *context, int slot, std::stringstream &out) {
+      ByteArray arena;
+      ham_key_t tmp = {0};
+      get_key(context, slot, &arena, &tmp);
+      out << std::string((const char *)tmp.data, tmp.size);
+    }
+
+    // Returns the size of a key
+    size_t get_key_size(int slot) const {
+      const uint8_t *p = get_chunk(slot);
+      if (*p & BtreeKey::kPrefixCompressed)
+        return (p[1] + m_index.get_chunk_size(slot) - 2);
+      return (m_index.get_chunk_size(slot) - 1);
+    }
+
+    // Returns the size of the node's prefix
+    size_t get_prefix_size() const {
+      return (m_data[0]);
+    }
+
+    // Returns a pointer to the node's prefix
+    const uint8_t *get_prefix() const {
+      return (m_data + 1);
+    }
+
+  private:
+    // Returns the size of the header (with padding)
+    static size_t get_header_size(size_t prefix_size) {
+      return ((1 + prefix_size + 3) & ~3);
+    }
+
+    // Returns the size of the current header
+    size_t get_header_size() const {
+      return (get_header_size(get_prefix_size()));
+    }
+
+    // Returns the number of bytes that |data| shares with |prefix|
+    static size_t get_shared_size(const uint8_t *prefix, size_t prefix_size,
+                    const uint8_t *data, size_t size) {
+      size_t max = std::min(prefix_size, size);
+      size_t i = 0;
+      while (i < max && prefix[i] == data[i])
+        i++;
+      return (i);
+    }
+
+    // Returns the size of a chunk when |size| bytes are stored, of which
+    // |shared| bytes are part of the prefix
+    static size_t get_chunk_size(size_t size, size_t shared) {
+      if (shared >= kMinSharedSize)
+        return (size - shared + 2);
+      return (size + 1);
+    }
+
+    // Returns a pointer to the chunk of a key
+    uint8_t *get_chunk(int slot) const {
+      return (m_index.get_chunk_data_by_offset(m_index.get_chunk_offset(slot)));
+    }
+
+    // Compares |key| against the node's prefix. Returns the number of
+    // matching bytes in |pmatched|
+    int compare_prefix(const ham_key_t *key, size_t *pmatched) const {
+      size_t prefix_size = get_prefix_size();
+      const uint8_t *prefix = get_prefix();
+      const uint8_t *data = (const uint8_t *)key->data;
+      size_t matched = get_shared_size(prefix, prefix_size, data, key->size);
+      *pmatched = matched;
+      if (matched == prefix_size)
+        return (0);
+      if (matched == key->size)
+        return (-1);
+      return (data[matched] < prefix[matched] ? -1 : +1);
+    }
+
+    // Compares |key| against the key in |slot|. |matched| and |prefix_cmp|
+    // are the results of compare_prefix().
+    template<typename Cmp>
+    int compare(Context *context, const ham_key_t *key, size_t matched,
+                    int prefix_cmp, int slot, Cmp &comparator) {
+      uint8_t *p = get_chunk(slot);
+      if (*p & BtreeKey::kPrefixCompressed) {
+        size_t shared = p[1];
+        // the slot shares more bytes with the prefix than the key does;
+        // they differ at the same position as the key and the prefix
+        if (shared > matched)
+          return (prefix_cmp);
+        return (comparator((const uint8_t *)key->data + shared,
+                                key->size - shared, p + 2,
+                                m_index.get_chunk_size(slot) - 2));
+      }
+      if (unlikely(*p & BtreeKey::kExtendedKey)) {
+        ham_key_t tmp = {0};
+        get_extended_key(context, get_extended_blob_id(slot), &tmp);
+        return (comparator(key->data, key->size, tmp.data, tmp.size));
+      }
+      return (comparator(key->data, key->size, p + 1,
+                              m_index.get_chunk_size(slot) - 1));
+    }
+
+    // Stores a key in a |slot| which was already inserted in the index.
+    // |data| is the full key (or the blob id of an extended key).
+    void store_key(size_t node_count, int slot, uint8_t flags,
+                    const uint8_t *data, size_t size) {
+      size_t shared = 0;
+      if (!(flags & BtreeKey::kExtendedKey))
+        shared = get_shared_size(get_prefix(), get_prefix_size(), data, size);
+      store_key(node_count, slot, flags, data, size, shared);
+    }
+
+    // Stores a key in a |slot|; |shared| bytes are part of the prefix
+    void store_key(size_t node_count, int slot, uint8_t flags,
+                    const uint8_t *data, size_t size, size_t shared) {
+      uint32_t offset = m_index.allocate_space(node_count, slot,
+                      get_chunk_size(size, shared));
+      uint8_t *p = m_index.get_chunk_data_by_offset(offset);
+      if (shared >= kMinSharedSize) {
+        p[0] = flags | BtreeKey::kPrefixCompressed;
+        p[1] = (uint8_t)shared;
+        memcpy(p + 2, data + shared, size - shared);
+      }
+      else {
+        p[0] = flags;
+        memcpy(p + 1, data, size);
+      }
+    }
+
+    // Copies the (decompressed) key data of |slot| to |dest|; returns the
+    // size of the key. Extended keys are NOT loaded.
+    size_t copy_key(int slot, uint8_t *dest) const {
+      const uint8_t *p = get_chunk(slot);
+      size_t chunk_size = m_index.get_chunk_size(slot);
+      if (*p & BtreeKey::kPrefixCompressed) {
+        memcpy(dest, get_prefix(), p[1]);
+        memcpy(dest + p[1], p + 2, chunk_size - 2);
+        return (p[1] + chunk_size - 2);
+      }
+      memcpy(dest, p + 1, chunk_size - 1);
+      return (chunk_size - 1);
+    }
+
+    // Copies |count| keys, starting at |start|, to |buffer|
+    void collect_keys(int start, size_t count, KeyBuffer *buffer) const {
+      size_t total = 0;
+      for (size_t i = 0; i < count; i++)
+        total += get_key_size(start + i);
+      buffer->arena.resize(total);
+      buffer->keys.resize(count);
+
+      uint32_t offset = 0;
+      for (size_t i = 0; i < count; i++) {
+        CollectedKey &key = buffer->keys[i];
+        key.flags = *get_chunk(start + i) & ~BtreeKey::kPrefixCompressed;
+        key.offset = offset;
+        key.size = copy_key(start + i, buffer->arena.get_ptr() + offset);
+        offset += key.size;
+      }
+    }
+
+    // Calculates the common prefix of the first and the last key in the
+    // range [start, start + count), skipping extended keys. Since the keys
+    // are sorted, all keys in between share this prefix. Returns the size
+    // of the prefix.
+    size_t calculate_prefix(int start, size_t count, uint8_t *prefix) const {
+      int first = start;
+      int last = start + (int)count - 1;
+      while (first <= last && (*get_chunk(first) & BtreeKey::kExtendedKey))
+        first++;
+      while (last > first && (*get_chunk(last) & BtreeKey::kExtendedKey))
+        last--;
+      if (first > last)
+        return (0);
+
+      ByteArray first_key(get_key_size(first));
+      size_t prefix_size = std::min(copy_key(first, first_key.get_ptr()),
+                      (size_t)kMaxPrefixSize);
+      if (last != first) {
+        ByteArray last_key(get_key_size(last));
+        size_t last_size = copy_key(last, last_key.get_ptr());
+        prefix_size = get_shared_size(first_key.get_ptr(), prefix_size,
+                        last_key.get_ptr(), last_size);
+      }
+      memcpy(prefix, first_key.get_ptr(), prefix_size);
+      return (prefix_size);
+    }
+
+    // Returns the number of bytes required to store the keys in |buffer|
+    // (including the header)
+    static size_t get_encoded_size(const KeyBuffer &buffer,
+                    const uint8_t *prefix, size_t prefix_size) {
+      size_t total = get_header_size(prefix_size);
+      for (size_t i = 0; i < buffer.keys.size(); i++) {
+        const CollectedKey &key = buffer.keys[i];
+        size_t shared = 0;
+        if (!(key.flags & BtreeKey::kExtendedKey))
+          shared = get_shared_size(prefix, prefix_size, buffer.get_data(i),
+                          key.size);
+        total += get_chunk_size(key.size, shared);
+      }
+      return (total);
+    }
+
+    // Discards the current keys and stores the keys from |buffer|,
+    // compressed with |prefix|. Returns false (and leaves the list
+    // untouched) if there is not enough space.
+    bool encode_keys(const KeyBuffer &buffer, const uint8_t *prefix,
+                    size_t prefix_size, size_t capacity) {
+      if (get_encoded_size(buffer, prefix, prefix_size)
+                      + UpfrontIndex::kPayloadOffset
+                      + capacity * m_index.get_full_index_size()
+              > m_range_size)
+        return (false);
+
+      m_data[0] = (uint8_t)prefix_size;
+      memcpy(m_data + 1, prefix, prefix_size);
+      size_t header_size = get_header_size();
+      m_index.create(m_data + header_size, m_range_size - header_size,
+                      capacity);
+
+      for (size_t i = 0; i < buffer.keys.size(); i++) {
+        const CollectedKey &key = buffer.keys[i];
+        m_index.insert(i, i);
+        store_key(i + 1, i, key.flags, buffer.get_data(i), key.size);
+      }
+      return (true);
+    }
+
+    // Re-encodes all keys if the common prefix of the node has changed
+    // and the new prefix saves space. If |force| is true then the keys are
+    // also re-encoded if the required space does not change.
+    // Returns true if the keys were re-encoded.
+    bool recompress(size_t node_count, bool force) {
+      uint8_t prefix[kMaxPrefixSize];
+      size_t prefix_size = calculate_prefix(0, node_count, prefix);
+      if (prefix_size == get_prefix_size()
+              && !::memcmp(prefix, get_prefix(), prefix_size))
+        return (false);
+
+      KeyBuffer buffer;
+      collect_keys(0, node_count, &buffer);
+
+      size_t old_size = get_header_size();
+      for (size_t i = 0; i < node_count; i++)
+        old_size += m_index.get_chunk_size(i);
+      size_t new_size = get_encoded_size(buffer, prefix, prefix_size);
+      if (new_size > old_size || (new_size == old_size && !force))
+        return (false);
+
+      return (encode_keys(buffer, prefix, prefix_size,
+                              m_index.get_capacity()));
+    }
+
+    // Removes the prefix of an empty node
+    void reset_prefix() {
+      size_t capacity = m_index.get_capacity();
+      m_data[0] = 0;
+      size_t header_size = get_header_size();
+      m_index.create(m_data + header_size, m_range_size - header_size,
+                      capacity);
+    }
+};
+
+} // namespace DefLayout
+
+} // namespace hamsterdb
+
+#endif /* HAM_BTREE_KEYS_PREFIX_H */
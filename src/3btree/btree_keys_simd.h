@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2005-2015 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * SIMD search routines for the PodKeyList
+ *
+ * A lower-bound search first performs a binary search till the remaining
+ * range is smaller than a threshold, then counts the keys in this range
+ * which are smaller than the search key. Since the keys are sorted, this
+ * number is the lower bound. The counting is branch-free and vectorized
+ * with SSE2 or AVX2.
+ *
+ * SSE2 and AVX2 do not have unsigned compare instructions; unsigned
+ * integers are therefore converted to signed integers by flipping the
+ * sign bit. SSE2 cannot compare 64bit integers; these are counted with
+ * scalar code.
+ *
+ * The instruction set is picked at runtime (see os_get_simd_lane_width()),
+ * the functions are compiled with gcc's "target" attribute and do not
+ * require special compiler flags.
+ *
+ * @exception_safe: nothrow
+ * @thread_safe: yes
+ */
+
+#ifndef HAM_BTREE_KEYS_SIMD_H
+#define HAM_BTREE_KEYS_SIMD_H
+
+#include "0root/root.h"
+
+#include <algorithm>
+
+#if defined(__GNUC__) && !defined(__clang__) \
+        && (defined(__x86_64__) || defined(__i386__)) \
+        && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#  include <immintrin.h>
+#  define HAM_SIMD_SEARCH 1
+#  define HAM_TARGET_SSE2 __attribute__((target("sse2")))
+#  define HAM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#include "ham/hamsterdb.h"
+
+// Always verify that a file of level N does not include headers > N!
+#include "1os/os.h"
+
+#ifndef HAM_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace hamsterdb {
+
+namespace SimdSearch {
+
+enum {
+  // The default threshold for switching from binary search to linear
+  // search, in bytes
+  kDefaultThresholdBytes = 256
+};
+
+// Returns the instruction set (HAM_SIMD_*) which is used for |requested|.
+// If the CPU does not support the requested instruction set then the
+// best available one is used.
+inline int
+select_isa(int requested)
+{
+  if (requested == HAM_SIMD_NONE)
+    return (HAM_SIMD_NONE);
+#ifdef HAM_SIMD_SEARCH
+  int width = os_get_simd_lane_width();
+  if (width >= 8 && requested != HAM_SIMD_SSE2)
+    return (HAM_SIMD_AVX2);
+  if (width >= 4)
+    return (HAM_SIMD_SSE2);
+#endif
+  return (HAM_SIMD_NONE);
+}
+
+// Returns the SIMD lane width (the number of 32bit integers which are
+// processed in parallel) of an instruction set
+inline int
+lane_width(int isa)
+{
+  switch (isa) {
+    case HAM_SIMD_AVX2:
+      return (8);
+    case HAM_SIMD_SSE2:
+      return (4);
+    default:
+      return (0);
+  }
+}
+
+// Counts the keys in |data[0..length[| which are smaller than |key|
+template<typename T>
+inline size_t
+count_less_scalar(const T *data, size_t length, T key)
+{
+  size_t count = 0;
+  for (size_t i = 0; i < length; i++)
+    count += data[i] < key;
+  return (count);
+}
+
+#ifdef HAM_SIMD_SEARCH
+
+//
+// SSE2
+//
+
+HAM_TARGET_SSE2 inline size_t
+count_less_sse2(const uint8_t *data, size_t length, uint8_t key)
+{
+  const __m128i sign = _mm_set1_epi8((char)0x80);
+  const __m128i k = _mm_set1_epi8((char)(key ^ 0x80));
+  size_t count = 0, i = 0;
+  for (; i + 16 <= length; i += 16) {
+    __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)&data[i]),
+                    sign);
+    count += __builtin_popcount(_mm_movemask_epi8(_mm_cmplt_epi8(v, k)));
+  }
+  return (count + count_less_scalar(&data[i], length - i, key));
+}
+
+HAM_TARGET_SSE2 inline size_t
+count_less_sse2(const uint16_t *data, size_t length, uint16_t key)
+{
+  const __m128i sign = _mm_set1_epi16((short)0x8000);
+  const __m128i k = _mm_set1_epi16((short)(key ^ 0x8000));
+  size_t count = 0, i = 0;
+  for (; i + 8 <= length; i += 8) {
+    __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)&data[i]),
+                    sign);
+    // each 16bit lane sets two bits in the mask
+    count += __builtin_popcount(_mm_movemask_epi8(_mm_cmplt_epi16(v, k))) / 2;
+  }
+  return (count + count_less_scalar(&data[i], length - i, key));
+}
+
+HAM_TARGET_SSE2 inline size_t
+count_less_sse2(const uint32_t *data, size_t length, uint32_t key)
+{
+  const __m128i sign = _mm_set1_epi32((int)0x80000000);
+  const __m128i k = _mm_set1_epi32((int)(key ^ 0x80000000));
+  size_t count = 0, i = 0;
+  for (; i + 4 <= length; i += 4) {
+    __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)&data[i]),
+                    sign);
+    count += __builtin_popcount(_mm_movemask_ps(
+                    _mm_castsi128_ps(_mm_cmplt_epi32(v, k))));
+  }
+  return (count + count_less_scalar(&data[i], length - i, key));
+}
+
+HAM_TARGET_SSE2 inline size_t
+count_less_sse2(const uint64_t *data, size_t length, uint64_t key)
+{
+  // SSE2 has no 64bit compare
+  return (count_less_scalar(data, length, key));
+}
+
+HAM_TARGET_SSE2 inline size_t
+count_less_sse2(const float *data, size_t length, float key)
+{
+  const __m128 k = _mm_set1_ps(key);
+  size_t count = 0, i = 0;
+  for (; i + 4 <= length; i += 4)
+    count += __builtin_popcount(_mm_movemask_ps(
+                    _mm_cmplt_ps(_mm_loadu_ps(&data[i]), k)));
+  return (count + count_less_scalar(&data[i], length - i, key));
+}
+
+HAM_TARGET_SSE2 inline size_t
+count_less_sse2(const double *data, size_t length, double key)
+{
+  const __m128d k = _mm_set1_pd(key);
+  size_t count = 0, i = 0;
+  for (; i + 2 <= length; i += 2)
+    count += __builtin_popcount(_mm_movemask_pd(
+                    _mm_cmplt_pd(_mm_loadu_pd(&data[i]), k)));
+  return (count + count_less_scalar(&data[i], length - i, key));
+}
+
+//
+// AVX2
+//
+
+HAM_TARGET_AVX2 inline size_t
+count_less_avx2(const uint8_t *data, size_t length, uint8_t key)
+{
+  const __m256i sign = _mm256_set1_epi8((char)0x80);
+  const __m256i k = _mm256_set1_epi8((char)(key ^ 0x80));
+  size_t count = 0, i = 0;
+  for (; i + 32 <= length; i += 32) {
+    __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)&data[i]),
+                    sign);
+    count += __builtin_popcount((uint32_t)_mm256_movemask_epi8(
+                    _mm256_cmpgt_epi8(k, v)));
+  }
+  return (count + count_less_scalar(&data[i], length - i, key));
+}
+
+HAM_TARGET_AVX2 inline size_t
+count_less_avx2(const uint16_t *data, size_t length, uint16_t key)
+{
+  const __m256i sign = _mm256_set1_epi16((short)0x8000);
+  const __m256i k = _mm256_set1_epi16((short)(key ^ 0x8000));
+  size_t count = 0, i = 0;
+  for (; i + 16 <= length; i += 16) {
+    __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)&data[i]),
+                    sign);
+    // each 16bit lane sets two bits in the mask
+    count += __builtin_popcount((uint32_t)_mm256_movemask_epi8(
+                    _mm256_cmpgt_epi16(k, v))) / 2;
+  }
+  return (count + count_less_scalar(&data[i], length - i, key));
+}
+
+HAM_TARGET_AVX2 inline size_t
+count_less_avx2(const uint32_t *data, size_t length, uint32_t key)
+{
+  const __m256i sign = _mm256_set1_epi32((int)0x80000000);
+  const __m256i k = _mm256_set1_epi32((int)(key ^ 0x80000000));
+  size_t count = 0, i = 0;
+  for (; i + 8 <= length; i += 8) {
+    __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)&data[i]),
+                    sign);
+    count += __builtin_popcount(_mm256_movemask_ps(
+                    _mm256_castsi256_ps(_mm256_cmpgt_epi32(k, v))));
+  }
+  return (count + count_less_scalar(&data[i], length - i, key));
+}
+
+HAM_TARGET_AVX2 inline size_t
+count_less_avx2(const uint64_t *data, size_t length, uint64_t key)
+{
+  const __m256i sign = _mm256_set1_epi64x((long long)0x8000000000000000ull);
+  const __m256i k = _mm256_set1_epi64x((long long)(key
+                          ^ 0x8000000000000000ull));
+  size_t count = 0, i = 0;
+  for (; i + 4 <= length; i += 4) {
+    __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)&data[i]),
+                    sign);
+    count += __builtin_popcount(_mm256_movemask_pd(
+                    _mm256_castsi256_pd(_mm256_cmpgt_epi64(k, v))));
+  }
+  return (count + count_less_scalar(&data[i], length - i, key));
+}
+
+HAM_TARGET_AVX2 inline size_t
+count_less_avx2(const float *data, size_t length, float key)
+{
+  const __m256 k = _mm256_set1_ps(key);
+  size_t count = 0, i = 0;
+  for (; i + 8 <= length; i += 8)
+    count += __builtin_popcount(_mm256_movemask_ps(
+                    _mm256_cmp_ps(_mm256_loadu_ps(&data[i]), k, _CMP_LT_OQ)));
+  return (count + count_less_scalar(&data[i], length - i, key));
+}
+
+HAM_TARGET_AVX2 inline size_t
+count_less_avx2(const double *data, size_t length, double key)
+{
+  const __m256d k = _mm256_set1_pd(key);
+  size_t count = 0, i = 0;
+  for (; i + 4 <= length; i += 4)
+    count += __builtin_popcount(_mm256_movemask_pd(
+                    _mm256_cmp_pd(_mm256_loadu_pd(&data[i]), k, _CMP_LT_OQ)));
+  return (count + count_less_scalar(&data[i], length - i, key));
+}
+
+#endif // HAM_SIMD_SEARCH
+
+// Returns the index of the first key in |data[0..length[| which is not
+// smaller than |key| (like std::lower_bound). Performs a binary search
+// till less than |threshold| keys are left, then counts the remaining
+// keys with the instruction set |isa|.
+template<typename T>
+inline size_t
+lower_bound(int isa, size_t threshold, const T *data, size_t length, T key)
+{
+  if (isa == HAM_SIMD_NONE)
+    return (std::lower_bound(data, data + length, key) - data);
+
+  size_t start = 0;
+  while (length > threshold) {
+    size_t half = length / 2;
+    if (data[start + half] < key) {
+      start += half + 1;
+      length -= half + 1;
+    }
+    else
+      length = half;
+  }
+
+#ifdef HAM_SIMD_SEARCH
+  if (isa == HAM_SIMD_AVX2)
+    return (start + count_less_avx2(&data[start], length, key));
+  return (start + count_less_sse2(&data[start], length, key));
+#else
+  return (start + count_less_scalar(&data[start], length, key));
+#endif
+}
+
+} // namespace SimdSearch
+
+} // namespace hamsterdb
+
+#endif /* HAM_BTREE_KEYS_SIMD_H */
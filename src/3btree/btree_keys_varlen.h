@@ -410,7 +410,7 @@ class VariableLengthKeyList : public BaseKeyList
       return (m_index.get_chunk_size(slot) - 1);
     }
 
-  private:
+  protected:
     // Returns the flags of a key. Flags are defined in btree_flags.h
     uint8_t get_key_flags(int slot) const {
       uint32_t offset = m_index.get_chunk_offset(slot);
@@ -489,8 +489,9 @@ class VariableLengthKeyList : public BaseKeyList
       rec.data = key->data;
       rec.size = key->size;
 
+      // extended keys are not affected by record compression
       uint64_t blob_id = m_db->lenv()->blob_manager()->allocate(
-                                            context, &rec, 0);
+                      context, &rec, BlobManager::kDisableCompression);
       ham_assert(blob_id != 0);
       ham_assert(m_extkey_cache->find(blob_id) == m_extkey_cache->end());
 
@@ -314,6 +314,93 @@ struct FixedSizeCompare
   }
 };
 
+// Loads an (unaligned) big-endian 64bit word
+static inline uint64_t
+load_big_endian64(const uint8_t *p)
+{
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) \
+        && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  uint64_t v;
+  ::memcpy(&v, p, sizeof(v));
+  return (__builtin_bswap64(v));
+#else
+  return (((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48)
+          | ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32)
+          | ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16)
+          | ((uint64_t)p[6] << 8) | (uint64_t)p[7]);
+#endif
+}
+
+// Loads an (unaligned) big-endian 32bit word
+static inline uint32_t
+load_big_endian32(const uint8_t *p)
+{
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) \
+        && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  uint32_t v;
+  ::memcpy(&v, p, sizeof(v));
+  return (__builtin_bswap32(v));
+#else
+  return (((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16)
+          | ((uint32_t)p[2] << 8) | (uint32_t)p[3]);
+#endif
+}
+
+//
+// Compares |Size| bytes as a sequence of big-endian words; this has the
+// same result as memcmp(3). The recursion is resolved at compile time.
+//
+template<uint32_t Size>
+struct BigEndianWordCompare
+{
+  static int compare(const uint8_t *lhs, const uint8_t *rhs) {
+    uint64_t l = load_big_endian64(lhs);
+    uint64_t r = load_big_endian64(rhs);
+    if (l != r)
+      return (l < r ? -1 : +1);
+    return (BigEndianWordCompare<Size - 8>::compare(lhs + 8, rhs + 8));
+  }
+};
+
+template<>
+struct BigEndianWordCompare<4>
+{
+  static int compare(const uint8_t *lhs, const uint8_t *rhs) {
+    uint32_t l = load_big_endian32(lhs);
+    uint32_t r = load_big_endian32(rhs);
+    return (l < r ? -1 : (l > r ? +1 : 0));
+  }
+};
+
+template<>
+struct BigEndianWordCompare<0>
+{
+  static int compare(const uint8_t *, const uint8_t *) {
+    return (0);
+  }
+};
+
+//
+// A comparator for fixed length binary keys if the key size is known at
+// compile time (see BtreeIndexFactory). Instead of calling memcmp(3), the
+// keys are compared as big-endian integers.
+// |Size| must be a multiple of 4.
+//
+template<uint32_t Size>
+struct FixedWidthCompare
+{
+  FixedWidthCompare(LocalDatabase *) {
+  }
+
+  int operator()(const void *lhs_data, uint32_t lhs_size,
+          const void *rhs_data, uint32_t rhs_size) const {
+    ham_assert(lhs_size == Size);
+    ham_assert(rhs_size == Size);
+    return (BigEndianWordCompare<Size>::compare((const uint8_t *)lhs_data,
+                            (const uint8_t *)rhs_data));
+  }
+};
+
 //
 // The default comparator for two keys, implemented with memcmp(3).
 // Both keys can have different sizes! shorter strings are treated as
@@ -417,16 +417,19 @@ class DuplicateTable
 
     // Writes the modified duplicate table to disk; returns the new
     // table-id
+    //
+    // The table is not compressed because it is updated frequently
     uint64_t flush_duplicate_table(Context *context) {
       ham_record_t record = {0};
       record.data = m_table.get_ptr();
       record.size = m_table.get_size();
       if (!m_table_id)
         m_table_id = m_db->lenv()->blob_manager()->allocate(
-                        context, &record, 0);
+                        context, &record, BlobManager::kDisableCompression);
       else
         m_table_id = m_db->lenv()->blob_manager()->overwrite(
-                        context, m_table_id, &record, 0);
+                        context, m_table_id, &record,
+                        BlobManager::kDisableCompression);
       return (m_table_id);
     }
 
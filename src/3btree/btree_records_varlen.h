@@ -0,0 +1,503 @@
+/*
+ * Copyright (C) 2005-2015 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * RecordList for variable length records (without duplicates)
+ *
+ * Records up to a configurable size (see HAM_PARAM_INLINE_RECORD_THRESHOLD)
+ * are stored directly in the leaf; larger records are stored as blobs.
+ * Since the records have variable length, an UpfrontIndex is used
+ * (see btree_keys_varlen.h).
+ *
+ *   Format for each slot:
+ *
+ *       1 byte flags (kBlobSizeInline or 0)
+ *       if kBlobSizeInline is set:
+ *              1 byte record size
+ *              <size> bytes record data
+ *       otherwise:
+ *              8 byte record id of the blob
+ *
+ * Each chunk has at least 1 + 8 bytes. Therefore an inline record can
+ * always be replaced by a blob id without allocating additional space.
+ *
+ * @exception_safe: unknown
+ * @thread_safe: unknown
+ */
+
+#ifndef HAM_BTREE_RECORDS_VARLEN_H
+#define HAM_BTREE_RECORDS_VARLEN_H
+
+#include "0root/root.h"
+
+#include <algorithm>
+#include <sstream>
+#include <iostream>
+
+// Always verify that a file of level N does not include headers > N!
+#include "1globals/globals.h"
+#include "1base/dynamic_array.h"
+#include "2page/page.h"
+#include "3blob_manager/blob_manager.h"
+#include "3btree/btree_node.h"
+#include "3btree/btree_flags.h"
+#include "3btree/upfront_index.h"
+#include "3btree/btree_records_base.h"
+#include "4env/env_local.h"
+#include "4db/db_local.h"
+
+#ifndef HAM_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace hamsterdb {
+
+//
+// The template classes in this file are wrapped in a separate namespace
+// to avoid naming clashes with btree_impl_default.h
+//
+namespace DefLayout {
+
+class VariableLengthRecordList : public BaseRecordList
+{
+  public:
+    enum {
+      // A flag whether this RecordList has sequential data
+      kHasSequentialData = 0,
+
+      // The minimum size of a chunk: 1 byte flags + 8 byte blob id
+      kMinChunkSize = 1 + 8
+    };
+
+    // Constructor
+    VariableLengthRecordList(LocalDatabase *db, PBtreeNode *node)
+      : m_db(db), m_node(node), m_index(db), m_data(0) {
+      m_threshold = db->config().inline_record_threshold;
+      // records with 8 bytes or less are always stored inline
+      if (m_threshold < sizeof(uint64_t))
+        m_threshold = sizeof(uint64_t);
+      // UpfrontIndex's chunk_size is just 1 byte (max 255)
+      if (m_threshold > LocalDatabase::kMaxInlineRecordThreshold)
+        m_threshold = LocalDatabase::kMaxInlineRecordThreshold;
+    }
+
+    // Creates a new RecordList starting at |data|
+    void create(uint8_t *data, size_t range_size) {
+      m_data = data;
+      m_index.create(m_data, range_size, range_size / get_full_record_size());
+      m_range_size = range_size;
+    }
+
+    // Opens an existing RecordList
+    void open(uint8_t *data, size_t range_size, size_t node_count) {
+      m_data = data;
+      m_index.open(m_data, range_size);
+      m_range_size = range_size;
+    }
+
+    // Calculates the required size for a range with the specified |capacity|
+    size_t get_required_range_size(size_t node_count) const {
+      return (m_index.get_required_range_size(node_count));
+    }
+
+    // Returns the actual record size including overhead; this is the size
+    // of the largest inline record, because requires_split() has to make
+    // sure that such a record can always be stored
+    size_t get_full_record_size() const {
+      return (get_max_chunk_size() + m_index.get_full_index_size());
+    }
+
+    // Returns the record counter of a key
+    int get_record_count(Context *context, int slot) const {
+      return (m_index.get_chunk_size(slot) == 0 ? 0 : 1);
+    }
+
+    // Returns the record size
+    uint64_t get_record_size(Context *context, int slot,
+                    int duplicate_index = 0) const {
+      const uint8_t *p = get_chunk_data(slot);
+      if (p[0] & BtreeRecord::kBlobSizeInline)
+        return (p[1]);
+
+      LocalEnvironment *env = m_db->lenv();
+      return (env->blob_manager()->get_blob_size(context,
+                              *(uint64_t *)(p + 1)));
+    }
+
+    // Returns the full record and stores it in |dest|; memory must be
+    // allocated by the caller
+    void get_record(Context *context, int slot, ByteArray *arena,
+                    ham_record_t *record, uint32_t flags,
+                    int duplicate_index) const {
+      const uint8_t *p = get_chunk_data(slot);
+
+      // the record is stored as a blob
+      if (!(p[0] & BtreeRecord::kBlobSizeInline)) {
+        LocalEnvironment *env = m_db->lenv();
+        env->blob_manager()->read(context, *(uint64_t *)(p + 1), record,
+                        flags, arena);
+        return;
+      }
+
+      // the record is stored inline
+      uint32_t size = p[1];
+      const uint8_t *data = p + 2;
+      record->size = size;
+
+      if (flags & HAM_PARTIAL) {
+        if (size <= sizeof(uint64_t)) {
+          ham_trace(("flag HAM_PARTIAL is not allowed if record is "
+                     "stored inline"));
+          throw Exception(HAM_INV_PARAMETER);
+        }
+        if (record->partial_offset > size) {
+          ham_trace(("partial offset is greater than the total record size"));
+          throw Exception(HAM_INV_PARAMETER);
+        }
+        if (record->partial_offset + record->partial_size > size)
+          record->partial_size = size - record->partial_offset;
+        data += record->partial_offset;
+        size = record->partial_size;
+      }
+
+      if (size == 0) {
+        record->data = 0;
+        record->size = 0;
+        return;
+      }
+
+      if (flags & HAM_DIRECT_ACCESS)
+        record->data = (void *)data;
+      else {
+        if ((record->flags & HAM_RECORD_USER_ALLOC) == 0) {
+          arena->resize(size);
+          record->data = arena->get_ptr();
+        }
+        memcpy(record->data, data, size);
+      }
+    }
+
+    // Updates the record of a key
+    void set_record(Context *context, int slot, int duplicate_index,
+                ham_record_t *record, uint32_t flags,
+                uint32_t *new_duplicate_index = 0) {
+      LocalEnvironment *env = m_db->lenv();
+      size_t node_count = m_node->get_count();
+      uint32_t chunk_size = m_index.get_chunk_size(slot);
+
+      // the id of the existing blob (if there is one)
+      uint64_t blob_id = 0;
+      bool is_inline = false;
+      if (chunk_size > 0) {
+        uint8_t *p = get_chunk_data(slot);
+        if (p[0] & BtreeRecord::kBlobSizeInline)
+          is_inline = true;
+        else
+          blob_id = *(uint64_t *)(p + 1);
+      }
+
+      // A partial update is merged with the existing record, unless the
+      // BlobManager can perform it
+      ham_record_t full_record;
+      ByteArray full_arena;
+      if ((flags & HAM_PARTIAL)
+            && (record->size <= m_threshold || is_inline)) {
+        merge_partial_record(context, slot, is_inline, blob_id, record,
+                        &full_record, &full_arena);
+        record = &full_record;
+        flags &= ~HAM_PARTIAL;
+      }
+
+      // store the record inline, if there's enough space
+      size_t required_size = std::max((size_t)kMinChunkSize,
+                      (size_t)(2 + record->size));
+      bool store_inline = record->size <= m_threshold;
+      if (store_inline && chunk_size < required_size
+          && !m_index.can_allocate_space(node_count, required_size))
+        store_inline = false;
+
+      uint8_t *p;
+
+      if (store_inline) {
+        if (chunk_size < required_size)
+          p = allocate_chunk(node_count, slot, required_size);
+        else {
+          shrink_chunk(slot, required_size);
+          p = get_chunk_data(slot);
+        }
+        if (blob_id)
+          env->blob_manager()->erase(context, blob_id);
+        p[0] = BtreeRecord::kBlobSizeInline;
+        p[1] = (uint8_t)record->size;
+        if (record->size)
+          memcpy(&p[2], record->data, record->size);
+        return;
+      }
+
+      // otherwise store the record as a blob
+      if (chunk_size == 0)
+        p = allocate_chunk(node_count, slot, kMinChunkSize);
+      else {
+        shrink_chunk(slot, kMinChunkSize);
+        p = get_chunk_data(slot);
+      }
+      if (blob_id)
+        blob_id = env->blob_manager()->overwrite(context, blob_id, record,
+                        flags);
+      else
+        blob_id = env->blob_manager()->allocate(context, record, flags);
+      p[0] = 0;
+      memcpy(&p[1], &blob_id, sizeof(blob_id));
+    }
+
+    // Erases the record
+    void erase_record(Context *context, int slot, int duplicate_index = 0,
+                    bool all_duplicates = true) {
+      uint32_t chunk_size = m_index.get_chunk_size(slot);
+      if (chunk_size == 0)
+        return;
+
+      uint8_t *p = get_chunk_data(slot);
+      if (!(p[0] & BtreeRecord::kBlobSizeInline))
+        m_db->lenv()->blob_manager()->erase(context, *(uint64_t *)(p + 1), 0);
+
+      // adjust next_offset, if necessary
+      m_index.maybe_invalidate_next_offset(m_index.get_chunk_offset(slot)
+                      + chunk_size);
+      m_index.increase_vacuumize_counter(chunk_size);
+      m_index.set_chunk_size(slot, 0);
+    }
+
+    // Erases a slot. Only updates the UpfrontIndex; does NOT delete the
+    // record blobs!
+    void erase(Context *context, size_t node_count, int slot) {
+      m_index.erase(node_count, slot);
+    }
+
+    // Inserts a slot for one additional record
+    void insert(Context *context, size_t node_count, int slot) {
+      m_index.insert(node_count, slot);
+    }
+
+    // Copies |count| items from this[sstart] to dest[dstart]
+    void copy_to(int sstart, size_t node_count,
+                    VariableLengthRecordList &dest, size_t other_node_count,
+                    int dstart) {
+      // make sure that the other node has sufficient capacity in its
+      // UpfrontIndex
+      dest.m_index.change_range_size(other_node_count, 0, 0,
+                      m_index.get_capacity());
+
+      uint32_t doffset;
+      for (size_t i = 0; i < node_count - sstart; i++) {
+        size_t size = m_index.get_chunk_size(sstart + i);
+
+        dest.m_index.insert(other_node_count + i, dstart + i);
+        // destination offset
+        doffset = dest.m_index.allocate_space(other_node_count + i + 1,
+                dstart + i, size);
+        doffset = dest.m_index.get_absolute_offset(doffset);
+        // source offset
+        uint32_t soffset = m_index.get_absolute_chunk_offset(sstart + i);
+        // copy the data
+        memcpy(&dest.m_data[doffset], &m_data[soffset], size);
+      }
+
+      // After copying, the caller will reduce the node count drastically.
+      // Therefore invalidate the cached next_offset.
+      m_index.invalidate_next_offset();
+    }
+
+    // Returns the record id
+    uint64_t get_record_id(int slot, int duplicate_index = 0) const {
+      return (*(uint64_t *)(get_chunk_data(slot) + 1));
+    }
+
+    // Sets the record id
+    void set_record_id(int slot, uint64_t id) {
+      ham_assert(m_index.get_chunk_size(slot) >= kMinChunkSize);
+      uint8_t *p = get_chunk_data(slot);
+      p[0] = 0;
+      memcpy(&p[1], &id, sizeof(id));
+    }
+
+    // Checks the integrity of this node. Throws an exception if there is a
+    // violation.
+    void check_integrity(Context *context, size_t node_count) const {
+      for (size_t i = 0; i < node_count; i++) {
+        uint32_t chunk_size = m_index.get_chunk_size(i);
+        if (chunk_size == 0)
+          continue;
+        const uint8_t *p = get_chunk_data(i);
+        if (chunk_size < kMinChunkSize
+            || ((p[0] & BtreeRecord::kBlobSizeInline)
+                && (uint32_t)p[1] + 2 > chunk_size)) {
+          ham_trace(("integrity violated: record in slot %u exceeds its "
+                     "chunk", (unsigned)i));
+          throw Exception(HAM_INTEGRITY_VIOLATED);
+        }
+      }
+
+      m_index.check_integrity(node_count);
+    }
+
+    // Rearranges the list
+    void vacuumize(size_t node_count, bool force) {
+      if (force)
+        m_index.increase_vacuumize_counter(100);
+      m_index.maybe_vacuumize(node_count);
+    }
+
+    // Change the capacity; the capacity will be reduced, growing is not
+    // implemented. Which means that the data area must be copied; the offsets
+    // do not have to be changed.
+    void change_range_size(size_t node_count, uint8_t *new_data_ptr,
+                size_t new_range_size, size_t capacity_hint) {
+      // no capacity given? then try to find a good default one
+      if (capacity_hint == 0) {
+        capacity_hint = (new_range_size - m_index.get_next_offset(node_count)
+                - get_full_record_size()) / m_index.get_full_index_size();
+        if (capacity_hint <= node_count)
+          capacity_hint = node_count + 1;
+      }
+
+      // if there's not enough space for the new capacity then try to reduce
+      // the capacity
+      if (m_index.get_next_offset(node_count) + get_full_record_size()
+                      + capacity_hint * m_index.get_full_index_size()
+                      + UpfrontIndex::kPayloadOffset
+                > new_range_size)
+        capacity_hint = node_count + 1;
+
+      m_index.change_range_size(node_count, new_data_ptr, new_range_size,
+                capacity_hint);
+      m_data = new_data_ptr;
+      m_range_size = new_range_size;
+    }
+
+    // Returns true if there's not enough space for another record. Makes
+    // sure that there is ALWAYS enough headroom for the largest inline
+    // record.
+    bool requires_split(size_t node_count) {
+      return (m_index.requires_split(node_count, get_max_chunk_size()));
+    }
+
+    // Fills the btree_metrics structure
+    void fill_metrics(btree_metrics_t *metrics, size_t node_count) {
+      BaseRecordList::fill_metrics(metrics, node_count);
+      BtreeStatistics::update_min_max_avg(&metrics->recordlist_index,
+                      m_index.get_capacity() * m_index.get_full_index_size());
+      BtreeStatistics::update_min_max_avg(&metrics->recordlist_unused,
+                          m_range_size - get_required_range_size(node_count));
+    }
+
+    // Prints a slot to |out| (for debugging)
+    void print(Context *context, int slot, std::stringstream &out) const {
+      out << "(" << get_record_size(context, slot) << " bytes)";
+    }
+
+  private:
+    // Returns the size of the largest chunk (flags, size and the largest
+    // inline record)
+    size_t get_max_chunk_size() const {
+      return (2 + m_threshold);
+    }
+
+    // Returns a pointer to the chunk of a slot
+    uint8_t *get_chunk_data(int slot) {
+      return (&m_data[m_index.get_absolute_chunk_offset(slot)]);
+    }
+
+    // Returns a pointer to the chunk of a slot (const flavour)
+    const uint8_t *get_chunk_data(int slot) const {
+      return (&m_data[m_index.get_absolute_chunk_offset(slot)]);
+    }
+
+    // Allocates a (new) chunk for a slot; the previous chunk is moved to
+    // the freelist. Returns a pointer to the chunk's data.
+    uint8_t *allocate_chunk(size_t node_count, int slot, size_t size) {
+      uint32_t old_chunk_size = m_index.get_chunk_size(slot);
+      uint32_t old_chunk_offset = m_index.get_chunk_offset(slot);
+      uint32_t chunk_offset = m_index.allocate_space(node_count, slot, size);
+      if (old_chunk_size > 0 && old_chunk_offset != chunk_offset) {
+        m_index.add_to_freelist(node_count, old_chunk_offset, old_chunk_size);
+        m_index.increase_vacuumize_counter(old_chunk_size);
+      }
+      return (&m_data[m_index.get_absolute_offset(chunk_offset)]);
+    }
+
+    // Reduces the size of a chunk; the remaining space is reclaimed when
+    // the list is vacuumized
+    void shrink_chunk(int slot, size_t size) {
+      uint32_t chunk_size = m_index.get_chunk_size(slot);
+      if (chunk_size <= size)
+        return;
+      m_index.maybe_invalidate_next_offset(m_index.get_chunk_offset(slot)
+                      + chunk_size);
+      m_index.set_chunk_size(slot, (uint16_t)size);
+      m_index.increase_vacuumize_counter(chunk_size - size);
+    }
+
+    // Merges a partial |record| with the existing record of a slot and
+    // stores the full record in |full_record|
+    void merge_partial_record(Context *context, int slot, bool is_inline,
+                    uint64_t blob_id, const ham_record_t *record,
+                    ham_record_t *full_record, ByteArray *full_arena) {
+      full_arena->resize(record->size, 0);
+      uint8_t *data = (uint8_t *)full_arena->get_ptr();
+
+      if (is_inline) {
+        const uint8_t *p = get_chunk_data(slot);
+        memcpy(data, &p[2], std::min((uint32_t)p[1], record->size));
+      }
+      else if (blob_id) {
+        ham_record_t old_record = {0};
+        ByteArray old_arena;
+        m_db->lenv()->blob_manager()->read(context, blob_id, &old_record,
+                        0, &old_arena);
+        memcpy(data, old_record.data, std::min(old_record.size, record->size));
+      }
+
+      memcpy(&data[record->partial_offset], record->data,
+                      record->partial_size);
+
+      *full_record = *record;
+      full_record->data = data;
+      full_record->partial_offset = 0;
+      full_record->partial_size = 0;
+    }
+
+    // The database
+    LocalDatabase *m_db;
+
+    // The current node
+    PBtreeNode *m_node;
+
+    // The index which manages variable length chunks
+    UpfrontIndex m_index;
+
+    // The actual data of the node
+    uint8_t *m_data;
+
+    // Records up to this size are stored inline
+    size_t m_threshold;
+};
+
+} // namespace DefLayout
+
+} // namespace hamsterdb
+
+#endif /* HAM_BTREE_RECORDS_VARLEN_H */
@@ -224,6 +224,7 @@ BtreeUpdateAction::split_page(Page *old_page, Page *parent,
       to_return = new_page;
       pivot_key = *key;
       pivot = old_node->get_count();
+      truncate_separator(old_node, &pivot_key);
     }
   }
 
@@ -245,6 +246,13 @@ BtreeUpdateAction::split_page(Page *old_page, Page *parent,
     /* now move some of the key/rid-tuples to the new page */
     old_node->split(m_context, new_node, pivot);
 
+    /* leaf page: the separator only has to be greater than the last key
+     * of the left page. Therefore the pivot key is truncated to its
+     * shortest prefix which fulfills this condition. (The pivot key of an
+     * internal page already is a separator and must not be modified.) */
+    if (old_node->is_leaf())
+      truncate_separator(old_node, &pivot_key);
+
     // if the new key is >= the pivot key then continue with the right page,
     // otherwise continue with the left page
     to_return = m_btree->compare_keys((ham_key_t *)key, &pivot_key) >= 0
@@ -285,6 +293,17 @@ BtreeUpdateAction::split_page(Page *old_page, Page *parent,
   return (to_return);
 }
 
+void
+BtreeUpdateAction::truncate_separator(BtreeNodeProxy *left_node,
+                                ham_key_t *separator)
+{
+  ByteArray arena;
+  ham_key_t left_key = {0};
+  left_node->get_key(m_context, left_node->get_count() - 1, &arena,
+                  &left_key);
+  separator->size = m_btree->get_separator_size(&left_key, separator);
+}
+
 Page *
 BtreeUpdateAction::allocate_new_root(Page *old_root)
 {
@@ -76,6 +76,10 @@ class BtreeUpdateAction
     Page *split_page(Page *old_page, Page *parent, const ham_key_t *key,
                         BtreeStatistics::InsertHints &hints);
 
+    // Truncates the |separator| of a leaf split to the shortest prefix which
+    // is still greater than the last key of |left_node|
+    void truncate_separator(BtreeNodeProxy *left_node, ham_key_t *separator);
+
     // Allocates a new root page and sets it up in the btree
     Page *allocate_new_root(Page *old_root);
 
@@ -16,15 +16,25 @@
 
 /*
  * btree enumeration; visits each node
+ *
+ * The parallel enumeration splits the leaf level in key ranges and visits
+ * them with multiple threads. Each thread uses its own visitor and its own
+ * Context; a thread only locks one page at a time, therefore the threads
+ * cannot block each other.
  */
 
 #include "0root/root.h"
 
+#include <vector>
+
 // Always verify that a file of level N does not include headers > N!
+#include "1base/error.h"
+#include "1base/mutex.h"
 #include "3page_manager/page_manager.h"
 #include "3btree/btree_index.h"
 #include "3btree/btree_node_proxy.h"
 #include "3btree/btree_visitor.h"
+#include "4context/context.h"
 
 #ifndef HAM_ROOT_H
 #  error "root.h was not included"
@@ -91,7 +101,8 @@ class BtreeVisitAction
 
         /* follow the pointer to the right sibling */
         if (right)
-          page = env->page_manager()->fetch(m_context, right, pm_flags);
+          page = env->page_manager()->fetch(m_context, right,
+                          pm_flags | PageManager::kReadAhead);
         else
           break;
       }
@@ -104,6 +115,192 @@ class BtreeVisitAction
     bool m_visit_internal_nodes;
 };
 
+class BtreeParallelVisitAction
+{
+    enum {
+      // Each thread gets this many ranges (on average); more ranges than
+      // threads improve the load balancing if the ranges differ in size
+      kRangesPerThread = 4
+    };
+
+    // A range of leaf nodes
+    struct Range {
+      Range(uint64_t start_, uint64_t end_, bool single_)
+        : start(start_), end(end_), single(single_) {
+      }
+
+      // The address of the first leaf
+      uint64_t start;
+
+      // The address of the first leaf which is NOT part of the range;
+      // 0 for the last range
+      uint64_t end;
+
+      // true if the range only consists of the first leaf
+      bool single;
+    };
+
+  public:
+    BtreeParallelVisitAction(BtreeIndex *btree, Context *context,
+                    std::vector<BtreeVisitor *> &visitors)
+      : m_btree(btree), m_context(context), m_visitors(visitors),
+        m_next_range(0), m_status(0) {
+    }
+
+    // Visits all leaf nodes
+    void run() {
+      std::vector<uint64_t> starts;
+      split_leaf_level(starts);
+
+      for (size_t i = 0; i < starts.size(); i++)
+        m_ranges.push_back(Range(starts[i],
+                                i + 1 < starts.size() ? starts[i + 1] : 0,
+                                false));
+      run_threads();
+    }
+
+    // Visits the leaf nodes stored at |pages|
+    void run(const std::vector<uint64_t> &pages) {
+      for (size_t i = 0; i < pages.size(); i++)
+        m_ranges.push_back(Range(pages[i], 0, true));
+      run_threads();
+    }
+
+  private:
+    // Returns the addresses of the first leaf of each range. Descends from
+    // the root till a level has enough nodes for all ranges, then picks
+    // evenly distributed nodes of this level and returns the leftmost
+    // leaf of each of them.
+    void split_leaf_level(std::vector<uint64_t> &starts) {
+      LocalEnvironment *env = m_btree->get_db()->lenv();
+      PageManager *pm = env->page_manager();
+      size_t wanted = m_visitors.size() * kRangesPerThread;
+
+      std::vector<uint64_t> level(1, m_btree->root_address());
+      Page *page = pm->fetch(m_context, level[0], PageManager::kReadOnly);
+      BtreeNodeProxy *node = m_btree->get_node_from_page(page);
+
+      while (!node->is_leaf() && level.size() < wanted) {
+        std::vector<uint64_t> children;
+        for (size_t i = 0; i < level.size(); i++) {
+          page = pm->fetch(m_context, level[i], PageManager::kReadOnly);
+          node = m_btree->get_node_from_page(page);
+          children.push_back(node->get_ptr_down());
+          for (size_t j = 0; j < node->get_count(); j++)
+            children.push_back(node->get_record_id(m_context, j));
+        }
+        level.swap(children);
+
+        page = pm->fetch(m_context, level[0], PageManager::kReadOnly);
+        node = m_btree->get_node_from_page(page);
+      }
+
+      size_t count = std::min(wanted, level.size());
+      for (size_t i = 0; i < count; i++) {
+        uint64_t address = level[i * level.size() / count];
+        while (true) {
+          page = pm->fetch(m_context, address, PageManager::kReadOnly);
+          node = m_btree->get_node_from_page(page);
+          if (node->is_leaf())
+            break;
+          address = node->get_ptr_down();
+        }
+        starts.push_back(address);
+      }
+    }
+
+    // Starts one thread per visitor and waits till all ranges are visited
+    void run_threads() {
+      // the pages of the caller are no longer required; unlock them,
+      // otherwise the threads would block
+      m_context->changeset.clear();
+
+      if (m_visitors.size() == 1)
+        run_worker(0);
+      else {
+        std::vector<Thread *> threads;
+        for (size_t i = 0; i < m_visitors.size(); i++)
+          threads.push_back(new Thread(
+                        &BtreeParallelVisitAction::run_worker, this, i));
+        for (size_t i = 0; i < threads.size(); i++) {
+          threads[i]->join();
+          delete threads[i];
+        }
+      }
+
+      if (m_status)
+        throw Exception(m_status);
+    }
+
+    // The thread function; picks the next range and visits its leaves
+    // till all ranges are done
+    void run_worker(size_t id) {
+      LocalDatabase *db = m_btree->get_db();
+      PageManager *pm = db->lenv()->page_manager();
+      BtreeVisitor &visitor = *m_visitors[id];
+      Context context(db->lenv(), 0, db);
+
+      try {
+        while (true) {
+          Range *range;
+          {
+            ScopedLock lock(m_mutex);
+            if (m_status != 0 || m_next_range == m_ranges.size())
+              return;
+            range = &m_ranges[m_next_range++];
+          }
+
+          uint64_t address = range->start;
+          while (address != 0 && address != range->end) {
+            Page *page = pm->fetch(&context, address, PageManager::kReadOnly);
+            BtreeNodeProxy *node = m_btree->get_node_from_page(page);
+            address = range->single ? 0 : node->get_right();
+            visitor(&context, node);
+            context.changeset.clear();
+          }
+        }
+      }
+      catch (Exception &ex) {
+        ScopedLock lock(m_mutex);
+        if (m_status == 0)
+          m_status = ex.code;
+      }
+    }
+
+    BtreeIndex *m_btree;
+    Context *m_context;
+    std::vector<BtreeVisitor *> &m_visitors;
+
+    // The ranges which are visited
+    std::vector<Range> m_ranges;
+
+    // Protects |m_next_range| and |m_status|
+    Mutex m_mutex;
+
+    // The index of the next range which is not yet visited
+    size_t m_next_range;
+
+    // The first error of a thread
+    ham_status_t m_status;
+};
+
+void
+BtreeIndex::visit_leaves_parallel(Context *context,
+                std::vector<BtreeVisitor *> &visitors)
+{
+  BtreeParallelVisitAction bpva(this, context, visitors);
+  bpva.run();
+}
+
+void
+BtreeIndex::visit_pages_parallel(Context *context,
+                const std::vector<uint64_t> &pages,
+                std::vector<BtreeVisitor *> &visitors)
+{
+  BtreeParallelVisitAction bpva(this, context, visitors);
+  bpva.run(pages);
+}
+
 void
 BtreeIndex::visit_nodes(Context *context, BtreeVisitor &visitor,
                 bool visit_internal_nodes)
@@ -38,7 +38,13 @@ namespace hamsterdb {
 // The ScanVisitor is the callback implementation for the scan call.
 // It will either receive single keys or multiple keys in an array.
 //
+// Parallel scans use one clone per thread; the partial results of the
+// clones are then merged.
+//
 struct ScanVisitor {
+  virtual ~ScanVisitor() {
+  }
+
   // Operates on a single key
   virtual void operator()(const void *key_data, uint16_t key_size, 
                   size_t duplicate_count) = 0;
@@ -48,6 +54,13 @@ struct ScanVisitor {
 
   // Assigns the internal result to |result|
   virtual void assign_result(hola_result_t *result) = 0;
+
+  // Returns a new visitor with the same parameters and an empty result
+  virtual ScanVisitor *clone() const = 0;
+
+  // Adds the partial result of |other| (a clone of this visitor) to the
+  // internal result
+  virtual void merge(const ScanVisitor *other) = 0;
 };
 
 struct Context;
@@ -58,6 +71,9 @@ class BtreeNodeProxy;
 // It will visit each node instead of each key.
 //
 struct BtreeVisitor {
+  virtual ~BtreeVisitor() {
+  }
+
   // Specifies if the visitor modifies the node
   virtual bool is_read_only() const = 0;
 
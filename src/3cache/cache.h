@@ -17,13 +17,19 @@
 /*
  * The Cache Manager
  *
- * Stores pages in a non-intrusive hash table (each Page instance keeps
- * next/previous pointers for the overflow bucket). Can efficiently purge
- * unused pages, because all pages are also stored in a (non-intrusive)
- * linked list, and whenever a page is accessed it is removed and re-inserted
- * at the head. The tail therefore points to the page which was not used
+ * Stores pages in a sharded open-addressing hash table (see page_table.h).
+ * Can efficiently purge unused pages, because all pages are also stored in
+ * a (non-intrusive) linked list, and whenever a page is accessed it is
+ * removed and re-inserted at the head. The tail therefore points to the page which was not used
  * in a long time, and is the primary candidate for purging.
  *
+ * With HAM_CACHE_POLICY_2Q, the list of all pages is split in two
+ * queues. New pages are stored in the "cold" queue (|m_totallist|); they
+ * are promoted to the "hot" queue (|m_hotlist|) when they are accessed
+ * again, or if they are internal Btree nodes. Pages are purged from the
+ * cold queue first. A scan which touches each page only once therefore
+ * cannot evict the working set of the hot queue.
+ *
  * @exception_safe: nothrow
  * @thread_safe: yes
  */
@@ -33,14 +39,14 @@
 
 #include "0root/root.h"
 
-#include <vector>
-
 #include "ham/hamsterdb_int.h"
 
 // Always verify that a file of level N does not include headers > N!
 #include "2page/page.h"
 #include "2page/page_collection.h"
 #include "2config/env_config.h"
+#include "3btree/btree_node.h"
+#include "3cache/page_table.h"
 
 #ifndef HAM_ROOT_H
 #  error "root.h was not included"
@@ -51,9 +57,9 @@ namespace hamsterdb {
 class Cache
 {
     enum {
-      // The number of buckets should be a prime number or similar, as it
-      // is used in a MODULO hash scheme
-      kBucketSize = 10317,
+      // HAM_CACHE_POLICY_2Q: the hot queue can grow up to 75 % of the
+      // cache capacity
+      kHotQueuePercent = 75
     };
 
     template<typename Purger>
@@ -83,9 +89,11 @@ class Cache
                             ? 0xffffffffffffffffull
                             : config.cache_size_bytes),
         m_page_size_bytes(config.page_size_bytes),
+        m_policy(config.cache_policy),
         m_alloc_elements(0), m_totallist(Page::kListCache),
-        m_buckets(kBucketSize, PageCollection(Page::kListBucket)),
-        m_cache_hits(0), m_cache_misses(0) {
+        m_hotlist(Page::kListCacheHot),
+        m_cache_hits(0), m_cache_misses(0), m_cache_hits_hot(0),
+        m_cache_hits_cold(0), m_cache_promotions(0) {
       ham_assert(m_capacity_bytes > 0);
     }
 
@@ -93,31 +101,47 @@ class Cache
     void fill_metrics(ham_env_metrics_t *metrics) const {
       metrics->cache_hits = m_cache_hits;
       metrics->cache_misses = m_cache_misses;
+      metrics->cache_policy = (uint32_t)m_policy;
+      metrics->cache_hits_hot = m_cache_hits_hot;
+      metrics->cache_hits_cold = m_cache_hits_cold;
+      metrics->cache_promotions = m_cache_promotions;
     }
 
     // Retrieves a page from the cache, also removes the page from the cache
     // and re-inserts it at the front. Returns null if the page was not cached.
     Page *get(uint64_t address) {
-      size_t hash = calc_hash(address);
-
-      Page *page = m_buckets[hash].get(address);;
+      Page *page = m_page_table.get(address);
       if (!page) {
         m_cache_misses++;
         return (0);
       }
 
+      m_cache_hits++;
+
+      // 2Q: pages in the hot queue move to its head; pages in the cold
+      // queue were accessed a second time and are promoted
+      if (m_policy == HAM_CACHE_POLICY_2Q) {
+        if (m_hotlist.del(page)) {
+          m_hotlist.put(page);
+          m_cache_hits_hot++;
+        }
+        else {
+          m_cache_hits_cold++;
+          promote(page);
+        }
+        return (page);
+      }
+
       // Now re-insert the page at the head of the "totallist", and
       // thus move far away from the tail. The pages at the tail are highest
       // candidates to be deleted when the cache is purged.
       m_totallist.del(page);
       m_totallist.put(page);
-      m_cache_hits++;
       return (page);
     }
 
     // Stores a page in the cache
     void put(Page *page) {
-      size_t hash = calc_hash(page->get_address());
       ham_assert(page->get_data());
 
       /* First remove the page from the cache, if it's already cached
@@ -125,28 +149,35 @@ class Cache
        * Then re-insert the page at the head of the list. The tail will
        * point to the least recently used page.
        */
-      m_totallist.del(page);
-      m_totallist.put(page);
+      if (m_policy == HAM_CACHE_POLICY_2Q && m_hotlist.del(page)) {
+        m_hotlist.put(page);
+      }
+      else {
+        m_totallist.del(page);
+        m_totallist.put(page);
+      }
 
       if (page->is_allocated())
         m_alloc_elements++;
-      m_buckets[hash].put(page);
+      m_page_table.put(page);
     }
 
     // Removes a page from the cache
     void del(Page *page) {
       ham_assert(page->get_address() != 0);
-      size_t hash = calc_hash(page->get_address());
-      /* remove the page from the cache buckets */
-      m_buckets[hash].del(page);
+      /* remove the page from the hash table */
+      m_page_table.del(page->get_address());
 
       /* remove it from the list of all cached pages */
-      if (m_totallist.del(page) && page->is_allocated())
+      bool removed = m_totallist.del(page);
+      if (!removed)
+        removed = m_hotlist.del(page);
+      if (removed && page->is_allocated())
         m_alloc_elements--;
     }
 
-    // Purges the cache. Implements a LRU eviction algorithm. Dirty pages are
-    // forwarded to the |processor()| for flushing.
+    // Purges the cache. Implements a LRU eviction algorithm (or 2Q, if
+    // enabled). Dirty pages are forwarded to the |processor()| for flushing.
     //
     // Tries to purge at least 20 pages. In benchmarks this has proven to
     // be a good limit.
@@ -155,28 +186,16 @@ class Cache
       int limit = int(current_elements()
                         - (m_capacity_bytes / m_page_size_bytes));
 
-      Page *page = m_totallist.tail();
-      for (int i = 0; i < limit && page != 0; i++) {
-        Page *next = page->get_previous(Page::kListCache);
-
-        // dirty pages are flushed by the worker thread
-        if (page->is_dirty()) {
-          processor(page);
-          page = next;
-          continue;
-        }
-        // non-dirty pages are deleted if possible
-        if (!page->is_dirty()
-                && page->cursor_list() == 0
-                && page != ignore_page
-                && page->mutex().try_lock()) {
-          del(page);
-          page->mutex().unlock();
-          delete page;
-        }
+      // 2Q: first purge the cold queue; internal Btree nodes are promoted
+      // instead of being purged
+      limit = purge_list(m_totallist, processor, ignore_page, limit,
+                      m_policy == HAM_CACHE_POLICY_2Q);
+      if (limit > 0)
+        purge_list(m_hotlist, processor, ignore_page, limit, false);
 
-        page = next;
-      }
+      // the caller holds the PageManager's lock, therefore nobody is
+      // reading from the hash table
+      m_page_table.release_retired();
     }
 
     // Visits all pages in the "totallist". If |cb| returns true then the
@@ -186,6 +205,7 @@ class Cache
     void purge_if(Purger &purger) {
       PurgeIfSelector<Purger> selector(this, purger);
       m_totallist.extract(selector);
+      m_hotlist.extract(selector);
     }
 
     // Returns true if the capacity limits are exceeded
@@ -201,7 +221,7 @@ class Cache
 
     // Returns the number of currently cached elements
     size_t current_elements() const {
-      return (m_totallist.size());
+      return (m_totallist.size() + m_hotlist.size());
     }
 
     // Returns the number of currently cached elements (excluding those that
@@ -210,12 +230,90 @@ class Cache
       return (m_alloc_elements);
     }
 
+    // Returns the replacement policy (HAM_CACHE_POLICY_*)
+    int policy() const {
+      return (m_policy);
+    }
+
+    // Returns the number of pages in the "hot" queue (HAM_CACHE_POLICY_2Q)
+    size_t hot_elements() const {
+      return (m_hotlist.size());
+    }
+
   private:
-    // Calculates the hash of a page address
-    size_t calc_hash(uint64_t value) const {
-      return ((size_t)(value % Cache::kBucketSize));
+    // Returns true if |page| is an internal Btree node. These nodes are
+    // visited by every lookup and therefore get priority in the cache.
+    static bool is_internal_node(Page *page) {
+      if (page->is_without_header())
+        return (false);
+      uint32_t type = page->get_type();
+      if (type != Page::kTypeBroot && type != Page::kTypeBindex)
+        return (false);
+      return (!PBtreeNode::from_page(page)->is_leaf());
+    }
+
+    // Moves a page from the cold queue to the head of the hot queue. If
+    // the hot queue grows too large then its tail is moved back to the
+    // cold queue.
+    void promote(Page *page) {
+      m_totallist.del(page);
+      m_hotlist.put(page);
+      m_cache_promotions++;
+
+      uint64_t max_hot = (m_capacity_bytes / m_page_size_bytes)
+                            * kHotQueuePercent / 100;
+      while (m_hotlist.size() > 1 && (uint64_t)m_hotlist.size() > max_hot) {
+        Page *tail = m_hotlist.tail();
+        m_hotlist.del(tail);
+        m_totallist.put(tail);
+      }
+    }
+
+    // Purges up to |limit| pages from the tail of |list|. If |promote_internal|
+    // is true then internal Btree nodes are promoted to the hot queue instead.
+    // Returns the number of pages which still should be purged.
+    template<typename Processor>
+    int purge_list(PageCollection &list, Processor &processor,
+                    Page *ignore_page, int limit, bool promote_internal) {
+      int list_id = (&list == &m_hotlist)
+                        ? Page::kListCacheHot
+                        : Page::kListCache;
+
+      Page *page = list.tail();
+      for (; limit > 0 && page != 0; limit--) {
+        Page *next = page->get_previous(list_id);
+
+        if (promote_internal && is_internal_node(page)) {
+          promote(page);
+          page = next;
+          continue;
+        }
+
+        // dirty pages are flushed by the worker thread
+        if (page->is_dirty()) {
+          processor(page);
+          page = next;
+          continue;
+        }
+        // non-dirty pages are deleted if possible
+        if (!page->is_dirty()
+                && page->cursor_list() == 0
+                && page != ignore_page
+                && !page->is_pinned()
+                && page->mutex().try_lock()) {
+          del(page);
+          page->mutex().unlock();
+          delete page;
+        }
+
+        page = next;
+      }
+      return (limit);
     }
 
+    // the replacement policy (HAM_CACHE_POLICY_*)
+    int m_policy;
+
     // the capacity (in bytes)
     uint64_t m_capacity_bytes;
 
@@ -226,17 +324,30 @@ class Cache
     // mapped)
     size_t m_alloc_elements;
 
-    // linked list of ALL cached pages
+    // linked list of ALL cached pages (HAM_CACHE_POLICY_LRU), or of the
+    // "cold" pages (HAM_CACHE_POLICY_2Q)
     PageCollection m_totallist;
 
-    // The hash table buckets - each is a linked list of Page pointers
-    std::vector<PageCollection> m_buckets;
+    // linked list of the "hot" pages (HAM_CACHE_POLICY_2Q)
+    PageCollection m_hotlist;
+
+    // Maps page addresses to Page pointers
+    PageTable m_page_table;
 
     // counts the cache hits
     uint64_t m_cache_hits;
 
     // counts the cache misses
     uint64_t m_cache_misses;
+
+    // counts the cache hits in the hot queue (HAM_CACHE_POLICY_2Q)
+    uint64_t m_cache_hits_hot;
+
+    // counts the cache hits in the cold queue (HAM_CACHE_POLICY_2Q)
+    uint64_t m_cache_hits_cold;
+
+    // counts the promotions to the hot queue (HAM_CACHE_POLICY_2Q)
+    uint64_t m_cache_promotions;
 };
 
 } // namespace hamsterdb
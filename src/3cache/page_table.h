@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2005-2015 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * The PageTable maps page addresses to Page pointers.
+ *
+ * It is split in shards; each shard is an open-addressing hash table with
+ * linear probing. Slots are stored in cache-line-aligned arrays, therefore
+ * a lookup usually touches a single cache line. Lookups do not acquire
+ * locks. Modifications are serialized by a per-shard Spinlock.
+ *
+ * When a shard grows, its slots are copied to a new array which is then
+ * published atomically. The old array is not released immediately, because
+ * concurrent readers might still access it; see release_retired().
+ *
+ * @exception_safe: strong
+ * @thread_safe: yes
+ */
+
+#ifndef HAM_PAGE_TABLE_H
+#define HAM_PAGE_TABLE_H
+
+#include "0root/root.h"
+
+#include <new>
+#include <vector>
+#include <boost/atomic.hpp>
+
+// Always verify that a file of level N does not include headers > N!
+#include "1base/spinlock.h"
+#include "1mem/mem.h"
+#include "2page/page.h"
+
+#ifndef HAM_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace hamsterdb {
+
+class PageTable
+{
+    enum {
+      // The number of shards; must be a power of two
+      kShards = 16,
+
+      // The initial number of slots per shard; must be a power of two
+      kInitialCapacity = 256,
+
+      // A shard is resized when more than 50 % of its slots are used
+      kMaxLoadPercent = 50,
+
+      // The size of a cache line
+      kCacheLineSize = 64
+    };
+
+    // Markers for unused slots
+    static const uint64_t kEmpty = 0xffffffffffffffffull;
+    static const uint64_t kDeleted = 0xfffffffffffffffeull;
+
+    // A single slot. |page| is always written before |address|, and
+    // cleared before |address| is overwritten; readers therefore never
+    // see a Page of a different address.
+    struct Slot {
+      boost::atomic<uint64_t> address;
+      boost::atomic<Page *> page;
+    };
+
+    // An array of slots
+    struct Table {
+      // Allocates a table with |capacity| empty slots; the slots are aligned
+      // to a cache line boundary
+      Table(size_t capacity_)
+        : capacity(capacity_) {
+        memory = Memory::allocate<uint8_t>(capacity * sizeof(Slot)
+                        + kCacheLineSize);
+        uint8_t *p = memory + (kCacheLineSize
+                        - ((size_t)memory % kCacheLineSize)) % kCacheLineSize;
+        slots = (Slot *)p;
+        for (size_t i = 0; i < capacity; i++) {
+          new (&slots[i]) Slot();
+          slots[i].page.store(0, boost::memory_order_relaxed);
+          slots[i].address.store(kEmpty, boost::memory_order_relaxed);
+        }
+      }
+
+      ~Table() {
+        Memory::release(memory);
+      }
+
+      // The number of slots; a power of two
+      size_t capacity;
+
+      // The aligned slot array
+      Slot *slots;
+
+      // The allocated memory
+      uint8_t *memory;
+    };
+
+    // A shard. The padding makes sure that two shards do not share a
+    // cache line.
+    struct Shard {
+      Shard()
+        : table(0), used(0), size(0) {
+      }
+
+      // The current table
+      boost::atomic<Table *> table;
+
+      // Number of used slots (including deleted ones)
+      size_t used;
+
+      // Number of stored pages
+      size_t size;
+
+      // Serializes modifications
+      Spinlock mutex;
+
+      // Tables which were replaced; see release_retired()
+      std::vector<Table *> retired;
+
+      uint8_t padding[kCacheLineSize];
+    };
+
+  public:
+    // Constructor
+    PageTable() {
+      for (size_t i = 0; i < kShards; i++)
+        m_shards[i].table.store(new Table(kInitialCapacity));
+    }
+
+    // Destructor; does not delete the pages
+    ~PageTable() {
+      release_retired();
+      for (size_t i = 0; i < kShards; i++)
+        delete m_shards[i].table.load();
+    }
+
+    // Returns the page with the |address|, or null if the page is not stored.
+    // Does not acquire locks.
+    Page *get(uint64_t address) const {
+      uint64_t hash = calc_hash(address);
+      const Shard &shard = m_shards[shard_of(hash)];
+      Table *table = shard.table.load(boost::memory_order_acquire);
+      size_t mask = table->capacity - 1;
+
+      for (size_t i = (size_t)hash & mask; ; i = (i + 1) & mask) {
+        Slot &slot = table->slots[i];
+        uint64_t a = slot.address.load(boost::memory_order_acquire);
+        if (a == address) {
+          Page *page = slot.page.load(boost::memory_order_acquire);
+          // the slot could have been re-used in the meantime
+          if (slot.address.load(boost::memory_order_acquire) != address)
+            return (0);
+          return (page);
+        }
+        if (a == kEmpty)
+          return (0);
+      }
+    }
+
+    // Stores a page; does nothing if the page is already stored
+    void put(Page *page) {
+      uint64_t address = page->get_address();
+      uint64_t hash = calc_hash(address);
+      Shard &shard = m_shards[shard_of(hash)];
+      ScopedSpinlock lock(shard.mutex);
+
+      Table *table = shard.table.load(boost::memory_order_relaxed);
+      size_t mask = table->capacity - 1;
+
+      Slot *free_slot = 0;
+      size_t i = (size_t)hash & mask;
+      for (; ; i = (i + 1) & mask) {
+        uint64_t a = table->slots[i].address.load(boost::memory_order_relaxed);
+        if (a == address) {
+          table->slots[i].page.store(page, boost::memory_order_release);
+          return;
+        }
+        if (a == kDeleted && !free_slot)
+          free_slot = &table->slots[i];
+        if (a == kEmpty)
+          break;
+      }
+
+      if (!free_slot) {
+        free_slot = &table->slots[i];
+        shard.used++;
+      }
+      free_slot->page.store(page, boost::memory_order_release);
+      free_slot->address.store(address, boost::memory_order_release);
+      shard.size++;
+
+      if (shard.used * 100 > table->capacity * kMaxLoadPercent)
+        grow(shard);
+    }
+
+    // Removes the page with the |address|. Returns true if the page was
+    // removed, otherwise false (if the page was not stored)
+    bool del(uint64_t address) {
+      uint64_t hash = calc_hash(address);
+      Shard &shard = m_shards[shard_of(hash)];
+      ScopedSpinlock lock(shard.mutex);
+
+      Table *table = shard.table.load(boost::memory_order_relaxed);
+      size_t mask = table->capacity - 1;
+
+      for (size_t i = (size_t)hash & mask; ; i = (i + 1) & mask) {
+        uint64_t a = table->slots[i].address.load(boost::memory_order_relaxed);
+        if (a == address) {
+          table->slots[i].page.store(0, boost::memory_order_release);
+          table->slots[i].address.store(kDeleted, boost::memory_order_release);
+          shard.size--;
+          return (true);
+        }
+        if (a == kEmpty)
+          return (false);
+      }
+    }
+
+    // Returns the number of stored pages
+    size_t size() const {
+      size_t s = 0;
+      for (size_t i = 0; i < kShards; i++)
+        s += m_shards[i].size;
+      return (s);
+    }
+
+    // Releases the tables which were replaced when shards were resized.
+    // The caller must make sure that there are no concurrent readers.
+    void release_retired() {
+      for (size_t i = 0; i < kShards; i++) {
+        Shard &shard = m_shards[i];
+        ScopedSpinlock lock(shard.mutex);
+        for (size_t j = 0; j < shard.retired.size(); j++)
+          delete shard.retired[j];
+        shard.retired.clear();
+      }
+    }
+
+  private:
+    // Mixes the bits of a page address (the lower bits of page addresses
+    // are usually zero)
+    static uint64_t calc_hash(uint64_t address) {
+      address ^= address >> 33;
+      address *= 0xff51afd7ed558ccdull;
+      address ^= address >> 33;
+      address *= 0xc4ceb9fe1a85ec53ull;
+      address ^= address >> 33;
+      return (address);
+    }
+
+    // Returns the shard of a hash; uses the upper bits, the lower bits
+    // are used for the slot index
+    static size_t shard_of(uint64_t hash) {
+      return ((size_t)(hash >> 60) & (kShards - 1));
+    }
+
+    // Copies all pages of a shard to a new table. If many slots are deleted
+    // then the new table has the same size, otherwise it's twice as large.
+    // Requires that the caller holds the shard's lock.
+    void grow(Shard &shard) {
+      Table *old_table = shard.table.load(boost::memory_order_relaxed);
+      size_t capacity = old_table->capacity;
+      if (shard.size * 100 > capacity * kMaxLoadPercent / 2)
+        capacity *= 2;
+
+      Table *new_table = new Table(capacity);
+      size_t mask = capacity - 1;
+      for (size_t j = 0; j < old_table->capacity; j++) {
+        Slot &slot = old_table->slots[j];
+        uint64_t address = slot.address.load(boost::memory_order_relaxed);
+        if (address == kEmpty || address == kDeleted)
+          continue;
+        size_t i = (size_t)calc_hash(address) & mask;
+        while (new_table->slots[i].address.load(boost::memory_order_relaxed)
+                        != kEmpty)
+          i = (i + 1) & mask;
+        new_table->slots[i].page.store(slot.page.load(
+                                boost::memory_order_relaxed),
+                        boost::memory_order_relaxed);
+        new_table->slots[i].address.store(address, boost::memory_order_relaxed);
+      }
+
+      shard.used = shard.size;
+      shard.table.store(new_table, boost::memory_order_release);
+      shard.retired.push_back(old_table);
+    }
+
+    // The shards
+    Shard m_shards[kShards];
+};
+
+} // namespace hamsterdb
+
+#endif /* HAM_PAGE_TABLE_H */
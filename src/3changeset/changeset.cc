@@ -47,8 +47,6 @@ struct PageCollectionVisitor
       pages[num_pages] = page;
       ++num_pages;
     }
-    // |page| is now removed from the Changeset
-    page->mutex().unlock();
     return (true);
   }
 
@@ -68,9 +66,10 @@ Changeset::flush(uint64_t lsn)
   // Fetch the pages, ignoring all pages that are not dirty
   Page **pages = (Page **)::alloca(sizeof(Page *) * m_collection.size());
   PageCollectionVisitor visitor(pages);
-  m_collection.extract(visitor);
+  m_collection.for_each(visitor);
 
-  // TODO sort by address (really?)
+  // all pages are now removed from the Changeset (and unlocked)
+  clear();
 
   if (visitor.num_pages == 0)
     return;
@@ -92,16 +91,20 @@ Changeset::flush(uint64_t lsn)
   if (g_CHANGESET_POST_LOG_HOOK)
     g_CHANGESET_POST_LOG_HOOK();
 
-  /* now write all the pages to the file; if any of these writes fail,
-   * we can still recover from the log */
+  /* now write all the pages to the file with a single batch; the device
+   * sorts them by address and merges adjacent pages. If any of these
+   * writes fail, we can still recover from the log */
+  std::vector<Page::PersistedData *> list;
+  list.reserve(visitor.num_pages);
   for (int i = 0; i < visitor.num_pages; i++) {
     Page *p = visitor.pages[i];
     if (p->is_without_header() == false)
       p->set_lsn(lsn);
-    p->flush();
-
-    HAM_INDUCE_ERROR(ErrorInducer::kChangesetFlush);
+    list.push_back(p->get_persisted_data());
   }
+  Page::flush(m_env->device(), list);
+
+  HAM_INDUCE_ERROR(ErrorInducer::kChangesetFlush);
 
   /* flush the file handle (if required) */
   if (m_env->get_flags() & HAM_ENABLE_FSYNC)
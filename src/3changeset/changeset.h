@@ -18,8 +18,12 @@
  * A changeset collects all pages that are modified during a single
  * operation.
  *
+ * Each page in the changeset is locked. Every page remembers the changeset
+ * which holds its lock, therefore several threads can use their own
+ * changesets at the same time.
+ *
  * @exception_safe: unknown
- * @thread_safe: unknown
+ * @thread_safe: no
  */
 
 #ifndef HAM_CHANGESET_H
@@ -43,17 +47,6 @@ class LocalEnvironment;
 
 class Changeset
 {
-    struct UnlockPage
-    {
-      bool operator()(Page *page) {
-    #ifdef HAM_ENABLE_HELGRIND
-        page->mutex().try_lock();
-    #endif
-        page->mutex().unlock();
-        return (true);
-      }
-    };
-
   public:
     Changeset(LocalEnvironment *env)
       : m_env(env), m_collection(Page::kListChangeset) {
@@ -71,19 +64,26 @@ class Changeset
     void put(Page *page) {
       if (!has(page)) {
         page->mutex().lock();
+        page->set_changeset(this);
+        m_collection.put(page);
       }
-      m_collection.put(page);
     }
 
     /* Removes a page from the changeset. The page is unlocked. */
     void del(Page *page) {
-      page->mutex().unlock();
+      // the page must be removed from the list BEFORE it is unlocked;
+      // otherwise another thread could already modify the list pointers
       m_collection.del(page);
+      page->set_changeset(0);
+#ifdef HAM_ENABLE_HELGRIND
+      page->mutex().try_lock();
+#endif
+      page->mutex().unlock();
     }
 
     /* Check if the page is already part of the changeset */
     bool has(Page *page) const {
-      return (m_collection.has(page));
+      return (page->get_changeset() == this);
     }
 
     /* Returns true if the changeset is empty */
@@ -93,9 +93,9 @@ class Changeset
 
     /* Removes all pages from the changeset. The pages are unlocked. */
     void clear() {
-      UnlockPage unlocker;
-      m_collection.for_each(unlocker);
-      m_collection.clear();
+      Page *page;
+      while ((page = m_collection.head()) != 0)
+        del(page);
     }
 
     /*
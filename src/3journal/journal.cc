@@ -24,6 +24,7 @@
 #include "1base/error.h"
 #include "1errorinducer/errorinducer.h"
 #include "1os/os.h"
+#include "2compressor/compressor_factory.h"
 #include "2device/device.h"
 #include "3journal/journal.h"
 #include "3page_manager/page_manager.h"
@@ -175,10 +176,89 @@ Journal::append_txn_commit(LocalTransaction *txn, uint64_t lsn)
 
   append_entry(idx, (uint8_t *)&entry, sizeof(entry));
 
-  // and flush the file
+  // with group commit, the file is flushed in wait_for_commit()
+  JournalState::GroupCommit &gc = m_state.group_commit;
+  if (gc.window > 0) {
+    gc.ticket = ++gc.appended;
+    gc.dirty[idx] = true;
+    return;
+  }
+
+  // otherwise flush the file immediately
   flush_buffer(idx, m_state.env->get_flags() & HAM_ENABLE_FSYNC);
 }
 
+void
+Journal::wait_for_commit(uint64_t ticket)
+{
+  JournalState::GroupCommit &gc = m_state.group_commit;
+  ScopedLock lock(gc.mutex);
+
+  while (gc.durable < ticket) {
+    // another thread is already flushing; wait till it's finished, then
+    // check if this commit was part of its group
+    if (gc.syncing) {
+      gc.cond.wait(lock);
+      continue;
+    }
+
+    // otherwise become the leader, and give other threads the chance to
+    // join the group
+    gc.syncing = true;
+    gc.cond.timed_wait(lock, boost::posix_time::microseconds(gc.window));
+    lock.unlock();
+
+    uint64_t last;
+    bool dirty[2];
+    try {
+      // write the buffers; this requires the Environment's lock
+      {
+        ScopedLock env_lock(m_state.env->mutex());
+        last = gc.appended;
+        for (int i = 0; i < 2; i++) {
+          dirty[i] = gc.dirty[i];
+          gc.dirty[i] = false;
+          flush_buffer(i);
+        }
+      }
+
+      // then sync the files; other threads can continue to append
+      // commits in the meantime
+      for (int i = 0; i < 2; i++) {
+        if (dirty[i]) {
+          ScopedLatency latency(&m_state.fsync_latency);
+          m_state.files[i].flush();
+        }
+      }
+    }
+    catch (Exception &) {
+      lock.lock();
+      gc.syncing = false;
+      gc.cond.notify_all();
+      throw;
+    }
+
+    lock.lock();
+    for (int i = 0; i < 2; i++) {
+      if (dirty[i])
+        gc.count_fsyncs++;
+    }
+    if (last > gc.durable) {
+      uint64_t size = last - gc.durable;
+      int slot = 0;
+      while (size > 1 && slot < JournalState::GroupCommit::kHistogramSize - 1) {
+        size >>= 1;
+        slot++;
+      }
+      gc.batch_sizes[slot]++;
+      gc.count_batches++;
+      gc.durable = last;
+    }
+    gc.syncing = false;
+    gc.cond.notify_all();
+  }
+}
+
 void
 Journal::append_insert(Database *db, LocalTransaction *txn,
                 ham_key_t *key, ham_record_t *record, uint32_t flags,
@@ -189,17 +269,32 @@ Journal::append_insert(Database *db, LocalTransaction *txn,
 
   PJournalEntry entry;
   PJournalEntryInsert insert;
-  uint32_t size = sizeof(PJournalEntryInsert)
-                        + key->size
-                        + (flags & HAM_PARTIAL
+  const uint8_t *key_data = (const uint8_t *)key->data;
+  uint32_t key_size = key->size;
+  const uint8_t *record_data = (const uint8_t *)record->data;
+  uint32_t record_size = flags & HAM_PARTIAL
                             ? record->partial_size
-                            : record->size)
-                        - 1;
+                            : record->size;
+
+  // compress the key and the record, if they're large enough
+  insert.compressed_key_size = (uint16_t)compress(key_data, key_size, 0);
+  if (insert.compressed_key_size) {
+    key_data = m_state.compressor_arena[0].get_ptr();
+    key_size = insert.compressed_key_size;
+  }
+  insert.compressed_record_size = compress(record_data, record_size, 1);
+  if (insert.compressed_record_size) {
+    record_data = m_state.compressor_arena[1].get_ptr();
+    record_size = insert.compressed_record_size;
+  }
+  if (insert.compressed_key_size || insert.compressed_record_size)
+    entry.compressor = (uint16_t)m_state.env->config().journal_compressor;
 
   entry.lsn = lsn;
   entry.dbname = db->name();
   entry.type = kEntryTypeInsert;
-  entry.followup_size = size;
+  entry.followup_size = sizeof(PJournalEntryInsert) - 1 + key_size
+                            + record_size;
 
   int idx;
   if (txn->get_flags() & HAM_TXN_TEMPORARY) {
@@ -221,10 +316,8 @@ Journal::append_insert(Database *db, LocalTransaction *txn,
   // append the entry to the logfile
   append_entry(idx, (uint8_t *)&entry, sizeof(entry),
                 (uint8_t *)&insert, sizeof(PJournalEntryInsert) - 1,
-                (uint8_t *)key->data, key->size,
-                (uint8_t *)record->data, (flags & HAM_PARTIAL
-                                ? record->partial_size
-                                : record->size));
+                key_data, key_size,
+                record_data, record_size);
   maybe_flush_buffer(idx);
 }
 
@@ -237,12 +330,21 @@ Journal::append_erase(Database *db, LocalTransaction *txn, ham_key_t *key,
 
   PJournalEntry entry;
   PJournalEntryErase erase;
-  uint32_t size = sizeof(PJournalEntryErase) + key->size - 1;
+  const uint8_t *key_data = (const uint8_t *)key->data;
+  uint32_t key_size = key->size;
+
+  // compress the key, if it's large enough
+  erase.compressed_key_size = (uint16_t)compress(key_data, key_size, 0);
+  if (erase.compressed_key_size) {
+    key_data = m_state.compressor_arena[0].get_ptr();
+    key_size = erase.compressed_key_size;
+    entry.compressor = (uint16_t)m_state.env->config().journal_compressor;
+  }
 
   entry.lsn = lsn;
   entry.dbname = db->name();
   entry.type = kEntryTypeErase;
-  entry.followup_size = size;
+  entry.followup_size = sizeof(PJournalEntryErase) - 1 + key_size;
   erase.key_size = key->size;
   erase.erase_flags = flags;
   erase.duplicate = duplicate_index;
@@ -261,7 +363,7 @@ Journal::append_erase(Database *db, LocalTransaction *txn, ham_key_t *key,
   // append the entry to the logfile
   append_entry(idx, (uint8_t *)&entry, sizeof(entry),
                 (uint8_t *)&erase, sizeof(PJournalEntryErase) - 1,
-                (uint8_t *)key->data, key->size);
+                key_data, key_size);
   maybe_flush_buffer(idx);
 }
 
@@ -293,7 +395,10 @@ Journal::append_changeset(const Page **pages, int num_pages, uint64_t lsn)
 
   size_t page_size = m_state.env->config().page_size_bytes;
   for (int i = 0; i < num_pages; i++) {
-    entry.followup_size += append_changeset_page(pages[i], page_size);
+    uint32_t size = append_changeset_page(pages[i], page_size);
+    if (size < page_size + sizeof(PJournalEntryPageHeader))
+      entry.compressor = (uint16_t)m_state.env->config().journal_compressor;
+    entry.followup_size += size;
   }
 
   HAM_INDUCE_ERROR(ErrorInducer::kChangesetFlush);
@@ -315,16 +420,139 @@ Journal::append_changeset(const Page **pages, int num_pages, uint64_t lsn)
   (void)switch_files_maybe();
 }
 
+void
+Journal::append_checkpoint(uint64_t lsn)
+{
+  if (m_state.disable_logging)
+    return;
+
+  PJournalEntry entry;
+  entry.type = kEntryTypeCheckpoint;
+  entry.lsn = lsn;
+
+  append_entry(m_state.current_fd, (uint8_t *)&entry, sizeof(entry));
+  flush_buffer(m_state.current_fd, m_state.env->get_flags() & HAM_ENABLE_FSYNC);
+
+  m_state.last_cp_lsn = lsn;
+}
+
 uint32_t
 Journal::append_changeset_page(const Page *page, uint32_t page_size)
 {
   PJournalEntryPageHeader header(page->get_address());
+  const uint8_t *data = page->get_raw_payload();
+
+  header.compressed_size = compress(data, page_size, 0);
+  if (header.compressed_size) {
+    data = m_state.compressor_arena[0].get_ptr();
+    page_size = header.compressed_size;
+  }
 
   append_entry(m_state.current_fd, (uint8_t *)&header, sizeof(header),
-                page->get_raw_payload(), page_size);
+                data, page_size);
   return (page_size + sizeof(header));
 }
 
+uint32_t
+Journal::compress(const uint8_t *data, uint32_t size, int arena)
+{
+  if (!m_state.compressor || size < JournalState::kCompressionThreshold)
+    return (0);
+
+  uint32_t compressed_size = m_state.compressor->compress(data, size,
+                  &m_state.compressor_arena[arena]);
+
+  m_state.count_bytes_before_compression += size;
+  m_state.count_bytes_after_compression += compressed_size
+                                              ? compressed_size
+                                              : size;
+  return (compressed_size);
+}
+
+Compressor *
+Journal::get_decompressor(int algo)
+{
+  if (m_state.compressor && algo == m_state.env->config().journal_compressor)
+    return (m_state.compressor.get());
+
+  if (!m_state.decompressor || m_state.decompressor_algo != algo) {
+    m_state.decompressor.reset(CompressorFactory::create(algo));
+    m_state.decompressor_algo = algo;
+    if (!m_state.decompressor) {
+      ham_log(("journal compression %d is not available", algo));
+      throw Exception(HAM_NOT_IMPLEMENTED);
+    }
+  }
+  return (m_state.decompressor.get());
+}
+
+void
+Journal::decompress_entry(PJournalEntry *entry, ByteArray *auxbuffer)
+{
+  // changesets are decompressed in recover_changeset()
+  if (entry->type != kEntryTypeInsert && entry->type != kEntryTypeErase)
+    return;
+
+  Compressor *compressor = get_decompressor(entry->compressor);
+  ByteArray &compressed = m_state.compressor_arena[0];
+  compressed.copy(auxbuffer->get_ptr(), (size_t)entry->followup_size);
+
+  if (entry->type == kEntryTypeInsert) {
+    PJournalEntryInsert *ins = (PJournalEntryInsert *)compressed.get_ptr();
+    uint32_t header_size = sizeof(PJournalEntryInsert) - 1;
+    uint32_t key_size = ins->compressed_key_size
+                            ? ins->compressed_key_size
+                            : ins->key_size;
+    uint32_t record_size = ins->insert_flags & HAM_PARTIAL
+                            ? ins->record_partial_size
+                            : ins->record_size;
+    uint32_t compressed_record_size = ins->compressed_record_size
+                            ? ins->compressed_record_size
+                            : record_size;
+    if (header_size + key_size + compressed_record_size
+            != entry->followup_size)
+      throw Exception(HAM_INTEGRITY_VIOLATED);
+
+    auxbuffer->clear();
+    uint8_t *p = auxbuffer->resize(header_size + ins->key_size + record_size);
+    ::memcpy(p, ins, header_size);
+    const uint8_t *key_data = &ins->data[0];
+    if (ins->compressed_key_size)
+      compressor->decompress(key_data, key_size, p + header_size,
+                      ins->key_size);
+    else
+      ::memcpy(p + header_size, key_data, key_size);
+    const uint8_t *record_data = key_data + key_size;
+    if (ins->compressed_record_size)
+      compressor->decompress(record_data, compressed_record_size,
+                      p + header_size + ins->key_size, record_size);
+    else
+      ::memcpy(p + header_size + ins->key_size, record_data, record_size);
+
+    ins = (PJournalEntryInsert *)p;
+    ins->compressed_key_size = 0;
+    ins->compressed_record_size = 0;
+  }
+  else {
+    PJournalEntryErase *e = (PJournalEntryErase *)compressed.get_ptr();
+    uint32_t header_size = sizeof(PJournalEntryErase) - 1;
+    if (header_size + e->compressed_key_size != entry->followup_size)
+      throw Exception(HAM_INTEGRITY_VIOLATED);
+
+    auxbuffer->clear();
+    uint8_t *p = auxbuffer->resize(header_size + e->key_size);
+    ::memcpy(p, e, header_size);
+    compressor->decompress(&e->data[0], e->compressed_key_size,
+                    p + header_size, e->key_size);
+
+    e = (PJournalEntryErase *)p;
+    e->compressed_key_size = 0;
+  }
+
+  entry->followup_size = auxbuffer->get_size();
+  entry->compressor = 0;
+}
+
 void
 Journal::transaction_flushed(LocalTransaction *txn)
 {
@@ -392,6 +620,10 @@ Journal::get_entry(Iterator *iter, PJournalEntry *entry, ByteArray *auxbuffer)
       m_state.files[iter->fdidx].pread(iter->offset, auxbuffer->get_ptr(),
                       (size_t)entry->followup_size);
       iter->offset += entry->followup_size;
+
+      // return the uncompressed data
+      if (entry->compressor)
+        decompress_entry(entry, auxbuffer);
     }
   }
   catch (Exception &) {
@@ -491,6 +723,9 @@ Journal::recover(LocalTransactionManager *txn_manager)
   // first re-apply the last changeset
   uint64_t start_lsn = recover_changeset();
 
+  // all entries older than the newest checkpoint were already persisted
+  start_lsn = std::max(start_lsn, m_state.last_cp_lsn);
+
   // load the state of the PageManager; the PageManager state is loaded AFTER
   // physical recovery because its page might have been restored in
   // recover_changeset()
@@ -505,13 +740,18 @@ Journal::recover(LocalTransactionManager *txn_manager)
 }
 
 uint64_t 
-Journal::scan_for_newest_changeset(File *file, uint64_t *position)
+Journal::scan_for_newest_changeset(File *file, uint64_t *position,
+                uint64_t *checkpoint_lsn, uint64_t *checkpoint_position,
+                uint64_t *newest_lsn)
 {
   Iterator it;
   PJournalEntry entry;
   ByteArray buffer;
   uint64_t result = 0;
 
+  *checkpoint_lsn = 0;
+  *newest_lsn = 0;
+
   // get the next entry
   try {
     uint64_t filesize = file->get_file_size();
@@ -526,6 +766,12 @@ Journal::scan_for_newest_changeset(File *file, uint64_t *position)
         *position = it.offset;
         result = entry.lsn;
       }
+      else if (entry.type == kEntryTypeCheckpoint) {
+        *checkpoint_position = it.offset;
+        *checkpoint_lsn = entry.lsn;
+      }
+      if (entry.lsn > *newest_lsn)
+        *newest_lsn = entry.lsn;
 
       // increment the offset
       it.offset += sizeof(entry);
@@ -545,8 +791,20 @@ Journal::recover_changeset()
 {
   // scan through both files, look for the file with the newest changeset
   uint64_t position0, position1, position;
-  uint64_t lsn1 = scan_for_newest_changeset(&m_state.files[0], &position0);
-  uint64_t lsn2 = scan_for_newest_changeset(&m_state.files[1], &position1);
+  uint64_t cp_lsn[2], cp_position[2], newest_lsn[2];
+  uint64_t lsn1 = scan_for_newest_changeset(&m_state.files[0], &position0,
+                  &cp_lsn[0], &cp_position[0], &newest_lsn[0]);
+  uint64_t lsn2 = scan_for_newest_changeset(&m_state.files[1], &position1,
+                  &cp_lsn[1], &cp_position[1], &newest_lsn[1]);
+
+  // remember the newest checkpoint; the logical recovery starts there
+  int cp = cp_lsn[0] > cp_lsn[1] ? 0 : 1;
+  if (cp_lsn[cp] != 0) {
+    m_state.last_cp_lsn = cp_lsn[cp];
+    m_state.last_cp_fd = cp;
+    m_state.last_cp_offset = cp_position[cp];
+    m_state.last_cp_in_newest_file = newest_lsn[cp] >= newest_lsn[1 - cp];
+  }
 
   // both files are empty or do not contain a changeset?
   if (lsn1 == 0 && lsn2 == 0)
@@ -572,6 +830,7 @@ Journal::recover_changeset()
 
     uint32_t page_size = m_state.env->config().page_size_bytes;
     ByteArray arena(page_size);
+    ByteArray compressed;
 
     uint64_t file_size = m_state.env->device()->file_size();
 
@@ -581,9 +840,20 @@ Journal::recover_changeset()
       m_state.files[m_state.current_fd].pread(position, &page_header,
                       sizeof(page_header));
       position += sizeof(page_header);
-      m_state.files[m_state.current_fd].pread(position, arena.get_ptr(),
-                      page_size);
-      position += page_size;
+      if (page_header.compressed_size) {
+        m_state.files[m_state.current_fd].pread(position,
+                        compressed.resize(page_header.compressed_size),
+                        page_header.compressed_size);
+        position += page_header.compressed_size;
+        get_decompressor(entry.compressor)->decompress(compressed.get_ptr(),
+                        page_header.compressed_size, arena.get_ptr(),
+                        page_size);
+      }
+      else {
+        m_state.files[m_state.current_fd].pread(position, arena.get_ptr(),
+                        page_size);
+        position += page_size;
+      }
 
       Page *page;
 
@@ -666,6 +936,16 @@ Journal::recover_journal(Context *context,
   // do not append to the journal during recovery
   m_state.disable_logging = true;
 
+  // skip everything before the newest checkpoint. If the checkpoint is in
+  // the newer file then the older file is not read at all.
+  if (m_state.last_cp_lsn != 0) {
+    it.fdidx = m_state.last_cp_fd;
+    it.fdstart = m_state.last_cp_in_newest_file
+                    ? 1 - m_state.last_cp_fd
+                    : m_state.last_cp_fd;
+    it.offset = m_state.last_cp_offset + sizeof(PJournalEntry);
+  }
+
   do {
     PJournalEntry entry;
 
@@ -758,6 +1038,10 @@ Journal::recover_journal(Context *context,
         // skip this; the changeset was already applied
         break;
       }
+      case kEntryTypeCheckpoint: {
+        // nothing to do
+        break;
+      }
       default:
         ham_log(("invalid journal entry type or journal is corrupt"));
         st = HAM_IO_ERROR;
@@ -846,13 +1130,24 @@ Journal::test()
 }
 
 JournalState::JournalState(LocalEnvironment *env)
-  : env(env), current_fd(0), threshold(env->config().journal_switch_threshold),
-    disable_logging(false), count_bytes_flushed(0),
-    count_bytes_before_compression(0), count_bytes_after_compression(0)
+  : env(env), current_fd(0), last_cp_lsn(0), last_cp_fd(0),
+    last_cp_offset(0), last_cp_in_newest_file(false),
+    threshold(env->config().journal_switch_threshold),
+    disable_logging(false), decompressor_algo(0), count_bytes_flushed(0),
+    count_bytes_before_compression(0), count_bytes_after_compression(0),
+    count_fsyncs(0)
 {
   if (threshold == 0)
     threshold = kSwitchTxnThreshold;
 
+  if (env->config().journal_compressor)
+    compressor.reset(CompressorFactory::create(
+                            env->config().journal_compressor));
+
+  if ((env->get_flags() & HAM_ENABLE_TRANSACTIONS)
+        && (env->get_flags() & HAM_ENABLE_FSYNC))
+    group_commit.window = env->config().journal_commit_window;
+
   open_txn[0] = 0;
   open_txn[1] = 0;
   closed_txn[0] = 0;
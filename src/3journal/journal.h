@@ -35,6 +35,14 @@
  * was written. In case of a commit or a changeset there will also be an
  * fsync, if HAM_ENABLE_FSYNC is enabled.
  *
+ * With "group commit" (HAM_PARAM_JOURNAL_COMMIT_WINDOW), a commit does not
+ * flush the buffer. Instead the committing thread releases the
+ * Environment's lock and calls wait_for_commit(). The first waiting thread
+ * becomes the "leader": it waits for the configured time window, then
+ * writes the buffers and syncs the files for all Transactions which were
+ * committed in the meantime. All other threads wait till their commit
+ * is durable.
+ *
  * The physical information is a collection of pages which are modified in
  * one or more database operations (i.e. ham_db_erase). This collection is
  * called a "changeset" and implemented in changeset.h/.cc. As soon as the
@@ -62,6 +70,17 @@
  * already applied, and we know that all older changesets
  * have already been written successfully to the database file.
  *
+ * With HAM_PARAM_CHECKPOINT_AGE_LIMIT, the TransactionManager periodically
+ * flushes all committed Transactions and appends a checkpoint. At this
+ * point all older entries are persisted in the database file; the
+ * recovery starts reading the journal at the newest checkpoint.
+ *
+ * With HAM_PARAM_JOURNAL_COMPRESSION, keys, records and changeset pages
+ * above a size threshold are compressed. The algorithm is stored in each
+ * PJournalEntry, therefore the parameter does not have to be specified
+ * again when the journal is recovered. get_entry() returns uncompressed
+ * entries.
+ *
  * @exception_safe: basic
  * @thread_safe: no
  */
@@ -126,7 +145,10 @@ class Journal
       kEntryTypeErase      = 5,
 
       // marks a whole changeset operation (writes modified pages)
-      kEntryTypeChangeset  = 6
+      kEntryTypeChangeset  = 6,
+
+      // marks a checkpoint; all older entries are persisted
+      kEntryTypeCheckpoint = 7
     };
 
     //
@@ -180,6 +202,18 @@ class Journal
     // Appends a journal entry for ham_txn_commit/kEntryTypeTxnCommit
     void append_txn_commit(LocalTransaction *txn, uint64_t lsn);
 
+    // Returns the ticket of the most recent commit if the caller has to
+    // wait for it (see wait_for_commit()), otherwise 0. Resets the ticket.
+    uint64_t take_commit_ticket() {
+      uint64_t ticket = m_state.group_commit.ticket;
+      m_state.group_commit.ticket = 0;
+      return (ticket);
+    }
+
+    // Waits till the commit with the |ticket| is durable. Must be called
+    // WITHOUT holding the Environment's lock.
+    void wait_for_commit(uint64_t ticket);
+
     // Appends a journal entry for ham_insert/kEntryTypeInsert
     void append_insert(Database *db, LocalTransaction *txn,
                     ham_key_t *key, ham_record_t *record, uint32_t flags,
@@ -193,6 +227,11 @@ class Journal
     // Appends a journal entry for a whole changeset/kEntryTypeChangeset
     void append_changeset(const Page **pages, int num_pages, uint64_t lsn);
 
+    // Appends a checkpoint/kEntryTypeCheckpoint. The caller guarantees
+    // that all modifications older than |lsn| were written to the
+    // database file, and that there are no open Transactions.
+    void append_checkpoint(uint64_t lsn);
+
     // Adjusts the transaction counters; called whenever |txn| is flushed.
     void transaction_flushed(LocalTransaction *txn);
 
@@ -212,6 +251,18 @@ class Journal
     // Fills the metrics
     void fill_metrics(ham_env_metrics_t *metrics) {
       metrics->journal_bytes_flushed = m_state.count_bytes_flushed;
+      metrics->journal_bytes_before_compression =
+              m_state.count_bytes_before_compression;
+      metrics->journal_bytes_after_compression =
+              m_state.count_bytes_after_compression;
+
+      JournalState::GroupCommit &gc = m_state.group_commit;
+      ScopedLock lock(gc.mutex);
+      metrics->journal_fsyncs = m_state.count_fsyncs + gc.count_fsyncs;
+      m_state.fsync_latency.fill_metrics(&metrics->latency_journal_fsync);
+      metrics->journal_group_commits = gc.count_batches;
+      for (int i = 0; i < JournalState::GroupCommit::kHistogramSize; i++)
+        metrics->journal_group_commit_sizes[i] = gc.batch_sizes[i];
     }
 
   private:
@@ -235,13 +286,30 @@ class Journal
     // was enabled)
     uint32_t append_changeset_page(const Page *page, uint32_t page_size);
 
+    // Compresses |size| bytes of |data| into |m_state.compressor_arena[arena]|.
+    // Returns the compressed size, or 0 if compression is disabled, if
+    // |data| is too small or if it cannot be compressed.
+    uint32_t compress(const uint8_t *data, uint32_t size, int arena);
+
+    // Returns a compressor for reading entries which were compressed
+    // with |algo|
+    Compressor *get_decompressor(int algo);
+
+    // Replaces the compressed follow-up data of an insert or erase entry
+    // with the uncompressed data
+    void decompress_entry(PJournalEntry *entry, ByteArray *auxbuffer);
+
     // Recovers (re-applies) the physical changelog; returns the lsn of the
     // Changelog
     uint64_t recover_changeset();
 
     // Scans a file for the newest changeset. Returns the lsn of this
-    // changeset, and the position (offset) in the file
-    uint64_t scan_for_newest_changeset(File *file, uint64_t *position);
+    // changeset, and the position (offset) in the file. Also returns
+    // the lsn and position of the newest checkpoint, and the lsn of the
+    // newest entry in the file.
+    uint64_t scan_for_newest_changeset(File *file, uint64_t *position,
+                    uint64_t *checkpoint_lsn, uint64_t *checkpoint_position,
+                    uint64_t *newest_lsn);
 
     // Recovers the logical journal
     void recover_journal(Context *context,
@@ -306,8 +374,11 @@ class Journal
         m_state.count_bytes_flushed += m_state.buffer[idx].get_size();
 
         m_state.buffer[idx].clear();
-        if (fsync)
+        if (fsync) {
+          ScopedLatency latency(&m_state.fsync_latency);
           m_state.files[idx].flush();
+          m_state.count_fsyncs++;
+        }
       }
     }
 
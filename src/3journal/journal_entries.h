@@ -47,7 +47,7 @@ HAM_PACK_0 struct HAM_PACK_1 PJournalEntry {
   // Constructor - sets all fields to 0
   PJournalEntry()
     : lsn(0), followup_size(0), txn_id(0), type(0),
-        dbname(0), _reserved(0) {
+        dbname(0), compressor(0) {
   }
 
   // the lsn of this entry
@@ -65,8 +65,9 @@ HAM_PACK_0 struct HAM_PACK_1 PJournalEntry {
   // the name of the database which is modified by this entry
   uint16_t dbname;
 
-  // a reserved value - reqd for padding
-  uint16_t _reserved;
+  // the compression algorithm (HAM_COMPRESSOR_*) of the follow-up
+  // structure, or 0 if it is not compressed
+  uint16_t compressor;
 } HAM_PACK_2;
 
 #include "1base/packstop.h"
@@ -89,13 +90,13 @@ HAM_PACK_0 struct HAM_PACK_1 PJournalEntryInsert {
   // key size
   uint16_t key_size;
 
-  // PRO: compressed key size
+  // compressed key size; 0 if the key is not compressed
   uint16_t compressed_key_size;
 
   // record size
   uint32_t record_size;
 
-  // PRO: compressed record size
+  // compressed record size; 0 if the record is not compressed
   uint32_t compressed_record_size;
 
   // record partial size
@@ -110,7 +111,7 @@ HAM_PACK_0 struct HAM_PACK_1 PJournalEntryInsert {
   // data follows here - first |key_size| bytes for the key, then
   // |record_size| bytes for the record (and maybe some padding)
   //
-  // PRO: this data can be compressed
+  // the key and the record can be compressed
   uint8_t data[1];
 
   // Returns a pointer to the key data
@@ -142,7 +143,7 @@ HAM_PACK_0 struct HAM_PACK_1 PJournalEntryErase {
   // key size
   uint16_t key_size;
 
-  // PRO: compressed key size
+  // compressed key size; 0 if the key is not compressed
   uint16_t compressed_key_size;
 
   // flags of ham_erase(), ham_cursor_erase()
@@ -153,7 +154,7 @@ HAM_PACK_0 struct HAM_PACK_1 PJournalEntryErase {
 
   // the key data
   //
-  // PRO: this data can be compressed
+  // the key can be compressed
   uint8_t data[1];
 
   // Returns a pointer to the key data
@@ -197,7 +198,7 @@ HAM_PACK_0 struct HAM_PACK_1 PJournalEntryPageHeader {
   // the page address
   uint64_t address;
 
-  // PRO: the compressed size, if compression is enabled
+  // the compressed size of the page; 0 if the page is not compressed
   uint32_t compressed_size;
 } HAM_PACK_2;
 
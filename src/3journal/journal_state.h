@@ -18,7 +18,7 @@
  * The Journal's state
  *
  * @exception_safe: nothrow
- * @thread_safe: no
+ * @thread_safe: no (except for the group commit state)
  */
 
 #ifndef HAM_JOURNAL_STATE_H
@@ -28,11 +28,16 @@
 
 #include <map>
 #include <string>
+#include <string.h>
 
 #include "ham/hamsterdb_int.h" // for metrics
 
 #include "1base/dynamic_array.h"
+#include "1base/latency_histogram.h"
+#include "1base/mutex.h"
+#include "1base/scoped_ptr.h"
 #include "1os/file.h"
+#include "2compressor/compressor.h"
 
 // Always verify that a file of level N does not include headers > N!
 
@@ -52,7 +57,10 @@ struct JournalState
     kSwitchTxnThreshold = 32,
 
     // flush buffers if this limit is exceeded
-    kBufferLimit = 1024 * 1024 // 1 mb
+    kBufferLimit = 1024 * 1024, // 1 mb
+
+    // keys, records and pages smaller than this are not compressed
+    kCompressionThreshold = 64
   };
 
   JournalState(LocalEnvironment *env);
@@ -78,6 +86,16 @@ struct JournalState
   // The lsn of the previous checkpoint
   uint64_t last_cp_lsn;
 
+  // The file with the previous checkpoint (only valid during recovery)
+  int last_cp_fd;
+
+  // The offset of the previous checkpoint (only valid during recovery)
+  uint64_t last_cp_offset;
+
+  // true if |last_cp_fd| is the newer of the two files (only valid during
+  // recovery)
+  bool last_cp_in_newest_file;
+
   // When having more than these Transactions in one file, we
   // swap the files
   size_t threshold;
@@ -85,6 +103,19 @@ struct JournalState
   // Set to false to disable logging; used during recovery
   bool disable_logging;
 
+  // The compressor for new entries; null if compression is disabled
+  ScopedPtr<Compressor> compressor;
+
+  // Buffers for the compressed data
+  ByteArray compressor_arena[2];
+
+  // A compressor for reading entries which were written with a different
+  // algorithm (HAM_PARAM_JOURNAL_COMPRESSION is not persistent)
+  ScopedPtr<Compressor> decompressor;
+
+  // The algorithm of |decompressor|
+  int decompressor_algo;
+
   // Counting the flushed bytes (for ham_env_get_metrics)
   uint64_t count_bytes_flushed;
 
@@ -94,6 +125,66 @@ struct JournalState
   // Counting the bytes after compression (for ham_env_get_metrics)
   uint64_t count_bytes_after_compression;
 
+  // Counting the fsyncs (for ham_env_get_metrics)
+  uint64_t count_fsyncs;
+
+  // The latencies of the fsyncs, incl. those of the group commits
+  LatencyHistogram fsync_latency;
+
+  // The state for group commits (HAM_PARAM_JOURNAL_COMMIT_WINDOW).
+  // |appended|, |ticket| and |dirty| are protected by the Environment's
+  // mutex, all other members by |mutex|.
+  struct GroupCommit {
+    enum {
+      // number of slots in the histogram of the batch sizes
+      kHistogramSize = 8
+    };
+
+    GroupCommit()
+      : window(0), appended(0), ticket(0), durable(0), syncing(false),
+        count_fsyncs(0), count_batches(0) {
+      dirty[0] = dirty[1] = false;
+      ::memset(batch_sizes, 0, sizeof(batch_sizes));
+    }
+
+    // The time window for collecting commits, in microseconds; 0 if
+    // group commit is disabled
+    uint32_t window;
+
+    // The ticket of the most recently appended commit
+    uint64_t appended;
+
+    // The ticket of the last commit which was not yet picked up by the
+    // committing thread; see Journal::take_commit_ticket()
+    uint64_t ticket;
+
+    // Set if a file contains commits which were not yet synced
+    bool dirty[2];
+
+    // Serializes the threads which wait for their commits
+    Mutex mutex;
+
+    // Signals waiting threads when a group was synced
+    Condition cond;
+
+    // The ticket of the most recent durable commit
+    uint64_t durable;
+
+    // True while a thread (the "leader") flushes a group
+    bool syncing;
+
+    // Counting the fsyncs of the groups
+    uint64_t count_fsyncs;
+
+    // Counting the groups
+    uint64_t count_batches;
+
+    // Histogram of the group sizes
+    uint64_t batch_sizes[kHistogramSize];
+  };
+
+  GroupCommit group_commit;
+
   // A map of all opened Databases
   typedef std::map<uint16_t, Database *> DatabaseMap;
   DatabaseMap database_map;
@@ -17,6 +17,8 @@
 #include "0root/root.h"
 
 #include <string.h>
+#include <limits>
+#include <algorithm>
 
 // Always verify that a file of level N does not include headers > N!
 #include "1base/dynamic_array.h"
@@ -38,9 +40,24 @@
 namespace hamsterdb {
 
 enum {
-  kPurgeAtLeast = 20
+  kPurgeAtLeast = 20,
+
+  // pages are assigned to the flush threads in regions of 1 MB, so that
+  // each thread can still coalesce adjacent pages
+  kFlushRegionShift = 20,
+
+  // the interval of the checkpointer (in milliseconds) if only
+  // HAM_PARAM_CHECKPOINT_DIRTY_PERCENT is set
+  kCheckpointInterval = 100
 };
 
+// Returns the index of the flush thread which writes the page at |address|
+static inline int
+select_flush_worker(uint64_t address, int count)
+{
+  return ((int)((address >> kFlushRegionShift) % count));
+}
+
 PageManagerState::PageManagerState(LocalEnvironment *env)
   : config(env->config()), header(env->header()),
     device(env->device()), lsn_manager(env->lsn_manager()),
@@ -48,20 +65,104 @@ PageManagerState::PageManagerState(LocalEnvironment *env)
     state_page(0), last_blob_page(0), last_blob_page_id(0),
     page_count_fetched(0), page_count_index(0), page_count_blob(0),
     page_count_page_manager(0), cache_hits(0), cache_misses(0),
-    freelist_hits(0), freelist_misses(0)
+    freelist_hits(0), freelist_misses(0), page_checksums_verified(0),
+    page_checksums_skipped(0), page_checksum_failures(0),
+    checkpoint_dirty_limit(0), checkpoint_count(0), checkpoint_pages(0)
 {
+  read_ahead.max_pages = 4 * config.readahead_pages;
+
+  if (config.flush_stall_percent > 0
+          && !(config.flags & HAM_CACHE_UNLIMITED)) {
+    flush.stall_limit = cache.capacity() / config.page_size_bytes
+                            * config.flush_stall_percent / 100;
+    if (flush.stall_limit == 0)
+      flush.stall_limit = 1;
+  }
+
+  // without a dirty ratio, only the age of the pages is relevant
+  checkpoint_dirty_limit = std::numeric_limits<uint64_t>::max();
+  if (config.checkpoint_dirty_percent > 0
+          && !(config.flags & HAM_CACHE_UNLIMITED))
+    checkpoint_dirty_limit = cache.capacity() / config.page_size_bytes
+                            * config.checkpoint_dirty_percent / 100;
 }
 
 PageManager::PageManager(LocalEnvironment *env)
-  : m_state(env)
+  : m_flush_worker_count(0), m_state(env)
+{
+  start_workers();
+}
+
+void
+PageManager::start_workers()
+{
+  m_flush_worker_count = m_state.config.flush_workers;
+  if (m_flush_worker_count < 1)
+    m_flush_worker_count = 1;
+  for (int i = 0; i < m_flush_worker_count; i++)
+    m_flush_workers[i].reset(new PageManagerWorker(&m_state.cache,
+                            &m_state.flush));
+
+  if (m_state.config.readahead_pages > 0
+          && !(m_state.config.flags & HAM_IN_MEMORY))
+    m_readahead_worker.reset(new PageManagerWorker(&m_state.cache));
+
+  if ((m_state.config.checkpoint_dirty_percent > 0
+            || m_state.config.checkpoint_age_limit > 0)
+          && !(m_state.config.flags & (HAM_IN_MEMORY | HAM_READ_ONLY))) {
+    // a page is written when it was found dirty by two consecutive
+    // checkpoints; therefore the interval is half of the age limit
+    uint32_t interval = kCheckpointInterval;
+    if (m_state.config.checkpoint_age_limit > 0)
+      interval = std::max(m_state.config.checkpoint_age_limit / 2, 1u);
+    m_checkpointer.reset(new PageManagerCheckpointer(this, interval));
+  }
+}
+
+void
+PageManager::allocate_flush_messages(FlushPageMessage **messages)
 {
-  /* start the worker thread */
-  m_worker.reset(new PageManagerWorker(&m_state.cache));
+  for (int i = 0; i < m_flush_worker_count; i++)
+    messages[i] = m_flush_workers[i]->allocate_flush_message(m_state.device);
+}
+
+void
+PageManager::dispatch_flush_messages(FlushPageMessage **messages)
+{
+  for (int i = 0; i < m_flush_worker_count; i++) {
+    if (messages[i]->list.size()) {
+      m_state.flush.pending_pages += messages[i]->list.size();
+      m_flush_workers[i]->add_to_queue(messages[i]);
+    }
+    else
+      m_flush_workers[i]->release_flush_message(messages[i]);
+  }
+}
+
+void
+PageManagerCheckpointer::run()
+{
+  ScopedLock lock(m_mutex);
+  while (!m_stop_requested) {
+    m_cond.timed_wait(lock, boost::posix_time::milliseconds(m_interval));
+    if (m_stop_requested)
+      break;
+
+    lock.unlock();
+    try {
+      m_page_manager->checkpoint();
+    }
+    catch (Exception &ex) {
+      ham_log(("checkpoint failed with error %d", ex.code));
+    }
+    lock.lock();
+  }
 }
 
 void
 PageManager::initialize(uint64_t pageid)
 {
+  ScopedRecursiveLock lock(m_state.mutex);
   Context context(0, 0, 0);
 
   m_state.free_pages.clear();
@@ -116,6 +217,33 @@ PageManager::initialize(uint64_t pageid)
 
 Page *
 PageManager::fetch(Context *context, uint64_t address, uint32_t flags)
+{
+  Page *page;
+  bool from_cache;
+
+  // Look up (or load) the page while the state is locked, and pin it to
+  // make sure that it is not purged before it's added to the Changeset.
+  // The page itself is locked without holding the state lock, otherwise
+  // a thread waiting for a page would block all other threads.
+  {
+    ScopedRecursiveLock lock(m_state.mutex);
+    page = fetch_unlocked(context, address, flags, &from_cache);
+    if (!page)
+      return (0);
+    page->pin();
+  }
+
+  safely_lock_page(context, page, from_cache);
+  page->unpin();
+
+  if ((flags & PageManager::kReadAhead) && m_readahead_worker.get())
+    read_ahead(page, from_cache);
+  return (page);
+}
+
+Page *
+PageManager::fetch_unlocked(Context *context, uint64_t address,
+                uint32_t flags, bool *from_cache)
 {
   /* fetch the page from the cache */
   Page *page;
@@ -125,10 +253,12 @@ PageManager::fetch(Context *context, uint64_t address, uint32_t flags)
   else
     page = m_state.cache.get(address);
 
+  *from_cache = (page != 0);
+
   if (page) {
     if (flags & PageManager::kNoHeader)
       page->set_without_header(true);
-    return (safely_lock_page(context, page, true));
+    return (page);
   }
 
   if ((flags & PageManager::kOnlyFromCache)
@@ -138,6 +268,10 @@ PageManager::fetch(Context *context, uint64_t address, uint32_t flags)
   page = new Page(m_state.device, context->db);
   try {
     page->fetch(address);
+    if (flags & PageManager::kNoHeader)
+      page->set_without_header(true);
+    else if (m_state.config.flags & HAM_ENABLE_CRC32)
+      verify_checksum(page);
   }
   catch (Exception &ex) {
     delete page;
@@ -154,16 +288,14 @@ PageManager::fetch(Context *context, uint64_t address, uint32_t flags)
           && !(flags & PageManager::kReadOnly))
     maybe_store_state(context, false);
 
-  if (flags & PageManager::kNoHeader)
-    page->set_without_header(true);
-
   m_state.page_count_fetched++;
-  return (safely_lock_page(context, page, false));
+  return (page);
 }
 
 Page *
 PageManager::alloc(Context *context, uint32_t page_type, uint32_t flags)
 {
+  ScopedRecursiveLock lock(m_state.mutex);
   uint64_t address = 0;
   Page *page = 0;
   uint32_t page_size = m_state.config.page_size_bytes;
@@ -253,9 +385,33 @@ done:
   return (page);
 }
 
+Page *
+PageManager::alloc_uncached(Context *context, uint32_t page_type)
+{
+  ScopedRecursiveLock lock(m_state.mutex);
+  ham_assert((m_state.config.flags & HAM_IN_MEMORY) == 0);
+  ham_assert(page_type == Page::kTypeBindex || page_type == Page::kTypeBroot);
+
+  Page *page = new Page(m_state.device, context->db);
+  try {
+    page->alloc(page_type, Page::kInitializeWithZeroes);
+  }
+  catch (Exception &ex) {
+    delete page;
+    throw ex;
+  }
+
+  page->set_dirty(true);
+  m_state.freelist_misses++;
+  m_state.page_count_index++;
+  return (page);
+}
+
 Page *
 PageManager::alloc_multiple_blob_pages(Context *context, size_t num_pages)
 {
+  ScopedRecursiveLock lock(m_state.mutex);
+
   // allocate only one page? then use the normal ::alloc() method
   if (num_pages == 1)
     return (alloc(context, Page::kTypeBlob, 0));
@@ -270,13 +426,16 @@ PageManager::alloc_multiple_blob_pages(Context *context, size_t num_pages)
             it++) {
       if (it->second >= num_pages) {
         for (size_t i = 0; i < num_pages; i++) {
+          // the old content of the pages is overwritten; don't verify
+          // their checksums
           if (i == 0) {
-            page = fetch(context, it->first, 0);
+            page = fetch(context, it->first, PageManager::kNoHeader);
             page->set_type(Page::kTypeBlob);
             page->set_without_header(false);
           }
           else {
-            Page *p = fetch(context, it->first + (i * page_size), 0);
+            Page *p = fetch(context, it->first + (i * page_size),
+                            PageManager::kNoHeader);
             p->set_type(Page::kTypeBlob);
             p->set_without_header(true);
           }
@@ -315,91 +474,250 @@ PageManager::alloc_multiple_blob_pages(Context *context, size_t num_pages)
 void
 PageManager::fill_metrics(ham_env_metrics_t *metrics) const
 {
+  ScopedRecursiveLock lock(m_state.mutex);
   metrics->page_count_fetched = m_state.page_count_fetched;
   metrics->page_count_flushed = Page::ms_page_count_flushed;
+  Page::ms_fetch_latency.fill_metrics(&metrics->latency_page_fetch);
+  Page::ms_flush_latency.fill_metrics(&metrics->latency_page_flush);
   metrics->page_count_type_index = m_state.page_count_index;
   metrics->page_count_type_blob = m_state.page_count_blob;
   metrics->page_count_type_page_manager = m_state.page_count_page_manager;
   metrics->freelist_hits = m_state.freelist_hits;
   metrics->freelist_misses = m_state.freelist_misses;
+  metrics->page_checksums_computed = Page::ms_page_checksums_computed;
+  metrics->page_checksums_verified = m_state.page_checksums_verified;
+  metrics->page_checksums_skipped = m_state.page_checksums_skipped;
+  metrics->page_checksum_failures = m_state.page_checksum_failures;
   m_state.cache.fill_metrics(metrics);
+
+  metrics->checkpoint_count = m_state.checkpoint_count;
+  metrics->checkpoint_pages = m_state.checkpoint_pages;
+  metrics->flush_queue_depth = m_state.flush.pending_pages;
+  metrics->flush_stalls = m_state.flush.stalls;
+  metrics->flush_stall_usec = m_state.flush.stall_usec;
+  for (int i = 0; i < m_flush_worker_count; i++)
+    if (m_flush_workers[i].get())
+      metrics->flush_worker_pages[i] = m_flush_workers[i]->pages_flushed();
+
+  ScopedLock ra_lock(m_state.read_ahead.mutex);
+  metrics->readahead_issued = m_state.read_ahead.issued;
+  metrics->readahead_hits = m_state.read_ahead.hits;
+  metrics->readahead_wasted = m_state.read_ahead.wasted;
 }
 
-struct FlushAllPagesPurger
+// Locks all pages and collects their persisted data, so that the dirty
+// pages can be flushed with a single batch
+struct FlushAllPagesCollector
 {
-  FlushAllPagesPurger(bool delete_pages)
-    : delete_pages(delete_pages) {
+  bool operator()(Page *page) {
+    page->mutex().lock();
+    list.push_back(page->get_persisted_data());
+    return (false);
   }
 
+  std::vector<Page::PersistedData *> list;
+};
+
+struct DeleteAllPagesPurger
+{
   bool operator()(Page *page) {
-    ScopedSpinlock lock(page->mutex());
-    page->flush();
-    return (delete_pages);
+    return (true);
   }
-
-  bool delete_pages;
 };
 
+static void
+unlock_pages(std::vector<Page::PersistedData *> &list)
+{
+  std::vector<Page::PersistedData *>::iterator it;
+  for (it = list.begin(); it != list.end(); ++it)
+    (*it)->mutex.unlock();
+}
+
 void
 PageManager::flush(bool delete_pages)
 {
-  FlushAllPagesPurger purger(delete_pages);
-  m_state.cache.purge_if(purger);
+  ScopedRecursiveLock lock(m_state.mutex);
+  FlushAllPagesCollector collector;
+  m_state.cache.purge_if(collector);
 
   if (m_state.state_page) {
-    ScopedSpinlock lock(m_state.state_page->mutex());
-    m_state.state_page->flush();
+    m_state.state_page->mutex().lock();
+    collector.list.push_back(m_state.state_page->get_persisted_data());
+  }
+
+  try {
+    Page::flush(m_state.device, collector.list);
+  }
+  catch (Exception &) {
+    unlock_pages(collector.list);
+    throw;
+  }
+  unlock_pages(collector.list);
+
+  if (delete_pages) {
+    DeleteAllPagesPurger purger;
+    m_state.cache.purge_if(purger);
   }
 }
 
 // Returns true if the page can be purged: page must use allocated
 // memory instead of an mmapped pointer; page must not be in use (= in
-// a changeset) and not have cursors attached
+// a changeset) and not have cursors attached. The page is assigned to
+// the flush thread which is responsible for its file region.
 struct PurgeProcessor
 {
-  PurgeProcessor(Page *last_blob_page, FlushPageMessage *message)
-    : last_blob_page(last_blob_page), message(message) {
+  PurgeProcessor(Page *last_blob_page, FlushPageMessage **messages,
+                  int count)
+    : last_blob_page(last_blob_page), messages(messages), count(count) {
   }
 
   bool operator()(Page *page) {
     // the lock in here will be unlocked by the worker thread
-    if (page == last_blob_page || !page->mutex().try_lock())
+    if (page == last_blob_page || page->is_pinned()
+            || !page->mutex().try_lock())
       return (false);
-    message->list.push_back(page->get_persisted_data());
+    int i = select_flush_worker(page->get_address(), count);
+    messages[i]->list.push_back(page->get_persisted_data());
     return (true);
   }
 
   Page *last_blob_page;
-  FlushPageMessage *message;
+  FlushPageMessage **messages;
+  int count;
 };
 
 void
 PageManager::purge_cache(Context *context)
 {
-  // do NOT purge the cache iff
-  //   1. this is an in-memory Environment
-  //   2. there's still a "purge cache" operation pending
-  //   3. the cache is not full
-  if (m_state.config.flags & HAM_IN_MEMORY
-      || m_state.purge_cache_pending
-      || !m_state.cache.is_cache_full())
-    return;
+  {
+    ScopedRecursiveLock lock(m_state.mutex);
+
+    // do NOT purge the cache iff
+    //   1. this is an in-memory Environment
+    //   2. there's still a "purge cache" operation pending
+    //   3. the cache is not full
+    if (m_state.config.flags & HAM_IN_MEMORY
+        || m_state.purge_cache_pending
+        || !m_state.cache.is_cache_full())
+      return;
+
+    // Purge as many pages as possible to get memory usage down to the
+    // cache's limit.
+    FlushPageMessage *messages[HAM_MAX_FLUSH_WORKERS];
+    allocate_flush_messages(&messages[0]);
+    PurgeProcessor processor(m_state.last_blob_page, &messages[0],
+                    m_flush_worker_count);
+    m_state.cache.purge(processor, m_state.last_blob_page);
+    dispatch_flush_messages(&messages[0]);
+  }
 
-  // Purge as many pages as possible to get memory usage down to the
-  // cache's limit.
-  FlushPageMessage *message = new FlushPageMessage(m_state.device);
-  PurgeProcessor processor(m_state.last_blob_page, message);
-  m_state.cache.purge(processor, m_state.last_blob_page);
+  // apply back-pressure if the flush threads fall behind; the lock was
+  // released, because the flush threads do not need it
+  if (m_state.flush.stall_limit > 0
+          && m_state.flush.pending_pages > m_state.flush.stall_limit)
+    wait_for_flush_workers();
+}
 
-  if (message->list.size())
-    m_worker->add_to_queue(message);
-  else
-    delete message;
+void
+PageManager::wait_for_flush_workers()
+{
+  FlushState &flush = m_state.flush;
+  boost::posix_time::ptime start
+          = boost::posix_time::microsec_clock::universal_time();
+
+  {
+    ScopedLock lock(flush.mutex);
+    while (flush.pending_pages > flush.stall_limit)
+      flush.cond.wait(lock);
+  }
+
+  boost::posix_time::time_duration stalled
+          = boost::posix_time::microsec_clock::universal_time() - start;
+  flush.stalls++;
+  flush.stall_usec += (uint64_t)stalled.total_microseconds();
+}
+
+// Counts the dirty pages of the cache
+struct DirtyPageCounter
+{
+  DirtyPageCounter()
+    : count(0) {
+  }
+
+  bool operator()(Page *page) {
+    if (page->is_dirty())
+      count++;
+    return (false);
+  }
+
+  uint64_t count;
+};
+
+// Selects the dirty pages which are written by the checkpointer: all
+// pages which were already dirty during the previous checkpoint, and
+// as many other pages as required to get below the dirty limit. Pages
+// which are in use are skipped.
+struct CheckpointProcessor
+{
+  CheckpointProcessor(FlushPageMessage **messages, int count,
+                  uint64_t excess)
+    : messages(messages), count(count), excess(excess), selected(0) {
+  }
+
+  bool operator()(Page *page) {
+    // the lock in here will be unlocked by the worker thread
+    if (!page->is_dirty() || page->is_pinned()
+            || !page->mutex().try_lock())
+      return (false);
+
+    Page::PersistedData *data = page->get_persisted_data();
+    if (data->is_aged || excess > 0) {
+      int i = select_flush_worker(page->get_address(), count);
+      messages[i]->list.push_back(data);
+      if (excess > 0)
+        excess--;
+      selected++;
+    }
+    else {
+      data->is_aged = true;
+      page->mutex().unlock();
+    }
+    return (false);
+  }
+
+  FlushPageMessage **messages;
+  int count;
+  uint64_t excess;
+  uint64_t selected;
+};
+
+void
+PageManager::checkpoint()
+{
+  ScopedRecursiveLock lock(m_state.mutex);
+
+  DirtyPageCounter counter;
+  m_state.cache.purge_if(counter);
+
+  uint64_t excess = 0;
+  if (counter.count > m_state.checkpoint_dirty_limit)
+    excess = counter.count - m_state.checkpoint_dirty_limit;
+
+  FlushPageMessage *messages[HAM_MAX_FLUSH_WORKERS];
+  allocate_flush_messages(&messages[0]);
+  CheckpointProcessor processor(&messages[0], m_flush_worker_count, excess);
+  m_state.cache.purge_if(processor);
+  dispatch_flush_messages(&messages[0]);
+
+  m_state.checkpoint_count++;
+  m_state.checkpoint_pages += processor.selected;
 }
 
 void
 PageManager::reclaim_space(Context *context)
 {
+  ScopedRecursiveLock lock(m_state.mutex);
+
   if (m_state.last_blob_page) {
     m_state.last_blob_page_id = m_state.last_blob_page->get_address();
     m_state.last_blob_page = 0;
@@ -456,6 +774,8 @@ struct DbClosePurger
 void
 PageManager::close_database(Context *context, LocalDatabase *db)
 {
+  ScopedRecursiveLock lock(m_state.mutex);
+
   if (m_state.last_blob_page) {
     m_state.last_blob_page_id = m_state.last_blob_page->get_address();
     m_state.last_blob_page = 0;
@@ -475,6 +795,8 @@ PageManager::del(Context *context, Page *page, size_t page_count)
   if (m_state.config.flags & HAM_IN_MEMORY)
     return;
 
+  ScopedRecursiveLock lock(m_state.mutex);
+
   // remove all pages from the changeset, otherwise they won't be unlocked
   context->changeset.del(page);
   if (page_count > 1) {
@@ -504,16 +826,27 @@ PageManager::reset(Context *context)
 {
   close(context);
 
-  /* start the worker thread */
-  m_worker.reset(new PageManagerWorker(&m_state.cache));
+  /* start the worker threads */
+  start_workers();
 }
 
 void
 PageManager::close(Context *context)
 {
-  /* wait for the worker thread to stop */
-  if (m_worker.get())
-    m_worker->stop_and_join();
+  /* wait for the worker threads to stop */
+  if (m_checkpointer.get()) {
+    m_checkpointer->stop_and_join();
+    m_checkpointer.reset(0);
+  }
+  if (m_readahead_worker.get()) {
+    m_readahead_worker->stop_and_join();
+    m_readahead_worker.reset(0);
+  }
+  for (int i = 0; i < m_flush_worker_count; i++)
+    if (m_flush_workers[i].get())
+      m_flush_workers[i]->stop_and_join();
+
+  ScopedRecursiveLock lock(m_state.mutex);
 
   // store the state of the PageManager
   if ((m_state.config.flags & HAM_IN_MEMORY) == 0
@@ -557,6 +890,7 @@ PageManager::close(Context *context)
 Page *
 PageManager::get_last_blob_page(Context *context)
 {
+  ScopedRecursiveLock lock(m_state.mutex);
   if (m_state.last_blob_page)
     return (safely_lock_page(context, m_state.last_blob_page, true));
   if (m_state.last_blob_page_id)
@@ -567,6 +901,7 @@ PageManager::get_last_blob_page(Context *context)
 void 
 PageManager::set_last_blob_page(Page *page)
 {
+  ScopedRecursiveLock lock(m_state.mutex);
   m_state.last_blob_page_id = 0;
   m_state.last_blob_page = page;
 }
@@ -729,6 +1064,88 @@ PageManager::maybe_store_state(Context *context, bool force)
   }
 }
 
+void
+PageManager::verify_checksum(Page *page)
+{
+  if (!Page::has_checksum(page->get_persisted_data()))
+    return;
+
+  // Mapped pages are cheap to fetch again after they were purged from
+  // the cache; only verify them once
+  size_t index = 0;
+  if (!page->is_allocated()) {
+    index = (size_t)(page->get_address() / m_state.config.page_size_bytes);
+    if (index < m_state.verified_pages.size()
+            && m_state.verified_pages[index]) {
+      m_state.page_checksums_skipped++;
+      return;
+    }
+  }
+
+  m_state.page_checksums_verified++;
+  if (!page->verify_checksum()) {
+    m_state.page_checksum_failures++;
+    ham_log(("page %llu: checksum mismatch",
+                (unsigned long long)page->get_address()));
+    throw Exception(HAM_INTEGRITY_VIOLATED);
+  }
+
+  if (!page->is_allocated()) {
+    if (index >= m_state.verified_pages.size())
+      m_state.verified_pages.resize(index + 1);
+    m_state.verified_pages[index] = true;
+  }
+}
+
+void
+PageManager::read_ahead(Page *page, bool from_cache)
+{
+  if (page->is_without_header()
+          || (page->get_type() != Page::kTypeBindex
+              && page->get_type() != Page::kTypeBroot))
+    return;
+  PBtreeNode *node = PBtreeNode::from_page(page);
+  if (!node->is_leaf())
+    return;
+
+  ReadAheadState &ra = m_state.read_ahead;
+  uint64_t address = page->get_address();
+  int depth = (int)m_state.config.readahead_pages;
+
+  ScopedLock lock(ra.mutex);
+
+  // was this page read ahead? then it did not block on the disk (unless
+  // it was cached, and reading it was not required)
+  if (ra.pages.erase(address)) {
+    if (from_cache)
+      ra.wasted++;
+    else
+      ra.hits++;
+  }
+
+  // only read ahead if at least two leaves were fetched in sequential
+  // order; otherwise discard the pages which were read for a previous
+  // traversal
+  if (address == ra.expected_next)
+    ra.run_length++;
+  else {
+    ra.wasted += ra.pages.size();
+    ra.pages.clear();
+    ra.order.clear();
+    ra.run_length = 1;
+  }
+  ra.expected_next = node->get_right();
+
+  if (ra.expected_next == 0 || ra.run_length < 2 || ra.in_flight
+          || (int)ra.pages.size() > depth / 2)
+    return;
+
+  ra.in_flight = true;
+  m_readahead_worker->add_to_queue(new ReadAheadMessage(m_state.device, &ra,
+                          ra.expected_next, depth,
+                          m_state.device->file_size()));
+}
+
 Page *
 PageManager::safely_lock_page(Context *context, Page *page,
                 bool allow_recursive_lock)
@@ -751,7 +1168,7 @@ PageManager::safely_lock_page(Context *context, Page *page,
 
   // make sure that the old data is not leaked
   if (old_data != 0)
-    m_worker->add_to_queue(new ReleasePointerMessage(old_data));
+    m_flush_workers[0]->add_to_queue(new ReleasePointerMessage(old_data));
 
   return (page);
 }
@@ -20,7 +20,8 @@
  * their physical address in the file.
  *
  * @exception_safe: basic
- * @thread_safe: no
+ * @thread_safe: yes (fetching and allocating pages is synchronized; pages
+ *          are pinned until they are locked by the caller's Changeset)
  */
 
 #ifndef HAM_PAGE_MANAGER_H
@@ -32,6 +33,7 @@
 
 // Always verify that a file of level N does not include headers > N!
 #include "1base/scoped_ptr.h"
+#include "3page_manager/page_manager_checkpointer.h"
 #include "3page_manager/page_manager_state.h"
 #include "3page_manager/page_manager_test.h"
 #include "3page_manager/page_manager_worker.h"
@@ -66,7 +68,12 @@ class PageManager
       kReadOnly = 2,
 
       // Flag for fetch(): page is part of a multi-page blob, has no header
-      kNoHeader = 4
+      kNoHeader = 4,
+
+      // Flag for fetch(): page is the right sibling of the previously
+      // fetched leaf; enables read-ahead if the leaves are traversed
+      // sequentially
+      kReadAhead = 8
     };
 
     // Constructor
@@ -89,6 +96,12 @@ class PageManager
     // The page is locked and stored in |context->changeset|.
     Page *alloc(Context *context, uint32_t page_type, uint32_t flags = 0);
 
+    // Allocates a new btree page at the end of the file. The page is neither
+    // stored in the cache nor in |context->changeset|; the caller writes
+    // it with Page::flush() and then deletes it.
+    // Not supported for in-memory Environments.
+    Page *alloc_uncached(Context *context, uint32_t page_type);
+
     // Allocates multiple adjacent pages.
     // Used by the BlobManager to store blobs that span multiple pages
     // Returns the first page in the list of pages
@@ -98,10 +111,16 @@ class PageManager
     // Flushes all pages to disk and deletes them if |delete_pages| is true
     void flush(bool delete_pages);
 
-    // Asks the worker thread to purge the cache if the cache limits are
-    // exceeded
+    // Asks the flush threads to purge the cache if the cache limits are
+    // exceeded. Stalls the caller if too many pages are waiting to be
+    // flushed.
     void purge_cache(Context *context);
 
+    // Writes back dirty pages which exceed the dirty ratio or the age limit
+    // (HAM_PARAM_CHECKPOINT_DIRTY_PERCENT, HAM_PARAM_CHECKPOINT_AGE_LIMIT).
+    // The pages stay in the cache. Called by the checkpointer thread.
+    void checkpoint();
+
     // Reclaim file space; truncates unused file space at the end of the file.
     void reclaim_space(Context *context);
 
@@ -112,7 +131,7 @@ class PageManager
     // to the Freelist. Will not do anything if the Environment is in-memory.
     void del(Context *context, Page *page, size_t page_count = 1);
 
-    // Resets the PageManager; calls clear(), then starts a new worker thread
+    // Resets the PageManager; calls clear(), then starts new worker threads
     void reset(Context *context);
 
     // Closes the PageManager; flushes all dirty pages
@@ -135,16 +154,57 @@ class PageManager
     // Persists the PageManager's state in the file
     uint64_t store_state(Context *context);
 
+    // Implementation of fetch(); looks up the page in the cache or reads
+    // it from disk. Requires that the caller holds |m_state.mutex|.
+    // |from_cache| is set to true if the page was already cached.
+    Page *fetch_unlocked(Context *context, uint64_t address, uint32_t flags,
+                bool *from_cache);
+
     // Calls store_state() whenever it makes sense
     void maybe_store_state(Context *context, bool force);
 
+    // Verifies the checksum of a page which was read from the device;
+    // throws HAM_INTEGRITY_VIOLATED if the checksum does not match
+    void verify_checksum(Page *page);
+
+    // Called by fetch() for leaf pages which are traversed sequentially;
+    // asks the read-ahead worker to read the following leaves
+    void read_ahead(Page *page, bool from_cache);
+
     // Locks a page, fetches contents from disk if they were flushed in
     // the meantime
     Page *safely_lock_page(Context *context, Page *page,
                 bool allow_recursive_lock);
 
-    // The worker thread which flushes dirty pages
-    ScopedPtr<PageManagerWorker> m_worker;
+    // Starts the flush threads, the read-ahead thread and the
+    // checkpointer thread
+    void start_workers();
+
+    // Allocates a FlushPageMessage for each flush thread
+    void allocate_flush_messages(FlushPageMessage **messages);
+
+    // Sends the |messages| to the flush threads; empty messages are
+    // released
+    void dispatch_flush_messages(FlushPageMessage **messages);
+
+    // Blocks till the flush threads caught up with the writers
+    void wait_for_flush_workers();
+
+    // The threads which flush dirty pages; each thread is responsible for
+    // a subset of the file regions
+    ScopedPtr<PageManagerWorker> m_flush_workers[HAM_MAX_FLUSH_WORKERS];
+
+    // The number of threads in |m_flush_workers|
+    int m_flush_worker_count;
+
+    // The worker thread which reads leaf pages ahead; only started if
+    // HAM_PARAM_READAHEAD_PAGES is set
+    ScopedPtr<PageManagerWorker> m_readahead_worker;
+
+    // The checkpointer thread; only started if
+    // HAM_PARAM_CHECKPOINT_DIRTY_PERCENT or HAM_PARAM_CHECKPOINT_AGE_LIMIT
+    // is set
+    ScopedPtr<PageManagerCheckpointer> m_checkpointer;
 
     // The state
     PageManagerState m_state;
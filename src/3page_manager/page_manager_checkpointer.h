@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2005-2015 Christoph Rupp (chris@crupp.de).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * The checkpointer thread of the PageManager. Wakes up periodically and
+ * asks the PageManager to write back dirty pages, even if the cache is
+ * not full (see HAM_PARAM_CHECKPOINT_DIRTY_PERCENT and
+ * HAM_PARAM_CHECKPOINT_AGE_LIMIT).
+ *
+ * @exception_safe: nothrow
+ * @thread_safe: yes
+ */
+
+#ifndef HAM_PAGE_MANAGER_CHECKPOINTER_H
+#define HAM_PAGE_MANAGER_CHECKPOINTER_H
+
+#include "0root/root.h"
+
+#include <boost/thread.hpp>
+
+// Always verify that a file of level N does not include headers > N!
+#include "1base/mutex.h"
+
+#ifndef HAM_ROOT_H
+#  error "root.h was not included"
+#endif
+
+namespace hamsterdb {
+
+class PageManager;
+
+class PageManagerCheckpointer
+{
+  public:
+    // Starts the thread; it calls PageManager::checkpoint() every
+    // |interval| milliseconds
+    PageManagerCheckpointer(PageManager *page_manager, uint32_t interval)
+      : m_page_manager(page_manager), m_interval(interval),
+        m_stop_requested(false),
+        m_thread(&PageManagerCheckpointer::run, this) {
+    }
+
+    // Stops the thread and waits till it terminated
+    void stop_and_join() {
+      {
+        ScopedLock lock(m_mutex);
+        m_stop_requested = true;
+        m_cond.notify_one();
+      }
+      m_thread.join();
+    }
+
+  private:
+    // The thread function; implemented in page_manager.cc
+    void run();
+
+    // The PageManager
+    PageManager *m_page_manager;
+
+    // The interval between two checkpoints, in milliseconds
+    uint32_t m_interval;
+
+    // true if the Environment is closed
+    bool m_stop_requested;
+
+    // A mutex for protecting |m_cond|
+    Mutex m_mutex;
+
+    // Signalled when the thread is stopped
+    Condition m_cond;
+
+    // The actual thread
+    boost::thread m_thread;
+};
+
+} // namespace hamsterdb
+
+#endif // HAM_PAGE_MANAGER_CHECKPOINTER_H
@@ -20,7 +20,7 @@
  * their physical address in the file.
  *
  * @exception_safe: nothrow
- * @thread_safe: no
+ * @thread_safe: no (the PageManager synchronizes access through |mutex|)
  */
 
 #ifndef HAM_PAGE_MANAGER_STATE_H
@@ -29,9 +29,12 @@
 #include "0root/root.h"
 
 #include <map>
+#include <deque>
+#include <vector>
 #include <boost/atomic.hpp>
 
 // Always verify that a file of level N does not include headers > N!
+#include "1base/mutex.h"
 #include "2config/env_config.h"
 #include "3cache/cache.h"
 
@@ -47,6 +50,81 @@ class LocalDatabase;
 class LocalEnvironment;
 class LsnManager;
 
+/*
+ * The state of the read-ahead; shared by the PageManager and its
+ * read-ahead worker thread
+ */
+struct ReadAheadState
+{
+  ReadAheadState()
+    : max_pages(0), in_flight(false), expected_next(0), run_length(0),
+      issued(0), hits(0), wasted(0) {
+  }
+
+  // Protects all members of this structure
+  mutable Mutex mutex;
+
+  // Pages which were read ahead but not yet fetched; maps the address of
+  // a page to the address of its right sibling
+  std::map<uint64_t, uint64_t> pages;
+
+  // The addresses of |pages|, in the order in which they were read
+  std::deque<uint64_t> order;
+
+  // The maximum number of |pages|; older pages are dropped
+  size_t max_pages;
+
+  // true if a read-ahead request is pending
+  bool in_flight;
+
+  // The right sibling of the leaf which was fetched last
+  uint64_t expected_next;
+
+  // The number of leaves which were fetched in sequential order
+  int run_length;
+
+  // number of pages which were read ahead
+  uint64_t issued;
+
+  // number of read-ahead pages which were fetched afterwards
+  uint64_t hits;
+
+  // number of read-ahead pages which were never fetched (or which were
+  // already cached)
+  uint64_t wasted;
+};
+
+/*
+ * The state of the flush workers; shared by the PageManager and its
+ * flush threads
+ */
+struct FlushState
+{
+  FlushState()
+    : pending_pages(0), stall_limit(0), stalls(0), stall_usec(0) {
+  }
+
+  // Protects |cond|
+  Mutex mutex;
+
+  // Signalled by the flush threads whenever they finished a batch
+  Condition cond;
+
+  // number of pages which were handed to the flush threads, but not
+  // yet written
+  boost::atomic<uint64_t> pending_pages;
+
+  // writers are stalled while |pending_pages| exceeds this limit
+  // (0: writers are never stalled)
+  uint64_t stall_limit;
+
+  // number of stalled writers
+  boost::atomic<uint64_t> stalls;
+
+  // total time that writers were stalled, in microseconds
+  boost::atomic<uint64_t> stall_usec;
+};
+
 /*
  * The internal state of the PageManager
  */
@@ -57,6 +135,11 @@ struct PageManagerState
 
   PageManagerState(LocalEnvironment *env);
 
+  // Protects the state (and the cache) against concurrent access; recursive
+  // because PageManager::alloc() and PageManager::store_state() fetch
+  // additional pages
+  mutable RecursiveMutex mutex;
+
   // Copy of the Environment's configuration
   const EnvironmentConfiguration config;
 
@@ -114,6 +197,35 @@ struct PageManagerState
 
   // number of freelist misses
   uint64_t freelist_misses;
+
+  // Mapped pages whose checksum was already verified; a mapped page is
+  // only verified when it is fetched for the first time
+  std::vector<bool> verified_pages;
+
+  // number of verified page checksums
+  uint64_t page_checksums_verified;
+
+  // number of mapped pages which were not verified again
+  uint64_t page_checksums_skipped;
+
+  // number of invalid page checksums
+  uint64_t page_checksum_failures;
+
+  // The state of the read-ahead
+  ReadAheadState read_ahead;
+
+  // The state of the flush workers
+  FlushState flush;
+
+  // the checkpointer writes dirty pages if there are more than this
+  // number of dirty pages in the cache
+  uint64_t checkpoint_dirty_limit;
+
+  // number of checkpoints
+  uint64_t checkpoint_count;
+
+  // number of pages written by the checkpointer
+  uint64_t checkpoint_pages;
 };
 
 } // namespace hamsterdb
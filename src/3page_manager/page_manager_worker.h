@@ -28,10 +28,13 @@
 #include <boost/atomic.hpp>
 
 // Always verify that a file of level N does not include headers > N!
+#include "1base/dynamic_array.h"
 #include "2device/device.h"
 #include "2queue/queue.h"
 #include "2worker/worker.h"
 #include "3cache/cache.h"
+#include "3btree/btree_node.h"
+#include "3page_manager/page_manager_state.h"
 
 #ifndef HAM_ROOT_H
 #  error "root.h was not included"
@@ -45,6 +48,7 @@ class Device;
 enum {
   kFlushPage = 1,
   kReleasePointer = 2,
+  kReadAhead = 3,
 };
 
 
@@ -67,12 +71,65 @@ struct ReleasePointerMessage : public MessageBase
   Page::PersistedData *ptr;
 };
 
+struct ReadAheadMessage : public MessageBase
+{
+  ReadAheadMessage(Device *device, ReadAheadState *state, uint64_t address,
+                  int count, uint64_t file_size)
+    : MessageBase(kReadAhead, 0), device(device), state(state),
+      address(address), count(count), file_size(file_size) {
+  }
+
+  Device *device;
+  ReadAheadState *state;
+  uint64_t address;
+  int count;
+  uint64_t file_size;
+};
+
 
 class PageManagerWorker : public Worker
 {
   public:
-    PageManagerWorker(Cache *cache)
-      : Worker(), m_cache(cache) {
+    PageManagerWorker(Cache *cache, FlushState *flush = 0)
+      : Worker(), m_cache(cache), m_flush(flush), m_pages_flushed(0) {
+    }
+
+    // Destructor; releases the recycled messages
+    ~PageManagerWorker() {
+      MessageBase *message;
+      while ((message = m_free_messages.pop()))
+        delete message;
+    }
+
+    // Returns an empty FlushPageMessage for |device|. The messages are
+    // recycled after they were processed. Must not be called by more than
+    // one thread at a time.
+    FlushPageMessage *allocate_flush_message(Device *device) {
+      FlushPageMessage *message = (FlushPageMessage *)m_free_messages.pop();
+      if (!message)
+        return (new FlushPageMessage(device));
+      message->device = device;
+      return (message);
+    }
+
+    // Returns an unused FlushPageMessage to the pool
+    void release_flush_message(FlushPageMessage *message) {
+      message->list.clear();
+      m_free_messages.push(message);
+    }
+
+    // Returns the number of pages which were flushed by this thread
+    uint64_t pages_flushed() const {
+      return (m_pages_flushed);
+    }
+
+  protected:
+    // Recycles FlushPageMessages; all other messages are deleted
+    virtual void release_message(MessageBase *message) {
+      if (message->type == kFlushPage)
+        release_flush_message((FlushPageMessage *)message);
+      else
+        delete message;
     }
 
   private:
@@ -80,21 +137,17 @@ class PageManagerWorker : public Worker
       switch (message->type) {
         case kFlushPage: {
           FlushPageMessage *fpm = (FlushPageMessage *)message;
-          std::vector<Page::PersistedData *>::iterator it;
-          for (it = fpm->list.begin(); it != fpm->list.end(); ++it) {
-            Page::PersistedData *page_data = *it;
-            ham_assert(page_data != 0);
-            ham_assert(page_data->mutex.try_lock() == false);
-            try {
-              if (page_data->raw_data != 0)
-                Page::flush(fpm->device, page_data);
-            }
-            catch (Exception &ex) {
-              page_data->mutex.unlock();
-              throw;
-            }
-            page_data->mutex.unlock();
+          // the dirty pages are written with a single batch
+          try {
+            Page::flush(fpm->device, fpm->list);
+          }
+          catch (Exception &ex) {
+            unlock(fpm->list);
+            flush_completed(fpm->list.size());
+            throw;
           }
+          unlock(fpm->list);
+          flush_completed(fpm->list.size());
           break;
         }
         case kReleasePointer: {
@@ -103,13 +156,105 @@ class PageManagerWorker : public Worker
           delete rpm->ptr;
           break;
         }
+        case kReadAhead: {
+          read_ahead((ReadAheadMessage *)message);
+          break;
+        }
         default:
           ham_assert(!"shouldn't be here");
       }
     }
 
+    // Unlocks the pages of a FlushPageMessage
+    void unlock(std::vector<Page::PersistedData *> &list) {
+      std::vector<Page::PersistedData *>::iterator it;
+      for (it = list.begin(); it != list.end(); ++it) {
+        ham_assert((*it)->mutex.try_lock() == false);
+        (*it)->mutex.unlock();
+      }
+    }
+
+    // Updates the counters after |count| pages were flushed, and wakes
+    // up writers which are stalled
+    void flush_completed(size_t count) {
+      m_pages_flushed += count;
+      if (!m_flush)
+        return;
+      m_flush->pending_pages -= count;
+      ScopedLock lock(m_flush->mutex);
+      m_flush->cond.notify_all();
+    }
+
+    // Reads up to |count| leaf pages, starting at |address| and following
+    // the right siblings. The pages are not stored in the cache; but they
+    // are now in the file cache of the operating system, and fetching them
+    // will not block on the disk.
+    void read_ahead(ReadAheadMessage *ram) {
+      ReadAheadState *state = ram->state;
+      size_t page_size = ram->device->page_size();
+      uint64_t address = ram->address;
+      m_buffer.resize(page_size);
+
+      for (int i = 0; i < ram->count && address != 0; i++) {
+        // skip pages which were already read
+        {
+          ScopedLock lock(state->mutex);
+          std::map<uint64_t, uint64_t>::iterator it
+                  = state->pages.find(address);
+          if (it != state->pages.end()) {
+            address = it->second;
+            continue;
+          }
+        }
+
+        if (address + page_size > ram->file_size)
+          break;
+        try {
+          ram->device->read(address, m_buffer.get_ptr(), page_size);
+        }
+        catch (Exception &) {
+          break;
+        }
+
+        // only continue if this is a leaf
+        PPageData *data = (PPageData *)m_buffer.get_ptr();
+        if (data->header.flags != Page::kTypeBindex
+                && data->header.flags != Page::kTypeBroot)
+          break;
+        PBtreeNode *node = (PBtreeNode *)data->header.payload;
+        if (!node->is_leaf())
+          break;
+
+        ScopedLock lock(state->mutex);
+        state->pages[address] = node->get_right();
+        state->order.push_back(address);
+        state->issued++;
+        while (state->order.size() > state->max_pages) {
+          if (state->pages.erase(state->order.front()))
+            state->wasted++;
+          state->order.pop_front();
+        }
+        address = node->get_right();
+      }
+
+      ScopedLock lock(state->mutex);
+      state->in_flight = false;
+    }
+
     // The PageManager's cache
     Cache *m_cache;
+
+    // The state shared with the other flush threads; can be null
+    FlushState *m_flush;
+
+    // number of pages flushed by this thread
+    boost::atomic<uint64_t> m_pages_flushed;
+
+    // Processed FlushPageMessages, ready to be reused
+    Queue m_free_messages;
+
+    // Buffer for reading pages ahead
+    ByteArray m_buffer;
 };
 
 } // namespace hamsterdb
@@ -228,6 +228,16 @@ class LocalCursor : public Cursor
       m_flags &= ~kCoupledToTxn;
     }
 
+    // Couples the cursor to the key |slot| of a btree leaf |page|, after
+    // the caller processed all keys up to (and including) this key
+    // without moving the cursor (see LocalDatabase::scan()). The next
+    // move(HAM_CURSOR_NEXT) returns the first key behind |slot|.
+    void couple_to_btree_page(Page *page, int slot) {
+      clear_dupecache();
+      m_btree_cursor.couple_to_page(page, slot, 0);
+      couple_to_btree();
+    }
+
     // Returns true if a cursor is coupled to the btree
     bool is_coupled_to_btree() const {
       return (!(m_flags & kCoupledToTxn));
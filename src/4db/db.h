@@ -112,6 +112,10 @@ class Database
     virtual ham_status_t erase(Cursor *cursor, Transaction *txn, ham_key_t *key,
                     uint32_t flags) = 0;
 
+    // Loads sorted key/value pairs into an empty Database (ham_db_bulk_load)
+    virtual ham_status_t bulk_load(ham_bulk_load_func_t func, void *context,
+                    uint32_t fill_factor) = 0;
+
     // Lookup of a key/value pair (ham_db_find, ham_cursor_find)
     virtual ham_status_t find(Cursor *cursor, Transaction *txn, ham_key_t *key,
                     ham_record_t *record, uint32_t flags) = 0;
@@ -19,6 +19,7 @@
 #include <boost/scope_exit.hpp>
 
 // Always verify that a file of level N does not include headers > N!
+#include "2compressor/compressor_factory.h"
 #include "3page_manager/page_manager.h"
 #include "3journal/journal.h"
 #include "3blob_manager/blob_manager.h"
@@ -176,7 +177,7 @@ LocalDatabase::insert_txn(Context *context, ham_key_t *key,
   /* get (or create) the node for this key */
   TransactionNode *node = m_txn_index->get(key, 0);
   if (!node) {
-    node = new TransactionNode(this, key);
+    node = m_txn_index->create_node(key);
     node_created = true;
     // TODO only store when the operation is successful?
     m_txn_index->store(node);
@@ -191,7 +192,7 @@ LocalDatabase::insert_txn(Context *context, ham_key_t *key,
   if (st) {
     if (node_created) {
       m_txn_index->remove(node);
-      delete node;
+      m_txn_index->destroy_node(node);
     }
     return (st);
   }
@@ -523,7 +524,7 @@ LocalDatabase::erase_txn(Context *context, ham_key_t *key, uint32_t flags,
   /* get (or create) the node for this key */
   TransactionNode *node = m_txn_index->get(key, 0);
   if (!node) {
-    node = new TransactionNode(this, key);
+    node = m_txn_index->create_node(key);
     node_created = true;
     // TODO only store when the operation is successful?
     m_txn_index->store(node);
@@ -536,7 +537,7 @@ LocalDatabase::erase_txn(Context *context, ham_key_t *key, uint32_t flags,
     if (st) {
       if (node_created) {
         m_txn_index->remove(node);
-        delete node;
+        m_txn_index->destroy_node(node);
       }
       return (st);
     }
@@ -627,6 +628,27 @@ LocalDatabase::create(Context *context, PBtreeHeader *btree_header)
     }
   }
 
+  // variable length records up to the threshold are stored in the leaf;
+  // this is not used for fixed length records or for duplicate keys
+  if (m_config.record_size != HAM_RECORD_SIZE_UNLIMITED
+        || (m_config.flags & HAM_ENABLE_DUPLICATE_KEYS))
+    m_config.inline_record_threshold = 0;
+
+  // the key compression and the inline record threshold select the btree
+  // layout, therefore they have to be stored before the btree is created
+  btree_header->set_key_compression(m_config.key_compressor);
+  btree_header->set_inline_record_threshold(
+                  (uint8_t)m_config.inline_record_threshold);
+
+  // records are compressed by the DiskBlobManager; they are not compressed
+  // in an In-Memory Environment
+  if (lenv()->get_flags() & HAM_IN_MEMORY)
+    m_config.record_compressor = 0;
+  btree_header->set_record_compression(m_config.record_compressor);
+  if (m_config.record_compressor)
+    m_record_compressor.reset(CompressorFactory::create(
+                            m_config.record_compressor));
+
   // create the btree
   m_btree_index.reset(new BtreeIndex(this, btree_header, persistent_flags,
                         m_config.key_type, m_config.key_size));
@@ -664,6 +686,17 @@ LocalDatabase::open(Context *context, PBtreeHeader *btree_header)
 
   m_config.key_type = btree_header->key_type();
   m_config.key_size = btree_header->key_size();
+  m_config.inline_record_threshold = btree_header->inline_record_threshold();
+  m_config.record_compressor = btree_header->record_compression();
+  if (m_config.record_compressor) {
+    if (!CompressorFactory::is_available(m_config.record_compressor)) {
+      ham_trace(("Record compression %d is not available",
+                 m_config.record_compressor));
+      return (HAM_NOT_IMPLEMENTED);
+    }
+    m_record_compressor.reset(CompressorFactory::create(
+                            m_config.record_compressor));
+  }
 
   /* create the BtreeIndex */
   m_btree_index.reset(new BtreeIndex(this, btree_header,
@@ -788,10 +821,13 @@ LocalDatabase::get_parameters(ham_parameter_t *param)
           }
           break;
         case HAM_PARAM_RECORD_COMPRESSION:
-          p->value = 0;
+          p->value = m_config.record_compressor;
           break;
         case HAM_PARAM_KEY_COMPRESSION:
-          p->value = 0;
+          p->value = m_btree_index->key_compression();
+          break;
+        case HAM_PARAM_INLINE_RECORD_THRESHOLD:
+          p->value = m_config.inline_record_threshold;
           break;
         default:
           ham_trace(("unknown parameter %d", (int)p->name));
@@ -829,6 +865,13 @@ LocalDatabase::check_integrity(uint32_t flags)
 
 ham_status_t
 LocalDatabase::count(Transaction *htxn, bool distinct, uint64_t *pcount)
+{
+  return (count(htxn, distinct, pcount, 1));
+}
+
+ham_status_t
+LocalDatabase::count(Transaction *htxn, bool distinct, uint64_t *pcount,
+                uint32_t threads)
 {
   LocalTransaction *txn = dynamic_cast<LocalTransaction *>(htxn);
 
@@ -842,7 +885,7 @@ LocalDatabase::count(Transaction *htxn, bool distinct, uint64_t *pcount)
      * call the btree function - this will retrieve the number of keys
      * in the btree
      */
-    uint64_t keycount = m_btree_index->count(&context, distinct);
+    uint64_t keycount = m_btree_index->count(&context, distinct, threads);
 
     /*
      * if transactions are enabled, then also sum up the number of keys
@@ -859,8 +902,106 @@ LocalDatabase::count(Transaction *htxn, bool distinct, uint64_t *pcount)
   }
 }
 
+//
+// Lets a ScanVisitor process whole leaf nodes; used for parallel scans
+//
+struct ScanNodeVisitor : public BtreeVisitor {
+  ScanNodeVisitor(ScanVisitor *visitor, bool distinct)
+    : m_visitor(visitor), m_distinct(distinct) {
+  }
+
+  // Specifies if the visitor modifies the node
+  virtual bool is_read_only() const {
+    return (true);
+  }
+
+  // called for each node
+  virtual void operator()(Context *context, BtreeNodeProxy *node) {
+    if (node->get_count() > 0)
+      node->scan(context, m_visitor, 0, m_distinct);
+  }
+
+  ScanVisitor *m_visitor;
+  bool m_distinct;
+};
+
+//
+// Scans btree leaf nodes with multiple threads. Each thread has its own
+// clone of the ScanVisitor. Pages are collected in batches; a batch is
+// scanned when it is full (or when flush() is called).
+//
+class ParallelScan {
+    enum {
+      // The number of pages per thread in a batch
+      kPagesPerThread = 64
+    };
+
+  public:
+    ParallelScan(BtreeIndex *btree, ScanVisitor *visitor, bool distinct,
+                    uint32_t threads)
+      : m_btree(btree), m_visitor(visitor) {
+      for (uint32_t i = 0; i < threads; i++) {
+        m_clones.push_back(visitor->clone());
+        m_node_visitors.push_back(new ScanNodeVisitor(m_clones.back(),
+                                distinct));
+      }
+    }
+
+    ~ParallelScan() {
+      for (size_t i = 0; i < m_clones.size(); i++) {
+        delete m_node_visitors[i];
+        delete m_clones[i];
+      }
+    }
+
+    // Scans all leaf nodes
+    void scan_all(Context *context) {
+      m_btree->visit_leaves_parallel(context, m_node_visitors);
+    }
+
+    // Adds a page to the current batch, which is the page of the caller's
+    // cursor. Unlocks the other pages of |context| if the batch is scanned.
+    void add(Context *context, Page *page) {
+      m_pages.push_back(page->get_address());
+      if (m_pages.size() >= kPagesPerThread * m_clones.size())
+        flush(context, page);
+    }
+
+    // Scans the current batch. |cursor_page| is the page of the caller's
+    // cursor; it is locked again when the batch is finished, otherwise
+    // it could be purged from the cache.
+    void flush(Context *context, Page *cursor_page) {
+      if (!m_pages.empty()) {
+        m_btree->visit_pages_parallel(context, m_pages, m_node_visitors);
+        m_pages.clear();
+        if (cursor_page)
+          context->changeset.put(cursor_page);
+      }
+    }
+
+    // Merges the partial results of all threads into the visitor
+    void merge() {
+      for (size_t i = 0; i < m_clones.size(); i++)
+        m_visitor->merge(m_clones[i]);
+    }
+
+  private:
+    BtreeIndex *m_btree;
+    ScanVisitor *m_visitor;
+    std::vector<ScanVisitor *> m_clones;
+    std::vector<BtreeVisitor *> m_node_visitors;
+    std::vector<uint64_t> m_pages;
+};
+
 ham_status_t
 LocalDatabase::scan(Transaction *txn, ScanVisitor *visitor, bool distinct)
+{
+  return (scan(txn, visitor, distinct, 1));
+}
+
+ham_status_t
+LocalDatabase::scan(Transaction *txn, ScanVisitor *visitor, bool distinct,
+                uint32_t threads)
 {
   ham_status_t st = 0;
   LocalCursor *cursor = 0;
@@ -874,8 +1015,23 @@ LocalDatabase::scan(Transaction *txn, ScanVisitor *visitor, bool distinct)
     /* purge cache if necessary */
     lenv()->page_manager()->purge_cache(&context);
 
+    ScopedPtr<ParallelScan> parallel;
+    if (threads > 1) {
+      parallel.reset(new ParallelScan(m_btree_index.get(), visitor,
+                              distinct, threads));
+
+      /* no transactional keys? then split the btree and scan all leafs
+       * in parallel */
+      if (!(get_flags() & HAM_ENABLE_TRANSACTIONS)
+          || m_txn_index->get_first() == 0) {
+        parallel->scan_all(&context);
+        parallel->merge();
+        return (0);
+      }
+    }
+
     /* create a cursor, move it to the first key */
-    LocalCursor *cursor = (LocalCursor *)cursor_create_impl(txn);
+    cursor = (LocalCursor *)cursor_create_impl(txn);
 
     st = cursor_move_impl(&context, cursor, &key, 0, HAM_CURSOR_FIRST);
     if (st)
@@ -912,15 +1068,21 @@ LocalDatabase::scan(Transaction *txn, ScanVisitor *visitor, bool distinct)
      * in transactions then move the scan to the btree node. Otherwise use
      * a regular cursor */
     while (true) {
-      if (!cursor->is_coupled_to_btree())
+      /* the current key is a transactional key? process it, then pick up
+       * the remaining keys with the cursor */
+      if (!cursor->is_coupled_to_btree()) {
+        (*visitor)(key.data, key.size, distinct
+                                        ? cursor->get_duplicate_count(&context)
+                                        : 1);
         break;
+      }
 
       int slot;
       cursor->get_btree_cursor()->get_coupled_key(&page, &slot);
       BtreeNodeProxy *node = m_btree_index->get_node_from_page(page);
 
-      /* are transactions present? then check if the next txn key is >= btree[0]
-       * and <= btree[n] */
+      /* are transactions present? then check if the next txn key is
+       * <= btree[n] */
       ham_key_t *txnkey = 0;
       if (cursor->get_txn_cursor()->get_coupled_op())
         txnkey = cursor->get_txn_cursor()->get_coupled_op()->get_node()->get_key();
@@ -935,8 +1097,7 @@ LocalDatabase::scan(Transaction *txn, ScanVisitor *visitor, bool distinct)
       }
 
       /* if yes: use the cursor to traverse the page */
-      if (node->compare(&context, txnkey, 0) >= 0
-          && node->compare(&context, txnkey, node->get_count() - 1) <= 0) {
+      if (node->compare(&context, txnkey, node->get_count() - 1) <= 0) {
         do {
           Page *new_page = 0;
           if (cursor->is_coupled_to_btree())
@@ -958,23 +1119,52 @@ LocalDatabase::scan(Transaction *txn, ScanVisitor *visitor, bool distinct)
       }
       else {
         /* Otherwise traverse directly in the btree page. This is the fastest
-         * code path. */
-        node->scan(&context, visitor, slot, distinct);
-        /* and then move to the next page */
-        if (cursor->get_btree_cursor()->move_to_next_page(&context) != 0)
-          break;
+         * code path. Parallel scans hand the page over to the threads. */
+        if (parallel && slot == 0)
+          parallel->add(&context, page);
+        else
+          node->scan(&context, visitor, slot, distinct);
+        /* and then move the cursor behind the page; the cursor merges the
+         * next btree key with the transactional keys */
+        cursor->couple_to_btree_page(page, node->get_count() - 1);
+        st = cursor_move_impl(&context, cursor, &key, 0, HAM_CURSOR_NEXT);
+        if (st != HAM_SUCCESS)
+          goto bail;
       }
     }
 
     /* pick up the remaining transactional keys */
     while ((st = cursor_move_impl(&context, cursor, &key,
                             0, HAM_CURSOR_NEXT)) == 0) {
+      /* parallel scans: if only btree keys are left and the cursor reached
+       * the beginning of a page then the remaining pages are scanned by
+       * the threads */
+      if (parallel && cursor->is_coupled_to_btree()
+          && !cursor->get_txn_cursor()->get_coupled_op()) {
+        int slot;
+        cursor->get_btree_cursor()->get_coupled_key(&page, &slot);
+        if (slot == 0
+            && cursor->get_btree_cursor()->get_duplicate_index() == 0) {
+          do {
+            cursor->get_btree_cursor()->get_coupled_key(&page);
+            parallel->add(&context, page);
+          } while (cursor->get_btree_cursor()->move_to_next_page(
+                                  &context) == 0);
+          st = HAM_KEY_NOT_FOUND;
+          break;
+        }
+      }
+
       (*visitor)(key.data, key.size, distinct
                                      ? cursor->get_duplicate_count(&context)
                                      : 1);
     }
 
 bail:
+    if (parallel && (st == 0 || st == HAM_KEY_NOT_FOUND)) {
+      parallel->flush(&context, 0);
+      parallel->merge();
+    }
     if (cursor) {
       cursor->close();
       delete cursor;
@@ -996,6 +1186,7 @@ LocalDatabase::insert(Cursor *hcursor, Transaction *txn, ham_key_t *key,
 {
   LocalCursor *cursor = (LocalCursor *)hcursor;
   Context context(lenv(), (LocalTransaction *)txn, this);
+  ScopedLatency latency(&lenv()->latencies()->insert);
 
   try {
     if (m_config.flags & (HAM_RECORD_NUMBER32 | HAM_RECORD_NUMBER64)) {
@@ -1098,12 +1289,94 @@ LocalDatabase::insert(Cursor *hcursor, Transaction *txn, ham_key_t *key,
   }
 }
 
+//
+// Retrieves the keys for the bulk loader from the user's callback function
+// and verifies them
+//
+class BulkLoadCallbackSource : public BtreeBulkLoadSource {
+  public:
+    BulkLoadCallbackSource(LocalDatabase *db, ham_bulk_load_func_t func,
+                    void *context)
+      : m_db(db), m_func(func), m_context(context) {
+    }
+
+    virtual bool next(ham_key_t *key, ham_record_t *record) {
+      ham_key_t empty_key = {0};
+      ham_record_t empty_record = {0};
+      *key = empty_key;
+      *record = empty_record;
+
+      ham_status_t st = m_func(key, record, m_context);
+      if (st == HAM_KEY_NOT_FOUND)
+        return (false);
+      if (st)
+        throw Exception(st);
+
+      const DatabaseConfiguration &config = m_db->config();
+      if (key->size && !key->data) {
+        ham_trace(("key->size != 0, but key->data is NULL"));
+        throw Exception(HAM_INV_PARAMETER);
+      }
+      if (record->size && !record->data) {
+        ham_trace(("record->size != 0, but record->data is NULL"));
+        throw Exception(HAM_INV_PARAMETER);
+      }
+      if (config.key_size != HAM_KEY_SIZE_UNLIMITED
+          && key->size != config.key_size) {
+        ham_trace(("invalid key size (%u instead of %u)",
+              key->size, config.key_size));
+        throw Exception(HAM_INV_KEY_SIZE);
+      }
+      if (config.record_size != HAM_RECORD_SIZE_UNLIMITED
+          && record->size != config.record_size) {
+        ham_trace(("invalid record size (%u instead of %u)",
+              record->size, config.record_size));
+        throw Exception(HAM_INV_RECORD_SIZE);
+      }
+      key->flags = 0;
+      key->_flags = 0;
+      record->flags = 0;
+      return (true);
+    }
+
+  private:
+    LocalDatabase *m_db;
+    ham_bulk_load_func_t m_func;
+    void *m_context;
+};
+
+ham_status_t
+LocalDatabase::bulk_load(ham_bulk_load_func_t func, void *func_context,
+                uint32_t fill_factor)
+{
+  if (get_flags() & (HAM_RECORD_NUMBER32 | HAM_RECORD_NUMBER64)) {
+    ham_trace(("bulk loading is not supported for record number databases"));
+    return (HAM_INV_PARAMETER);
+  }
+  if (m_txn_index && m_txn_index->get_first()) {
+    ham_trace(("bulk loading requires an empty database"));
+    return (HAM_INV_PARAMETER);
+  }
+
+  Context context(lenv(), 0, this);
+
+  try {
+    BulkLoadCallbackSource source(this, func, func_context);
+    m_btree_index->bulk_load(&context, source, fill_factor);
+    return (0);
+  }
+  catch (Exception &ex) {
+    return (ex.code);
+  }
+}
+
 ham_status_t
 LocalDatabase::erase(Cursor *hcursor, Transaction *txn, ham_key_t *key,
                 uint32_t flags)
 {
   LocalCursor *cursor = (LocalCursor *)hcursor;
   Context context(lenv(), (LocalTransaction *)txn, this);
+  ScopedLatency latency(&lenv()->latencies()->erase);
 
   try {
     ham_status_t st = 0;
@@ -1163,6 +1436,8 @@ LocalDatabase::find(Cursor *hcursor, Transaction *txn, ham_key_t *key,
       return (st);
     }
 
+    ScopedLatency latency(&lenv()->latencies()->find);
+
     if (m_config.key_size != HAM_KEY_SIZE_UNLIMITED
         && key->size != m_config.key_size) {
       ham_trace(("invalid key size (%u instead of %u)",
@@ -28,6 +28,7 @@
 
 // Always verify that a file of level N does not include headers > N!
 #include "1base/scoped_ptr.h"
+#include "2compressor/compressor.h"
 #include "3btree/btree_index.h"
 #include "4txn/txn_local.h"
 #include "4db/db.h"
@@ -55,7 +56,11 @@ class LocalDatabase : public Database {
   public:
     enum {
       // The default threshold for inline records
-      kInlineRecordThreshold = 32
+      kInlineRecordThreshold = 32,
+
+      // The maximum threshold for variable length records which are
+      // stored in the leaf (see HAM_PARAM_INLINE_RECORD_THRESHOLD)
+      kMaxInlineRecordThreshold = 250
     };
 
     // Constructor
@@ -73,6 +78,12 @@ class LocalDatabase : public Database {
       return (m_txn_index.get());
     }
 
+    // Returns the compressor for the records; null if record compression
+    // is disabled
+    Compressor *record_compressor() {
+      return (m_record_compressor.get());
+    }
+
     // Returns the LocalEnvironment instance
     LocalEnvironment *lenv() {
       return ((LocalEnvironment *)m_env);
@@ -100,10 +111,21 @@ class LocalDatabase : public Database {
     virtual ham_status_t count(Transaction *txn, bool distinct,
                     uint64_t *pcount);
 
+    // Returns the number of keys; the btree is counted with |threads|
+    // threads
+    ham_status_t count(Transaction *txn, bool distinct, uint64_t *pcount,
+                    uint32_t threads);
+
     // Scans the whole database, applies a processor function
     virtual ham_status_t scan(Transaction *txn, ScanVisitor *visitor,
                     bool distinct);
 
+    // Scans the whole database with |threads| threads. Each thread uses
+    // its own clone of |visitor|; the partial results are merged into
+    // |visitor|. The transactional keys are processed by the calling thread.
+    ham_status_t scan(Transaction *txn, ScanVisitor *visitor, bool distinct,
+                    uint32_t threads);
+
     // Inserts a key/value pair (ham_db_insert, ham_cursor_insert)
     virtual ham_status_t insert(Cursor *cursor, Transaction *txn,
                     ham_key_t *key, ham_record_t *record, uint32_t flags);
@@ -112,6 +134,10 @@ class LocalDatabase : public Database {
     virtual ham_status_t erase(Cursor *cursor, Transaction *txn, ham_key_t *key,
                     uint32_t flags);
 
+    // Loads sorted key/value pairs into an empty Database (ham_db_bulk_load)
+    virtual ham_status_t bulk_load(ham_bulk_load_func_t func, void *context,
+                    uint32_t fill_factor);
+
     // Lookup of a key/value pair (ham_db_find, ham_cursor_find)
     virtual ham_status_t find(Cursor *cursor, Transaction *txn, ham_key_t *key,
                     ham_record_t *record, uint32_t flags);
@@ -253,6 +279,9 @@ class LocalDatabase : public Database {
     // the transaction index
     ScopedPtr<TransactionIndex> m_txn_index;
 
+    // the record compressor; can be null
+    ScopedPtr<Compressor> m_record_compressor;
+
     // the comparison function
     ham_compare_func_t m_cmp_func;
 };
@@ -77,6 +77,12 @@ class RemoteDatabase : public Database
     virtual ham_status_t erase(Cursor *cursor, Transaction *txn, ham_key_t *key,
                     uint32_t flags);
 
+    // Loads sorted key/value pairs into an empty Database (ham_db_bulk_load)
+    virtual ham_status_t bulk_load(ham_bulk_load_func_t func, void *context,
+                    uint32_t fill_factor) {
+      return (HAM_NOT_IMPLEMENTED);
+    }
+
     // Lookup of a key/value pair (ham_db_find, ham_cursor_find)
     virtual ham_status_t find(Cursor *cursor, Transaction *txn, ham_key_t *key,
                     ham_record_t *record, uint32_t flags);
@@ -241,7 +241,10 @@ Environment::txn_commit(Transaction *txn, uint32_t flags)
 {
   try {
     ScopedLock lock(m_mutex);
-    return (do_txn_commit(txn, flags));
+    ham_status_t st = do_txn_commit(txn, flags);
+    if (st == 0)
+      do_wait_for_commit(lock);
+    return (st);
   }
   catch (Exception &ex) {
     return (ex.code);
@@ -181,6 +181,12 @@ class Environment
     // Commits a transaction (ham_txn_commit)
     virtual ham_status_t do_txn_commit(Transaction *txn, uint32_t flags) = 0;
 
+    // Waits till a committed transaction is durable; called after
+    // do_txn_commit() while |lock| (the Environment's mutex) is held.
+    // The default implementation does nothing.
+    virtual void do_wait_for_commit(ScopedLock &lock) {
+    }
+
     // Commits a transaction (ham_txn_abort)
     virtual ham_status_t do_txn_abort(Transaction *txn, uint32_t flags) = 0;
 
@@ -64,8 +64,8 @@ typedef HAM_PACK_0 struct HAM_PACK_1
   // PRO: for storing journal compression algorithm
   uint8_t journal_compression;
 
-  // reserved
-  uint8_t _reserved2;
+  // persistent flags (EnvironmentHeader::kFlag*)
+  uint8_t flags;
 
   // blob id of the PageManager's state
   uint64_t page_manager_blobid;
@@ -83,6 +83,12 @@ typedef HAM_PACK_0 struct HAM_PACK_1
 class EnvironmentHeader
 {
   public:
+    // persistent flags
+    enum {
+      // the pages store a checksum (HAM_ENABLE_CRC32)
+      kFlagPageChecksums = 1
+    };
+
     // Constructor
     EnvironmentHeader(Page *page)
       : m_header_page(page) {
@@ -164,6 +170,16 @@ class EnvironmentHeader
       header()->journal_compression = (algorithm << 4) | level;
     }
 
+    // Returns the persistent flags (kFlag*)
+    uint8_t flags() {
+      return (header()->flags);
+    }
+
+    // Sets the persistent flags (kFlag*)
+    void set_flags(uint8_t flags) {
+      header()->flags = flags;
+    }
+
     // Returns the header page with persistent configuration settings
     Page *header_page() {
       return (m_header_page);
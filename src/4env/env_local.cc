@@ -18,8 +18,10 @@
 
 // Always verify that a file of level N does not include headers > N!
 #include "1os/os.h"
+#include "2compressor/compressor_factory.h"
 #include "2device/device_factory.h"
 #include "3btree/btree_index.h"
+#include "3btree/btree_keys_simd.h"
 #include "3btree/btree_stats.h"
 #include "3blob_manager/blob_manager_factory.h"
 #include "3journal/journal.h"
@@ -130,6 +132,12 @@ LocalEnvironment::do_create()
   m_header->set_page_size(m_config.page_size_bytes);
   m_header->set_max_databases(m_config.max_databases);
 
+  /* enable page checksums? this setting is persistent */
+  if (m_config.flags & HAM_IN_MEMORY)
+    m_config.flags &= ~HAM_ENABLE_CRC32;
+  if (m_config.flags & HAM_ENABLE_CRC32)
+    m_header->set_flags(EnvironmentHeader::kFlagPageChecksums);
+
   /* load page manager after setting up the blobmanager and the device! */
   m_page_manager.reset(new PageManager(this));
 
@@ -223,6 +231,13 @@ LocalEnvironment::do_open()
       goto fail_with_fake_cleansing;
     }
 
+    /* the checksum setting is persistent; it was specified when the
+     * Environment was created */
+    if (m_header->flags() & EnvironmentHeader::kFlagPageChecksums)
+      m_config.flags |= HAM_ENABLE_CRC32;
+    else
+      m_config.flags &= ~HAM_ENABLE_CRC32;
+
     st = 0;
 
 fail_with_fake_cleansing:
@@ -241,6 +256,12 @@ fail_with_fake_cleansing:
     /* now read the "real" header page and store it in the Environment */
     page = new Page(m_device.get());
     page->fetch(0);
+    if ((m_config.flags & HAM_ENABLE_CRC32) && !page->verify_checksum()) {
+      ham_log(("header page: checksum mismatch"));
+      delete page;
+      m_device->close();
+      return (HAM_INTEGRITY_VIOLATED);
+    }
     m_header.reset(new EnvironmentHeader(page));
   }
 
@@ -326,11 +347,44 @@ LocalEnvironment::do_get_parameters(ham_parameter_t *param)
         p->value = m_config.journal_switch_threshold;
         break;
       case HAM_PARAM_JOURNAL_COMPRESSION:
-        p->value = 0;
+        p->value = m_config.journal_compressor;
         break;
       case HAM_PARAM_POSIX_FADVISE:
         p->value = m_config.posix_advice;
         break;
+      case HAM_PARAM_CACHE_POLICY:
+        p->value = m_config.cache_policy;
+        break;
+      case HAM_PARAM_READAHEAD_PAGES:
+        p->value = m_config.readahead_pages;
+        break;
+      case HAM_PARAM_JOURNAL_COMMIT_WINDOW:
+        p->value = m_config.journal_commit_window;
+        break;
+      case HAM_PARAM_SIMD_SEARCH:
+        p->value = m_config.simd_search;
+        break;
+      case HAM_PARAM_LINEAR_SEARCH_THRESHOLD:
+        p->value = m_config.linear_search_threshold;
+        break;
+      case HAM_PARAM_IO_BACKEND:
+        p->value = m_config.io_backend;
+        break;
+      case HAM_PARAM_FLUSH_WORKERS:
+        p->value = m_config.flush_workers;
+        break;
+      case HAM_PARAM_FLUSH_STALL_PERCENT:
+        p->value = m_config.flush_stall_percent;
+        break;
+      case HAM_PARAM_CHECKPOINT_DIRTY_PERCENT:
+        p->value = m_config.checkpoint_dirty_percent;
+        break;
+      case HAM_PARAM_CHECKPOINT_AGE_LIMIT:
+        p->value = m_config.checkpoint_age_limit;
+        break;
+      case HAM_PARAM_MMAP_RESERVE:
+        p->value = m_config.mmap_reserve_bytes;
+        break;
       default:
         ham_trace(("unknown parameter %d", (int)p->name));
         return (HAM_INV_PARAMETER);
@@ -377,11 +431,27 @@ LocalEnvironment::do_create_db(Database **pdb, DatabaseConfiguration &config,
     for (; param->name; param++) {
       switch (param->name) {
         case HAM_PARAM_RECORD_COMPRESSION:
-          ham_trace(("Record compression is only available in hamsterdb pro"));
-          return (HAM_NOT_IMPLEMENTED);
+          if (param->value != HAM_COMPRESSOR_NONE
+                && !CompressorFactory::is_available((int)param->value)) {
+            ham_trace(("Record compression %u is not available",
+                       (unsigned)param->value));
+            return (HAM_NOT_IMPLEMENTED);
+          }
+          config.record_compressor = (int)param->value;
+          break;
         case HAM_PARAM_KEY_COMPRESSION:
-          ham_trace(("Key compression is only available in hamsterdb pro"));
-          return (HAM_NOT_IMPLEMENTED);
+          if (param->value != HAM_COMPRESSOR_NONE
+                && param->value != HAM_COMPRESSOR_PREFIX
+                && param->value != HAM_COMPRESSOR_FOR) {
+            ham_trace(("Key compression %u is only available in hamsterdb "
+                       "pro", (unsigned)param->value));
+            return (HAM_NOT_IMPLEMENTED);
+          }
+          config.key_compressor = (int)param->value;
+          break;
+        case HAM_PARAM_INLINE_RECORD_THRESHOLD:
+          config.inline_record_threshold = (size_t)param->value;
+          break;
         case HAM_PARAM_KEY_TYPE:
           config.key_type = (uint16_t)param->value;
           break;
@@ -445,6 +515,36 @@ LocalEnvironment::do_create_db(Database **pdb, DatabaseConfiguration &config,
     config.key_type = HAM_TYPE_UINT64;
   }
 
+  if (config.key_compressor == HAM_COMPRESSOR_PREFIX
+        && (config.key_type != HAM_TYPE_BINARY
+          || config.key_size != HAM_KEY_SIZE_UNLIMITED)) {
+    ham_trace(("prefix compression requires variable length binary keys"));
+    return (HAM_INV_PARAMETER);
+  }
+
+  if (config.key_compressor == HAM_COMPRESSOR_FOR
+        && config.key_type != HAM_TYPE_UINT32
+        && config.key_type != HAM_TYPE_UINT64) {
+    ham_trace(("frame-of-reference compression requires keys of type "
+               "HAM_TYPE_UINT32 or HAM_TYPE_UINT64"));
+    return (HAM_INV_PARAMETER);
+  }
+
+  if (config.inline_record_threshold > 0) {
+    if (config.inline_record_threshold
+          > LocalDatabase::kMaxInlineRecordThreshold) {
+      ham_trace(("inline record threshold too large; must be <= %d",
+                 (int)LocalDatabase::kMaxInlineRecordThreshold));
+      return (HAM_INV_PARAMETER);
+    }
+    if (m_config.page_size_bytes / (config.inline_record_threshold + 8)
+          < 10) {
+      ham_trace(("inline record threshold too large; either increase "
+                 "page_size or decrease the threshold"));
+      return (HAM_INV_PARAMETER);
+    }
+  }
+
   uint32_t mask = HAM_FORCE_RECORDS_INLINE
                     | HAM_FLUSH_WHEN_COMMITTED
                     | HAM_ENABLE_DUPLICATE_KEYS
@@ -520,11 +620,17 @@ LocalEnvironment::do_open_db(Database **pdb, DatabaseConfiguration &config,
     for (; param->name; param++) {
       switch (param->name) {
         case HAM_PARAM_RECORD_COMPRESSION:
-          ham_trace(("Record compression is only available in hamsterdb pro"));
-          return (HAM_NOT_IMPLEMENTED);
+          ham_trace(("Record compression can only be set when the database "
+                     "is created"));
+          return (HAM_INV_PARAMETER);
         case HAM_PARAM_KEY_COMPRESSION:
-          ham_trace(("Key compression is only available in hamsterdb pro"));
-          return (HAM_NOT_IMPLEMENTED);
+          ham_trace(("Key compression can only be set when the database "
+                     "is created"));
+          return (HAM_INV_PARAMETER);
+        case HAM_PARAM_INLINE_RECORD_THRESHOLD:
+          ham_trace(("The inline record threshold can only be set when the "
+                     "database is created"));
+          return (HAM_INV_PARAMETER);
         default:
           ham_trace(("invalid parameter 0x%x (%d)", param->name, param->name));
           return (HAM_INV_PARAMETER);
@@ -677,9 +783,25 @@ LocalEnvironment::do_txn_begin(const char *name, uint32_t flags)
 ham_status_t
 LocalEnvironment::do_txn_commit(Transaction *txn, uint32_t flags)
 {
+  ScopedLatency latency(&m_latencies.commit);
   return (m_txn_manager->commit(txn, flags));
 }
 
+void
+LocalEnvironment::do_wait_for_commit(ScopedLock &lock)
+{
+  if (!m_journal)
+    return;
+
+  uint64_t ticket = m_journal->take_commit_ticket();
+  if (ticket) {
+    // release the lock; other threads can then commit their Transactions
+    // and join the group
+    lock.unlock();
+    m_journal->wait_for_commit(ticket);
+  }
+}
+
 ham_status_t
 LocalEnvironment::do_txn_abort(Transaction *txn, uint32_t flags)
 {
@@ -742,6 +864,13 @@ LocalEnvironment::do_fill_metrics(ham_env_metrics_t *metrics) const
   // the Journal (if available)
   if (m_journal)
     m_journal->fill_metrics(metrics);
+  // the last checkpoint
+  metrics->checkpoint_lsn = m_lsn_manager.checkpoint();
+  // the latencies of the database operations
+  m_latencies.find.fill_metrics(&metrics->latency_find);
+  m_latencies.insert.fill_metrics(&metrics->latency_insert);
+  m_latencies.erase.fill_metrics(&metrics->latency_erase);
+  m_latencies.commit.fill_metrics(&metrics->latency_commit);
   // the (first) database
   if (!m_database_map.empty()) {
     LocalDatabase *db = (LocalDatabase *)m_database_map.begin()->second;
@@ -750,7 +879,8 @@ LocalEnvironment::do_fill_metrics(ham_env_metrics_t *metrics) const
   // and of the btrees
   BtreeIndex::fill_metrics(metrics);
   // SIMD support enabled?
-  metrics->simd_lane_width = os_get_simd_lane_width();
+  metrics->simd_lane_width = SimdSearch::lane_width(
+                  SimdSearch::select_isa(m_config.simd_search));
 }
 
 void
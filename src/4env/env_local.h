@@ -27,6 +27,7 @@
 #include "0root/root.h"
 
 // Always verify that a file of level N does not include headers > N!
+#include "1base/latency_histogram.h"
 #include "1base/scoped_ptr.h"
 #include "2lsn_manager/lsn_manager.h"
 #include "3journal/journal.h"
@@ -49,6 +50,15 @@ class BlobManager;
 class LocalTransaction;
 struct MessageBase;
 
+// The latencies of the database operations (for ham_env_get_metrics)
+struct OperationLatencies
+{
+  LatencyHistogram find;
+  LatencyHistogram insert;
+  LatencyHistogram erase;
+  LatencyHistogram commit;
+};
+
 //
 // The Environment implementation for local file access
 //
@@ -92,6 +102,11 @@ class LocalEnvironment : public Environment
       return (m_txn_manager.get());
     }
 
+    // Returns the latency histograms of the database operations
+    OperationLatencies *latencies() {
+      return (&m_latencies);
+    }
+
     // Increments the lsn and returns the incremented value
     uint64_t next_lsn() {
       return (m_lsn_manager.next());
@@ -140,6 +155,9 @@ class LocalEnvironment : public Environment
     // Commits a transaction (ham_txn_commit)
     virtual ham_status_t do_txn_commit(Transaction *txn, uint32_t flags);
 
+    // Waits till the commit is durable if group commit is enabled
+    virtual void do_wait_for_commit(ScopedLock &lock);
+
     // Commits a transaction (ham_txn_abort)
     virtual ham_status_t do_txn_abort(Transaction *txn, uint32_t flags);
 
@@ -185,6 +203,9 @@ class LocalEnvironment : public Environment
 
     // The lsn manager
     LsnManager m_lsn_manager;
+
+    // The latencies of the database operations
+    OperationLatencies m_latencies;
 };
 
 } // namespace hamsterdb
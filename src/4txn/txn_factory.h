@@ -29,7 +29,7 @@
 #include "ham/types.h"
 
 // Always verify that a file of level N does not include headers > N!
-#include "1mem/mem.h"
+#include "1mem/arena.h"
 #include "4txn/txn.h"
 
 #ifndef HAM_ROOT_H
@@ -45,14 +45,15 @@ struct TransactionFactory
             TransactionNode *node, uint32_t flags, uint32_t orig_flags,
             uint64_t lsn, ham_key_t *key, ham_record_t *record) {
     TransactionOperation *op;
-    op = Memory::allocate<TransactionOperation>(sizeof(*op)
+    op = (TransactionOperation *)txn->get_arena()->allocate(sizeof(*op)
                                             + (record ? record->size : 0)
                                             + (key ? key->size : 0));
     op->initialize(txn, node, flags, orig_flags, lsn, key, record);
     return (op);
   }
 
-  // Destroys a TransactionOperation
+  // Destroys a TransactionOperation; its memory is released when the
+  // Transaction's Arena is released
   static void destroy_operation(TransactionOperation *op) {
     op->destroy();
   }
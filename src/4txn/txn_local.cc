@@ -126,10 +126,9 @@ TransactionOperation::destroy()
   if (prev)
     prev->set_next_in_txn(next);
 
+  // the memory of this operation is released by the Transaction's Arena
   if (delete_node)
-    delete node;
-
-  Memory::release(this);
+    node->get_db()->txn_index()->destroy_node(node);
 }
 
 TransactionNode *
@@ -199,6 +198,19 @@ TransactionNode::append(LocalTransaction *txn, uint32_t orig_flags,
   return (op);
 }
 
+TransactionNode *
+TransactionIndex::create_node(ham_key_t *key)
+{
+  return (new (m_node_pool.allocate()) TransactionNode(m_db, key));
+}
+
+void
+TransactionIndex::destroy_node(TransactionNode *node)
+{
+  node->~TransactionNode();
+  m_node_pool.release(node);
+}
+
 void
 TransactionIndex::store(TransactionNode *node)
 {
@@ -216,7 +228,9 @@ LocalTransactionManager::LocalTransactionManager(Environment *env)
     m_queued_ops_for_flush(0), m_queued_bytes_for_flush(0),
     m_txn_threshold(kFlushTxnThreshold),
     m_ops_threshold(kFlushOperationsThreshold),
-    m_bytes_threshold(kFlushBytesThreshold)
+    m_bytes_threshold(kFlushBytesThreshold),
+    m_last_checkpoint(boost::posix_time::microsec_clock::universal_time()),
+    m_arena_pool(kArenaChunkSize, kMaxFreeArenaChunks)
 {
   if (m_env->get_flags() & HAM_FLUSH_WHEN_COMMITTED) {
     m_txn_threshold = 0;
@@ -228,7 +242,8 @@ LocalTransactionManager::LocalTransactionManager(Environment *env)
 LocalTransaction::LocalTransaction(LocalEnvironment *env, const char *name,
         uint32_t flags)
   : Transaction(env, name, flags), m_log_desc(0), m_oldest_op(0),
-    m_newest_op(0), m_op_counter(0), m_accum_data_size(0)
+    m_newest_op(0), m_op_counter(0), m_accum_data_size(0),
+    m_arena(((LocalTransactionManager *)env->txn_manager())->get_arena_pool())
 {
   LocalTransactionManager *ltm = 
         (LocalTransactionManager *)env->txn_manager();
@@ -292,10 +307,13 @@ LocalTransaction::free_operations()
 
   set_oldest_op(0);
   set_newest_op(0);
+
+  // now release the memory of all operations at once
+  m_arena.release();
 }
 
 TransactionIndex::TransactionIndex(LocalDatabase *db)
-  : m_db(db)
+  : m_db(db), m_node_pool(sizeof(TransactionNode), kMaxFreeNodes)
 {
   rbt_new(this);
 }
@@ -306,7 +324,7 @@ TransactionIndex::~TransactionIndex()
 
   while ((node = rbt_last(this))) {
     remove(node);
-    delete node;
+    destroy_node(node);
   }
 
   // re-initialize the tree
@@ -550,10 +568,37 @@ LocalTransactionManager::maybe_flush_committed_txns(Context *context)
 {
   if (m_queued_txn_for_flush > m_txn_threshold
       || m_queued_ops_for_flush > m_ops_threshold
-      || m_queued_bytes_for_flush > m_bytes_threshold)
+      || m_queued_bytes_for_flush > m_bytes_threshold
+      || is_checkpoint_due())
     flush_committed_txns_impl(context);
 }
 
+bool
+LocalTransactionManager::is_checkpoint_due() const
+{
+  uint32_t age_limit = m_env->config().checkpoint_age_limit;
+  if (age_limit == 0 || !(m_env->get_flags() & HAM_ENABLE_RECOVERY))
+    return (false);
+
+  boost::posix_time::time_duration age
+          = boost::posix_time::microsec_clock::universal_time()
+                - m_last_checkpoint;
+  return (age.total_milliseconds() >= age_limit);
+}
+
+void
+LocalTransactionManager::maybe_checkpoint()
+{
+  // the checkpoint is only valid if all Transactions were flushed
+  if (get_oldest_txn() != 0 || !is_checkpoint_due())
+    return;
+
+  uint64_t lsn = lenv()->next_lsn();
+  lenv()->journal()->append_checkpoint(lsn);
+  lenv()->lsn_manager()->set_checkpoint(lsn);
+  m_last_checkpoint = boost::posix_time::microsec_clock::universal_time();
+}
+
 void 
 LocalTransactionManager::flush_committed_txns(Context *context /* = 0 */)
 {
@@ -616,6 +661,9 @@ LocalTransactionManager::flush_committed_txns_impl(Context *context)
     context->changeset.clear();
 
   ham_assert(context->changeset.is_empty());
+
+  if (journal)
+    maybe_checkpoint();
 }
 
 uint64_t
@@ -25,6 +25,10 @@
 #include "0root/root.h"
 
 // Always verify that a file of level N does not include headers > N!
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "1mem/arena.h"
+#include "1mem/memory_pool.h"
 #include "1rb/rb.h"
 #include "4txn/txn.h"
 
@@ -331,6 +335,12 @@ class TransactionNode
 //
 class TransactionIndex
 {
+  enum {
+    // the maximum number of released TransactionNodes which are cached
+    // for recycling
+    kMaxFreeNodes = 1024
+  };
+
   public:
     // Traverses a TransactionIndex; for each node, a callback is executed
     struct Visitor {
@@ -343,6 +353,14 @@ class TransactionIndex
     // Destructor; frees all nodes and their operations
     ~TransactionIndex();
 
+    // Creates a new TransactionNode; the memory is taken from a pool.
+    // The node is not yet stored in the index.
+    TransactionNode *create_node(ham_key_t *key);
+
+    // Destroys a TransactionNode which was created with |create_node|;
+    // the node has to be removed from the index first
+    void destroy_node(TransactionNode *node);
+
     // Stores a new TransactionNode in the index
     void store(TransactionNode *node);
 
@@ -372,6 +390,9 @@ class TransactionIndex
     // the Database for all operations in this tree
     LocalDatabase *m_db;
 
+    // recycles the memory of the TransactionNodes
+    MemoryPool m_node_pool;
+
     // stuff for rb.h
     TransactionNode *rbt_root;
     TransactionNode rbt_nil;
@@ -435,6 +456,11 @@ class LocalTransaction : public Transaction
       return (m_accum_data_size);
     }
 
+    // Returns the Arena for the TransactionOperations
+    Arena *get_arena() {
+      return (&m_arena);
+    }
+
   private:
     friend class Journal;
     friend struct TxnFixture;
@@ -470,6 +496,10 @@ class LocalTransaction : public Transaction
     // The approximate accumulated memory consumed by this Transaction
     // (sums up key->size and record->size over all operations)
     int m_accum_data_size;
+
+    // The memory of the TransactionOperations; released at once when the
+    // operations are freed
+    Arena m_arena;
 };
 
 
@@ -486,7 +516,14 @@ class LocalTransactionManager : public TransactionManager
       kFlushOperationsThreshold = kFlushTxnThreshold * 20,
 
       // flush if this limit is exceeded
-      kFlushBytesThreshold = 1024 * 1024 // 1 mb - same as journal buffer
+      kFlushBytesThreshold = 1024 * 1024, // 1 mb - same as journal buffer
+
+      // the size of the Arena chunks of the Transactions
+      kArenaChunkSize = 4 * 1024,
+
+      // the maximum number of released Arena chunks which are cached
+      // for recycling (same as kFlushBytesThreshold)
+      kMaxFreeArenaChunks = kFlushBytesThreshold / kArenaChunkSize
     };
 
   public:
@@ -512,6 +549,11 @@ class LocalTransactionManager : public TransactionManager
       return (++m_txn_id);
     }
 
+    // Returns the pool for the Arena chunks of the Transactions
+    MemoryPool *get_arena_pool() {
+      return (&m_arena_pool);
+    }
+
     // Returns the current transaction ID; only for testing!
     uint64_t test_get_txn_id() const {
       return (m_txn_id);
@@ -539,6 +581,14 @@ class LocalTransactionManager : public TransactionManager
     // transactions waiting to be flushed, or if other conditions apply
     void maybe_flush_committed_txns(Context *context);
 
+    // Returns true if the checkpoint age limit expired
+    // (HAM_PARAM_CHECKPOINT_AGE_LIMIT)
+    bool is_checkpoint_due() const;
+
+    // Appends a checkpoint to the journal if the age limit expired and
+    // all Transactions were flushed
+    void maybe_checkpoint();
+
     // The current transaction ID
     uint64_t m_txn_id;
 
@@ -559,6 +609,12 @@ class LocalTransactionManager : public TransactionManager
 
     // Threshold for transactio queue
     int m_bytes_threshold;
+
+    // The time of the last checkpoint
+    boost::posix_time::ptime m_last_checkpoint;
+
+    // Recycles the Arena chunks of flushed Transactions
+    MemoryPool m_arena_pool;
 };
 
 } // namespace hamsterdb
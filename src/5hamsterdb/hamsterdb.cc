@@ -25,6 +25,7 @@
 #include "1base/error.h"
 #include "1base/dynamic_array.h"
 #include "1mem/mem.h"
+#include "2compressor/compressor_factory.h"
 #include "2config/db_config.h"
 #include "2config/env_config.h"
 #include "2page/page.h"
@@ -290,11 +291,6 @@ ham_env_create(ham_env_t **henv, const char *filename,
     return (HAM_INV_PARAMETER);
   }
 
-  if (flags & HAM_ENABLE_CRC32) {
-    ham_trace(("Crc32 is only available in hamsterdb pro"));
-    return (HAM_NOT_IMPLEMENTED);
-  }
-
   /* HAM_ENABLE_TRANSACTIONS implies HAM_ENABLE_RECOVERY, unless explicitly
    * disabled */
   if ((flags & HAM_ENABLE_TRANSACTIONS) && !(flags & HAM_DISABLE_RECOVERY))
@@ -312,8 +308,14 @@ ham_env_create(ham_env_t **henv, const char *filename,
     for (; param->name; param++) {
       switch (param->name) {
       case HAM_PARAM_JOURNAL_COMPRESSION:
-        ham_trace(("Journal compression is only available in hamsterdb pro"));
-        return (HAM_NOT_IMPLEMENTED);
+        if (param->value != HAM_COMPRESSOR_NONE
+              && !CompressorFactory::is_available((int)param->value)) {
+          ham_trace(("Journal compression %u is not available",
+                     (unsigned)param->value));
+          return (HAM_NOT_IMPLEMENTED);
+        }
+        config.journal_compressor = (int)param->value;
+        break;
       case HAM_PARAM_CACHE_SIZE:
         if (flags & HAM_IN_MEMORY && param->value != 0) {
           ham_trace(("combination of HAM_IN_MEMORY and cache size != 0 "
@@ -356,6 +358,80 @@ ham_env_create(ham_env_t **henv, const char *filename,
       case HAM_PARAM_POSIX_FADVISE:
         config.posix_advice = (int)param->value;
         break;
+      case HAM_PARAM_CACHE_POLICY:
+        if (param->value != HAM_CACHE_POLICY_LRU
+            && param->value != HAM_CACHE_POLICY_2Q) {
+          ham_trace(("invalid cache policy %d", (int)param->value));
+          return (HAM_INV_PARAMETER);
+        }
+        config.cache_policy = (int)param->value;
+        break;
+      case HAM_PARAM_READAHEAD_PAGES:
+        if (param->value > 1024) {
+          ham_trace(("read-ahead must not exceed 1024 pages"));
+          return (HAM_INV_PARAMETER);
+        }
+        config.readahead_pages = (size_t)param->value;
+        break;
+      case HAM_PARAM_JOURNAL_COMMIT_WINDOW:
+        if (param->value > 1000000) {
+          ham_trace(("commit window must not exceed 1 second"));
+          return (HAM_INV_PARAMETER);
+        }
+        config.journal_commit_window = (uint32_t)param->value;
+        break;
+      case HAM_PARAM_SIMD_SEARCH:
+        if (param->value > HAM_SIMD_AVX2) {
+          ham_trace(("invalid value for HAM_PARAM_SIMD_SEARCH"));
+          return (HAM_INV_PARAMETER);
+        }
+        config.simd_search = (int)param->value;
+        break;
+      case HAM_PARAM_LINEAR_SEARCH_THRESHOLD:
+        config.linear_search_threshold = (size_t)param->value;
+        break;
+      case HAM_PARAM_IO_BACKEND:
+        if (param->value > HAM_IO_BACKEND_URING_DIRECT) {
+          ham_trace(("invalid value for HAM_PARAM_IO_BACKEND"));
+          return (HAM_INV_PARAMETER);
+        }
+        config.io_backend = (int)param->value;
+        break;
+      case HAM_PARAM_FLUSH_WORKERS:
+        if (param->value < 1 || param->value > HAM_MAX_FLUSH_WORKERS) {
+          ham_trace(("invalid value for HAM_PARAM_FLUSH_WORKERS"));
+          return (HAM_INV_PARAMETER);
+        }
+        config.flush_workers = (int)param->value;
+        break;
+      case HAM_PARAM_FLUSH_STALL_PERCENT:
+        if (param->value > 100) {
+          ham_trace(("invalid value for HAM_PARAM_FLUSH_STALL_PERCENT"));
+          return (HAM_INV_PARAMETER);
+        }
+        config.flush_stall_percent = (int)param->value;
+        break;
+      case HAM_PARAM_CHECKPOINT_DIRTY_PERCENT:
+        if (param->value > 100) {
+          ham_trace(("invalid value for HAM_PARAM_CHECKPOINT_DIRTY_PERCENT"));
+          return (HAM_INV_PARAMETER);
+        }
+        config.checkpoint_dirty_percent = (int)param->value;
+        break;
+      case HAM_PARAM_CHECKPOINT_AGE_LIMIT:
+        if (param->value > 3600 * 1000) {
+          ham_trace(("checkpoint age limit must not exceed 1 hour"));
+          return (HAM_INV_PARAMETER);
+        }
+        config.checkpoint_age_limit = (uint32_t)param->value;
+        break;
+      case HAM_PARAM_MMAP_RESERVE:
+        if (param->value > std::numeric_limits<size_t>::max()) {
+          ham_trace(("invalid value for HAM_PARAM_MMAP_RESERVE"));
+          return (HAM_INV_PARAMETER);
+        }
+        config.mmap_reserve_bytes = param->value;
+        break;
       default:
         ham_trace(("unknown parameter %d", (int)param->name));
         return (HAM_INV_PARAMETER);
@@ -509,11 +585,6 @@ ham_env_open(ham_env_t **henv, const char *filename, uint32_t flags,
     return (HAM_INV_PARAMETER);
   }
 
-  if (flags & HAM_ENABLE_CRC32) {
-    ham_trace(("Crc32 is only available in hamsterdb pro"));
-    return (HAM_NOT_IMPLEMENTED);
-  }
-
   /* HAM_ENABLE_TRANSACTIONS implies HAM_ENABLE_RECOVERY, unless explicitly
    * disabled */
   if ((flags & HAM_ENABLE_TRANSACTIONS) && !(flags & HAM_DISABLE_RECOVERY))
@@ -532,8 +603,14 @@ ham_env_open(ham_env_t **henv, const char *filename, uint32_t flags,
     for (; param->name; param++) {
       switch (param->name) {
       case HAM_PARAM_JOURNAL_COMPRESSION:
-        ham_trace(("Journal compression is only available in hamsterdb pro"));
-        return (HAM_NOT_IMPLEMENTED);
+        if (param->value != HAM_COMPRESSOR_NONE
+              && !CompressorFactory::is_available((int)param->value)) {
+          ham_trace(("Journal compression %u is not available",
+                     (unsigned)param->value));
+          return (HAM_NOT_IMPLEMENTED);
+        }
+        config.journal_compressor = (int)param->value;
+        break;
       case HAM_PARAM_CACHE_SIZE:
         /* don't allow cache limits with unlimited cache */
         if (flags & HAM_CACHE_UNLIMITED && param->value != 0) {
@@ -563,6 +640,80 @@ ham_env_open(ham_env_t **henv, const char *filename, uint32_t flags,
       case HAM_PARAM_POSIX_FADVISE:
         config.posix_advice = (int)param->value;
         break;
+      case HAM_PARAM_CACHE_POLICY:
+        if (param->value != HAM_CACHE_POLICY_LRU
+            && param->value != HAM_CACHE_POLICY_2Q) {
+          ham_trace(("invalid cache policy %d", (int)param->value));
+          return (HAM_INV_PARAMETER);
+        }
+        config.cache_policy = (int)param->value;
+        break;
+      case HAM_PARAM_READAHEAD_PAGES:
+        if (param->value > 1024) {
+          ham_trace(("read-ahead must not exceed 1024 pages"));
+          return (HAM_INV_PARAMETER);
+        }
+        config.readahead_pages = (size_t)param->value;
+        break;
+      case HAM_PARAM_JOURNAL_COMMIT_WINDOW:
+        if (param->value > 1000000) {
+          ham_trace(("commit window must not exceed 1 second"));
+          return (HAM_INV_PARAMETER);
+        }
+        config.journal_commit_window = (uint32_t)param->value;
+        break;
+      case HAM_PARAM_SIMD_SEARCH:
+        if (param->value > HAM_SIMD_AVX2) {
+          ham_trace(("invalid value for HAM_PARAM_SIMD_SEARCH"));
+          return (HAM_INV_PARAMETER);
+        }
+        config.simd_search = (int)param->value;
+        break;
+      case HAM_PARAM_LINEAR_SEARCH_THRESHOLD:
+        config.linear_search_threshold = (size_t)param->value;
+        break;
+      case HAM_PARAM_IO_BACKEND:
+        if (param->value > HAM_IO_BACKEND_URING_DIRECT) {
+          ham_trace(("invalid value for HAM_PARAM_IO_BACKEND"));
+          return (HAM_INV_PARAMETER);
+        }
+        config.io_backend = (int)param->value;
+        break;
+      case HAM_PARAM_FLUSH_WORKERS:
+        if (param->value < 1 || param->value > HAM_MAX_FLUSH_WORKERS) {
+          ham_trace(("invalid value for HAM_PARAM_FLUSH_WORKERS"));
+          return (HAM_INV_PARAMETER);
+        }
+        config.flush_workers = (int)param->value;
+        break;
+      case HAM_PARAM_FLUSH_STALL_PERCENT:
+        if (param->value > 100) {
+          ham_trace(("invalid value for HAM_PARAM_FLUSH_STALL_PERCENT"));
+          return (HAM_INV_PARAMETER);
+        }
+        config.flush_stall_percent = (int)param->value;
+        break;
+      case HAM_PARAM_CHECKPOINT_DIRTY_PERCENT:
+        if (param->value > 100) {
+          ham_trace(("invalid value for HAM_PARAM_CHECKPOINT_DIRTY_PERCENT"));
+          return (HAM_INV_PARAMETER);
+        }
+        config.checkpoint_dirty_percent = (int)param->value;
+        break;
+      case HAM_PARAM_CHECKPOINT_AGE_LIMIT:
+        if (param->value > 3600 * 1000) {
+          ham_trace(("checkpoint age limit must not exceed 1 hour"));
+          return (HAM_INV_PARAMETER);
+        }
+        config.checkpoint_age_limit = (uint32_t)param->value;
+        break;
+      case HAM_PARAM_MMAP_RESERVE:
+        if (param->value > std::numeric_limits<size_t>::max()) {
+          ham_trace(("invalid value for HAM_PARAM_MMAP_RESERVE"));
+          return (HAM_INV_PARAMETER);
+        }
+        config.mmap_reserve_bytes = param->value;
+        break;
       default:
         ham_trace(("unknown parameter %d", (int)param->name));
         return (HAM_INV_PARAMETER);
@@ -1540,6 +1691,40 @@ ham_db_get_key_count(ham_db_t *hdb, ham_txn_t *htxn, uint32_t flags,
                   keycount)));
 }
 
+HAM_EXPORT ham_status_t HAM_CALLCONV
+ham_db_bulk_load(ham_db_t *hdb, ham_bulk_load_func_t func, void *context,
+                uint32_t fill_factor, uint32_t flags)
+{
+  Database *db = (Database *)hdb;
+
+  if (!db) {
+    ham_trace(("parameter 'db' must not be NULL"));
+    return (HAM_INV_PARAMETER);
+  }
+  if (!func) {
+    ham_trace(("parameter 'func' must not be NULL"));
+    return (db->set_error(HAM_INV_PARAMETER));
+  }
+  if (fill_factor > 100) {
+    ham_trace(("parameter 'fill_factor' must be <= 100"));
+    return (db->set_error(HAM_INV_PARAMETER));
+  }
+  if (flags) {
+    ham_trace(("parameter 'flags' contains unsupported flag bits: %08x",
+          flags));
+    return (db->set_error(HAM_INV_PARAMETER));
+  }
+  if (db->get_flags() & HAM_READ_ONLY) {
+    ham_trace(("cannot insert in a read-only database"));
+    return (db->set_error(HAM_WRITE_PROTECTED));
+  }
+
+  ScopedLock lock(db->get_env()->mutex());
+
+  return (db->set_error(db->bulk_load(func, context,
+                  fill_factor ? fill_factor : 100)));
+}
+
 void HAM_CALLCONV
 ham_set_errhandler(ham_errhandler_fun f)
 {
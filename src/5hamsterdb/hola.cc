@@ -16,10 +16,13 @@
 
 #include "0root/root.h"
 
+#include <algorithm>
+
 #include "ham/hamsterdb_ola.h"
 
 // Always verify that a file of level N does not include headers > N!
 #include "1base/error.h"
+#include "1base/mutex.h"
 #include "3btree/btree_visitor.h"
 #include "4db/db.h"
 #include "4db/db_local.h"
@@ -30,8 +33,9 @@
 
 using namespace hamsterdb;
 
-ham_status_t HAM_CALLCONV
-hola_count(ham_db_t *hdb, ham_txn_t *htxn, hola_result_t *result)
+static ham_status_t
+count_impl(ham_db_t *hdb, ham_txn_t *htxn, hola_result_t *result,
+                uint32_t threads)
 {
   if (!hdb) {
     ham_trace(("parameter 'db' must not be NULL"));
@@ -49,6 +53,10 @@ hola_count(ham_db_t *hdb, ham_txn_t *htxn, hola_result_t *result)
   result->u.result_u64 = 0;
 
   ScopedLock lock(db->get_env()->mutex());
+  LocalDatabase *ldb = dynamic_cast<LocalDatabase *>(db);
+  if (ldb)
+    return (db->set_error(ldb->count(txn, false, &result->u.result_u64,
+                                    threads)));
   return (db->set_error(db->count(txn, false, &result->u.result_u64)));
 }
 
@@ -83,6 +91,17 @@ struct CountIfScanVisitor : public ScanVisitor {
     memcpy(&result->u.result_u64, &m_count, sizeof(uint64_t));
   }
 
+  // Returns a new visitor with an empty result
+  virtual ScanVisitor *clone() const {
+    return (new CountIfScanVisitor(m_pred));
+  }
+
+  // Adds the partial result of |other|
+  virtual void merge(const ScanVisitor *other) {
+    const CountIfScanVisitor *o = (const CountIfScanVisitor *)other;
+    m_count += o->m_count;
+  }
+
   // The counter
   uint64_t m_count;
 
@@ -121,6 +140,17 @@ struct CountIfScanVisitorBinary : public ScanVisitor {
     memcpy(&result->u.result_u64, &m_count, sizeof(uint64_t));
   }
 
+  // Returns a new visitor with an empty result
+  virtual ScanVisitor *clone() const {
+    return (new CountIfScanVisitorBinary(m_key_size, m_pred));
+  }
+
+  // Adds the partial result of |other|
+  virtual void merge(const ScanVisitor *other) {
+    const CountIfScanVisitorBinary *o = (const CountIfScanVisitorBinary *)other;
+    m_count += o->m_count;
+  }
+
   // The counter
   uint64_t m_count;
 
@@ -131,9 +161,9 @@ struct CountIfScanVisitorBinary : public ScanVisitor {
   hola_bool_predicate_t *m_pred;
 };
 
-ham_status_t HAM_CALLCONV
-hola_count_if(ham_db_t *hdb, ham_txn_t *txn, hola_bool_predicate_t *pred,
-                hola_result_t *result)
+static ham_status_t
+count_if_impl(ham_db_t *hdb, ham_txn_t *txn, hola_bool_predicate_t *pred,
+                hola_result_t *result, uint32_t threads)
 {
   if (!hdb) {
     ham_trace(("parameter 'db' must not be NULL"));
@@ -188,14 +218,16 @@ hola_count_if(ham_db_t *hdb, ham_txn_t *txn, hola_bool_predicate_t *pred,
   }
 
   ScopedLock lock(db->get_env()->mutex());
-  ham_status_t st = db->scan((Transaction *)txn, visitor.get(), false);
+  ham_status_t st = db->scan((Transaction *)txn, visitor.get(), false,
+                          threads);
   if (st == 0)
     visitor->assign_result(result);
   return (db->set_error(st));
 }
 
-ham_status_t HAM_CALLCONV
-hola_count_distinct(ham_db_t *hdb, ham_txn_t *htxn, hola_result_t *result)
+static ham_status_t
+count_distinct_impl(ham_db_t *hdb, ham_txn_t *htxn, hola_result_t *result,
+                uint32_t threads)
 {
   if (!hdb) {
     ham_trace(("parameter 'db' must not be NULL"));
@@ -213,12 +245,17 @@ hola_count_distinct(ham_db_t *hdb, ham_txn_t *htxn, hola_result_t *result)
   result->u.result_u64 = 0;
 
   ScopedLock lock(db->get_env()->mutex());
+  LocalDatabase *ldb = dynamic_cast<LocalDatabase *>(db);
+  if (ldb)
+    return (db->set_error(ldb->count(txn, true, &result->u.result_u64,
+                                    threads)));
   return (db->set_error(db->count(txn, true, &result->u.result_u64)));
 }
 
-ham_status_t HAM_CALLCONV
-hola_count_distinct_if(ham_db_t *hdb, ham_txn_t *txn,
-                hola_bool_predicate_t *pred, hola_result_t *result)
+static ham_status_t
+count_distinct_if_impl(ham_db_t *hdb, ham_txn_t *txn,
+                hola_bool_predicate_t *pred, hola_result_t *result,
+                uint32_t threads)
 {
   if (!hdb) {
     ham_trace(("parameter 'db' must not be NULL"));
@@ -273,7 +310,8 @@ hola_count_distinct_if(ham_db_t *hdb, ham_txn_t *txn,
   }
 
   ScopedLock lock(db->get_env()->mutex());
-  ham_status_t st = db->scan((Transaction *)txn, visitor.get(), true);
+  ham_status_t st = db->scan((Transaction *)txn, visitor.get(), true,
+                          threads);
   if (st == 0)
     visitor->assign_result(result);
   return (db->set_error(st));
@@ -312,6 +350,18 @@ struct AverageScanVisitor : public ScanVisitor {
     memcpy(&result->u.result_u64, &res, sizeof(uint64_t));
   }
 
+  // Returns a new visitor with an empty result
+  virtual ScanVisitor *clone() const {
+    return (new AverageScanVisitor());
+  }
+
+  // Adds the partial result of |other|
+  virtual void merge(const ScanVisitor *other) {
+    const AverageScanVisitor *o = (const AverageScanVisitor *)other;
+    m_sum += o->m_sum;
+    m_count += o->m_count;
+  }
+
   // The sum of all keys
   ResultType m_sum;
 
@@ -319,8 +369,9 @@ struct AverageScanVisitor : public ScanVisitor {
   uint64_t m_count;
 };
 
-ham_status_t HAM_CALLCONV
-hola_average(ham_db_t *hdb, ham_txn_t *txn, hola_result_t *result)
+static ham_status_t
+average_impl(ham_db_t *hdb, ham_txn_t *txn, hola_result_t *result,
+                uint32_t threads)
 {
   if (!hdb) {
     ham_trace(("parameter 'db' must not be NULL"));
@@ -372,7 +423,8 @@ hola_average(ham_db_t *hdb, ham_txn_t *txn, hola_result_t *result)
   }
 
   ScopedLock lock(db->get_env()->mutex());
-  ham_status_t st = db->scan((Transaction *)txn, visitor.get(), false);
+  ham_status_t st = db->scan((Transaction *)txn, visitor.get(), false,
+                          threads);
   if (st == 0)
     visitor->assign_result(result);
   return (db->set_error(st));
@@ -416,6 +468,18 @@ struct AverageIfScanVisitor : public ScanVisitor {
     memcpy(&result->u.result_u64, &res, sizeof(uint64_t));
   }
 
+  // Returns a new visitor with an empty result
+  virtual ScanVisitor *clone() const {
+    return (new AverageIfScanVisitor(m_pred));
+  }
+
+  // Adds the partial result of |other|
+  virtual void merge(const ScanVisitor *other) {
+    const AverageIfScanVisitor *o = (const AverageIfScanVisitor *)other;
+    m_sum += o->m_sum;
+    m_count += o->m_count;
+  }
+
   // The sum of all keys
   ResultType m_sum;
 
@@ -426,9 +490,9 @@ struct AverageIfScanVisitor : public ScanVisitor {
   hola_bool_predicate_t *m_pred;
 };
 
-ham_status_t HAM_CALLCONV
-hola_average_if(ham_db_t *hdb, ham_txn_t *txn, hola_bool_predicate_t *pred,
-                hola_result_t *result)
+static ham_status_t
+average_if_impl(ham_db_t *hdb, ham_txn_t *txn, hola_bool_predicate_t *pred,
+                hola_result_t *result, uint32_t threads)
 {
   if (!hdb) {
     ham_trace(("parameter 'db' must not be NULL"));
@@ -484,7 +548,8 @@ hola_average_if(ham_db_t *hdb, ham_txn_t *txn, hola_bool_predicate_t *pred,
   }
 
   ScopedLock lock(db->get_env()->mutex());
-  ham_status_t st = db->scan((Transaction *)txn, visitor.get(), false);
+  ham_status_t st = db->scan((Transaction *)txn, visitor.get(), false,
+                          threads);
   if (st == 0)
     visitor->assign_result(result);
   return (db->set_error(st));
@@ -536,12 +601,24 @@ struct SumScanVisitor : public ScanVisitor {
     memcpy(&result->u.result_u64, &m_sum, sizeof(uint64_t));
   }
 
+  // Returns a new visitor with an empty result
+  virtual ScanVisitor *clone() const {
+    return (new SumScanVisitor());
+  }
+
+  // Adds the partial result of |other|
+  virtual void merge(const ScanVisitor *other) {
+    const SumScanVisitor *o = (const SumScanVisitor *)other;
+    m_sum += o->m_sum;
+  }
+
   // The sum of all keys
   ResultType m_sum;
 };
 
-ham_status_t HAM_CALLCONV
-hola_sum(ham_db_t *hdb, ham_txn_t *txn, hola_result_t *result)
+static ham_status_t
+sum_impl(ham_db_t *hdb, ham_txn_t *txn, hola_result_t *result,
+                uint32_t threads)
 {
   if (!hdb) {
     ham_trace(("parameter 'hdb' must not be NULL"));
@@ -593,7 +670,8 @@ hola_sum(ham_db_t *hdb, ham_txn_t *txn, hola_result_t *result)
   }
 
   ScopedLock lock(db->get_env()->mutex());
-  ham_status_t st = db->scan((Transaction *)txn, visitor.get(), false);
+  ham_status_t st = db->scan((Transaction *)txn, visitor.get(), false,
+                          threads);
   if (st == 0)
     visitor->assign_result(result);
   return (db->set_error(st));
@@ -632,6 +710,17 @@ struct SumIfScanVisitor : public ScanVisitor {
     memcpy(&result->u.result_u64, &m_sum, sizeof(uint64_t));
   }
 
+  // Returns a new visitor with an empty result
+  virtual ScanVisitor *clone() const {
+    return (new SumIfScanVisitor(m_pred));
+  }
+
+  // Adds the partial result of |other|
+  virtual void merge(const ScanVisitor *other) {
+    const SumIfScanVisitor *o = (const SumIfScanVisitor *)other;
+    m_sum += o->m_sum;
+  }
+
   // The sum of all keys
   ResultType m_sum;
 
@@ -639,9 +728,9 @@ struct SumIfScanVisitor : public ScanVisitor {
   hola_bool_predicate_t *m_pred;
 };
 
-ham_status_t HAM_CALLCONV
-hola_sum_if(ham_db_t *hdb, ham_txn_t *txn, hola_bool_predicate_t *pred,
-                hola_result_t *result)
+static ham_status_t
+sum_if_impl(ham_db_t *hdb, ham_txn_t *txn, hola_bool_predicate_t *pred,
+                hola_result_t *result, uint32_t threads)
 {
   if (!hdb) {
     ham_trace(("parameter 'db' must not be NULL"));
@@ -697,8 +786,92 @@ hola_sum_if(ham_db_t *hdb, ham_txn_t *txn, hola_bool_predicate_t *pred,
   }
 
   ScopedLock lock(db->get_env()->mutex());
-  ham_status_t st = db->scan((Transaction *)txn, visitor.get(), false);
+  ham_status_t st = db->scan((Transaction *)txn, visitor.get(), false,
+                          threads);
   if (st == 0)
     visitor->assign_result(result);
   return (db->set_error(st));
 }
+
+ham_status_t HAM_CALLCONV
+hola_count(ham_db_t *hdb, ham_txn_t *htxn, hola_result_t *result)
+{
+  return (count_impl(hdb, htxn, result, 1));
+}
+
+ham_status_t HAM_CALLCONV
+hola_count_if(ham_db_t *hdb, ham_txn_t *txn, hola_bool_predicate_t *pred,
+                hola_result_t *result)
+{
+  return (count_if_impl(hdb, txn, pred, result, 1));
+}
+
+ham_status_t HAM_CALLCONV
+hola_count_distinct(ham_db_t *hdb, ham_txn_t *htxn, hola_result_t *result)
+{
+  return (count_distinct_impl(hdb, htxn, result, 1));
+}
+
+ham_status_t HAM_CALLCONV
+hola_count_distinct_if(ham_db_t *hdb, ham_txn_t *txn,
+                hola_bool_predicate_t *pred, hola_result_t *result)
+{
+  return (count_distinct_if_impl(hdb, txn, pred, result, 1));
+}
+
+ham_status_t HAM_CALLCONV
+hola_average(ham_db_t *hdb, ham_txn_t *txn, hola_result_t *result)
+{
+  return (average_impl(hdb, txn, result, 1));
+}
+
+ham_status_t HAM_CALLCONV
+hola_average_if(ham_db_t *hdb, ham_txn_t *txn, hola_bool_predicate_t *pred,
+                hola_result_t *result)
+{
+  return (average_if_impl(hdb, txn, pred, result, 1));
+}
+
+ham_status_t HAM_CALLCONV
+hola_sum(ham_db_t *hdb, ham_txn_t *txn, hola_result_t *result)
+{
+  return (sum_impl(hdb, txn, result, 1));
+}
+
+ham_status_t HAM_CALLCONV
+hola_sum_if(ham_db_t *hdb, ham_txn_t *txn, hola_bool_predicate_t *pred,
+                hola_result_t *result)
+{
+  return (sum_if_impl(hdb, txn, pred, result, 1));
+}
+
+ham_status_t HAM_CALLCONV
+hola_aggregate(ham_db_t *hdb, ham_txn_t *txn, int function,
+                hola_bool_predicate_t *pred, uint32_t threads,
+                hola_result_t *result)
+{
+  if (threads == 0)
+    threads = std::max(1u, Thread::hardware_concurrency());
+
+  switch (function) {
+    case HOLA_COUNT:
+      return (count_impl(hdb, txn, result, threads));
+    case HOLA_COUNT_IF:
+      return (count_if_impl(hdb, txn, pred, result, threads));
+    case HOLA_COUNT_DISTINCT:
+      return (count_distinct_impl(hdb, txn, result, threads));
+    case HOLA_COUNT_DISTINCT_IF:
+      return (count_distinct_if_impl(hdb, txn, pred, result, threads));
+    case HOLA_AVERAGE:
+      return (average_impl(hdb, txn, result, threads));
+    case HOLA_AVERAGE_IF:
+      return (average_if_impl(hdb, txn, pred, result, threads));
+    case HOLA_SUM:
+      return (sum_impl(hdb, txn, result, threads));
+    case HOLA_SUM_IF:
+      return (sum_if_impl(hdb, txn, pred, result, threads));
+    default:
+      ham_trace(("unknown function %d", function));
+      return (HAM_INV_PARAMETER);
+  }
+}
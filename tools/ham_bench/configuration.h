@@ -90,7 +90,13 @@ struct Configuration
       flush_txn_immediately(false), disable_recovery(false),
       journal_compression(0), record_compression(0), key_compression(0),
       read_only(false), enable_crc32(false), record_number32(false),
-      record_number64(false), posix_fadvice(HAM_POSIX_FADVICE_NORMAL) {
+      record_number64(false), posix_fadvice(HAM_POSIX_FADVICE_NORMAL),
+      cache_policy(HAM_CACHE_POLICY_LRU), readahead(0),
+      journal_commit_window(0), linear_threshold(0),
+      simd_search(HAM_SIMD_AUTO), io_backend(HAM_IO_BACKEND_POSIX),
+      flush_workers(1), flush_stall_percent(50), checkpoint_dirty_percent(0),
+      checkpoint_age_limit(0), mmap_reserve(0),
+      inline_record_threshold(0) {
   }
 
   void print() const {
@@ -100,7 +106,8 @@ struct Configuration
       "snappy",
       "lzf",
       "lzo",
-      "bitmap"
+      "prefix",
+      "for"
     };
     std::cout << "Configuration: --seed=" << seed << " ";
     if (journal_compression)
@@ -186,6 +193,50 @@ struct Configuration
                               ? "random"
                               : "??unknown??")
               << " ";
+    if (cache_policy)
+      std::cout << "--cache-policy="
+              << (cache_policy == HAM_CACHE_POLICY_2Q
+                              ? "2q"
+                              : "??unknown??")
+              << " ";
+    if (readahead)
+      std::cout << "--readahead=" << readahead << " ";
+    if (journal_commit_window)
+      std::cout << "--journal-commit-window=" << journal_commit_window << " ";
+    if (linear_threshold)
+      std::cout << "--pax-linear-threshold=" << linear_threshold << " ";
+    if (simd_search)
+      std::cout << "--simd="
+              << (simd_search == HAM_SIMD_NONE
+                              ? "none"
+                              : simd_search == HAM_SIMD_SSE2
+                                  ? "sse2"
+                                  : simd_search == HAM_SIMD_AVX2
+                                      ? "avx2"
+                                      : "??unknown??")
+              << " ";
+    if (io_backend)
+      std::cout << "--io-backend="
+              << (io_backend == HAM_IO_BACKEND_URING
+                              ? "uring"
+                              : io_backend == HAM_IO_BACKEND_URING_DIRECT
+                                  ? "uring-direct"
+                                  : "??unknown??")
+              << " ";
+    if (flush_workers != 1)
+      std::cout << "--flush-workers=" << flush_workers << " ";
+    if (flush_stall_percent != 50)
+      std::cout << "--flush-stall-percent=" << flush_stall_percent << " ";
+    if (checkpoint_dirty_percent)
+      std::cout << "--checkpoint-dirty-percent=" << checkpoint_dirty_percent
+              << " ";
+    if (checkpoint_age_limit)
+      std::cout << "--checkpoint-age-limit=" << checkpoint_age_limit << " ";
+    if (mmap_reserve)
+      std::cout << "--mmap-reserve=" << mmap_reserve << " ";
+    if (inline_record_threshold)
+      std::cout << "--inline-record-threshold=" << inline_record_threshold
+              << " ";
     if (!filename.empty())
       std::cout << filename;
     else {
@@ -295,6 +346,18 @@ struct Configuration
   bool record_number32;
   bool record_number64;
   int posix_fadvice;
+  int cache_policy;
+  int readahead;
+  int journal_commit_window;
+  int linear_threshold;
+  int simd_search;
+  int io_backend;
+  int flush_workers;
+  int flush_stall_percent;
+  int checkpoint_dirty_percent;
+  int checkpoint_age_limit;
+  uint64_t mmap_reserve;
+  int inline_record_threshold;
 };
 
 #endif /* HAM_BENCH_CONFIGURATION_H */
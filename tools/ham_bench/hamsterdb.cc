@@ -71,7 +71,7 @@ HamsterDatabase::do_create_env()
 {
   ham_status_t st = 0;
   uint32_t flags = 0;
-  ham_parameter_t params[6] = {{0, 0}};
+  ham_parameter_t params[20] = {{0, 0}};
 
   ScopedLock lock(ms_mutex);
 
@@ -91,6 +91,41 @@ HamsterDatabase::do_create_env()
     params[p].name = HAM_PARAM_POSIX_FADVISE;
     params[p].value = m_config->posix_fadvice;
     p++;
+    params[p].name = HAM_PARAM_CACHE_POLICY;
+    params[p].value = m_config->cache_policy;
+    p++;
+    params[p].name = HAM_PARAM_READAHEAD_PAGES;
+    params[p].value = m_config->readahead;
+    p++;
+    params[p].name = HAM_PARAM_JOURNAL_COMMIT_WINDOW;
+    params[p].value = m_config->journal_commit_window;
+    p++;
+    params[p].name = HAM_PARAM_SIMD_SEARCH;
+    params[p].value = m_config->simd_search;
+    p++;
+    params[p].name = HAM_PARAM_LINEAR_SEARCH_THRESHOLD;
+    params[p].value = m_config->linear_threshold;
+    p++;
+    params[p].name = HAM_PARAM_IO_BACKEND;
+    params[p].value = m_config->io_backend;
+    p++;
+    params[p].name = HAM_PARAM_FLUSH_WORKERS;
+    params[p].value = m_config->flush_workers;
+    p++;
+    params[p].name = HAM_PARAM_FLUSH_STALL_PERCENT;
+    params[p].value = m_config->flush_stall_percent;
+    p++;
+    params[p].name = HAM_PARAM_CHECKPOINT_DIRTY_PERCENT;
+    params[p].value = m_config->checkpoint_dirty_percent;
+    p++;
+    params[p].name = HAM_PARAM_CHECKPOINT_AGE_LIMIT;
+    params[p].value = m_config->checkpoint_age_limit;
+    p++;
+    if (m_config->mmap_reserve) {
+      params[p].name = HAM_PARAM_MMAP_RESERVE;
+      params[p].value = m_config->mmap_reserve;
+      p++;
+    }
     if (m_config->use_encryption) {
       params[p].name = HAM_PARAM_ENCRYPTION_KEY;
       params[p].value = (uint64_t)"1234567890123456";
@@ -155,7 +190,7 @@ HamsterDatabase::do_open_env()
 {
   ham_status_t st = 0;
   uint32_t flags = 0;
-  ham_parameter_t params[6] = {{0, 0}};
+  ham_parameter_t params[20] = {{0, 0}};
 
   ScopedLock lock(ms_mutex);
 
@@ -173,6 +208,41 @@ HamsterDatabase::do_open_env()
     params[p].name = HAM_PARAM_POSIX_FADVISE;
     params[p].value = m_config->posix_fadvice;
     p++;
+    params[p].name = HAM_PARAM_CACHE_POLICY;
+    params[p].value = m_config->cache_policy;
+    p++;
+    params[p].name = HAM_PARAM_READAHEAD_PAGES;
+    params[p].value = m_config->readahead;
+    p++;
+    params[p].name = HAM_PARAM_JOURNAL_COMMIT_WINDOW;
+    params[p].value = m_config->journal_commit_window;
+    p++;
+    params[p].name = HAM_PARAM_SIMD_SEARCH;
+    params[p].value = m_config->simd_search;
+    p++;
+    params[p].name = HAM_PARAM_LINEAR_SEARCH_THRESHOLD;
+    params[p].value = m_config->linear_threshold;
+    p++;
+    params[p].name = HAM_PARAM_IO_BACKEND;
+    params[p].value = m_config->io_backend;
+    p++;
+    params[p].name = HAM_PARAM_FLUSH_WORKERS;
+    params[p].value = m_config->flush_workers;
+    p++;
+    params[p].name = HAM_PARAM_FLUSH_STALL_PERCENT;
+    params[p].value = m_config->flush_stall_percent;
+    p++;
+    params[p].name = HAM_PARAM_CHECKPOINT_DIRTY_PERCENT;
+    params[p].value = m_config->checkpoint_dirty_percent;
+    p++;
+    params[p].name = HAM_PARAM_CHECKPOINT_AGE_LIMIT;
+    params[p].value = m_config->checkpoint_age_limit;
+    p++;
+    if (m_config->mmap_reserve) {
+      params[p].name = HAM_PARAM_MMAP_RESERVE;
+      params[p].value = m_config->mmap_reserve;
+      p++;
+    }
     if (m_config->use_encryption) {
       params[p].name = HAM_PARAM_ENCRYPTION_KEY;
       params[p].value = (uint64_t)"1234567890123456";
@@ -333,6 +403,11 @@ HamsterDatabase::do_create_db(int id)
     params[n].value = m_config->key_compression;
     n++;
   }
+  if (m_config->inline_record_threshold) {
+    params[n].name = HAM_PARAM_INLINE_RECORD_THRESHOLD;
+    params[n].value = m_config->inline_record_threshold;
+    n++;
+  }
 
   uint32_t flags = 0;
 
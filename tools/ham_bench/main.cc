@@ -96,6 +96,17 @@
 #define ARG_RECORD_NUMBER32                     69
 #define ARG_RECORD_NUMBER64                     70
 #define ARG_POSIX_FADVICE                       71
+#define ARG_CACHE_POLICY                        72
+#define ARG_READAHEAD                           73
+#define ARG_JOURNAL_COMMIT_WINDOW               74
+#define ARG_SIMD                                75
+#define ARG_IO_BACKEND                          76
+#define ARG_FLUSH_WORKERS                       77
+#define ARG_FLUSH_STALL_PERCENT                 78
+#define ARG_CHECKPOINT_DIRTY_PERCENT            79
+#define ARG_CHECKPOINT_AGE_LIMIT                80
+#define ARG_MMAP_RESERVE                        81
+#define ARG_INLINE_RECORD_THRESHOLD             82
 
 /*
  * command line parameters
@@ -389,20 +400,20 @@ static option_t opts[] = {
     ARG_JOURNAL_COMPRESSION,
     0,
     "journal-compression",
-    "Pro: Enables journal compression ('none', 'zlib', 'snappy', 'lzf', 'lzo')",
+    "Enables journal compression ('lzf'; Pro: 'zlib', 'snappy', 'lzo')",
     GETOPTS_NEED_ARGUMENT },
   {
     ARG_RECORD_COMPRESSION,
     0,
     "record-compression",
-    "Pro: Enables record compression ('none', 'zlib', 'snappy', 'lzf', 'lzo')",
+    "Enables record compression ('lzf'; Pro: 'zlib', 'snappy', 'lzo')",
     GETOPTS_NEED_ARGUMENT },
   {
     ARG_KEY_COMPRESSION,
     0,
     "key-compression",
-    "Pro: Enables key compression ('none', 'zlib', 'snappy', 'lzf', 'lzo', "
-            "'bitmap')",
+    "Enables key compression ('prefix', 'for'; Pro: 'zlib', 'snappy', "
+            "'lzf', 'lzo')",
     GETOPTS_NEED_ARGUMENT },
   {
     ARG_PAX_LINEAR_THRESHOLD,
@@ -414,8 +425,62 @@ static option_t opts[] = {
     ARG_PAX_DISABLE_SIMD,
     0,
     "pax-disable-simd",
-    "Pro: Enables use of SIMD instructions",
+    "Disables use of SIMD instructions",
     0 },
+  {
+    ARG_SIMD,
+    0,
+    "simd",
+    "Sets the SIMD instruction set for searching: 'auto' (default), 'none', "
+            "'sse2', 'avx2'",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_IO_BACKEND,
+    0,
+    "io-backend",
+    "Sets the I/O backend: 'posix' (default), 'uring', 'uring-direct'",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_FLUSH_WORKERS,
+    0,
+    "flush-workers",
+    "Sets the number of threads which flush dirty pages (default: 1)",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_FLUSH_STALL_PERCENT,
+    0,
+    "flush-stall-percent",
+    "Stalls writers if this percentage of the cache is waiting to be "
+            "flushed (default: 50; 0 disables stalls)",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_CHECKPOINT_DIRTY_PERCENT,
+    0,
+    "checkpoint-dirty-percent",
+    "Writes back dirty pages in the background if this percentage of the "
+            "cache is dirty (default: 0 - disabled)",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_CHECKPOINT_AGE_LIMIT,
+    0,
+    "checkpoint-age-limit",
+    "Writes back pages which are dirty for longer than this many "
+            "milliseconds (default: 0 - disabled)",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_MMAP_RESERVE,
+    0,
+    "mmap-reserve",
+    "Reserves this many bytes of address space for the mapped file; the "
+            "mapping grows with the file (default: 0 - disabled)",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_INLINE_RECORD_THRESHOLD,
+    0,
+    "inline-record-threshold",
+    "Stores records up to this size in the btree leaf (max: 250; "
+            "default: 0 - disabled)",
+    GETOPTS_NEED_ARGUMENT },
   {
     ARG_READ_ONLY,
     0,
@@ -426,7 +491,7 @@ static option_t opts[] = {
     ARG_ENABLE_CRC32,
     0,
     "enable-crc32",
-    "Pro: Enables use of CRC32 verification",
+    "Enables CRC32C page checksums",
     0 },
   {
     ARG_RECORD_NUMBER32,
@@ -446,6 +511,24 @@ static option_t opts[] = {
     "posix-fadvice",
     "Sets the posix_fadvise() parameter: 'random', 'normal' (default)",
     GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_CACHE_POLICY,
+    0,
+    "cache-policy",
+    "Sets the cache replacement policy: 'lru' (default), '2q'",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_READAHEAD,
+    0,
+    "readahead",
+    "Sets the number of leaf pages which are read ahead (default: 0)",
+    GETOPTS_NEED_ARGUMENT },
+  {
+    ARG_JOURNAL_COMMIT_WINDOW,
+    0,
+    "journal-commit-window",
+    "Enables group commits; sets the time window in microseconds (default: 0)",
+    GETOPTS_NEED_ARGUMENT },
   {0, 0}
 };
 
@@ -462,17 +545,16 @@ parse_compression_type(const char *param)
     return (HAM_COMPRESSOR_LZF);
   if (!strcmp(param, "lzo"))
     return (HAM_COMPRESSOR_LZO);
+  if (!strcmp(param, "prefix"))
+    return (HAM_COMPRESSOR_PREFIX);
+  if (!strcmp(param, "for"))
+    return (HAM_COMPRESSOR_FOR);
   printf("invalid compression specifier '%s': expecting 'none', 'zlib', "
-                  "'snappy', 'lzf', 'lzo'\n", param);
+                  "'snappy', 'lzf', 'lzo', 'prefix', 'for'\n", param);
   exit(-1);
   return (HAM_COMPRESSOR_NONE);
 }
 
-namespace hamsterdb {
-extern int g_linear_threshold;
-extern bool g_is_simd_enabled;
-};
-
 static void
 parse_config(int argc, char **argv, Configuration *c)
 {
@@ -785,7 +867,7 @@ parse_config(int argc, char **argv, Configuration *c)
       c->key_compression = parse_compression_type(param);
     }
     else if (opt == ARG_PAX_LINEAR_THRESHOLD) {
-      hamsterdb::Globals::ms_linear_threshold = strtoul(param, 0, 0);
+      c->linear_threshold = strtoul(param, 0, 0);
     }
     else if (opt == ARG_POSIX_FADVICE) {
       if (!strcmp(param, "normal"))
@@ -797,8 +879,72 @@ parse_config(int argc, char **argv, Configuration *c)
         exit(-1);
       }
     }
+    else if (opt == ARG_CACHE_POLICY) {
+      if (!strcmp(param, "lru"))
+        c->cache_policy = HAM_CACHE_POLICY_LRU;
+      else if (!strcmp(param, "2q"))
+        c->cache_policy = HAM_CACHE_POLICY_2Q;
+      else {
+        printf("[FAIL] invalid parameter for 'cache-policy'\n");
+        exit(-1);
+      }
+    }
+    else if (opt == ARG_READAHEAD) {
+      c->readahead = strtoul(param, 0, 0);
+    }
+    else if (opt == ARG_JOURNAL_COMMIT_WINDOW) {
+      c->journal_commit_window = strtoul(param, 0, 0);
+    }
     else if (opt == ARG_PAX_DISABLE_SIMD) {
-      hamsterdb::Globals::ms_is_simd_enabled = false;
+      c->simd_search = HAM_SIMD_NONE;
+    }
+    else if (opt == ARG_SIMD) {
+      if (param && !strcmp(param, "auto"))
+        c->simd_search = HAM_SIMD_AUTO;
+      else if (param && !strcmp(param, "none"))
+        c->simd_search = HAM_SIMD_NONE;
+      else if (param && !strcmp(param, "sse2"))
+        c->simd_search = HAM_SIMD_SSE2;
+      else if (param && !strcmp(param, "avx2"))
+        c->simd_search = HAM_SIMD_AVX2;
+      else {
+        printf("[FAIL] invalid parameter for 'simd'\n");
+        exit(-1);
+      }
+    }
+    else if (opt == ARG_IO_BACKEND) {
+      if (param && !strcmp(param, "posix"))
+        c->io_backend = HAM_IO_BACKEND_POSIX;
+      else if (param && !strcmp(param, "uring"))
+        c->io_backend = HAM_IO_BACKEND_URING;
+      else if (param && !strcmp(param, "uring-direct"))
+        c->io_backend = HAM_IO_BACKEND_URING_DIRECT;
+      else {
+        printf("[FAIL] invalid parameter for 'io-backend'\n");
+        exit(-1);
+      }
+    }
+    else if (opt == ARG_FLUSH_WORKERS) {
+      c->flush_workers = strtoul(param, 0, 0);
+      if (c->flush_workers < 1 || c->flush_workers > HAM_MAX_FLUSH_WORKERS) {
+        printf("[FAIL] invalid parameter for 'flush-workers'\n");
+        exit(-1);
+      }
+    }
+    else if (opt == ARG_FLUSH_STALL_PERCENT) {
+      c->flush_stall_percent = strtoul(param, 0, 0);
+    }
+    else if (opt == ARG_CHECKPOINT_DIRTY_PERCENT) {
+      c->checkpoint_dirty_percent = strtoul(param, 0, 0);
+    }
+    else if (opt == ARG_CHECKPOINT_AGE_LIMIT) {
+      c->checkpoint_age_limit = strtoul(param, 0, 0);
+    }
+    else if (opt == ARG_MMAP_RESERVE) {
+      c->mmap_reserve = strtoull(param, 0, 0);
+    }
+    else if (opt == ARG_INLINE_RECORD_THRESHOLD) {
+      c->inline_record_threshold = strtoul(param, 0, 0);
     }
     else if (opt == ARG_ENABLE_CRC32) {
       c->enable_crc32 = true;
@@ -846,6 +992,21 @@ parse_config(int argc, char **argv, Configuration *c)
   }
 }
 
+static void
+print_latency(const char *name, const latency_metrics_t *latency)
+{
+  if (latency->count == 0)
+    return;
+  printf("\thamsterdb latency_%-17s count %lu avg %lu p50 %lu p99 %lu "
+                  "p999 %lu max %lu (usec)\n", name,
+          (long unsigned int)latency->count,
+          (long unsigned int)(latency->total_usec / latency->count),
+          (long unsigned int)latency->p50_usec,
+          (long unsigned int)latency->p99_usec,
+          (long unsigned int)latency->p999_usec,
+          (long unsigned int)latency->max_usec);
+}
+
 static void
 print_metrics(Metrics *metrics, Configuration *conf)
 {
@@ -962,10 +1123,59 @@ print_metrics(Metrics *metrics, Configuration *conf)
           (long unsigned int)metrics->hamster_metrics.cache_hits);
   printf("\thamsterdb cache_misses                %lu\n",
           (long unsigned int)metrics->hamster_metrics.cache_misses);
+  if (metrics->hamster_metrics.cache_policy == HAM_CACHE_POLICY_2Q) {
+    printf("\thamsterdb cache_hits_hot              %lu\n",
+          (long unsigned int)metrics->hamster_metrics.cache_hits_hot);
+    printf("\thamsterdb cache_hits_cold             %lu\n",
+          (long unsigned int)metrics->hamster_metrics.cache_hits_cold);
+    printf("\thamsterdb cache_promotions            %lu\n",
+          (long unsigned int)metrics->hamster_metrics.cache_promotions);
+  }
+  if (metrics->hamster_metrics.readahead_issued) {
+    printf("\thamsterdb readahead_issued            %lu\n",
+          (long unsigned int)metrics->hamster_metrics.readahead_issued);
+    printf("\thamsterdb readahead_hits              %lu\n",
+          (long unsigned int)metrics->hamster_metrics.readahead_hits);
+    printf("\thamsterdb readahead_wasted            %lu\n",
+          (long unsigned int)metrics->hamster_metrics.readahead_wasted);
+  }
+  if (metrics->hamster_metrics.flush_stalls
+          || metrics->hamster_metrics.flush_queue_depth
+          || conf->flush_workers > 1) {
+    printf("\thamsterdb flush_queue_depth           %lu\n",
+          (long unsigned int)metrics->hamster_metrics.flush_queue_depth);
+    for (int i = 0; i < conf->flush_workers; i++)
+      printf("\thamsterdb flush_worker_pages[%d]      %lu\n", i,
+          (long unsigned int)metrics->hamster_metrics.flush_worker_pages[i]);
+    printf("\thamsterdb flush_stalls                %lu\n",
+          (long unsigned int)metrics->hamster_metrics.flush_stalls);
+    printf("\thamsterdb flush_stall_usec            %lu\n",
+          (long unsigned int)metrics->hamster_metrics.flush_stall_usec);
+  }
+  if (conf->checkpoint_dirty_percent || conf->checkpoint_age_limit) {
+    printf("\thamsterdb checkpoint_count            %lu\n",
+          (long unsigned int)metrics->hamster_metrics.checkpoint_count);
+    printf("\thamsterdb checkpoint_pages            %lu\n",
+          (long unsigned int)metrics->hamster_metrics.checkpoint_pages);
+    printf("\thamsterdb checkpoint_lsn              %lu\n",
+          (long unsigned int)metrics->hamster_metrics.checkpoint_lsn);
+  }
+  if (conf->enable_crc32) {
+    printf("\thamsterdb page_checksums_computed     %lu\n",
+          (long unsigned int)metrics->hamster_metrics.page_checksums_computed);
+    printf("\thamsterdb page_checksums_verified     %lu\n",
+          (long unsigned int)metrics->hamster_metrics.page_checksums_verified);
+    printf("\thamsterdb page_checksums_skipped      %lu\n",
+          (long unsigned int)metrics->hamster_metrics.page_checksums_skipped);
+    printf("\thamsterdb page_checksum_failures      %lu\n",
+          (long unsigned int)metrics->hamster_metrics.page_checksum_failures);
+  }
   printf("\thamsterdb blob_total_allocated        %lu\n",
           (long unsigned int)metrics->hamster_metrics.blob_total_allocated);
   printf("\thamsterdb blob_total_read             %lu\n",
           (long unsigned int)metrics->hamster_metrics.blob_total_read);
+  printf("\thamsterdb blob_bytes_read_uncached    %lu\n",
+          (long unsigned int)metrics->hamster_metrics.blob_bytes_read_uncached);
   printf("\thamsterdb btree_smo_split             %lu\n",
           (long unsigned int)metrics->hamster_metrics.btree_smo_split);
   printf("\thamsterdb btree_smo_merge             %lu\n",
@@ -976,8 +1186,25 @@ print_metrics(Metrics *metrics, Configuration *conf)
           (long unsigned int)metrics->hamster_metrics.extended_duptables);
   printf("\thamsterdb journal_bytes_flushed       %lu\n",
           (long unsigned int)metrics->hamster_metrics.journal_bytes_flushed);
+  printf("\thamsterdb journal_fsyncs              %lu\n",
+          (long unsigned int)metrics->hamster_metrics.journal_fsyncs);
+  if (metrics->hamster_metrics.journal_group_commits) {
+    printf("\thamsterdb journal_group_commits       %lu\n",
+          (long unsigned int)metrics->hamster_metrics.journal_group_commits);
+    for (int i = 0; i < 8; i++)
+      printf("\thamsterdb journal_group_commit_size[%d] %lu\n", i,
+          (long unsigned int)metrics->hamster_metrics.journal_group_commit_sizes[i]);
+  }
   printf("\thamsterdb simd_lane_width             %d\n",
           metrics->hamster_metrics.simd_lane_width);
+  print_latency("find", &metrics->hamster_metrics.latency_find);
+  print_latency("insert", &metrics->hamster_metrics.latency_insert);
+  print_latency("erase", &metrics->hamster_metrics.latency_erase);
+  print_latency("commit", &metrics->hamster_metrics.latency_commit);
+  print_latency("page_fetch", &metrics->hamster_metrics.latency_page_fetch);
+  print_latency("page_flush", &metrics->hamster_metrics.latency_page_flush);
+  print_latency("journal_fsync",
+          &metrics->hamster_metrics.latency_journal_fsync);
 }
 
 struct Callable
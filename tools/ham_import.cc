@@ -28,6 +28,7 @@
 #define ARG_HELP          1
 #define ARG_STDIN         2
 #define ARG_MERGE         3
+#define ARG_BULK          4
 
 
 /*
@@ -52,6 +53,12 @@ static option_t opts[] = {
     "merge",
     "merge database dump into existing file",
     0 },
+  {
+    ARG_BULK,
+    "bulk",
+    "bulk",
+    "use the bulk loader for new databases",
+    0 },
   { 0, 0, 0, 0, 0 } /* terminating element */
 };
 
@@ -63,8 +70,8 @@ error(const char *foo, ham_status_t st) {
 
 class Importer {
   public:
-    Importer(FILE *f, ham_env_t *env, const char *outfilename)
-      : m_f(f), m_env(env), m_outfilename(outfilename) {
+    Importer(FILE *f, ham_env_t *env, const char *outfilename, bool bulk)
+      : m_f(f), m_env(env), m_outfilename(outfilename), m_bulk(bulk) {
     }
 
     virtual ~Importer() { }
@@ -75,13 +82,15 @@ class Importer {
     FILE *m_f;
     ham_env_t *m_env;
     const char *m_outfilename;
+    bool m_bulk;
 };
 
 class BinaryImporter : public Importer {
   public:
-    BinaryImporter(FILE *f, ham_env_t *env, const char *outfilename)
-      : Importer(f, env, outfilename), m_db(0), m_insert_flags(0),
-        m_db_counter(0), m_item_counter(0) {
+    BinaryImporter(FILE *f, ham_env_t *env, const char *outfilename,
+            bool bulk)
+      : Importer(f, env, outfilename, bulk), m_db(0), m_insert_flags(0),
+        m_db_counter(0), m_item_counter(0), m_pending(false) {
       m_buffer = (char *)malloc(1024 * 1024);
     }
 
@@ -94,29 +103,21 @@ class BinaryImporter : public Importer {
     }
 
     virtual void run() {
-      while (!feof(m_f)) {
-        // read the next message from the stream
-        uint32_t size = read_size();
-        if (!size)
-          return;
-
-        m_buffer = (char *)realloc(0, size);
-        if (size != fread(m_buffer, 1, size, m_f)) {
-          fprintf(stderr, "Error reading %u bytes: %s\n", size,
-                  strerror(errno));
-          exit(-1);
-        }
-
-        // unpack serialized datum
-        HamsterTool::Datum datum;
-        datum.ParseFromArray(m_buffer, size);
-
+      HamsterTool::Datum datum;
+      while (read_datum(datum)) {
         switch (datum.type()) {
           case HamsterTool::Datum::ENVIRONMENT:
             read_environment(datum);
             break;
           case HamsterTool::Datum::DATABASE:
-            read_database(datum);
+            // a new database is filled with the bulk loader; it reads
+            // all following items
+            if (read_database(datum) && m_bulk) {
+              ham_status_t st = ham_db_bulk_load(m_db, bulk_load_item, this,
+                                0, 0);
+              if (st)
+                error("ham_db_bulk_load", st);
+            }
             m_db_counter++;
             break;
           case HamsterTool::Datum::ITEM:
@@ -131,6 +132,57 @@ class BinaryImporter : public Importer {
     }
 
   private:
+    // Reads the next message from the stream; returns false at the end
+    // of the stream
+    bool read_datum(HamsterTool::Datum &datum) {
+      // the bulk loader stops at the first message which is not an item
+      if (m_pending) {
+        m_pending = false;
+        datum = m_pending_datum;
+        return (true);
+      }
+
+      if (feof(m_f))
+        return (false);
+
+      uint32_t size = read_size();
+      if (!size)
+        return (false);
+
+      m_buffer = (char *)realloc(0, size);
+      if (size != fread(m_buffer, 1, size, m_f)) {
+        fprintf(stderr, "Error reading %u bytes: %s\n", size,
+                strerror(errno));
+        exit(-1);
+      }
+
+      // unpack serialized datum
+      datum.ParseFromArray(m_buffer, size);
+      return (true);
+    }
+
+    // Callback for ham_db_bulk_load; returns the next item of the stream.
+    // The items were exported with a cursor, therefore they are sorted.
+    static ham_status_t HAM_CALLCONV bulk_load_item(ham_key_t *key,
+            ham_record_t *record, void *context) {
+      BinaryImporter *self = (BinaryImporter *)context;
+      if (!self->read_datum(self->m_item_datum))
+        return (HAM_KEY_NOT_FOUND);
+      if (self->m_item_datum.type() != HamsterTool::Datum::ITEM) {
+        self->m_pending = true;
+        self->m_pending_datum = self->m_item_datum;
+        return (HAM_KEY_NOT_FOUND);
+      }
+
+      const HamsterTool::Item &item = self->m_item_datum.item();
+      key->data = (void *)item.key().data();
+      key->size = item.key().size();
+      record->data = (void *)item.record().data();
+      record->size = item.record().size();
+      self->m_item_counter++;
+      return (0);
+    }
+
     void read_environment(HamsterTool::Datum &datum) {
       // only process if the Environment does not yet exist
       if (m_env)
@@ -150,7 +202,8 @@ class BinaryImporter : public Importer {
         error("ham_env_create", st);
     }
 
-    void read_database(HamsterTool::Datum &datum) {
+    // Opens or creates a database; returns true if it was created
+    bool read_database(HamsterTool::Datum &datum) {
       const HamsterTool::Database &db = datum.db();
 
       // create database (if it does not yet exist)
@@ -182,13 +235,14 @@ class BinaryImporter : public Importer {
 
       ham_status_t st = ham_env_open_db(m_env, &m_db, db.name(), open_flags, 0);
       if (st == 0)
-        return;
+        return (false);
       if (st != HAM_DATABASE_NOT_FOUND)
         error("ham_env_open_db", st);
 
       st = ham_env_create_db(m_env, &m_db, db.name(), db.flags(), &params[0]);
       if (st)
         error("ham_env_create_db", st);
+      return (true);
     }
 
     void read_item(HamsterTool::Datum &datum) {
@@ -228,6 +282,9 @@ class BinaryImporter : public Importer {
     uint32_t m_insert_flags;
     size_t m_db_counter;
     size_t m_item_counter;
+    bool m_pending;
+    HamsterTool::Datum m_pending_datum;
+    HamsterTool::Datum m_item_datum;
 };
 
 int
@@ -235,6 +292,7 @@ main(int argc, char **argv) {
   unsigned opt;
   char *param, *dumpfilename = 0, *envfilename = 0;
   bool merge = false;
+  bool bulk = false;
   bool use_stdin = false;
 
   getopts_init(argc, argv, "ham_import");
@@ -247,6 +305,9 @@ main(int argc, char **argv) {
       case ARG_MERGE:
         merge = true;
         break;
+      case ARG_BULK:
+        bulk = true;
+        break;
       case GETOPTS_PARAMETER:
         if (!dumpfilename && !use_stdin)
           dumpfilename = param;
@@ -262,11 +323,12 @@ main(int argc, char **argv) {
       case ARG_HELP:
         print_banner("ham_import");
 
-        printf("usage: ham_import [--stdin] [--merge] <data> <environ>\n");
+        printf("usage: ham_import [--stdin] [--merge] [--bulk] <data> <environ>\n");
         printf("usage: ham_import --help\n");
         printf("       --help:       this help screen\n");
         printf("       --stdin:      read dump data from stdin\n");
         printf("       --merge:      merge data into existing environment\n");
+        printf("       --bulk:       use the bulk loader for new databases\n");
         printf("       <data>:       filename with exported data\n");
         printf("       <environ>:    hamsterdb environment which will be created (or filled)\n");
         return (0);
@@ -329,7 +391,7 @@ main(int argc, char **argv) {
   }
 
   // now run the import; the importer will create the environment
-  Importer *importer = new BinaryImporter(f, env, envfilename);
+  Importer *importer = new BinaryImporter(f, env, envfilename, bulk);
   importer->run();
   delete importer;
   fclose(f);
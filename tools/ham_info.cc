@@ -85,6 +85,10 @@ get_compressor_name(int library) {
       return ("lzf");
     case HAM_COMPRESSOR_LZO:
       return ("lzo");
+    case HAM_COMPRESSOR_PREFIX:
+      return ("prefix");
+    case HAM_COMPRESSOR_FOR:
+      return ("for");
     default:
       return ("???");
   }
@@ -248,6 +252,7 @@ print_database(ham_env_t *env, ham_db_t *db, uint16_t dbname,
     {HAM_PARAM_FLAGS, 0},
     {HAM_PARAM_RECORD_COMPRESSION, 0},
     {HAM_PARAM_KEY_COMPRESSION, 0},
+    {HAM_PARAM_INLINE_RECORD_THRESHOLD, 0},
     {0, 0}
   };
 
@@ -303,6 +308,9 @@ print_database(ham_env_t *env, ham_db_t *db, uint16_t dbname,
                       params[4].value & HAM_FORCE_RECORDS_INLINE
                             ? "yes"
                             : "no");
+    if (params[7].value)
+      printf("    inline records:       <= %u bytes\n",
+                      (unsigned)params[7].value);
   }
 
   if (full)
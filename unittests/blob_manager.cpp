@@ -14,11 +14,15 @@
  * limitations under the License.
  */
 
+#include <vector>
+#include <algorithm>
+
 #include "3rdparty/catch/catch.hpp"
 
 #include "utils.h"
 #include "os.hpp"
 
+#include "2compressor/compressor_lzf.h"
 #include "2page/page.h"
 #include "3page_manager/page_manager.h"
 #include "3page_manager/page_manager_test.h"
@@ -755,4 +759,275 @@ TEST_CASE("BlobManager-inmem-64k/smallBlobTest", "")
   f.smallBlobTest();
 }
 
+// large blobs are read without loading their pages into the cache, but
+// dirty (cached) pages are still used
+TEST_CASE("BlobManager/uncachedReadTest", "")
+{
+  ham_env_t *env;
+  ham_db_t *db;
+  ham_parameter_t params[] = {
+    {HAM_PARAM_CACHESIZE, 64 * HAM_DEFAULT_PAGE_SIZE},
+    {0, 0}
+  };
+  const uint32_t kSize = 2 * 1024 * 1024;
+  std::vector<uint8_t> data(kSize);
+  std::vector<uint8_t> buffer(kSize);
+
+  REQUIRE(0 == ham_env_create(&env, Utils::opath(".test"), HAM_DISABLE_MMAP,
+                          0644, &params[0]));
+  REQUIRE(0 == ham_env_create_db(env, &db, 1, 0, 0));
+  for (uint32_t i = 0; i < 5; i++) {
+    for (uint32_t j = 0; j < kSize; j++)
+      data[j] = (uint8_t)(i + j * 7);
+    ham_key_t key = ham_make_key(&i, sizeof(i));
+    ham_record_t rec = ham_make_record(&data[0], kSize);
+    REQUIRE(0 == ham_db_insert(db, 0, &key, &rec, 0));
+  }
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+
+  REQUIRE(0 == ham_env_open(&env, Utils::opath(".test"), HAM_DISABLE_MMAP,
+                          &params[0]));
+  REQUIRE(0 == ham_env_open_db(env, &db, 1, 0, 0));
+
+  // modify a page in the middle of the first blob; it remains dirty
+  // in the cache
+  uint32_t i = 0;
+  ham_key_t key = ham_make_key(&i, sizeof(i));
+  ham_record_t rec = ham_make_record(&data[0], kSize);
+  rec.partial_offset = kSize / 2;
+  rec.partial_size = 100;
+  ::memset(&data[0], 0xff, 100);
+  REQUIRE(0 == ham_db_insert(db, 0, &key, &rec, HAM_OVERWRITE | HAM_PARTIAL));
+
+  ham_env_metrics_t metrics;
+  REQUIRE(0 == ham_env_get_metrics(env, &metrics));
+  uint64_t fetched = metrics.page_count_fetched;
+
+  for (i = 0; i < 5; i++) {
+    for (uint32_t j = 0; j < kSize; j++)
+      data[j] = (uint8_t)(i + j * 7);
+    if (i == 0)
+      ::memset(&data[kSize / 2], 0xff, 100);
+
+    // read the full record into a user-supplied buffer
+    key = ham_make_key(&i, sizeof(i));
+    rec = ham_make_record(&buffer[0], kSize);
+    rec.flags = HAM_RECORD_USER_ALLOC;
+    REQUIRE(0 == ham_db_find(db, 0, &key, &rec, 0));
+    REQUIRE(rec.size == kSize);
+    REQUIRE(0 == ::memcmp(&data[0], &buffer[0], kSize));
+
+    // then stream it in chunks of 300 kb
+    const uint32_t kChunk = 300 * 1024;
+    for (uint32_t offset = 0; offset < kSize; offset += kChunk) {
+      rec = ham_make_record(&buffer[0], kChunk);
+      rec.flags = HAM_RECORD_USER_ALLOC;
+      rec.partial_offset = offset;
+      rec.partial_size = kChunk;
+      REQUIRE(0 == ham_db_find(db, 0, &key, &rec, HAM_PARTIAL));
+      uint32_t expected = std::min(kChunk, kSize - offset);
+      REQUIRE(rec.partial_size == expected);
+      REQUIRE(0 == ::memcmp(&data[offset], &buffer[0], expected));
+    }
+  }
+
+  // the blob pages were not loaded into the cache
+  REQUIRE(0 == ham_env_get_metrics(env, &metrics));
+  uint64_t fetched_pages = metrics.page_count_fetched - fetched;
+  REQUIRE(fetched_pages < 100);
+  REQUIRE(metrics.blob_bytes_read_uncached > 9ull * kSize);
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+}
+
+static void
+lzf_roundtrip(LzfCompressor *lzf, const std::vector<uint8_t> &data,
+                bool compressible)
+{
+  ByteArray arena;
+  uint32_t size = (uint32_t)data.size();
+  uint32_t length = lzf->compress(size ? &data[0] : 0, size, &arena);
+  if (!compressible) {
+    REQUIRE(length == 0u);
+    return;
+  }
+  REQUIRE(length > 0u);
+  REQUIRE(length < size);
+
+  std::vector<uint8_t> out(size);
+  lzf->decompress(arena.get_ptr(), length, &out[0], size);
+  REQUIRE(out == data);
+
+  // the decompressed size has to match
+  bool thrown = false;
+  try {
+    lzf->decompress(arena.get_ptr(), length, &out[0], size - 1);
+  }
+  catch (Exception &ex) {
+    REQUIRE(ex.code == HAM_INTEGRITY_VIOLATED);
+    thrown = true;
+  }
+  REQUIRE(thrown == true);
+}
+
+TEST_CASE("BlobManager/lzfCompressorTest", "")
+{
+  LzfCompressor lzf;
+  std::vector<uint8_t> data;
+
+  // tiny or random data cannot be compressed
+  lzf_roundtrip(&lzf, data, false);
+  data.push_back(1);
+  lzf_roundtrip(&lzf, data, false);
+  data.resize(10000);
+  for (size_t i = 0; i < data.size(); i++)
+    data[i] = (uint8_t)(::rand() >> 3);
+  lzf_roundtrip(&lzf, data, false);
+
+  // long runs of the same byte
+  data.assign(100000, 'x');
+  lzf_roundtrip(&lzf, data, true);
+
+  // repeating text, mixed with short literal runs
+  std::string text;
+  for (int i = 0; i < 1000; i++) {
+    char buffer[128];
+    ::snprintf(buffer, sizeof(buffer),
+            "{\"id\": %d, \"name\": \"user%d\", \"active\": %s}, ",
+            i, i * 7, i % 3 ? "true" : "false");
+    text += buffer;
+  }
+  data.assign(text.begin(), text.end());
+  lzf_roundtrip(&lzf, data, true);
+
+  // matches at the maximum distance
+  data.resize(8192 + 300);
+  for (size_t i = 0; i < 8192; i++)
+    data[i] = (uint8_t)(::rand() >> 3);
+  std::copy(data.begin(), data.begin() + 300, data.begin() + 8192);
+  lzf_roundtrip(&lzf, data, true);
+}
+
+// Returns a json-like record which compresses well
+static std::vector<uint8_t>
+make_json_record(uint32_t i, uint32_t size)
+{
+  static const char *json = "{\"key\": \"value\", \"id\": 0123456789}, ";
+  uint32_t length = (uint32_t)::strlen(json);
+  std::vector<uint8_t> data(size);
+  for (uint32_t j = 0; j < size; j++)
+    data[j] = (uint8_t)json[(i + j) % length];
+  return (data);
+}
+
+TEST_CASE("BlobManager/recordCompressionTest", "")
+{
+  ham_env_t *env;
+  ham_db_t *db;
+  ham_parameter_t params[] = {
+    {HAM_PARAM_RECORD_COMPRESSION, HAM_COMPRESSOR_LZF},
+    {0, 0}
+  };
+  const uint32_t kCount = 200;
+
+  REQUIRE(0 == ham_env_create(&env, Utils::opath(".test"), 0, 0644, 0));
+
+  // only lzf is available
+  ham_parameter_t zlib[] = {
+    {HAM_PARAM_RECORD_COMPRESSION, HAM_COMPRESSOR_ZLIB},
+    {0, 0}
+  };
+  REQUIRE(HAM_NOT_IMPLEMENTED == ham_env_create_db(env, &db, 1, 0, &zlib[0]));
+
+  REQUIRE(0 == ham_env_create_db(env, &db, 1, 0, &params[0]));
+  for (uint32_t i = 0; i < kCount; i++) {
+    std::vector<uint8_t> data = make_json_record(i, 10 + i * 97);
+    ham_key_t key = ham_make_key(&i, sizeof(i));
+    ham_record_t rec = ham_make_record(&data[0], (uint32_t)data.size());
+    REQUIRE(0 == ham_db_insert(db, 0, &key, &rec, 0));
+  }
+
+  ham_env_metrics_t metrics;
+  REQUIRE(0 == ham_env_get_metrics(env, &metrics));
+  REQUIRE(metrics.record_bytes_before_compression > 0ull);
+  uint64_t after = metrics.record_bytes_after_compression * 4;
+  REQUIRE(after < metrics.record_bytes_before_compression);
+
+  // compression can only be set when the database is created
+  REQUIRE(0 == ham_db_close(db, 0));
+  REQUIRE(HAM_INV_PARAMETER == ham_env_open_db(env, &db, 1, 0, &params[0]));
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+
+  REQUIRE(0 == ham_env_open(&env, Utils::opath(".test"), 0, 0));
+  REQUIRE(0 == ham_env_open_db(env, &db, 1, 0, 0));
+  ham_parameter_t get[] = {
+    {HAM_PARAM_RECORD_COMPRESSION, 0},
+    {0, 0}
+  };
+  REQUIRE(0 == ham_db_get_parameters(db, &get[0]));
+  REQUIRE((uint64_t)HAM_COMPRESSOR_LZF == get[0].value);
+
+  for (uint32_t i = 0; i < kCount; i++) {
+    std::vector<uint8_t> data = make_json_record(i, 10 + i * 97);
+    ham_key_t key = ham_make_key(&i, sizeof(i));
+    ham_record_t rec = {0};
+    REQUIRE(0 == ham_db_find(db, 0, &key, &rec, 0));
+    REQUIRE(rec.size == (uint32_t)data.size());
+    REQUIRE(0 == ::memcmp(rec.data, &data[0], rec.size));
+
+    // partial read
+    if (data.size() > 200) {
+      rec = ham_make_record(0, 0);
+      rec.partial_offset = 100;
+      rec.partial_size = 50;
+      REQUIRE(0 == ham_db_find(db, 0, &key, &rec, HAM_PARTIAL));
+      REQUIRE(rec.partial_size == 50u);
+      REQUIRE(0 == ::memcmp(rec.data, &data[100], 50));
+    }
+  }
+
+  // partial writes modify the record in place; the records are then
+  // compressed again
+  for (uint32_t i = 1; i < kCount; i += 2) {
+    std::vector<uint8_t> data = make_json_record(i, 10 + i * 97);
+    uint32_t offset = (uint32_t)data.size() / 2;
+    uint32_t new_size = (uint32_t)data.size() + (i % 4 == 1 ? 1000 : 0);
+    data.resize(new_size, 0);
+    std::vector<uint8_t> patch(64, (uint8_t)i);
+    std::copy(patch.begin(), patch.end(), data.begin() + offset);
+
+    ham_key_t key = ham_make_key(&i, sizeof(i));
+    ham_record_t rec = ham_make_record(&patch[0], new_size);
+    rec.partial_offset = offset;
+    rec.partial_size = (uint32_t)patch.size();
+    REQUIRE(0 == ham_db_insert(db, 0, &key, &rec,
+                            HAM_OVERWRITE | HAM_PARTIAL));
+
+    rec = ham_make_record(0, 0);
+    REQUIRE(0 == ham_db_find(db, 0, &key, &rec, 0));
+    REQUIRE(rec.size == new_size);
+    REQUIRE(0 == ::memcmp(rec.data, &data[0], new_size));
+  }
+
+  // records which cannot be compressed are stored uncompressed
+  for (uint32_t i = 0; i < kCount; i += 2) {
+    std::vector<uint8_t> data(1000 + i);
+    for (size_t j = 0; j < data.size(); j++)
+      data[j] = (uint8_t)(::rand() >> 3);
+    ham_key_t key = ham_make_key(&i, sizeof(i));
+    ham_record_t rec = ham_make_record(&data[0], (uint32_t)data.size());
+    REQUIRE(0 == ham_db_insert(db, 0, &key, &rec, HAM_OVERWRITE));
+    rec = ham_make_record(0, 0);
+    REQUIRE(0 == ham_db_find(db, 0, &key, &rec, 0));
+    REQUIRE(rec.size == (uint32_t)data.size());
+    REQUIRE(0 == ::memcmp(rec.data, &data[0], rec.size));
+  }
+
+  REQUIRE(0 == ham_db_check_integrity(db, 0));
+  for (uint32_t i = 0; i < kCount; i++) {
+    ham_key_t key = ham_make_key(&i, sizeof(i));
+    REQUIRE(0 == ham_db_erase(db, 0, &key, 0));
+  }
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+}
+
 } // namespace hamsterdb
@@ -16,6 +16,11 @@
 
 #include "3rdparty/catch/catch.hpp"
 
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
 #include "utils.h"
 #include "os.hpp"
 
@@ -165,6 +170,162 @@ struct BtreeFixture {
     REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
   }
 
+  // Verifies that FixedWidthCompare returns the same results as memcmp(3)
+  template<uint32_t Size>
+  void fixedWidthCompareTest() {
+    FixedWidthCompare<Size> cmp(0);
+    uint8_t lhs[Size];
+    uint8_t rhs[Size];
+    uint32_t seed = 1;
+
+    for (int i = 0; i < 10000; i++) {
+      for (uint32_t j = 0; j < Size; j++) {
+        seed = seed * 1103515245 + 12345;
+        lhs[j] = rhs[j] = (uint8_t)(seed >> 16);
+      }
+      // modify a single byte (or none) to test every position
+      int pos = i % (Size + 1);
+      if (pos < (int)Size)
+        rhs[pos] = (uint8_t)(seed >> 8);
+
+      int expected = ::memcmp(lhs, rhs, Size);
+      int result = cmp(lhs, Size, rhs, Size);
+      bool same = (expected < 0 && result < 0)
+                    || (expected > 0 && result > 0)
+                    || (expected == 0 && result == 0);
+      REQUIRE(same);
+      result = cmp(rhs, Size, lhs, Size);
+      same = (expected < 0 && result > 0)
+                    || (expected > 0 && result < 0)
+                    || (expected == 0 && result == 0);
+      REQUIRE(same);
+    }
+  }
+
+  // Inserts random fixed length keys and verifies that the cursor returns
+  // them in memcmp(3) order
+  void fixedWidthKeysTest(uint32_t size) {
+    ham_db_t *db;
+    ham_env_t *env;
+    ham_cursor_t *cursor;
+    ham_parameter_t p[] = {
+        { HAM_PARAM_KEY_SIZE, size },
+        { 0, 0 }
+    };
+
+    REQUIRE(0 == ham_env_create(&env, Utils::opath("test.db"), 0, 0, 0));
+    REQUIRE(0 == ham_env_create_db(env, &db, 1, 0, &p[0]));
+
+    std::vector<std::string> keys;
+    uint32_t seed = 1;
+    ham_key_t key = {0};
+    ham_record_t rec = {0};
+    for (int i = 0; i < 20000; i++) {
+      std::string s(size, '\0');
+      for (uint32_t j = 0; j < size; j++) {
+        seed = seed * 1103515245 + 12345;
+        s[j] = (char)(seed >> 16);
+      }
+      // many keys share a prefix
+      if (i % 2)
+        s.replace(0, size / 2, size / 2, 'x');
+      key.data = (void *)s.data();
+      key.size = size;
+      ham_status_t st = ham_db_insert(db, 0, &key, &rec, 0);
+      bool ok = (st == 0 || st == HAM_DUPLICATE_KEY);
+      REQUIRE(ok);
+      if (st == 0)
+        keys.push_back(s);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    REQUIRE(0 == ham_cursor_create(&cursor, db, 0, 0));
+    for (size_t i = 0; i < keys.size(); i++) {
+      REQUIRE(0 == ham_cursor_move(cursor, &key, 0, HAM_CURSOR_NEXT));
+      REQUIRE(key.size == size);
+      REQUIRE(0 == ::memcmp(key.data, keys[i].data(), size));
+    }
+    REQUIRE(HAM_KEY_NOT_FOUND == ham_cursor_move(cursor, 0, 0,
+                            HAM_CURSOR_NEXT));
+    REQUIRE(0 == ham_cursor_close(cursor));
+
+    for (size_t i = 0; i < keys.size(); i++) {
+      key.data = (void *)keys[i].data();
+      key.size = size;
+      REQUIRE(0 == ham_db_find(db, 0, &key, &rec, 0));
+    }
+    REQUIRE(0 == ham_db_check_integrity(db, 0));
+    REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+  }
+
+  // Compares the binary search with the specialized comparator against
+  // the generic memcmp(3) based comparator
+  template<uint32_t Size>
+  void fixedWidthCompareBenchmark() {
+    const unsigned int kKeys = 1024 * 1024;
+    const unsigned int kLookups = 4 * 1024 * 1024;
+
+    // sorted keys which share a long common prefix, like hashes in a
+    // densely populated range
+    std::vector<uint8_t> keys(kKeys * Size, 0x42);
+    for (unsigned int i = 0; i < kKeys; i++) {
+      uint8_t *p = &keys[i * Size + Size - 4];
+      p[0] = (uint8_t)(i >> 24);
+      p[1] = (uint8_t)(i >> 16);
+      p[2] = (uint8_t)(i >> 8);
+      p[3] = (uint8_t)i;
+    }
+
+    std::vector<unsigned int> lookups(kLookups);
+    uint32_t seed = 1;
+    for (unsigned int i = 0; i < kLookups; i++) {
+      seed = seed * 1103515245 + 12345;
+      lookups[i] = (seed >> 4) % kKeys;
+    }
+
+    using namespace boost::posix_time;
+    FixedSizeCompare generic(0);
+    ptime start = microsec_clock::universal_time();
+    size_t found = binary_search(&keys[0], kKeys, Size, lookups, generic);
+    time_duration generic_time = microsec_clock::universal_time() - start;
+    REQUIRE(found == kLookups);
+
+    FixedWidthCompare<Size> specialized(0);
+    start = microsec_clock::universal_time();
+    found = binary_search(&keys[0], kKeys, Size, lookups, specialized);
+    time_duration specialized_time = microsec_clock::universal_time() - start;
+    REQUIRE(found == kLookups);
+
+    printf("%u byte keys: FixedSizeCompare %d ms, FixedWidthCompare %d ms\n",
+                    Size, (int)generic_time.total_milliseconds(),
+                    (int)specialized_time.total_milliseconds());
+  }
+
+  template<typename Cmp>
+  static size_t binary_search(const uint8_t *keys, unsigned int count,
+                  uint32_t size, const std::vector<unsigned int> &lookups,
+                  Cmp &cmp) {
+    size_t found = 0;
+    for (size_t i = 0; i < lookups.size(); i++) {
+      const uint8_t *key = &keys[lookups[i] * size];
+      int l = 0;
+      int r = (int)count - 1;
+      while (l <= r) {
+        int m = (l + r) / 2;
+        int c = cmp(key, size, &keys[m * size], size);
+        if (c == 0) {
+          found++;
+          break;
+        }
+        if (c < 0)
+          r = m - 1;
+        else
+          l = m + 1;
+      }
+    }
+    return (found);
+  }
+
   void autoDefaultRecords() {
     ham_db_t *db;
     ham_env_t *env;
@@ -468,9 +629,46 @@ TEST_CASE("Btree/fixedBinaryType", "")
 {
   BtreeFixture f;
   f.fixedTypeTest(HAM_TYPE_BINARY, 8, 960,
+      "hamsterdb::BtreeIndexTraitsImpl<hamsterdb::PaxNodeImpl<hamsterdb::PaxLayout::BinaryKeyList, hamsterdb::PaxLayout::DefaultRecordList>, hamsterdb::FixedWidthCompare<8u> >");
+}
+
+TEST_CASE("Btree/fixedBinaryType16", "")
+{
+  BtreeFixture f;
+  f.fixedTypeTest(HAM_TYPE_BINARY, 16, 653,
+      "hamsterdb::BtreeIndexTraitsImpl<hamsterdb::PaxNodeImpl<hamsterdb::PaxLayout::BinaryKeyList, hamsterdb::PaxLayout::DefaultRecordList>, hamsterdb::FixedWidthCompare<16u> >");
+}
+
+TEST_CASE("Btree/fixedBinaryTypeGeneric", "")
+{
+  BtreeFixture f;
+  f.fixedTypeTest(HAM_TYPE_BINARY, 10, 859,
       "hamsterdb::BtreeIndexTraitsImpl<hamsterdb::PaxNodeImpl<hamsterdb::PaxLayout::BinaryKeyList, hamsterdb::PaxLayout::DefaultRecordList>, hamsterdb::FixedSizeCompare>");
 }
 
+TEST_CASE("Btree/fixedWidthCompareTest", "")
+{
+  BtreeFixture f;
+  f.fixedWidthCompareTest<8>();
+  f.fixedWidthCompareTest<16>();
+  f.fixedWidthCompareTest<20>();
+  f.fixedWidthCompareTest<32>();
+}
+
+TEST_CASE("Btree/fixedWidthKeysTest", "")
+{
+  BtreeFixture f;
+  f.fixedWidthKeysTest(20);
+  f.fixedWidthKeysTest(32);
+}
+
+TEST_CASE("./Btree/fixedWidthCompareBenchmark", "")
+{
+  BtreeFixture f;
+  f.fixedWidthCompareBenchmark<16>();
+  f.fixedWidthCompareBenchmark<32>();
+}
+
 TEST_CASE("Btree/autoDefaultRecords", "")
 {
   BtreeFixture f;
@@ -19,6 +19,8 @@
 
 #include "3rdparty/catch/catch.hpp"
 
+#include "ham/hamsterdb_ola.h"
+
 #include "utils.h"
 #include "os.hpp"
 
@@ -51,7 +53,8 @@ struct BtreeDefaultFixture {
   BtreeDefaultFixture(bool duplicates = false,
                   uint16_t key_size = HAM_KEY_SIZE_UNLIMITED,
                   uint32_t rec_size = HAM_RECORD_SIZE_UNLIMITED,
-                  uint32_t page_size = 1024 * 16)
+                  uint32_t page_size = 1024 * 16,
+                  int key_compression = HAM_COMPRESSOR_NONE)
     : m_db(0), m_env(0), m_key_size(key_size), m_rec_size(rec_size),
       m_duplicates(duplicates) {
     os::unlink(Utils::opath(".test"));
@@ -65,6 +68,7 @@ struct BtreeDefaultFixture {
       { HAM_PARAM_KEY_SIZE, key_size },
       { HAM_PARAM_KEY_TYPE, type },
       { HAM_PARAM_RECORD_SIZE, rec_size },
+      { HAM_PARAM_KEY_COMPRESSION, (uint64_t)key_compression },
       { 0, 0 }
     };
     REQUIRE(0 ==
@@ -632,6 +636,1023 @@ TEST_CASE("BtreeDefault/fixedRecordsWithDuplicatesTest", "")
   f.eraseCursorTest(ivec);
 }
 
+TEST_CASE("BtreeDefault/Prefix/randomEraseMergeTest", "")
+{
+  BtreeDefaultFixture::IntVector ivec;
+  for (int i = 0; i < 10000; i++)
+    ivec.push_back(i);
+  std::srand(0); // make this reproducable
+  std::random_shuffle(ivec.begin(), ivec.end());
+
+  BtreeDefaultFixture f(false, HAM_KEY_SIZE_UNLIMITED,
+                  HAM_RECORD_SIZE_UNLIMITED, 1024 * 16, HAM_COMPRESSOR_PREFIX);
+
+#ifdef HAVE_GCC_ABI_DEMANGLE
+  // do not run the next test if this is an evaluation version, because
+  // eval-versions have obfuscated symbol names
+  if (ham_is_pro_evaluation() == 0) {
+    std::string abi;
+    abi = ((LocalDatabase *)f.m_db)->btree_index()->test_get_classname();
+    REQUIRE(abi == "hamsterdb::BtreeIndexTraitsImpl<hamsterdb::DefaultNodeImpl<hamsterdb::DefLayout::PrefixCompressedKeyList, hamsterdb::PaxLayout::DefaultRecordList>, hamsterdb::VariableSizeCompare>");
+  }
+#endif
+
+  f.insertSplitTest(ivec, true, false);
+  f.eraseCursorTest(ivec);
+}
+
+TEST_CASE("BtreeDefault/Prefix/randomEraseMergeDuplicateTest", "")
+{
+  BtreeDefaultFixture::IntVector ivec;
+  for (int i = 0; i < 10000; i++) {
+    ivec.push_back(i);
+    ivec.push_back(i);
+    ivec.push_back(i);
+  }
+  std::srand(0); // make this reproducable
+  std::random_shuffle(ivec.begin(), ivec.end());
+
+  BtreeDefaultFixture f(true, HAM_KEY_SIZE_UNLIMITED,
+                  HAM_RECORD_SIZE_UNLIMITED, 1024 * 16, HAM_COMPRESSOR_PREFIX);
+  f.insertSplitTest(ivec, true, false);
+  f.eraseCursorTest(ivec);
+}
+
+TEST_CASE("BtreeDefault/Prefix/eraseRandomExtendedKeySplitTest", "")
+{
+  BtreeDefaultFixture::IntVector ivec;
+  for (int i = 0; i < 1000; i++)
+    ivec.push_back(i);
+  std::srand(0); // make this reproducable
+  std::random_shuffle(ivec.begin(), ivec.end());
+
+  BtreeDefaultFixture f(false, HAM_KEY_SIZE_UNLIMITED,
+                  HAM_RECORD_SIZE_UNLIMITED, 1024 * 16, HAM_COMPRESSOR_PREFIX);
+  f.insertExtendedTest(ivec);
+  f.eraseExtendedTest(ivec);
+}
+
+struct PrefixCompressionFixture
+{
+  ham_db_t *m_db;
+  ham_env_t *m_env;
+
+  PrefixCompressionFixture(uint32_t page_size = 1024 * 16)
+    : m_db(0), m_env(0) {
+    os::unlink(Utils::opath(".test"));
+    ham_parameter_t p1[] = {
+      { HAM_PARAM_PAGESIZE, page_size },
+      { 0, 0 }
+    };
+    REQUIRE(0 ==
+        ham_env_create(&m_env, Utils::opath(".test"), 0, 0644, &p1[0]));
+    REQUIRE(0 == ham_env_create_db(m_env, &m_db, 1, 0, &s_params[0]));
+  }
+
+  ~PrefixCompressionFixture() {
+    if (m_env)
+      REQUIRE(0 == ham_env_close(m_env, HAM_AUTO_CLEANUP));
+  }
+
+  void reopen() {
+    REQUIRE(0 == ham_env_close(m_env, HAM_AUTO_CLEANUP));
+    REQUIRE(0 == ham_env_open(&m_env, Utils::opath(".test"), 0, 0));
+    REQUIRE(0 == ham_env_open_db(m_env, &m_db, 1, 0, 0));
+  }
+
+  // URL-like keys; they share long prefixes, and the number in the middle
+  // makes sure that the suffixes differ
+  ham_key_t makeKey(int i, char *buffer) {
+    sprintf(buffer, "http://www.example.com/articles/%08d/index%d.html",
+                    i, i % 7);
+    ham_key_t key = ham_make_key(buffer, (uint16_t)(strlen(buffer) + 1));
+    return (key);
+  }
+
+  void insert(const BtreeDefaultFixture::IntVector &inserts) {
+    char buffer[128];
+    for (size_t i = 0; i < inserts.size(); i++) {
+      int value = inserts[i];
+      ham_key_t key = makeKey(value, buffer);
+      ham_record_t rec = ham_make_record(&value, sizeof(value));
+      REQUIRE(0 == ham_db_insert(m_db, 0, &key, &rec, 0));
+    }
+  }
+
+  void find(const BtreeDefaultFixture::IntVector &keys, bool exists) {
+    char buffer[128];
+    for (size_t i = 0; i < keys.size(); i++) {
+      ham_key_t key = makeKey(keys[i], buffer);
+      ham_record_t rec = {0};
+      if (!exists) {
+        REQUIRE(HAM_KEY_NOT_FOUND == ham_db_find(m_db, 0, &key, &rec, 0));
+        continue;
+      }
+      REQUIRE(0 == ham_db_find(m_db, 0, &key, &rec, 0));
+      REQUIRE(rec.size == sizeof(int));
+      REQUIRE(*(int *)rec.data == keys[i]);
+    }
+  }
+
+  void erase(const BtreeDefaultFixture::IntVector &keys) {
+    char buffer[128];
+    for (size_t i = 0; i < keys.size(); i++) {
+      ham_key_t key = makeKey(keys[i], buffer);
+      REQUIRE(0 == ham_db_erase(m_db, 0, &key, 0));
+    }
+  }
+
+  // Walks the database with a cursor and compares all keys against the
+  // (sorted) |expected| keys
+  void checkCursor(BtreeDefaultFixture::IntVector expected) {
+    std::vector<std::string> strings;
+    char buffer[128];
+    for (size_t i = 0; i < expected.size(); i++) {
+      makeKey(expected[i], buffer);
+      strings.push_back(buffer);
+    }
+    std::sort(strings.begin(), strings.end());
+
+    ham_cursor_t *cursor;
+    ham_key_t key = {0};
+    REQUIRE(0 == ham_cursor_create(&cursor, m_db, 0, 0));
+    for (size_t i = 0; i < strings.size(); i++) {
+      REQUIRE(0 == ham_cursor_move(cursor, &key, 0, HAM_CURSOR_NEXT));
+      REQUIRE(strings[i] == (const char *)key.data);
+    }
+    REQUIRE(HAM_KEY_NOT_FOUND
+                == ham_cursor_move(cursor, &key, 0, HAM_CURSOR_NEXT));
+    REQUIRE(0 == ham_cursor_close(cursor));
+  }
+
+  void insertFindEraseTest(bool random) {
+    BtreeDefaultFixture::IntVector ivec;
+    for (int i = 0; i < 20000; i++)
+      ivec.push_back(i);
+    if (random) {
+      std::srand(0); // make this reproducable
+      std::random_shuffle(ivec.begin(), ivec.end());
+    }
+
+    insert(ivec);
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+    find(ivec, true);
+    checkCursor(ivec);
+
+    // erase every other key
+    BtreeDefaultFixture::IntVector erased, remaining;
+    for (size_t i = 0; i < ivec.size(); i++) {
+      if (ivec[i] % 2)
+        erased.push_back(ivec[i]);
+      else
+        remaining.push_back(ivec[i]);
+    }
+    erase(erased);
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+    find(erased, false);
+    find(remaining, true);
+
+    // the compression is persistent
+    reopen();
+    ham_parameter_t params[] = {
+      { HAM_PARAM_KEY_COMPRESSION, 0 },
+      { 0, 0 }
+    };
+    REQUIRE(0 == ham_db_get_parameters(m_db, &params[0]));
+    REQUIRE(HAM_COMPRESSOR_PREFIX == params[0].value);
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+    find(remaining, true);
+    checkCursor(remaining);
+
+    // now erase everything
+    erase(remaining);
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+    checkCursor(BtreeDefaultFixture::IntVector());
+  }
+
+  void approxMatchTest() {
+    BtreeDefaultFixture::IntVector ivec;
+    for (int i = 0; i < 10000; i += 2)
+      ivec.push_back(i);
+    insert(ivec);
+
+    char buffer[128];
+    char expected[128];
+    for (int i = 1; i < 9999; i += 2) {
+      ham_key_t key = makeKey(i, buffer);
+      ham_record_t rec = {0};
+      REQUIRE(0 == ham_db_find(m_db, 0, &key, &rec, HAM_FIND_GT_MATCH));
+      makeKey(*(int *)rec.data, expected);
+      REQUIRE(0 == strcmp(expected, (const char *)key.data));
+      REQUIRE(1 == ham_key_get_approximate_match_type(&key));
+    }
+  }
+
+  // Keys which do not share a prefix with their neighbours are stored
+  // uncompressed
+  void mixedKeysTest() {
+    char buffer[128];
+    for (int i = 0; i < 10000; i++) {
+      if (i % 3)
+        makeKey(i, buffer);
+      else
+        sprintf(buffer, "%d", i);
+      ham_key_t key = ham_make_key(buffer, (uint16_t)(strlen(buffer) + 1));
+      ham_record_t rec = ham_make_record(&i, sizeof(i));
+      REQUIRE(0 == ham_db_insert(m_db, 0, &key, &rec, 0));
+    }
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+
+    for (int i = 0; i < 10000; i++) {
+      if (i % 3)
+        makeKey(i, buffer);
+      else
+        sprintf(buffer, "%d", i);
+      ham_key_t key = ham_make_key(buffer, (uint16_t)(strlen(buffer) + 1));
+      ham_record_t rec = {0};
+      REQUIRE(0 == ham_db_find(m_db, 0, &key, &rec, 0));
+      REQUIRE(*(int *)rec.data == i);
+    }
+  }
+
+  // Compressed keys require less pages than uncompressed keys
+  void fanoutTest() {
+    ham_db_t *db;
+    ham_parameter_t params[] = {
+      { HAM_PARAM_KEY_COMPRESSION, HAM_COMPRESSOR_NONE },
+      { 0, 0 }
+    };
+    REQUIRE(0 == ham_env_create_db(m_env, &db, 2, 0, &params[0]));
+
+    char buffer[128];
+    for (int i = 0; i < 20000; i++) {
+      ham_key_t key = makeKey(i, buffer);
+      ham_record_t rec = {0};
+      REQUIRE(0 == ham_db_insert(m_db, 0, &key, &rec, 0));
+      REQUIRE(0 == ham_db_insert(db, 0, &key, &rec, 0));
+    }
+
+    ham_env_metrics_t metrics = {0};
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+    ((LocalDatabase *)m_db)->fill_metrics(&metrics);
+    uint64_t compressed_pages = metrics.btree_leaf_metrics.number_of_pages;
+    memset(&metrics, 0, sizeof(metrics));
+    ((LocalDatabase *)db)->fill_metrics(&metrics);
+    uint64_t uncompressed_pages = metrics.btree_leaf_metrics.number_of_pages;
+    bool fewer_pages = compressed_pages * 3 < uncompressed_pages * 2;
+    REQUIRE(fewer_pages == true);
+  }
+
+  static ham_parameter_t s_params[];
+};
+
+ham_parameter_t PrefixCompressionFixture::s_params[] = {
+  { HAM_PARAM_KEY_COMPRESSION, HAM_COMPRESSOR_PREFIX },
+  { 0, 0 }
+};
+
+TEST_CASE("BtreeDefault/Prefix/insertFindEraseTest", "")
+{
+  PrefixCompressionFixture f;
+  f.insertFindEraseTest(false);
+}
+
+TEST_CASE("BtreeDefault/Prefix/randomInsertFindEraseTest", "")
+{
+  PrefixCompressionFixture f;
+  f.insertFindEraseTest(true);
+}
+
+TEST_CASE("BtreeDefault/Prefix/randomInsertFindErase1kTest", "")
+{
+  PrefixCompressionFixture f(1024);
+  f.insertFindEraseTest(true);
+}
+
+TEST_CASE("BtreeDefault/Prefix/approxMatchTest", "")
+{
+  PrefixCompressionFixture f;
+  f.approxMatchTest();
+}
+
+TEST_CASE("BtreeDefault/Prefix/mixedKeysTest", "")
+{
+  PrefixCompressionFixture f;
+  f.mixedKeysTest();
+}
+
+TEST_CASE("BtreeDefault/Prefix/fanoutTest", "")
+{
+  PrefixCompressionFixture f;
+  f.fanoutTest();
+}
+
+TEST_CASE("BtreeDefault/Prefix/invalidParametersTest", "")
+{
+  ham_env_t *env;
+  ham_db_t *db;
+  os::unlink(Utils::opath(".test"));
+  REQUIRE(0 == ham_env_create(&env, Utils::opath(".test"), 0, 0644, 0));
+
+  // only variable length binary keys are supported
+  ham_parameter_t p1[] = {
+    { HAM_PARAM_KEY_TYPE, HAM_TYPE_UINT32 },
+    { HAM_PARAM_KEY_COMPRESSION, HAM_COMPRESSOR_PREFIX },
+    { 0, 0 }
+  };
+  REQUIRE(HAM_INV_PARAMETER == ham_env_create_db(env, &db, 1, 0, &p1[0]));
+  ham_parameter_t p2[] = {
+    { HAM_PARAM_KEY_SIZE, 16 },
+    { HAM_PARAM_KEY_COMPRESSION, HAM_COMPRESSOR_PREFIX },
+    { 0, 0 }
+  };
+  REQUIRE(HAM_INV_PARAMETER == ham_env_create_db(env, &db, 1, 0, &p2[0]));
+
+  // the other algorithms are not available
+  ham_parameter_t p3[] = {
+    { HAM_PARAM_KEY_COMPRESSION, HAM_COMPRESSOR_ZLIB },
+    { 0, 0 }
+  };
+  REQUIRE(HAM_NOT_IMPLEMENTED == ham_env_create_db(env, &db, 1, 0, &p3[0]));
+
+  // compression cannot be changed when the database is opened
+  REQUIRE(0 == ham_env_create_db(env, &db, 1, 0,
+                          &PrefixCompressionFixture::s_params[0]));
+  REQUIRE(0 == ham_db_close(db, 0));
+  REQUIRE(HAM_INV_PARAMETER == ham_env_open_db(env, &db, 1, 0,
+                          &PrefixCompressionFixture::s_params[0]));
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+}
+
+struct ForCompressionFixture
+{
+  ham_db_t *m_db;
+  ham_env_t *m_env;
+  int m_key_type;
+
+  ForCompressionFixture(int key_type, uint32_t page_size = 1024 * 16,
+                  uint32_t flags = 0)
+    : m_db(0), m_env(0), m_key_type(key_type) {
+    os::unlink(Utils::opath(".test"));
+    ham_parameter_t p1[] = {
+      { HAM_PARAM_PAGESIZE, page_size },
+      { 0, 0 }
+    };
+    ham_parameter_t p2[] = {
+      { HAM_PARAM_KEY_TYPE, (uint64_t)key_type },
+      { HAM_PARAM_KEY_COMPRESSION, HAM_COMPRESSOR_FOR },
+      { 0, 0 }
+    };
+    REQUIRE(0 ==
+        ham_env_create(&m_env, Utils::opath(".test"), 0, 0644, &p1[0]));
+    REQUIRE(0 == ham_env_create_db(m_env, &m_db, 1, flags, &p2[0]));
+  }
+
+  ~ForCompressionFixture() {
+    if (m_env)
+      REQUIRE(0 == ham_env_close(m_env, HAM_AUTO_CLEANUP));
+  }
+
+  void reopen() {
+    REQUIRE(0 == ham_env_close(m_env, HAM_AUTO_CLEANUP));
+    REQUIRE(0 == ham_env_open(&m_env, Utils::opath(".test"), 0, 0));
+    REQUIRE(0 == ham_env_open_db(m_env, &m_db, 1, 0, 0));
+  }
+
+  // Creates a key; |buffer| must have room for a uint64_t
+  ham_key_t makeKey(uint64_t value, void *buffer) {
+    ham_key_t key = ham_make_key(buffer, sizeof(uint64_t));
+    if (m_key_type == HAM_TYPE_UINT32) {
+      *(uint32_t *)buffer = (uint32_t)value;
+      key.size = sizeof(uint32_t);
+    }
+    else
+      *(uint64_t *)buffer = value;
+    return (key);
+  }
+
+  // Returns the value of a key
+  uint64_t getValue(const ham_key_t *key) {
+    if (m_key_type == HAM_TYPE_UINT32) {
+      REQUIRE(key->size == sizeof(uint32_t));
+      return (*(uint32_t *)key->data);
+    }
+    REQUIRE(key->size == sizeof(uint64_t));
+    return (*(uint64_t *)key->data);
+  }
+
+  void insert(const std::vector<uint64_t> &inserts) {
+    uint64_t buffer;
+    for (size_t i = 0; i < inserts.size(); i++) {
+      uint64_t value = inserts[i];
+      ham_key_t key = makeKey(value, &buffer);
+      ham_record_t rec = ham_make_record(&value, sizeof(value));
+      REQUIRE(0 == ham_db_insert(m_db, 0, &key, &rec, 0));
+    }
+  }
+
+  void find(const std::vector<uint64_t> &keys, bool exists) {
+    uint64_t buffer;
+    for (size_t i = 0; i < keys.size(); i++) {
+      ham_key_t key = makeKey(keys[i], &buffer);
+      ham_record_t rec = {0};
+      if (!exists) {
+        REQUIRE(HAM_KEY_NOT_FOUND == ham_db_find(m_db, 0, &key, &rec, 0));
+        continue;
+      }
+      REQUIRE(0 == ham_db_find(m_db, 0, &key, &rec, 0));
+      REQUIRE(rec.size == sizeof(uint64_t));
+      REQUIRE(*(uint64_t *)rec.data == keys[i]);
+    }
+  }
+
+  void erase(const std::vector<uint64_t> &keys) {
+    uint64_t buffer;
+    for (size_t i = 0; i < keys.size(); i++) {
+      ham_key_t key = makeKey(keys[i], &buffer);
+      REQUIRE(0 == ham_db_erase(m_db, 0, &key, 0));
+    }
+  }
+
+  // Walks the database with a cursor and compares all keys against the
+  // |expected| keys
+  void checkCursor(std::vector<uint64_t> expected) {
+    std::sort(expected.begin(), expected.end());
+
+    ham_cursor_t *cursor;
+    ham_key_t key = {0};
+    REQUIRE(0 == ham_cursor_create(&cursor, m_db, 0, 0));
+    for (size_t i = 0; i < expected.size(); i++) {
+      REQUIRE(0 == ham_cursor_move(cursor, &key, 0, HAM_CURSOR_NEXT));
+      uint64_t value = getValue(&key);
+      REQUIRE(expected[i] == value);
+    }
+    REQUIRE(HAM_KEY_NOT_FOUND
+                == ham_cursor_move(cursor, &key, 0, HAM_CURSOR_NEXT));
+    REQUIRE(0 == ham_cursor_close(cursor));
+  }
+
+  // Creates |count| keys; |step| is the distance between two keys
+  std::vector<uint64_t> makeKeys(int count, uint64_t step, bool random) {
+    std::vector<uint64_t> keys;
+    for (int i = 0; i < count; i++)
+      keys.push_back(1 + i * step);
+    if (random) {
+      std::srand(0); // make this reproducable
+      std::random_shuffle(keys.begin(), keys.end());
+    }
+    return (keys);
+  }
+
+  void insertFindEraseTest(int count, uint64_t step, bool random) {
+    std::vector<uint64_t> keys = makeKeys(count, step, random);
+
+    insert(keys);
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+    find(keys, true);
+    checkCursor(keys);
+
+    // erase every other key
+    std::vector<uint64_t> erased, remaining;
+    for (size_t i = 0; i < keys.size(); i++) {
+      if (i % 2)
+        erased.push_back(keys[i]);
+      else
+        remaining.push_back(keys[i]);
+    }
+    erase(erased);
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+    find(erased, false);
+    find(remaining, true);
+
+    // the compression is persistent
+    reopen();
+    ham_parameter_t params[] = {
+      { HAM_PARAM_KEY_COMPRESSION, 0 },
+      { 0, 0 }
+    };
+    REQUIRE(0 == ham_db_get_parameters(m_db, &params[0]));
+    REQUIRE(HAM_COMPRESSOR_FOR == params[0].value);
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+    find(remaining, true);
+    checkCursor(remaining);
+
+    // re-insert the erased keys
+    insert(erased);
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+    find(keys, true);
+
+    // now erase everything
+    erase(keys);
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+    checkCursor(std::vector<uint64_t>());
+  }
+
+  void approxMatchTest() {
+    std::vector<uint64_t> keys = makeKeys(5000, 10, false);
+    insert(keys);
+
+    uint64_t buffer;
+    for (uint64_t i = 5; i < 49990; i += 10) {
+      ham_key_t key = makeKey(i, &buffer);
+      ham_record_t rec = {0};
+      REQUIRE(0 == ham_db_find(m_db, 0, &key, &rec, HAM_FIND_GT_MATCH));
+      uint64_t value = getValue(&key);
+      REQUIRE(value == i + 6);
+      REQUIRE(1 == ham_key_get_approximate_match_type(&key));
+
+      key = makeKey(i, &buffer);
+      REQUIRE(0 == ham_db_find(m_db, 0, &key, &rec, HAM_FIND_LT_MATCH));
+      value = getValue(&key);
+      REQUIRE(value == i - 4);
+      REQUIRE(-1 == ham_key_get_approximate_match_type(&key));
+    }
+
+    // there is no key lower than the first key
+    ham_key_t key = makeKey(0, &buffer);
+    ham_record_t rec = {0};
+    REQUIRE(HAM_KEY_NOT_FOUND
+                == ham_db_find(m_db, 0, &key, &rec, HAM_FIND_LT_MATCH));
+  }
+
+  // hola uses the scan() method of the KeyList
+  void scanTest() {
+    std::vector<uint64_t> keys = makeKeys(20000, 3, true);
+    insert(keys);
+
+    uint64_t sum = 0;
+    for (size_t i = 0; i < keys.size(); i++)
+      sum += keys[i];
+
+    hola_result_t result;
+    REQUIRE(0 == hola_sum(m_db, 0, &result));
+    REQUIRE(result.u.result_u64 == sum);
+  }
+
+  void duplicateTest() {
+    uint64_t buffer;
+    for (int i = 0; i < 5000; i++) {
+      ham_key_t key = makeKey(i / 5, &buffer);
+      ham_record_t rec = ham_make_record(&i, sizeof(i));
+      REQUIRE(0 == ham_db_insert(m_db, 0, &key, &rec, HAM_DUPLICATE));
+    }
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+
+    uint64_t count;
+    REQUIRE(0 == ham_db_get_key_count(m_db, 0, 0, &count));
+    REQUIRE(count == 5000);
+    REQUIRE(0 == ham_db_get_key_count(m_db, 0, HAM_SKIP_DUPLICATES, &count));
+    REQUIRE(count == 1000);
+  }
+
+  // Sequential keys require less pages than uncompressed keys. The
+  // records are empty, therefore the leafs only store keys.
+  void fanoutTest() {
+    ham_db_t *db1, *db2;
+    ham_parameter_t p1[] = {
+      { HAM_PARAM_KEY_TYPE, (uint64_t)m_key_type },
+      { HAM_PARAM_KEY_COMPRESSION, HAM_COMPRESSOR_FOR },
+      { HAM_PARAM_RECORD_SIZE, 0 },
+      { 0, 0 }
+    };
+    ham_parameter_t p2[] = {
+      { HAM_PARAM_KEY_TYPE, (uint64_t)m_key_type },
+      { HAM_PARAM_RECORD_SIZE, 0 },
+      { 0, 0 }
+    };
+    REQUIRE(0 == ham_env_create_db(m_env, &db1, 2, 0, &p1[0]));
+    REQUIRE(0 == ham_env_create_db(m_env, &db2, 3, 0, &p2[0]));
+
+    uint64_t buffer;
+    for (int i = 0; i < 50000; i++) {
+      ham_key_t key = makeKey(1000000 + i * 7, &buffer);
+      ham_record_t rec = {0};
+      REQUIRE(0 == ham_db_insert(db1, 0, &key, &rec, 0));
+      REQUIRE(0 == ham_db_insert(db2, 0, &key, &rec, 0));
+    }
+
+    ham_env_metrics_t metrics = {0};
+    REQUIRE(0 == ham_db_check_integrity(db1, 0));
+    ((LocalDatabase *)db1)->fill_metrics(&metrics);
+    uint64_t compressed_pages = metrics.btree_leaf_metrics.number_of_pages;
+    memset(&metrics, 0, sizeof(metrics));
+    ((LocalDatabase *)db2)->fill_metrics(&metrics);
+    uint64_t uncompressed_pages = metrics.btree_leaf_metrics.number_of_pages;
+    bool fewer_pages = compressed_pages * 2 < uncompressed_pages;
+    REQUIRE(fewer_pages == true);
+  }
+};
+
+TEST_CASE("BtreeDefault/For/insertFindErase32Test", "")
+{
+  ForCompressionFixture f(HAM_TYPE_UINT32);
+  f.insertFindEraseTest(20000, 1, false);
+}
+
+TEST_CASE("BtreeDefault/For/randomInsertFindErase32Test", "")
+{
+  ForCompressionFixture f(HAM_TYPE_UINT32);
+  f.insertFindEraseTest(20000, 13, true);
+}
+
+TEST_CASE("BtreeDefault/For/randomInsertFindErase64Test", "")
+{
+  ForCompressionFixture f(HAM_TYPE_UINT64);
+  f.insertFindEraseTest(20000, 1000003, true);
+}
+
+TEST_CASE("BtreeDefault/For/sparseKeys64Test", "")
+{
+  ForCompressionFixture f(HAM_TYPE_UINT64);
+  f.insertFindEraseTest(5000, 0x0fffffffffffffffull / 5000, true);
+}
+
+TEST_CASE("BtreeDefault/For/randomInsertFindErase1kTest", "")
+{
+  ForCompressionFixture f(HAM_TYPE_UINT64, 1024);
+  f.insertFindEraseTest(10000, 100, true);
+}
+
+TEST_CASE("BtreeDefault/For/approxMatchTest", "")
+{
+  ForCompressionFixture f(HAM_TYPE_UINT32);
+  f.approxMatchTest();
+}
+
+TEST_CASE("BtreeDefault/For/scanTest", "")
+{
+  ForCompressionFixture f(HAM_TYPE_UINT32);
+  f.scanTest();
+}
+
+TEST_CASE("BtreeDefault/For/duplicateTest", "")
+{
+  ForCompressionFixture f(HAM_TYPE_UINT64, 1024 * 16, HAM_ENABLE_DUPLICATES);
+  f.duplicateTest();
+}
+
+TEST_CASE("BtreeDefault/For/fanout32Test", "")
+{
+  ForCompressionFixture f(HAM_TYPE_UINT32);
+  f.fanoutTest();
+}
+
+TEST_CASE("BtreeDefault/For/fanout64Test", "")
+{
+  ForCompressionFixture f(HAM_TYPE_UINT64);
+  f.fanoutTest();
+}
+
+TEST_CASE("BtreeDefault/For/recordNumberTest", "")
+{
+  ham_env_t *env;
+  ham_db_t *db;
+  os::unlink(Utils::opath(".test"));
+  REQUIRE(0 == ham_env_create(&env, Utils::opath(".test"), 0, 0644, 0));
+  ham_parameter_t params[] = {
+    { HAM_PARAM_KEY_COMPRESSION, HAM_COMPRESSOR_FOR },
+    { 0, 0 }
+  };
+  REQUIRE(0 == ham_env_create_db(env, &db, 1, HAM_RECORD_NUMBER64,
+                          &params[0]));
+
+  for (uint64_t i = 1; i <= 10000; i++) {
+    uint64_t recno;
+    ham_key_t key = ham_make_key(&recno, sizeof(recno));
+    key.flags = HAM_KEY_USER_ALLOC;
+    ham_record_t rec = ham_make_record(&i, sizeof(i));
+    REQUIRE(0 == ham_db_insert(db, 0, &key, &rec, 0));
+    REQUIRE(recno == i);
+  }
+  REQUIRE(0 == ham_db_check_integrity(db, 0));
+
+  for (uint64_t i = 1; i <= 10000; i++) {
+    ham_key_t key = ham_make_key(&i, sizeof(i));
+    ham_record_t rec = {0};
+    REQUIRE(0 == ham_db_find(db, 0, &key, &rec, 0));
+    REQUIRE(*(uint64_t *)rec.data == i);
+  }
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+}
+
+TEST_CASE("BtreeDefault/For/invalidParametersTest", "")
+{
+  ham_env_t *env;
+  ham_db_t *db;
+  os::unlink(Utils::opath(".test"));
+  REQUIRE(0 == ham_env_create(&env, Utils::opath(".test"), 0, 0644, 0));
+
+  // only uint32 and uint64 keys are supported
+  ham_parameter_t p1[] = {
+    { HAM_PARAM_KEY_COMPRESSION, HAM_COMPRESSOR_FOR },
+    { 0, 0 }
+  };
+  REQUIRE(HAM_INV_PARAMETER == ham_env_create_db(env, &db, 1, 0, &p1[0]));
+  ham_parameter_t p2[] = {
+    { HAM_PARAM_KEY_TYPE, HAM_TYPE_UINT16 },
+    { HAM_PARAM_KEY_COMPRESSION, HAM_COMPRESSOR_FOR },
+    { 0, 0 }
+  };
+  REQUIRE(HAM_INV_PARAMETER == ham_env_create_db(env, &db, 1, 0, &p2[0]));
+  ham_parameter_t p3[] = {
+    { HAM_PARAM_KEY_TYPE, HAM_TYPE_REAL64 },
+    { HAM_PARAM_KEY_COMPRESSION, HAM_COMPRESSOR_FOR },
+    { 0, 0 }
+  };
+  REQUIRE(HAM_INV_PARAMETER == ham_env_create_db(env, &db, 1, 0, &p3[0]));
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+}
+
+struct InlineRecordFixture
+{
+  ham_db_t *m_db;
+  ham_env_t *m_env;
+
+  InlineRecordFixture(uint64_t key_type = HAM_TYPE_UINT32,
+                  uint64_t threshold = 200)
+    : m_db(0), m_env(0) {
+    os::unlink(Utils::opath(".test"));
+    REQUIRE(0 == ham_env_create(&m_env, Utils::opath(".test"), 0, 0644, 0));
+    ham_parameter_t params[] = {
+      { HAM_PARAM_KEY_TYPE, key_type },
+      { HAM_PARAM_INLINE_RECORD_THRESHOLD, threshold },
+      { 0, 0 }
+    };
+    REQUIRE(0 == ham_env_create_db(m_env, &m_db, 1, 0, &params[0]));
+  }
+
+  ~InlineRecordFixture() {
+    if (m_env)
+      REQUIRE(0 == ham_env_close(m_env, HAM_AUTO_CLEANUP));
+  }
+
+  void reopen() {
+    REQUIRE(0 == ham_env_close(m_env, HAM_AUTO_CLEANUP));
+    REQUIRE(0 == ham_env_open(&m_env, Utils::opath(".test"), 0, 0));
+    REQUIRE(0 == ham_env_open_db(m_env, &m_db, 1, 0, 0));
+  }
+
+  // Fills |buffer| with the record data of key |i|
+  static ham_record_t makeRecord(uint32_t i, uint32_t size,
+                  std::vector<uint8_t> &buffer) {
+    buffer.resize(size + 1);
+    for (uint32_t j = 0; j < size; j++)
+      buffer[j] = (uint8_t)(i + j);
+    ham_record_t rec = ham_make_record(&buffer[0], size);
+    return (rec);
+  }
+
+  void insert(uint32_t i, uint32_t size, uint32_t flags = 0) {
+    std::vector<uint8_t> buffer;
+    ham_key_t key = ham_make_key(&i, sizeof(i));
+    ham_record_t rec = makeRecord(i, size, buffer);
+    REQUIRE(0 == ham_db_insert(m_db, 0, &key, &rec, flags));
+  }
+
+  void find(uint32_t i, uint32_t size) {
+    std::vector<uint8_t> buffer;
+    ham_key_t key = ham_make_key(&i, sizeof(i));
+    ham_record_t expected = makeRecord(i, size, buffer);
+    ham_record_t rec = {0};
+    REQUIRE(0 == ham_db_find(m_db, 0, &key, &rec, 0));
+    REQUIRE(rec.size == expected.size);
+    if (size)
+      REQUIRE(0 == memcmp(rec.data, expected.data, size));
+  }
+
+  uint64_t getBlobCount() {
+    ham_env_metrics_t metrics = {0};
+    REQUIRE(0 == ham_env_get_metrics(m_env, &metrics));
+    return (metrics.blob_total_allocated);
+  }
+
+  static uint32_t getSize(uint32_t i, int generation) {
+    return ((i * (generation ? 53 : 37)) % 300);
+  }
+
+  void insertFindEraseTest() {
+    const uint32_t kCount = 20000;
+    for (uint32_t i = 0; i < kCount; i++)
+      insert(i, getSize(i, 0));
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+    for (uint32_t i = 0; i < kCount; i++)
+      find(i, getSize(i, 0));
+
+    // overwrite every third record with a different size; this moves
+    // records from the leaf to blobs and vice versa
+    for (uint32_t i = 0; i < kCount; i += 3)
+      insert(i, getSize(i, 1), HAM_OVERWRITE);
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+    for (uint32_t i = 0; i < kCount; i++)
+      find(i, getSize(i, i % 3 == 0 ? 1 : 0));
+
+    // erase every other key
+    for (uint32_t i = 0; i < kCount; i += 2) {
+      ham_key_t key = ham_make_key(&i, sizeof(i));
+      REQUIRE(0 == ham_db_erase(m_db, 0, &key, 0));
+    }
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+
+    // the threshold is persistent
+    reopen();
+    ham_parameter_t params[] = {
+      { HAM_PARAM_INLINE_RECORD_THRESHOLD, 0 },
+      { 0, 0 }
+    };
+    REQUIRE(0 == ham_db_get_parameters(m_db, &params[0]));
+    REQUIRE(200u == params[0].value);
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+
+    for (uint32_t i = 0; i < kCount; i++) {
+      if (i % 2 == 0) {
+        ham_key_t key = ham_make_key(&i, sizeof(i));
+        ham_record_t rec = {0};
+        REQUIRE(HAM_KEY_NOT_FOUND == ham_db_find(m_db, 0, &key, &rec, 0));
+      }
+      else
+        find(i, getSize(i, i % 3 == 0 ? 1 : 0));
+    }
+
+    // now erase everything
+    for (uint32_t i = 1; i < kCount; i += 2) {
+      ham_key_t key = ham_make_key(&i, sizeof(i));
+      REQUIRE(0 == ham_db_erase(m_db, 0, &key, 0));
+    }
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+    uint64_t keys = 1;
+    REQUIRE(0 == ham_db_get_key_count(m_db, 0, 0, &keys));
+    REQUIRE(0u == keys);
+  }
+
+  // Records up to the threshold do not allocate blobs
+  void blobTest() {
+    for (uint32_t i = 0; i < 10000; i++)
+      insert(i, 16 + i % 185);
+    REQUIRE(0u == getBlobCount());
+
+    for (uint32_t i = 10000; i < 10100; i++)
+      insert(i, 201);
+    REQUIRE(100u == getBlobCount());
+
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+    for (uint32_t i = 0; i < 10000; i++)
+      find(i, 16 + i % 185);
+    for (uint32_t i = 10000; i < 10100; i++)
+      find(i, 201);
+  }
+
+  void partialTest() {
+    uint32_t i = 1;
+    insert(i, 100);
+
+    // partial read of an inline record
+    ham_key_t key = ham_make_key(&i, sizeof(i));
+    ham_record_t rec = {0};
+    rec.partial_offset = 10;
+    rec.partial_size = 20;
+    REQUIRE(0 == ham_db_find(m_db, 0, &key, &rec, HAM_PARTIAL));
+    REQUIRE(100u == rec.size);
+    REQUIRE(20u == rec.partial_size);
+    for (uint32_t j = 0; j < 20; j++)
+      REQUIRE((uint8_t)(i + 10 + j) == ((uint8_t *)rec.data)[j]);
+
+    // partial write of an inline record
+    std::vector<uint8_t> expected;
+    makeRecord(i, 100, expected);
+    uint8_t patch[10];
+    memset(patch, 0xff, sizeof(patch));
+    memcpy(&expected[50], patch, sizeof(patch));
+    rec = ham_make_record(patch, 100);
+    rec.partial_offset = 50;
+    rec.partial_size = sizeof(patch);
+    REQUIRE(0 == ham_db_insert(m_db, 0, &key, &rec,
+                            HAM_OVERWRITE | HAM_PARTIAL));
+    memset(&rec, 0, sizeof(rec));
+    REQUIRE(0 == ham_db_find(m_db, 0, &key, &rec, 0));
+    REQUIRE(100u == rec.size);
+    REQUIRE(0 == memcmp(rec.data, &expected[0], 100));
+
+    // the record grows beyond the threshold and is moved to a blob
+    expected.resize(300, 0);
+    memcpy(&expected[280], patch, sizeof(patch));
+    rec = ham_make_record(patch, 300);
+    rec.partial_offset = 280;
+    rec.partial_size = sizeof(patch);
+    REQUIRE(0 == ham_db_insert(m_db, 0, &key, &rec,
+                            HAM_OVERWRITE | HAM_PARTIAL));
+    REQUIRE(1u == getBlobCount());
+    memset(&rec, 0, sizeof(rec));
+    REQUIRE(0 == ham_db_find(m_db, 0, &key, &rec, 0));
+    REQUIRE(300u == rec.size);
+    REQUIRE(0 == memcmp(rec.data, &expected[0], 300));
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+  }
+};
+
+TEST_CASE("BtreeDefault/InlineRecords/insertFindEraseTest", "")
+{
+  InlineRecordFixture f;
+
+#ifdef HAVE_GCC_ABI_DEMANGLE
+  // do not run the next test if this is an evaluation version, because
+  // eval-versions have obfuscated symbol names
+  if (ham_is_pro_evaluation() == 0) {
+    std::string abi;
+    abi = ((LocalDatabase *)f.m_db)->btree_index()->test_get_classname();
+    REQUIRE(abi == "hamsterdb::BtreeIndexTraitsImpl<hamsterdb::DefaultNodeImpl<hamsterdb::PaxLayout::PodKeyList<unsigned int>, hamsterdb::DefLayout::VariableLengthRecordList>, hamsterdb::NumericCompare<unsigned int> >");
+  }
+#endif
+
+  f.insertFindEraseTest();
+}
+
+TEST_CASE("BtreeDefault/InlineRecords/binaryKeysTest", "")
+{
+  InlineRecordFixture f(HAM_TYPE_BINARY);
+
+#ifdef HAVE_GCC_ABI_DEMANGLE
+  // do not run the next test if this is an evaluation version, because
+  // eval-versions have obfuscated symbol names
+  if (ham_is_pro_evaluation() == 0) {
+    std::string abi;
+    abi = ((LocalDatabase *)f.m_db)->btree_index()->test_get_classname();
+    REQUIRE(abi == "hamsterdb::BtreeIndexTraitsImpl<hamsterdb::DefaultNodeImpl<hamsterdb::DefLayout::VariableLengthKeyList, hamsterdb::DefLayout::VariableLengthRecordList>, hamsterdb::VariableSizeCompare>");
+  }
+#endif
+
+  f.insertFindEraseTest();
+}
+
+TEST_CASE("BtreeDefault/InlineRecords/blobTest", "")
+{
+  InlineRecordFixture f;
+  f.blobTest();
+}
+
+TEST_CASE("BtreeDefault/InlineRecords/partialTest", "")
+{
+  InlineRecordFixture f;
+  f.partialTest();
+}
+
+TEST_CASE("BtreeDefault/InlineRecords/invalidParametersTest", "")
+{
+  ham_env_t *env;
+  ham_db_t *db;
+  os::unlink(Utils::opath(".test"));
+  ham_parameter_t ep[] = {
+    { HAM_PARAM_PAGE_SIZE, 1024 },
+    { 0, 0 }
+  };
+  REQUIRE(0 == ham_env_create(&env, Utils::opath(".test"), 0, 0644, &ep[0]));
+
+  // the threshold is limited
+  ham_parameter_t p1[] = {
+    { HAM_PARAM_INLINE_RECORD_THRESHOLD, 251 },
+    { 0, 0 }
+  };
+  REQUIRE(HAM_INV_PARAMETER == ham_env_create_db(env, &db, 1, 0, &p1[0]));
+
+  // ... and must fit into the page
+  ham_parameter_t p2[] = {
+    { HAM_PARAM_INLINE_RECORD_THRESHOLD, 200 },
+    { 0, 0 }
+  };
+  REQUIRE(HAM_INV_PARAMETER == ham_env_create_db(env, &db, 1, 0, &p2[0]));
+
+  // the threshold is ignored for fixed length records and duplicates
+  ham_parameter_t p3[] = {
+    { HAM_PARAM_INLINE_RECORD_THRESHOLD, 32 },
+    { HAM_PARAM_RECORD_SIZE, 20 },
+    { 0, 0 }
+  };
+  ham_parameter_t get[] = {
+    { HAM_PARAM_INLINE_RECORD_THRESHOLD, 0 },
+    { 0, 0 }
+  };
+  REQUIRE(0 == ham_env_create_db(env, &db, 1, 0, &p3[0]));
+  REQUIRE(0 == ham_db_get_parameters(db, &get[0]));
+  REQUIRE(0u == get[0].value);
+  REQUIRE(0 == ham_env_create_db(env, &db, 2, HAM_ENABLE_DUPLICATE_KEYS,
+                          &p3[1]));
+  ham_parameter_t p4[] = {
+    { HAM_PARAM_INLINE_RECORD_THRESHOLD, 32 },
+    { 0, 0 }
+  };
+  REQUIRE(0 == ham_env_create_db(env, &db, 3, HAM_ENABLE_DUPLICATE_KEYS,
+                          &p4[0]));
+  REQUIRE(0 == ham_db_get_parameters(db, &get[0]));
+  REQUIRE(0u == get[0].value);
+
+  // the threshold cannot be changed when the database is opened
+  REQUIRE(0 == ham_env_create_db(env, &db, 4, 0, &p4[0]));
+  REQUIRE(0 == ham_db_get_parameters(db, &get[0]));
+  REQUIRE(32u == get[0].value);
+  REQUIRE(0 == ham_db_close(db, 0));
+  REQUIRE(HAM_INV_PARAMETER == ham_env_open_db(env, &db, 4, 0, &p4[0]));
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+}
+
 
 using namespace hamsterdb::DefLayout;
 
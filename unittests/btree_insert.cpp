@@ -14,6 +14,10 @@
  * limitations under the License.
  */
 
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
 #include "3rdparty/catch/catch.hpp"
 
 #include "utils.h"
@@ -22,6 +26,7 @@
 #include "2page/page.h"
 #include "3btree/btree_index.h"
 #include "3btree/btree_node.h"
+#include "3btree/btree_node_proxy.h"
 #include "3page_manager/page_manager.h"
 #include "4context/context.h"
 #include "4db/db_local.h"
@@ -178,6 +183,132 @@ struct BtreeInsertFixture {
     node = PBtreeNode::from_page(page);
     REQUIRE(1 == node->get_count());
   }
+
+  // Fills |buffer| with a 64 byte key; the keys differ in bytes 32 - 35,
+  // followed by |fill|
+  static void make_separator_key(uint32_t i, uint8_t *buffer,
+                  uint8_t fill = 'y') {
+    ::memset(buffer, 'x', 32);
+    buffer[32] = (uint8_t)(i >> 24);
+    buffer[33] = (uint8_t)(i >> 16);
+    buffer[34] = (uint8_t)(i >> 8);
+    buffer[35] = (uint8_t)i;
+    ::memset(buffer + 36, fill, 28);
+  }
+
+  // Returns the largest key size of all internal nodes
+  size_t max_separator_size(ham_db_t *db) {
+    LocalDatabase *ldb = (LocalDatabase *)db;
+    PageManager *pm = ldb->lenv()->page_manager();
+    BtreeIndex *btree = ldb->btree_index();
+    ByteArray arena;
+    ham_key_t key = {0};
+    size_t max_size = 0;
+
+    Page *page = pm->fetch(m_context.get(), btree->root_address(),
+                    PageManager::kReadOnly);
+    BtreeNodeProxy *node = btree->get_node_from_page(page);
+    while (!node->is_leaf()) {
+      uint64_t ptr_down = node->get_ptr_down();
+      while (true) {
+        for (size_t i = 0; i < node->get_count(); i++) {
+          node->get_key(m_context.get(), i, &arena, &key);
+          max_size = std::max(max_size, (size_t)key.size);
+        }
+        if (!node->get_right())
+          break;
+        page = pm->fetch(m_context.get(), node->get_right(),
+                        PageManager::kReadOnly);
+        node = btree->get_node_from_page(page);
+      }
+      page = pm->fetch(m_context.get(), ptr_down, PageManager::kReadOnly);
+      node = btree->get_node_from_page(page);
+    }
+    m_context->changeset.clear(); // unlock pages
+    return (max_size);
+  }
+
+  void separatorTruncationTest() {
+    ham_db_t *db;
+    ham_parameter_t p[] = {
+      { HAM_PARAM_KEY_TYPE, HAM_TYPE_BINARY },
+      { 0, 0 }
+    };
+    REQUIRE(0 == ham_env_create_db(m_env, &db, 2, 0, &p[0]));
+
+    const uint32_t count = 2000;
+    std::vector<uint32_t> values(count);
+    for (uint32_t i = 0; i < count; i++)
+      values[i] = i * 7;
+    for (uint32_t i = count - 1; i > 0; i--)
+      std::swap(values[i], values[(i * 31 + 17) % (i + 1)]);
+
+    uint8_t buffer[64];
+    ham_key_t key = ham_make_key(&buffer[0], sizeof(buffer));
+    ham_record_t rec = {0};
+    for (uint32_t i = 0; i < count; i++) {
+      make_separator_key(values[i], &buffer[0]);
+      REQUIRE(0 == ham_db_insert(db, 0, &key, &rec, 0));
+    }
+
+    // the separators in the internal nodes only store the differing bytes
+    // of the keys
+    size_t size = max_separator_size(db);
+    REQUIRE(size > 0);
+    REQUIRE(size <= 36);
+    REQUIRE(0 == ham_db_check_integrity(db, 0));
+
+    // all keys are found, and a cursor visits them in sorted order
+    for (uint32_t i = 0; i < count; i++) {
+      make_separator_key(i * 7, &buffer[0]);
+      REQUIRE(0 == ham_db_find(db, 0, &key, &rec, 0));
+    }
+
+    ham_cursor_t *cursor;
+    ham_key_t k = {0};
+    REQUIRE(0 == ham_cursor_create(&cursor, db, 0, 0));
+    for (uint32_t i = 0; i < count; i++) {
+      REQUIRE(0 == ham_cursor_move(cursor, &k, 0, HAM_CURSOR_NEXT));
+      make_separator_key(i * 7, &buffer[0]);
+      REQUIRE(k.size == sizeof(buffer));
+      REQUIRE(0 == ::memcmp(k.data, &buffer[0], sizeof(buffer)));
+    }
+    REQUIRE(0 == ham_cursor_close(cursor));
+
+    // insert keys which are sorted directly before the existing keys; they
+    // are greater than a separator, but less than the first key of the
+    // right page
+    for (uint32_t i = 0; i < count; i++) {
+      make_separator_key(values[i], &buffer[0], 'a');
+      REQUIRE(0 == ham_db_insert(db, 0, &key, &rec, 0));
+    }
+    REQUIRE(0 == ham_db_check_integrity(db, 0));
+    for (uint32_t i = 0; i < count; i++) {
+      make_separator_key(i * 7, &buffer[0], 'a');
+      REQUIRE(0 == ham_db_find(db, 0, &key, &rec, 0));
+    }
+
+    // keys which fall between two keys, but share a prefix with a
+    // separator, are not found
+    make_separator_key(7 * 100 + 1, &buffer[0]);
+    REQUIRE(HAM_KEY_NOT_FOUND == ham_db_find(db, 0, &key, &rec, 0));
+    make_separator_key(7 * 100, &buffer[0]);
+    buffer[63] = 'x';
+    REQUIRE(HAM_KEY_NOT_FOUND == ham_db_find(db, 0, &key, &rec, 0));
+
+    // erase every other key; the tree remains consistent
+    for (uint32_t i = 0; i < count; i += 2) {
+      make_separator_key(i * 7, &buffer[0]);
+      REQUIRE(0 == ham_db_erase(db, 0, &key, 0));
+    }
+    REQUIRE(0 == ham_db_check_integrity(db, 0));
+    for (uint32_t i = 1; i < count; i += 2) {
+      make_separator_key(i * 7, &buffer[0]);
+      REQUIRE(0 == ham_db_find(db, 0, &key, &rec, 0));
+    }
+
+    REQUIRE(0 == ham_db_close(db, 0));
+  }
 };
 
 TEST_CASE("BtreeInsert/defaultPivotTest", "")
@@ -198,3 +329,412 @@ TEST_CASE("BtreeInsert/sequentialInsertPivotTest", "")
   f.sequentialInsertPivotTest();
 }
 
+TEST_CASE("BtreeInsert/separatorTruncationTest", "")
+{
+  BtreeInsertFixture f;
+  f.separatorTruncationTest();
+}
+
+
+// The input of the bulk loader: |count| keys, each key has |duplicates|
+// records
+struct BulkLoadInput {
+  enum {
+    // every 10th key is large and stored as an extended key
+    kExtendedKeys = 1,
+
+    // the keys are uint32_t (otherwise binary)
+    kPodKeys = 2,
+
+    // all records have 4 bytes (otherwise every 7th record is a blob)
+    kFixedRecords = 4
+  };
+
+  BulkLoadInput(int count_, int duplicates_ = 1, uint32_t flags_ = 0)
+    : count(count_), duplicates(duplicates_), flags(flags_),
+      current(0), status(0) {
+  }
+
+  // Fills |key| with the key of item |i|
+  void make_key(int i, std::vector<uint8_t> &buffer, ham_key_t *key) const {
+    if (flags & kPodKeys) {
+      buffer.resize(sizeof(uint32_t));
+      *(uint32_t *)&buffer[0] = (uint32_t)i;
+    }
+    else {
+      buffer.assign((flags & kExtendedKeys) && i % 10 == 0 ? 300 : 8,
+                      (uint8_t)i);
+      // big-endian, therefore the binary keys are sorted
+      buffer[0] = (uint8_t)(i >> 24);
+      buffer[1] = (uint8_t)(i >> 16);
+      buffer[2] = (uint8_t)(i >> 8);
+      buffer[3] = (uint8_t)i;
+    }
+    key->data = &buffer[0];
+    key->size = (uint16_t)buffer.size();
+  }
+
+  // Fills |record| with the |dup|th record of item |i|
+  void make_record(int i, int dup, std::vector<uint8_t> &buffer,
+                  ham_record_t *record) const {
+    buffer.assign((flags & kFixedRecords) || i % 7 != 0 ? 4 : 100,
+                    (uint8_t)dup);
+    *(uint32_t *)&buffer[0] = (uint32_t)(i + dup);
+    record->data = &buffer[0];
+    record->size = (uint32_t)buffer.size();
+  }
+
+  // The callback function for ham_db_bulk_load
+  static ham_status_t HAM_CALLCONV next(ham_key_t *key, ham_record_t *record,
+                  void *context) {
+    BulkLoadInput *input = (BulkLoadInput *)context;
+    if (input->status)
+      return (input->status);
+    if (input->current == input->count * input->duplicates)
+      return (HAM_KEY_NOT_FOUND);
+    int i = input->current / input->duplicates;
+    int dup = input->current % input->duplicates;
+    input->make_key(i, input->key_buffer, key);
+    input->make_record(i, dup, input->record_buffer, record);
+    input->current++;
+    return (0);
+  }
+
+  int count;
+  int duplicates;
+  uint32_t flags;
+  int current;
+  ham_status_t status;
+  std::vector<uint8_t> key_buffer;
+  std::vector<uint8_t> record_buffer;
+};
+
+struct BulkLoadFixture {
+  ham_db_t *m_db;
+  ham_env_t *m_env;
+  uint32_t m_env_flags;
+
+  BulkLoadFixture(uint32_t env_flags = 0, uint32_t db_flags = 0,
+                  uint32_t key_type = HAM_TYPE_BINARY,
+                  uint32_t record_size = HAM_RECORD_SIZE_UNLIMITED)
+    : m_db(0), m_env(0), m_env_flags(env_flags) {
+    ham_parameter_t p1[] = {
+      { HAM_PARAM_PAGESIZE, 4096 },
+      { 0, 0 }
+    };
+    ham_parameter_t p2[] = {
+      { HAM_PARAM_KEY_TYPE, key_type },
+      { HAM_PARAM_RECORD_SIZE, record_size },
+      { 0, 0 }
+    };
+
+    os::unlink(Utils::opath(".test"));
+    REQUIRE(0 == ham_env_create(&m_env, Utils::opath(".test"), m_env_flags,
+                            0644, &p1[0]));
+    REQUIRE(0 == ham_env_create_db(m_env, &m_db, 1, db_flags, &p2[0]));
+  }
+
+  ~BulkLoadFixture() {
+    if (m_env)
+	  REQUIRE(0 == ham_env_close(m_env, HAM_AUTO_CLEANUP));
+  }
+
+  void reopen() {
+    REQUIRE(0 == ham_env_close(m_env, HAM_AUTO_CLEANUP));
+    REQUIRE(0 == ham_env_open(&m_env, Utils::opath(".test"),
+                            m_env_flags, 0));
+    REQUIRE(0 == ham_env_open_db(m_env, &m_db, 1, 0, 0));
+  }
+
+  // Returns the number of leaf nodes
+  int count_leaves() {
+    LocalDatabase *db = (LocalDatabase *)m_db;
+    PageManager *pm = db->lenv()->page_manager();
+    Context context(db->lenv(), 0, db);
+    BtreeIndex *btree = db->btree_index();
+
+    Page *page = pm->fetch(&context, btree->root_address(),
+                    PageManager::kReadOnly);
+    BtreeNodeProxy *node = btree->get_node_from_page(page);
+    while (!node->is_leaf()) {
+      page = pm->fetch(&context, node->get_ptr_down(), PageManager::kReadOnly);
+      node = btree->get_node_from_page(page);
+    }
+
+    int leaves = 1;
+    while (node->get_right()) {
+      page = pm->fetch(&context, node->get_right(), PageManager::kReadOnly);
+      node = btree->get_node_from_page(page);
+      leaves++;
+    }
+    return (leaves);
+  }
+
+  // Verifies that the database stores all keys of |input|
+  void verify(const BulkLoadInput &input) {
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+
+    uint64_t count;
+    REQUIRE(0 == ham_db_get_key_count(m_db, 0, 0, &count));
+    REQUIRE((uint64_t)(input.count * input.duplicates) == count);
+
+    std::vector<uint8_t> kbuf, rbuf;
+    ham_key_t expected_key = {0};
+    ham_record_t expected_record = {0};
+
+    // the keys can be found
+    for (int i = 0; i < input.count; i += 13) {
+      ham_record_t record = {0};
+      input.make_key(i, kbuf, &expected_key);
+      input.make_record(i, 0, rbuf, &expected_record);
+      REQUIRE(0 == ham_db_find(m_db, 0, &expected_key, &record, 0));
+      REQUIRE(expected_record.size == record.size);
+      REQUIRE(0 == ::memcmp(expected_record.data, record.data, record.size));
+    }
+
+    // a cursor visits all keys in the correct order
+    ham_cursor_t *cursor;
+    REQUIRE(0 == ham_cursor_create(&cursor, m_db, 0, 0));
+    for (int i = 0; i < input.count; i++) {
+      for (int dup = 0; dup < input.duplicates; dup++) {
+        ham_key_t key = {0};
+        ham_record_t record = {0};
+        REQUIRE(0 == ham_cursor_move(cursor, &key, &record, HAM_CURSOR_NEXT));
+        input.make_key(i, kbuf, &expected_key);
+        input.make_record(i, dup, rbuf, &expected_record);
+        REQUIRE(expected_key.size == key.size);
+        REQUIRE(0 == ::memcmp(expected_key.data, key.data, key.size));
+        REQUIRE(expected_record.size == record.size);
+        REQUIRE(0 == ::memcmp(expected_record.data, record.data,
+                                record.size));
+      }
+    }
+    REQUIRE(HAM_KEY_NOT_FOUND == ham_cursor_move(cursor, 0, 0,
+                            HAM_CURSOR_NEXT));
+    REQUIRE(0 == ham_cursor_close(cursor));
+  }
+
+  // Loads |input|, verifies the database and then modifies it
+  void loadTest(BulkLoadInput &input, uint32_t fill_factor = 0) {
+    REQUIRE(0 == ham_db_bulk_load(m_db, BulkLoadInput::next, &input,
+                            fill_factor, 0));
+    verify(input);
+    if (!(m_env_flags & HAM_IN_MEMORY)) {
+      reopen();
+      verify(input);
+    }
+
+    std::vector<uint8_t> kbuf, rbuf;
+    ham_key_t key = {0};
+    ham_record_t record = {0};
+    input.make_key(input.count, kbuf, &key);
+    input.make_record(input.count, 0, rbuf, &record);
+    REQUIRE(0 == ham_db_insert(m_db, 0, &key, &record, 0));
+    input.make_key(input.count / 2, kbuf, &key);
+    REQUIRE(0 == ham_db_erase(m_db, 0, &key, 0));
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+  }
+
+  void binaryTest() {
+    BulkLoadInput input(20000, 1, BulkLoadInput::kExtendedKeys);
+    loadTest(input);
+  }
+
+  void podTest() {
+    BulkLoadInput input(100000, 1,
+                    BulkLoadInput::kPodKeys | BulkLoadInput::kFixedRecords);
+    loadTest(input);
+  }
+
+  void duplicateTest() {
+    BulkLoadInput input(5000, 5, BulkLoadInput::kExtendedKeys);
+    loadTest(input);
+  }
+
+  void manyDuplicatesTest() {
+    BulkLoadInput input(10, 2000);
+    loadTest(input);
+  }
+
+  void emptyTest() {
+    BulkLoadInput input(0);
+    REQUIRE(0 == ham_db_bulk_load(m_db, BulkLoadInput::next, &input, 0, 0));
+    verify(input);
+  }
+
+  void fillFactorTest(uint32_t fill_factor) {
+    BulkLoadInput input(50000, 1,
+                    BulkLoadInput::kPodKeys | BulkLoadInput::kFixedRecords);
+    REQUIRE(0 == ham_db_bulk_load(m_db, BulkLoadInput::next, &input,
+                            fill_factor, 0));
+    verify(input);
+  }
+
+  void invalidParameterTest() {
+    BulkLoadInput input(100);
+    REQUIRE(HAM_INV_PARAMETER == ham_db_bulk_load(0, BulkLoadInput::next,
+                            &input, 0, 0));
+    REQUIRE(HAM_INV_PARAMETER == ham_db_bulk_load(m_db, 0, &input, 0, 0));
+    REQUIRE(HAM_INV_PARAMETER == ham_db_bulk_load(m_db, BulkLoadInput::next,
+                            &input, 101, 0));
+    REQUIRE(HAM_INV_PARAMETER == ham_db_bulk_load(m_db, BulkLoadInput::next,
+                            &input, 0, 1));
+  }
+
+  void notEmptyTest() {
+    BulkLoadInput input(100);
+    std::vector<uint8_t> kbuf;
+    ham_key_t key = {0};
+    ham_record_t record = {0};
+    input.make_key(1000, kbuf, &key);
+    REQUIRE(0 == ham_db_insert(m_db, 0, &key, &record, 0));
+
+    REQUIRE(HAM_INV_PARAMETER == ham_db_bulk_load(m_db, BulkLoadInput::next,
+                            &input, 0, 0));
+  }
+
+  // Returns the keys 0, 1, 2, 1
+  static ham_status_t HAM_CALLCONV unsorted(ham_key_t *key,
+                  ham_record_t *record, void *context) {
+    static uint32_t keys[] = {0, 1, 2, 1};
+    int *current = (int *)context;
+    if (*current == 4)
+      return (HAM_KEY_NOT_FOUND);
+    key->data = &keys[*current];
+    key->size = sizeof(uint32_t);
+    (*current)++;
+    return (0);
+  }
+
+  void unsortedTest() {
+    int current = 0;
+    REQUIRE(HAM_INV_PARAMETER == ham_db_bulk_load(m_db, unsorted, &current,
+                            0, 0));
+
+    // the database is still empty
+    uint64_t count;
+    REQUIRE(0 == ham_db_get_key_count(m_db, 0, 0, &count));
+    REQUIRE(0ull == count);
+    REQUIRE(0 == ham_db_check_integrity(m_db, 0));
+  }
+
+  void duplicateKeyTest() {
+    BulkLoadInput input(100, 2);
+    REQUIRE(HAM_DUPLICATE_KEY == ham_db_bulk_load(m_db, BulkLoadInput::next,
+                            &input, 0, 0));
+  }
+
+  void callbackErrorTest() {
+    BulkLoadInput input(100);
+    input.status = HAM_IO_ERROR;
+    REQUIRE(HAM_IO_ERROR == ham_db_bulk_load(m_db, BulkLoadInput::next,
+                            &input, 0, 0));
+  }
+
+  void invalidSizeTest() {
+    BulkLoadInput input(100);
+    REQUIRE(HAM_INV_KEY_SIZE == ham_db_bulk_load(m_db, BulkLoadInput::next,
+                            &input, 0, 0));
+  }
+};
+
+TEST_CASE("BtreeInsert/BulkLoad/binaryTest", "")
+{
+  BulkLoadFixture f;
+  f.binaryTest();
+}
+
+TEST_CASE("BtreeInsert/BulkLoad/podTest", "")
+{
+  BulkLoadFixture f(0, 0, HAM_TYPE_UINT32, 4);
+  f.podTest();
+}
+
+TEST_CASE("BtreeInsert/BulkLoad/inMemoryTest", "")
+{
+  BulkLoadFixture f(HAM_IN_MEMORY);
+  f.binaryTest();
+}
+
+TEST_CASE("BtreeInsert/BulkLoad/recoveryTest", "")
+{
+  BulkLoadFixture f(HAM_ENABLE_RECOVERY);
+  f.binaryTest();
+}
+
+TEST_CASE("BtreeInsert/BulkLoad/transactionTest", "")
+{
+  BulkLoadFixture f(HAM_ENABLE_TRANSACTIONS, 0, HAM_TYPE_UINT32, 4);
+  f.podTest();
+}
+
+TEST_CASE("BtreeInsert/BulkLoad/duplicateTest", "")
+{
+  BulkLoadFixture f(0, HAM_ENABLE_DUPLICATE_KEYS);
+  f.duplicateTest();
+}
+
+TEST_CASE("BtreeInsert/BulkLoad/manyDuplicatesTest", "")
+{
+  BulkLoadFixture f(0, HAM_ENABLE_DUPLICATE_KEYS);
+  f.manyDuplicatesTest();
+}
+
+TEST_CASE("BtreeInsert/BulkLoad/emptyTest", "")
+{
+  BulkLoadFixture f;
+  f.emptyTest();
+}
+
+TEST_CASE("BtreeInsert/BulkLoad/fillFactorTest", "")
+{
+  int full_leaves, half_leaves;
+  {
+    BulkLoadFixture f(0, 0, HAM_TYPE_UINT32, 4);
+    f.fillFactorTest(100);
+    full_leaves = f.count_leaves();
+  }
+  {
+    BulkLoadFixture f(0, 0, HAM_TYPE_UINT32, 4);
+    f.fillFactorTest(50);
+    half_leaves = f.count_leaves();
+  }
+  int minimum = full_leaves * 2 - 1;
+  REQUIRE(half_leaves >= minimum);
+}
+
+TEST_CASE("BtreeInsert/BulkLoad/invalidParameterTest", "")
+{
+  BulkLoadFixture f;
+  f.invalidParameterTest();
+}
+
+TEST_CASE("BtreeInsert/BulkLoad/notEmptyTest", "")
+{
+  BulkLoadFixture f;
+  f.notEmptyTest();
+}
+
+TEST_CASE("BtreeInsert/BulkLoad/unsortedTest", "")
+{
+  BulkLoadFixture f(0, 0, HAM_TYPE_UINT32);
+  f.unsortedTest();
+}
+
+TEST_CASE("BtreeInsert/BulkLoad/duplicateKeyTest", "")
+{
+  BulkLoadFixture f;
+  f.duplicateKeyTest();
+}
+
+TEST_CASE("BtreeInsert/BulkLoad/callbackErrorTest", "")
+{
+  BulkLoadFixture f;
+  f.callbackErrorTest();
+}
+
+TEST_CASE("BtreeInsert/BulkLoad/invalidSizeTest", "")
+{
+  BulkLoadFixture f(0, 0, HAM_TYPE_UINT32);
+  f.invalidSizeTest();
+}
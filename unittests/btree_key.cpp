@@ -16,6 +16,9 @@
 
 #include "3rdparty/catch/catch.hpp"
 
+#include <vector>
+#include <algorithm>
+
 #include "utils.h"
 #include "os.hpp"
 
@@ -25,6 +28,7 @@
 #include "3btree/btree_flags.h"
 #include "3btree/btree_node_proxy.h"
 #include "3btree/btree_impl_default.h"
+#include "3btree/btree_keys_simd.h"
 #include "3page_manager/page_manager.h"
 #include "3btree/btree_node.h"
 #include "4context/context.h"
@@ -606,4 +610,89 @@ TEST_CASE("BtreeKey/eraseAllDuplicateRecord4", "")
   f.eraseAllDuplicateRecordTest4();
 }
 
+template<typename T>
+static void
+simdLowerBoundTest(T step, int count)
+{
+  int isas[] = {HAM_SIMD_NONE, HAM_SIMD_SSE2, HAM_SIMD_AVX2};
+  std::vector<T> data;
+  for (int i = 0; i < count; i++)
+    data.push_back((T)(i * step));
+
+  // search for all existing keys, for keys between them and for keys
+  // which are larger/smaller than all others; test all lengths of the
+  // linear range
+  for (int j = 0; j < 3; j++) {
+    int isa = SimdSearch::select_isa(isas[j]);
+    for (size_t threshold = 1; threshold < 70; threshold += 7) {
+      for (int i = -1; i <= count; i++) {
+        T keys[2] = {(T)(i * step), (T)(i * step + step / 2)};
+        for (int k = 0; k < 2; k++) {
+          size_t expected = std::lower_bound(data.begin(), data.end(),
+                          keys[k]) - data.begin();
+          REQUIRE(expected == SimdSearch::lower_bound(isa, threshold,
+                          &data[0], data.size(), keys[k]));
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("BtreeKey/simdLowerBoundTest", "")
+{
+  // the keys exceed the range of the signed types
+  simdLowerBoundTest<uint8_t>(2, 120);
+  simdLowerBoundTest<uint16_t>(200, 300);
+  simdLowerBoundTest<uint32_t>(0x00c00000, 300);
+  simdLowerBoundTest<uint64_t>(0x00c0000000000000ull, 300);
+  simdLowerBoundTest<float>(1.5f, 300);
+  simdLowerBoundTest<double>(1.5, 300);
+}
+
+TEST_CASE("BtreeKey/simdSearchParameterTest", "")
+{
+  ham_env_t *env;
+  ham_db_t *db;
+  ham_parameter_t params[] = {
+    {HAM_PARAM_SIMD_SEARCH, HAM_SIMD_SSE2},
+    {HAM_PARAM_LINEAR_SEARCH_THRESHOLD, 16},
+    {0, 0}
+  };
+  ham_parameter_t db_params[] = {
+    {HAM_PARAM_KEY_TYPE, HAM_TYPE_UINT64},
+    {0, 0}
+  };
+
+  REQUIRE(0 == ham_env_create(&env, Utils::opath(".test"), 0, 0644,
+                          &params[0]));
+  params[0].value = 0;
+  params[1].value = 0;
+  REQUIRE(0 == ham_env_get_parameters(env, &params[0]));
+  REQUIRE(params[0].value == (uint64_t)HAM_SIMD_SSE2);
+  REQUIRE(params[1].value == 16u);
+
+  // insert and look up keys with the forced instruction set
+  REQUIRE(0 == ham_env_create_db(env, &db, 1, 0, &db_params[0]));
+  for (uint64_t i = 0; i < 5000; i++) {
+    uint64_t k = i * 3;
+    ham_key_t key = ham_make_key(&k, sizeof(k));
+    ham_record_t rec = {0};
+    REQUIRE(0 == ham_db_insert(db, 0, &key, &rec, 0));
+  }
+  for (uint64_t i = 0; i < 5000 * 3; i++) {
+    uint64_t k = i;
+    ham_key_t key = ham_make_key(&k, sizeof(k));
+    ham_record_t rec = {0};
+    REQUIRE((i % 3 ? HAM_KEY_NOT_FOUND : 0)
+                    == ham_db_find(db, 0, &key, &rec, 0));
+  }
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+
+  // invalid instruction sets are rejected
+  params[0].value = 17;
+  params[1].name = 0;
+  REQUIRE(HAM_INV_PARAMETER == ham_env_create(&env, Utils::opath(".test"),
+                          0, 0644, &params[0]));
+}
+
 } // namespace hamsterdb
@@ -128,5 +128,41 @@ TEST_CASE("Changeset/clear",
     delete page[i];
 }
 
+TEST_CASE("Changeset/ownership",
+          "Pages remember the Changeset which locked them")
+{
+  ChangesetFixture f;
+  Changeset ch1((LocalEnvironment *)f.m_env);
+  Changeset ch2((LocalEnvironment *)f.m_env);
+  Page *page = new Page(((LocalEnvironment *)f.m_env)->device());
+  page->set_address(1024);
+
+  ch1.put(page);
+  REQUIRE(true == ch1.has(page));
+  REQUIRE(false == ch2.has(page));
+  REQUIRE(&ch1 == page->get_changeset());
+  REQUIRE(false == page->mutex().try_lock());
+
+  // adding the page a second time must not dead-lock
+  ch1.put(page);
+
+  ch1.clear();
+  REQUIRE(false == ch1.has(page));
+  REQUIRE((Changeset *)NULL == page->get_changeset());
+
+  // the page was unlocked and can be added to another Changeset
+  ch2.put(page);
+  REQUIRE(true == ch2.has(page));
+  ch2.clear();
+
+  // pinned pages are not purged from the cache
+  page->pin();
+  REQUIRE(true == page->is_pinned());
+  page->unpin();
+  REQUIRE(false == page->is_pinned());
+
+  delete page;
+}
+
 } // namespace hamsterdb
 
@@ -14,12 +14,15 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+
 #include "3rdparty/catch/catch.hpp"
 
 #include "utils.h"
 #include "os.hpp"
 
 #include "2device/device.h"
+#include "2device/device_uring.h"
 #include "4env/env_local.h"
 
 using namespace hamsterdb;
@@ -30,12 +33,17 @@ struct DeviceFixture
   ham_env_t *m_env;
   Device *m_dev;
 
-  DeviceFixture(bool inmemory) {
+  DeviceFixture(bool inmemory, int io_backend = HAM_IO_BACKEND_POSIX) {
     (void)os::unlink(Utils::opath(".test"));
 
+    ham_parameter_t params[] = {
+      {HAM_PARAM_IO_BACKEND, (uint64_t)io_backend},
+      {0, 0}
+    };
     REQUIRE(0 ==
         ham_env_create(&m_env, Utils::opath(".test"),
-            inmemory ? HAM_IN_MEMORY : 0, 0644, 0));
+            inmemory ? HAM_IN_MEMORY : 0, 0644,
+            inmemory ? 0 : &params[0]));
     REQUIRE(0 ==
         ham_env_create_db(m_env, &m_db, 1, 0, 0));
     m_dev = ((LocalEnvironment *)m_env)->device();
@@ -195,6 +203,121 @@ struct DeviceFixture
       delete pages[i];
     }
   }
+
+  // writes 10 pages with a single batch; the requests are not sorted,
+  // and some of them are adjacent
+  void writeBatchTest() {
+    uint32_t ps = HAM_DEFAULT_PAGE_SIZE;
+    int order[10] = {3, 4, 5, 0, 9, 1, 2, 8, 6, 7};
+    IoRequest requests[10];
+    uint8_t *buffer[10];
+    uint8_t *temp = (uint8_t *)malloc(ps);
+
+    m_dev->truncate(ps * 10);
+    for (int i = 0; i < 10; i++) {
+      buffer[i] = Memory::allocate_aligned<uint8_t>(ps, 4096);
+      memset(buffer[i], order[i] + 1, ps);
+      requests[i].address = order[i] * ps;
+      requests[i].buffer = buffer[i];
+      requests[i].size = ps;
+    }
+    m_dev->write_batch(&requests[0], 10);
+
+    for (int i = 0; i < 10; i++) {
+      memset(temp, i + 1, ps);
+      m_dev->read(i * ps, buffer[0], ps);
+      REQUIRE(0 == memcmp(buffer[0], temp, ps));
+    }
+
+    for (int i = 0; i < 10; i++)
+      Memory::release(buffer[i]);
+    free(temp);
+  }
+
+  // writes 6 of 10 pages with a single batch; the adjacent pages are
+  // merged, and the gaps are not modified
+  void writeBatchRunsTest() {
+    uint32_t ps = HAM_DEFAULT_PAGE_SIZE;
+    int order[6] = {7, 2, 3, 9, 0, 4};
+    IoRequest requests[6];
+    uint8_t *buffer[6];
+    uint8_t *temp = (uint8_t *)malloc(ps);
+    uint8_t *read = (uint8_t *)malloc(ps);
+
+    m_dev->truncate(ps * 10);
+    memset(temp, 0, ps);
+    for (int i = 0; i < 10; i++)
+      m_dev->write(i * ps, temp, ps);
+
+    for (int i = 0; i < 6; i++) {
+      buffer[i] = Memory::allocate_aligned<uint8_t>(ps, 4096);
+      memset(buffer[i], order[i] + 1, ps);
+      requests[i].address = order[i] * ps;
+      requests[i].buffer = buffer[i];
+      requests[i].size = ps;
+    }
+    m_dev->write_batch(&requests[0], 6);
+
+    for (int i = 0; i < 10; i++) {
+      bool written = std::find(&order[0], &order[6], i) != &order[6];
+      memset(temp, written ? i + 1 : 0, ps);
+      m_dev->read(i * ps, read, ps);
+      REQUIRE(0 == memcmp(read, temp, ps));
+    }
+
+    for (int i = 0; i < 6; i++)
+      Memory::release(buffer[i]);
+    free(read);
+    free(temp);
+  }
+
+  // reads 10 pages with a single batch, using aligned and unaligned
+  // buffers
+  void readBatchTest() {
+    uint32_t ps = HAM_DEFAULT_PAGE_SIZE;
+    IoRequest requests[10];
+    uint8_t *buffer[10];
+    uint8_t *temp = (uint8_t *)malloc(ps + 1);
+
+    m_dev->truncate(ps * 10);
+    for (int i = 0; i < 10; i++) {
+      memset(temp, i + 1, ps);
+      m_dev->write(i * ps, temp, ps);
+    }
+
+    for (int i = 0; i < 10; i++) {
+      buffer[i] = Memory::allocate_aligned<uint8_t>(ps + 1, 4096);
+      requests[i].address = (9 - i) * ps;
+      // odd buffers are not aligned
+      requests[i].buffer = buffer[i] + (i & 1);
+      requests[i].size = ps;
+    }
+    m_dev->read_batch(&requests[0], 10);
+
+    for (int i = 0; i < 10; i++) {
+      memset(temp, 10 - i, ps);
+      REQUIRE(0 == memcmp(buffer[i] + (i & 1), temp, ps));
+      Memory::release(buffer[i]);
+    }
+    free(temp);
+  }
+
+  // verifies that the UringDevice is used and that it is functional
+  void uringTest(bool direct) {
+    UringDevice *dev = dynamic_cast<UringDevice *>(m_dev);
+    REQUIRE(dev != 0);
+#ifdef HAM_HAVE_IO_URING
+    REQUIRE(dev->is_ring_active());
+#endif
+    REQUIRE(dev->is_direct() == direct);
+
+    // page buffers are aligned for O_DIRECT
+    Page page(m_dev);
+    m_dev->alloc_page(&page);
+    if (direct)
+      REQUIRE(((uintptr_t)page.get_data() % 4096) == 0);
+    m_dev->free_page(&page);
+  }
 };
 
 TEST_CASE("Device/newDelete", "")
@@ -252,6 +375,243 @@ TEST_CASE("Device/readWritePage", "")
 }
 
 
+TEST_CASE("Device/writeBatch", "")
+{
+  DeviceFixture f(false);
+  f.writeBatchTest();
+}
+
+TEST_CASE("Device/writeBatchRuns", "")
+{
+  DeviceFixture f(false);
+  f.writeBatchRunsTest();
+}
+
+TEST_CASE("Device/readBatch", "")
+{
+  DeviceFixture f(false);
+  f.readBatchTest();
+}
+
+TEST_CASE("Device-uring/uring", "")
+{
+  DeviceFixture f(false, HAM_IO_BACKEND_URING);
+  f.uringTest(false);
+}
+
+TEST_CASE("Device-uring/mmapUnmap", "")
+{
+  DeviceFixture f(false, HAM_IO_BACKEND_URING);
+  f.mmapUnmapTest();
+}
+
+TEST_CASE("Device-uring/readWrite", "")
+{
+  DeviceFixture f(false, HAM_IO_BACKEND_URING);
+  f.readWriteTest();
+}
+
+TEST_CASE("Device-uring/readWritePage", "")
+{
+  DeviceFixture f(false, HAM_IO_BACKEND_URING);
+  f.readWritePageTest();
+}
+
+TEST_CASE("Device-uring/writeBatch", "")
+{
+  DeviceFixture f(false, HAM_IO_BACKEND_URING);
+  f.writeBatchTest();
+}
+
+TEST_CASE("Device-uring/writeBatchRuns", "")
+{
+  DeviceFixture f(false, HAM_IO_BACKEND_URING);
+  f.writeBatchRunsTest();
+}
+
+TEST_CASE("Device-uring/readBatch", "")
+{
+  DeviceFixture f(false, HAM_IO_BACKEND_URING);
+  f.readBatchTest();
+}
+
+TEST_CASE("Device-uring-direct/uring", "")
+{
+  DeviceFixture f(false, HAM_IO_BACKEND_URING_DIRECT);
+  f.uringTest(true);
+}
+
+TEST_CASE("Device-uring-direct/readWrite", "")
+{
+  DeviceFixture f(false, HAM_IO_BACKEND_URING_DIRECT);
+  f.readWriteTest();
+}
+
+TEST_CASE("Device-uring-direct/readWritePage", "")
+{
+  DeviceFixture f(false, HAM_IO_BACKEND_URING_DIRECT);
+  f.readWritePageTest();
+}
+
+TEST_CASE("Device-uring-direct/writeBatch", "")
+{
+  DeviceFixture f(false, HAM_IO_BACKEND_URING_DIRECT);
+  f.writeBatchTest();
+}
+
+TEST_CASE("Device-uring-direct/readBatch", "")
+{
+  DeviceFixture f(false, HAM_IO_BACKEND_URING_DIRECT);
+  f.readBatchTest();
+}
+
+// inserts keys with a small cache (the cache is purged frequently),
+// then verifies them after the Environment was flushed and reopened
+static void
+uringInsertFindTest(int io_backend)
+{
+  ham_env_t *env;
+  ham_db_t *db;
+  ham_parameter_t params[] = {
+    {HAM_PARAM_IO_BACKEND, (uint64_t)io_backend},
+    {HAM_PARAM_CACHE_SIZE, 16 * HAM_DEFAULT_PAGE_SIZE},
+    {0, 0}
+  };
+  ham_parameter_t db_params[] = {
+    {HAM_PARAM_KEY_TYPE, HAM_TYPE_UINT32},
+    {0, 0}
+  };
+  std::vector<uint8_t> data(100);
+
+  REQUIRE(0 == ham_env_create(&env, Utils::opath(".test"), 0, 0644,
+                          &params[0]));
+  REQUIRE(0 == ham_env_create_db(env, &db, 1, 0, &db_params[0]));
+  for (uint32_t i = 0; i < 20000; i++) {
+    ham_key_t key = ham_make_key(&i, sizeof(i));
+    ham_record_t rec = ham_make_record(&data[0], (uint32_t)data.size());
+    *(uint32_t *)&data[0] = i;
+    REQUIRE(0 == ham_db_insert(db, 0, &key, &rec, 0));
+  }
+  REQUIRE(0 == ham_env_flush(env, 0));
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+
+  params[0].value = 0;
+  params[1].name = 0;
+  REQUIRE(0 == ham_env_open(&env, Utils::opath(".test"), 0, &params[0]));
+  REQUIRE(0 == ham_env_get_parameters(env, &params[0]));
+  REQUIRE(params[0].value == (uint64_t)HAM_IO_BACKEND_POSIX);
+  REQUIRE(0 == ham_env_close(env, 0));
+
+  params[0].value = io_backend;
+  REQUIRE(0 == ham_env_open(&env, Utils::opath(".test"), 0, &params[0]));
+  params[0].value = 0;
+  REQUIRE(0 == ham_env_get_parameters(env, &params[0]));
+  REQUIRE(params[0].value == (uint64_t)io_backend);
+  REQUIRE(0 == ham_env_open_db(env, &db, 1, 0, 0));
+  for (uint32_t i = 0; i < 20000; i++) {
+    ham_key_t key = ham_make_key(&i, sizeof(i));
+    ham_record_t rec = {0};
+    REQUIRE(0 == ham_db_find(db, 0, &key, &rec, 0));
+    REQUIRE(rec.size == data.size());
+    REQUIRE(*(uint32_t *)rec.data == i);
+  }
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+}
+
+TEST_CASE("Device-uring/insertFind", "")
+{
+  uringInsertFindTest(HAM_IO_BACKEND_URING);
+}
+
+TEST_CASE("Device-uring-direct/insertFind", "")
+{
+  uringInsertFindTest(HAM_IO_BACKEND_URING_DIRECT);
+}
+
+TEST_CASE("Device-uring/invalidParameter", "")
+{
+  ham_env_t *env;
+  ham_parameter_t params[] = {
+    {HAM_PARAM_IO_BACKEND, 3},
+    {0, 0}
+  };
+  REQUIRE(HAM_INV_PARAMETER == ham_env_create(&env, Utils::opath(".test"),
+                          0, 0644, &params[0]));
+}
+
+// inserts keys into an Environment with a reserved address space, and
+// verifies that new pages are mapped as well
+static void
+mmapReserveTest(uint64_t reserve, bool expect_mapped)
+{
+  ham_env_t *env;
+  ham_db_t *db;
+  ham_parameter_t params[] = {
+    {HAM_PARAM_MMAP_RESERVE, reserve},
+    {HAM_PARAM_CACHE_SIZE, 16 * HAM_DEFAULT_PAGE_SIZE},
+    {0, 0}
+  };
+  ham_parameter_t db_params[] = {
+    {HAM_PARAM_KEY_TYPE, HAM_TYPE_UINT32},
+    {0, 0}
+  };
+  std::vector<uint8_t> data(100);
+
+  REQUIRE(0 == ham_env_create(&env, Utils::opath(".test"), 0, 0644,
+                          &params[0]));
+  REQUIRE(0 == ham_env_create_db(env, &db, 1, 0, &db_params[0]));
+  for (uint32_t i = 0; i < 20000; i++) {
+    ham_key_t key = ham_make_key(&i, sizeof(i));
+    ham_record_t rec = ham_make_record(&data[0], (uint32_t)data.size());
+    *(uint32_t *)&data[0] = i;
+    REQUIRE(0 == ham_db_insert(db, 0, &key, &rec, 0));
+  }
+
+  // the whole file is mapped, including a newly allocated page
+  Device *device = ((LocalEnvironment *)env)->device();
+  Page page(device, (LocalDatabase *)db);
+  device->alloc_page(&page);
+  uint64_t file_size = device->file_size();
+  REQUIRE(expect_mapped == device->is_mapped(0, (size_t)file_size));
+  REQUIRE(expect_mapped == !page.is_allocated());
+  device->free_page(&page);
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+
+  // reopen with and without the reserved address space
+  for (int pass = 0; pass < 2; pass++) {
+    uint64_t expected = pass == 0 ? reserve : 0;
+    params[0].value = expected;
+    REQUIRE(0 == ham_env_open(&env, Utils::opath(".test"), 0, &params[0]));
+    params[0].value = 0;
+    params[1].name = 0;
+    REQUIRE(0 == ham_env_get_parameters(env, &params[0]));
+    REQUIRE(params[0].value == expected);
+    params[1].name = HAM_PARAM_CACHE_SIZE;
+    REQUIRE(0 == ham_env_open_db(env, &db, 1, 0, 0));
+    for (uint32_t i = 0; i < 20000; i++) {
+      ham_key_t key = ham_make_key(&i, sizeof(i));
+      ham_record_t rec = {0};
+      REQUIRE(0 == ham_db_find(db, 0, &key, &rec, 0));
+      REQUIRE(rec.size == data.size());
+      REQUIRE(*(uint32_t *)rec.data == i);
+    }
+    REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+  }
+}
+
+#ifndef WIN32
+TEST_CASE("Device/mmapReserve", "")
+{
+  mmapReserveTest(64 * 1024 * 1024, true);
+}
+
+// the file outgrows the reserved address space
+TEST_CASE("Device/mmapReserveExceeded", "")
+{
+  mmapReserveTest(4 * HAM_DEFAULT_PAGE_SIZE, false);
+}
+#endif
+
 TEST_CASE("Device-inmem/newDelete", "")
 {
   DeviceFixture f(true);
@@ -1360,6 +1360,56 @@ TEST_CASE("Env/createOpenEmptyTest", "")
   f.createOpenEmptyTest();
 }
 
+TEST_CASE("Env/latencyMetricsTest", "")
+{
+  ham_env_t *env;
+  ham_db_t *db;
+  ham_txn_t *txn;
+  ham_key_t key = {0};
+  ham_record_t rec = {0};
+  ham_env_metrics_t metrics;
+
+  REQUIRE(0 == ham_env_create(&env, Utils::opath(".test"),
+                          HAM_ENABLE_TRANSACTIONS | HAM_ENABLE_FSYNC, 0644, 0));
+  REQUIRE(0 == ham_env_create_db(env, &db, 1, 0, 0));
+
+  for (int i = 0; i < 100; i++) {
+    key.data = &i;
+    key.size = sizeof(i);
+    REQUIRE(0 == ham_txn_begin(&txn, env, 0, 0, 0));
+    REQUIRE(0 == ham_db_insert(db, txn, &key, &rec, 0));
+    REQUIRE(0 == ham_txn_commit(txn, 0));
+  }
+  for (int i = 0; i < 100; i++) {
+    key.data = &i;
+    key.size = sizeof(i);
+    REQUIRE(0 == ham_db_find(db, 0, &key, &rec, 0));
+  }
+  for (int i = 0; i < 50; i++) {
+    key.data = &i;
+    key.size = sizeof(i);
+    REQUIRE(0 == ham_db_erase(db, 0, &key, 0));
+  }
+
+  REQUIRE(0 == ham_env_get_metrics(env, &metrics));
+  REQUIRE(100u == metrics.latency_insert.count);
+  REQUIRE(100u == metrics.latency_find.count);
+  REQUIRE(50u == metrics.latency_erase.count);
+  REQUIRE(100u == metrics.latency_commit.count);
+  REQUIRE(metrics.latency_journal_fsync.count > 0);
+  REQUIRE(metrics.latency_insert.p50_usec <= metrics.latency_insert.p99_usec);
+  REQUIRE(metrics.latency_insert.p99_usec
+                  <= metrics.latency_insert.p999_usec);
+  REQUIRE(metrics.latency_insert.p999_usec
+                  <= metrics.latency_insert.max_usec);
+
+  // the page latencies are global
+  REQUIRE(0 == ham_env_flush(env, 0));
+  REQUIRE(0 == ham_env_get_metrics(env, &metrics));
+  REQUIRE(metrics.latency_page_flush.count > 0);
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+}
+
 
 TEST_CASE("Env-inmem/createCloseTest", "")
 {
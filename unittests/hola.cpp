@@ -381,6 +381,92 @@ struct HolaFixture {
     REQUIRE(result.type == HAM_TYPE_UINT64);
     REQUIRE(result.u.result_u64 == c);
   }
+
+  // Runs |function| with 1, 2, 4 and "one per core" threads and checks
+  // the results
+  void checkParallel(ham_txn_t *txn, int function,
+                  hola_bool_predicate_t *pred, uint64_t expected) {
+    uint32_t threads[] = {1, 2, 4, 0};
+    for (int i = 0; i < 4; i++) {
+      hola_result_t result;
+      REQUIRE(0 == hola_aggregate(m_db, txn, function, pred, threads[i],
+                              &result));
+      REQUIRE(result.type == HAM_TYPE_UINT64);
+      REQUIRE(result.u.result_u64 == expected);
+    }
+  }
+
+  void parallelTest(int count) {
+    ham_key_t key = {0};
+    ham_record_t record = {0};
+    uint64_t sum = 0, sum_if = 0, count_if = 0;
+
+    for (int i = 0; i < count; i++) {
+      key.data = &i;
+      key.size = sizeof(i);
+      REQUIRE(0 == ham_db_insert(m_db, 0, &key, &record, 0));
+      sum += i;
+      if ((i & 1) == 0) {
+        sum_if += i;
+        count_if++;
+      }
+    }
+
+    hola_bool_predicate_t predicate;
+    predicate.context = 0;
+    predicate.predicate_func = sum_if_predicate;
+
+    checkParallel(0, HOLA_SUM, 0, sum);
+    checkParallel(0, HOLA_SUM_IF, &predicate, sum_if);
+    checkParallel(0, HOLA_COUNT, 0, count);
+    checkParallel(0, HOLA_COUNT_DISTINCT, 0, count);
+    checkParallel(0, HOLA_COUNT_IF, &predicate, count_if);
+    checkParallel(0, HOLA_COUNT_DISTINCT_IF, &predicate, count_if);
+    checkParallel(0, HOLA_AVERAGE, 0, sum / count);
+    checkParallel(0, HOLA_AVERAGE_IF, &predicate, sum_if / count_if);
+
+    hola_result_t result;
+    REQUIRE(HAM_INV_PARAMETER == hola_aggregate(m_db, 0, HOLA_SUM_IF, 0, 2,
+                            &result));
+    REQUIRE(HAM_INV_PARAMETER == hola_aggregate(m_db, 0, 0, 0, 2,
+                            &result));
+  }
+
+  // the btree stores the even keys, a Transaction inserts odd keys in
+  // the middle and at the end of the btree
+  void parallelTxnTest(int count) {
+    uint64_t sum = 0, sum_if = 0, keys = 0;
+    ham_txn_t *txn = 0;
+    REQUIRE(0 == ham_txn_begin(&txn, m_env, 0, 0, 0));
+
+    for (int i = 0; i < count; i += 2) {
+      REQUIRE(0 == insertBtree(i));
+      sum += i;
+      sum_if += i;
+      keys++;
+    }
+    for (int i = count / 2 + 1; i < count / 2 + 100; i += 2) {
+      REQUIRE(0 == insertTxn(txn, i));
+      sum += i;
+      keys++;
+    }
+    for (int i = count + 1; i < count + 100; i += 2) {
+      REQUIRE(0 == insertTxn(txn, i));
+      sum += i;
+      keys++;
+    }
+
+    hola_bool_predicate_t predicate;
+    predicate.context = 0;
+    predicate.predicate_func = sum_if_predicate;
+
+    checkParallel(txn, HOLA_SUM, 0, sum);
+    checkParallel(txn, HOLA_SUM_IF, &predicate, sum_if);
+    checkParallel(txn, HOLA_COUNT, 0, keys);
+    checkParallel(txn, HOLA_COUNT_DISTINCT, 0, keys);
+
+    ham_txn_abort(txn, 0);
+  }
 };
 
 TEST_CASE("Hola/sumTest", "")
@@ -449,4 +535,16 @@ TEST_CASE("Hola/countDistinctIfTest", "")
   f.countIfTest(20);
 }
 
+TEST_CASE("Hola/parallelTest", "")
+{
+  HolaFixture f(false, HAM_TYPE_UINT32);
+  f.parallelTest(100000);
+}
+
+TEST_CASE("Hola/parallelTxnTest", "")
+{
+  HolaFixture f(true, HAM_TYPE_UINT32);
+  f.parallelTxnTest(100000);
+}
+
 } // namespace hamsterdb
@@ -16,6 +16,8 @@
 
 #include "3rdparty/catch/catch.hpp"
 
+#include <boost/thread/thread.hpp>
+
 #include "os.hpp"
 #include "utils.h"
 
@@ -100,14 +102,19 @@ struct JournalFixture {
     return (test.lsn());
   }
 
-  void setup(bool flush_when_committed = true) {
+  void setup(bool flush_when_committed = true, int compressor = 0) {
     (void)os::unlink(Utils::opath(".test"));
 
+    ham_parameter_t params[] = {
+      {HAM_PARAM_JOURNAL_COMPRESSION, (uint64_t)compressor},
+      {0, 0}
+    };
+
     REQUIRE(0 ==
         ham_env_create(&m_env, Utils::opath(".test"),
                 (flush_when_committed ? HAM_FLUSH_WHEN_COMMITTED : 0)
                 | HAM_ENABLE_TRANSACTIONS
-                | HAM_ENABLE_RECOVERY, 0644, 0));
+                | HAM_ENABLE_RECOVERY, 0644, &params[0]));
     REQUIRE(0 ==
             ham_env_create_db(m_env, &m_db, 1, HAM_ENABLE_DUPLICATE_KEYS, 0));
 
@@ -916,6 +923,76 @@ struct JournalFixture {
 #endif
   }
 
+  void recoverFromCheckpointTest() {
+#ifndef WIN32
+    ham_txn_t *txn;
+    ham_key_t key = {};
+    ham_record_t rec = {};
+    ham_env_metrics_t metrics;
+
+    teardown();
+
+    ham_parameter_t params[] = {
+      {HAM_PARAM_CHECKPOINT_AGE_LIMIT, 50},
+      {0, 0}
+    };
+    REQUIRE(0 == ham_env_create(&m_env, Utils::opath(".test"),
+                HAM_ENABLE_TRANSACTIONS, 0644, &params[0]));
+    REQUIRE(0 == ham_env_create_db(m_env, &m_db, 1, 0, 0));
+
+    params[0].value = 0;
+    REQUIRE(0 == ham_env_get_parameters(m_env, &params[0]));
+    REQUIRE(params[0].value == 50);
+
+    /* the first commit after the age limit expired flushes all
+     * Transactions and writes a checkpoint */
+    boost::this_thread::sleep(boost::posix_time::milliseconds(60));
+    for (int i = 0; i < 10; i++) {
+      REQUIRE(0 == ham_txn_begin(&txn, m_env, 0, 0, 0));
+      key.data = &i;
+      key.size = sizeof(i);
+      REQUIRE(0 == ham_db_insert(m_db, txn, &key, &rec, 0));
+      REQUIRE(0 == ham_txn_commit(txn, 0));
+    }
+    REQUIRE(0 == ham_env_get_metrics(m_env, &metrics));
+    REQUIRE(metrics.checkpoint_lsn != 0);
+    uint64_t checkpoint_lsn = metrics.checkpoint_lsn;
+
+    /* backup the journal files, then re-create the Environment from the
+     * journal */
+    m_lenv = (LocalEnvironment *)m_env;
+    m_lenv->journal()->flush_buffer(0);
+    m_lenv->journal()->flush_buffer(1);
+    REQUIRE(true == os::copy(Utils::opath(".test.jrn0"),
+          Utils::opath(".test.bak0")));
+    REQUIRE(true == os::copy(Utils::opath(".test.jrn1"),
+          Utils::opath(".test.bak1")));
+    REQUIRE(0 == ham_env_close(m_env,
+                HAM_AUTO_CLEANUP | HAM_DONT_CLEAR_LOG));
+    REQUIRE(true == os::copy(Utils::opath(".test.bak0"),
+          Utils::opath(".test.jrn0")));
+    REQUIRE(true == os::copy(Utils::opath(".test.bak1"),
+          Utils::opath(".test.jrn1")));
+
+    REQUIRE(0 ==
+        ham_env_open(&m_env, Utils::opath(".test"),
+            HAM_ENABLE_TRANSACTIONS | HAM_AUTO_RECOVERY, 0));
+    REQUIRE(0 == ham_env_open_db(m_env, &m_db, 1, 0, 0));
+    m_lenv = (LocalEnvironment *)m_env;
+
+    /* the recovery started at the newest checkpoint */
+    JournalTest test = m_lenv->journal()->test();
+    REQUIRE(test.state()->last_cp_lsn >= checkpoint_lsn);
+    verifyJournalIsEmpty();
+
+    for (int i = 0; i < 10; i++) {
+      key.data = &i;
+      key.size = sizeof(i);
+      REQUIRE(0 == ham_db_find(m_db, 0, &key, &rec, 0));
+    }
+#endif
+  }
+
   void recoverInsertTest() {
     ham_txn_t *txn[2];
     LogEntry vec[200];
@@ -1044,13 +1121,13 @@ struct JournalFixture {
     REQUIRE(0ull == keycount);
   }
 
-  void recoverAfterChangesetTest() {
+  void recoverAfterChangesetTest(int compressor = 0) {
 #ifndef WIN32
     ham_txn_t *txn;
 
     // do not immediately flush the changeset after a commit
     teardown();
-    setup(false);
+    setup(false, compressor);
 
     g_changeset_flushed = false;
     g_CHANGESET_POST_LOG_HOOK = changeset_post_log_hook;
@@ -1068,6 +1145,14 @@ struct JournalFixture {
       i++;
     }
 
+    /* the pages of the changeset were compressed */
+    if (compressor) {
+      ham_env_metrics_t metrics;
+      REQUIRE(0 == ham_env_get_metrics(m_env, &metrics));
+      REQUIRE(metrics.journal_bytes_after_compression
+                    < metrics.journal_bytes_before_compression);
+    }
+
     /* backup the files */
     REQUIRE(true == os::copy(Utils::opath(".test"),
           Utils::opath(".test.bak")));
@@ -1111,6 +1196,205 @@ struct JournalFixture {
 #endif
   }
 
+  void appendCompressedInsertTest() {
+    teardown();
+    setup(true, HAM_COMPRESSOR_LZF);
+
+    Journal *j = disconnect_and_create_new_journal();
+    ham_txn_t *txn;
+    char keydata[200];
+    char recdata[1000];
+    ::memset(keydata, 'k', sizeof(keydata));
+    ::memset(recdata, 'r', sizeof(recdata));
+    ham_key_t key = ham_make_key(keydata, sizeof(keydata));
+    ham_record_t rec = ham_make_record(recdata, sizeof(recdata));
+    REQUIRE(0 == ham_txn_begin(&txn, m_env, 0, 0, 0));
+
+    uint64_t lsn = m_lenv->next_lsn();
+    j->append_insert((Database *)m_db, (LocalTransaction *)txn,
+              &key, &rec, HAM_OVERWRITE, lsn);
+
+    /* and a partial record */
+    rec.size = 2000;
+    rec.partial_size = 500;
+    rec.partial_offset = 10;
+    lsn = m_lenv->next_lsn();
+    j->append_insert((Database *)m_db, (LocalTransaction *)txn,
+              &key, &rec, HAM_PARTIAL, lsn);
+
+    ham_env_metrics_t metrics;
+    j->fill_metrics(&metrics);
+    REQUIRE(metrics.journal_bytes_before_compression == 1900u);
+    REQUIRE(metrics.journal_bytes_after_compression < 200u);
+
+    j->close(true);
+    j->open();
+
+    /* the journal files are smaller than the data */
+    JournalTest test = j->test();
+    uint64_t size = test.state()->files[0].get_file_size()
+                        + test.state()->files[1].get_file_size();
+    REQUIRE(size < 1000u);
+
+    /* verify that the entries are returned uncompressed */
+    Journal::Iterator iter;
+    memset(&iter, 0, sizeof(iter));
+    PJournalEntry entry;
+    ByteArray auxbuffer;
+    j->get_entry(&iter, &entry, &auxbuffer); // this is the txn
+    j->get_entry(&iter, &entry, &auxbuffer); // this is the insert
+    REQUIRE((uint64_t)3 == entry.lsn);
+    REQUIRE(0 == entry.compressor);
+    REQUIRE(entry.followup_size == sizeof(PJournalEntryInsert) - 1 + 1200);
+    PJournalEntryInsert *ins = (PJournalEntryInsert *)auxbuffer.get_ptr();
+    REQUIRE(200 == ins->key_size);
+    REQUIRE(0 == ins->compressed_key_size);
+    REQUIRE(1000u == ins->record_size);
+    REQUIRE(0u == ins->compressed_record_size);
+    REQUIRE((unsigned)HAM_OVERWRITE == ins->insert_flags);
+    REQUIRE(0 == memcmp(keydata, ins->get_key_data(), sizeof(keydata)));
+    REQUIRE(0 == memcmp(recdata, ins->get_record_data(), sizeof(recdata)));
+
+    j->get_entry(&iter, &entry, &auxbuffer); // this is the partial insert
+    REQUIRE((uint64_t)4 == entry.lsn);
+    REQUIRE(entry.followup_size == sizeof(PJournalEntryInsert) - 1 + 700);
+    ins = (PJournalEntryInsert *)auxbuffer.get_ptr();
+    REQUIRE(200 == ins->key_size);
+    REQUIRE(2000u == ins->record_size);
+    REQUIRE(500u == ins->record_partial_size);
+    REQUIRE(10u == ins->record_partial_offset);
+    REQUIRE((unsigned)HAM_PARTIAL == ins->insert_flags);
+    REQUIRE(0 == memcmp(keydata, ins->get_key_data(), sizeof(keydata)));
+    REQUIRE(0 == memcmp(recdata, ins->get_record_data(), 500));
+
+    REQUIRE(0 == ham_txn_abort(txn, 0));
+  }
+
+  void appendCompressedEraseTest() {
+    teardown();
+    setup(true, HAM_COMPRESSOR_LZF);
+
+    Journal *j = disconnect_and_create_new_journal();
+    ham_txn_t *txn;
+    char keydata[200];
+    ::memset(keydata, 'k', sizeof(keydata));
+    ham_key_t key = ham_make_key(keydata, sizeof(keydata));
+    REQUIRE(0 == ham_txn_begin(&txn, m_env, 0, 0, 0));
+
+    uint64_t lsn = m_lenv->next_lsn();
+    j->append_erase((Database *)m_db, (LocalTransaction *)txn, &key, 1, 0, lsn);
+
+    /* small keys are not compressed */
+    key.size = 5;
+    lsn = m_lenv->next_lsn();
+    j->append_erase((Database *)m_db, (LocalTransaction *)txn, &key, 2, 0, lsn);
+    j->close(true);
+    j->open();
+
+    Journal::Iterator iter;
+    memset(&iter, 0, sizeof(iter));
+    PJournalEntry entry;
+    ByteArray auxbuffer;
+    j->get_entry(&iter, &entry, &auxbuffer); // this is the txn
+    j->get_entry(&iter, &entry, &auxbuffer); // this is the erase
+    REQUIRE((uint64_t)3 == entry.lsn);
+    REQUIRE(entry.followup_size == sizeof(PJournalEntryErase) - 1 + 200);
+    PJournalEntryErase *er = (PJournalEntryErase *)auxbuffer.get_ptr();
+    REQUIRE(200 == er->key_size);
+    REQUIRE(0 == er->compressed_key_size);
+    REQUIRE(1u == er->duplicate);
+    REQUIRE(0 == memcmp(keydata, er->get_key_data(), sizeof(keydata)));
+
+    j->get_entry(&iter, &entry, &auxbuffer); // this is the second erase
+    REQUIRE((uint64_t)4 == entry.lsn);
+    REQUIRE(entry.followup_size == sizeof(PJournalEntryErase) - 1 + 5);
+    er = (PJournalEntryErase *)auxbuffer.get_ptr();
+    REQUIRE(5 == er->key_size);
+    REQUIRE(2u == er->duplicate);
+    REQUIRE(0 == memcmp(keydata, er->get_key_data(), 5));
+
+    REQUIRE(0 == ham_txn_abort(txn, 0));
+  }
+
+  void recoverCompressedInsertTest() {
+#ifndef WIN32
+    // do not flush the committed Transactions
+    teardown();
+    setup(false, HAM_COMPRESSOR_LZF);
+
+    char recdata[512];
+    for (int i = 0; i < 20; i++) {
+      ham_txn_t *txn;
+      ::memset(recdata, 'a' + i, sizeof(recdata));
+      ham_key_t key = ham_make_key(&i, sizeof(i));
+      ham_record_t rec = ham_make_record(recdata, sizeof(recdata));
+      REQUIRE(0 == ham_txn_begin(&txn, m_env, 0, 0, 0));
+      REQUIRE(0 == ham_db_insert(m_db, txn, &key, &rec, 0));
+      REQUIRE(0 == ham_txn_commit(txn, 0));
+    }
+
+    /* backup the files */
+    REQUIRE(true == os::copy(Utils::opath(".test"),
+          Utils::opath(".test.bak")));
+    REQUIRE(true == os::copy(Utils::opath(".test.jrn0"),
+          Utils::opath(".test.bak0")));
+    REQUIRE(true == os::copy(Utils::opath(".test.jrn1"),
+          Utils::opath(".test.bak1")));
+
+    /* close the environment, then restore the files */
+    REQUIRE(0 == ham_env_close(m_env, HAM_AUTO_CLEANUP));
+    REQUIRE(true == os::copy(Utils::opath(".test.bak"),
+          Utils::opath(".test")));
+    REQUIRE(true == os::copy(Utils::opath(".test.bak0"),
+          Utils::opath(".test.jrn0")));
+    REQUIRE(true == os::copy(Utils::opath(".test.bak1"),
+          Utils::opath(".test.jrn1")));
+
+    /* recover without specifying the compression */
+    REQUIRE(0 ==
+        ham_env_open(&m_env, Utils::opath(".test"),
+            HAM_ENABLE_TRANSACTIONS | HAM_AUTO_RECOVERY, 0));
+    REQUIRE(0 == ham_env_open_db(m_env, &m_db, 1, 0, 0));
+    verifyJournalIsEmpty();
+
+    for (int i = 0; i < 20; i++) {
+      ::memset(recdata, 'a' + i, sizeof(recdata));
+      ham_key_t key = ham_make_key(&i, sizeof(i));
+      ham_record_t rec = {0};
+      REQUIRE(0 == ham_db_find(m_db, 0, &key, &rec, 0));
+      REQUIRE(rec.size == sizeof(recdata));
+      REQUIRE(0 == memcmp(recdata, rec.data, sizeof(recdata)));
+    }
+#endif
+  }
+
+  void compressionParameterTest() {
+    teardown();
+
+    ham_parameter_t params[] = {
+      {HAM_PARAM_JOURNAL_COMPRESSION, HAM_COMPRESSOR_ZLIB},
+      {0, 0}
+    };
+
+    REQUIRE(HAM_NOT_IMPLEMENTED == ham_env_create(&m_env,
+                Utils::opath(".test"), HAM_ENABLE_TRANSACTIONS, 0644,
+                &params[0]));
+
+    params[0].value = HAM_COMPRESSOR_LZF;
+    REQUIRE(0 == ham_env_create(&m_env, Utils::opath(".test"),
+                HAM_ENABLE_TRANSACTIONS, 0644, &params[0]));
+    params[0].value = 0;
+    REQUIRE(0 == ham_env_get_parameters(m_env, &params[0]));
+    REQUIRE(params[0].value == (uint64_t)HAM_COMPRESSOR_LZF);
+    REQUIRE(0 == ham_env_close(m_env, 0));
+
+    /* the setting is not persistent */
+    REQUIRE(0 == ham_env_open(&m_env, Utils::opath(".test"),
+                HAM_ENABLE_TRANSACTIONS, 0));
+    REQUIRE(0 == ham_env_get_parameters(m_env, &params[0]));
+    REQUIRE(params[0].value == 0u);
+  }
+
   void recoverAfterChangesetAndCommitTest() {
 #ifndef WIN32
     ham_txn_t *txn;
@@ -1495,6 +1779,94 @@ struct JournalFixture {
     REQUIRE(params[0].value == 44);
   }
 
+  static void groupCommitThread(ham_env_t *env, ham_db_t *db, int id,
+                  int *failures) {
+    for (int i = 0; i < 25; i++) {
+      ham_txn_t *txn;
+      int k = id * 100 + i;
+      ham_key_t key = ham_make_key(&k, sizeof(k));
+      ham_record_t rec = {0};
+      if (ham_txn_begin(&txn, env, 0, 0, 0)
+          || ham_db_insert(db, txn, &key, &rec, 0)
+          || ham_txn_commit(txn, 0))
+        (*failures)++;
+    }
+  }
+
+  void groupCommitTest() {
+    teardown();
+
+    ham_parameter_t params[] = {
+      {HAM_PARAM_JOURNAL_COMMIT_WINDOW, 2000},
+      {0, 0}
+    };
+
+    REQUIRE(0 == ham_env_create(&m_env, Utils::opath(".test"),
+                HAM_ENABLE_TRANSACTIONS | HAM_ENABLE_FSYNC, 0644,
+                &params[0]));
+    REQUIRE(0 == ham_env_create_db(m_env, &m_db, 1, 0, 0));
+
+    params[0].value = 0;
+    REQUIRE(0 == ham_env_get_parameters(m_env, &params[0]));
+    REQUIRE(params[0].value == 2000);
+
+    // commit from several threads; all failures are counted because
+    // REQUIRE is not thread safe
+    int failures[4] = {0};
+    boost::thread *threads[4];
+    for (int i = 0; i < 4; i++)
+      threads[i] = new boost::thread(groupCommitThread, m_env, m_db, i,
+                      &failures[i]);
+    for (int i = 0; i < 4; i++) {
+      threads[i]->join();
+      delete threads[i];
+      REQUIRE(failures[i] == 0);
+    }
+
+    ham_env_metrics_t metrics;
+    REQUIRE(0 == ham_env_get_metrics(m_env, &metrics));
+    REQUIRE(metrics.journal_group_commits > 0);
+    REQUIRE(metrics.journal_group_commits <= 100);
+    REQUIRE(metrics.journal_fsyncs > 0);
+    uint64_t batches = 0;
+    for (int i = 0; i < 8; i++)
+      batches += metrics.journal_group_commit_sizes[i];
+    REQUIRE(batches == metrics.journal_group_commits);
+
+    // all Transactions were committed
+    for (int i = 0; i < 4; i++) {
+      for (int j = 0; j < 25; j++) {
+        int k = i * 100 + j;
+        ham_key_t key = ham_make_key(&k, sizeof(k));
+        ham_record_t rec = {0};
+        REQUIRE(0 == ham_db_find(m_db, 0, &key, &rec, 0));
+      }
+    }
+  }
+
+  void noGroupCommitTest() {
+    teardown();
+
+    REQUIRE(0 == ham_env_create(&m_env, Utils::opath(".test"),
+                HAM_ENABLE_TRANSACTIONS | HAM_ENABLE_FSYNC, 0644, 0));
+    REQUIRE(0 == ham_env_create_db(m_env, &m_db, 1, 0, 0));
+
+    for (int i = 0; i < 10; i++) {
+      ham_txn_t *txn;
+      ham_key_t key = ham_make_key(&i, sizeof(i));
+      ham_record_t rec = {0};
+      REQUIRE(0 == ham_txn_begin(&txn, m_env, 0, 0, 0));
+      REQUIRE(0 == ham_db_insert(m_db, txn, &key, &rec, 0));
+      REQUIRE(0 == ham_txn_commit(txn, 0));
+    }
+
+    // every commit was synced separately
+    ham_env_metrics_t metrics;
+    REQUIRE(0 == ham_env_get_metrics(m_env, &metrics));
+    REQUIRE(metrics.journal_group_commits == 0);
+    REQUIRE(metrics.journal_fsyncs >= 10);
+  }
+
   void issue45Test() {
     ham_txn_t *txn;
     ham_key_t key = {0};
@@ -1636,6 +2008,12 @@ TEST_CASE("Journal/recoverSkipAlreadyFlushed", "")
   f.recoverSkipAlreadyFlushedTest();
 }
 
+TEST_CASE("Journal/recoverFromCheckpointTest", "")
+{
+  JournalFixture f;
+  f.recoverFromCheckpointTest();
+}
+
 TEST_CASE("Journal/recoverInsertTest", "")
 {
   JournalFixture f;
@@ -1654,6 +2032,12 @@ TEST_CASE("Journal/recoverAfterChangesetTest", "")
   f.recoverAfterChangesetTest();
 }
 
+TEST_CASE("Journal/recoverAfterCompressedChangesetTest", "")
+{
+  JournalFixture f;
+  f.recoverAfterChangesetTest(HAM_COMPRESSOR_LZF);
+}
+
 TEST_CASE("Journal/recoverAfterChangesetAndCommitTest", "")
 {
   JournalFixture f;
@@ -1690,5 +2074,40 @@ TEST_CASE("Journal/issue45Test", "")
   f.issue45Test();
 }
 
-} // namespace hamsterdb
+TEST_CASE("Journal/groupCommitTest", "")
+{
+  JournalFixture f;
+  f.groupCommitTest();
+}
+
+TEST_CASE("Journal/noGroupCommitTest", "")
+{
+  JournalFixture f;
+  f.noGroupCommitTest();
+}
+
+TEST_CASE("Journal/appendCompressedInsertTest", "")
+{
+  JournalFixture f;
+  f.appendCompressedInsertTest();
+}
+
+TEST_CASE("Journal/appendCompressedEraseTest", "")
+{
+  JournalFixture f;
+  f.appendCompressedEraseTest();
+}
 
+TEST_CASE("Journal/recoverCompressedInsertTest", "")
+{
+  JournalFixture f;
+  f.recoverCompressedInsertTest();
+}
+
+TEST_CASE("Journal/compressionParameterTest", "")
+{
+  JournalFixture f;
+  f.compressionParameterTest();
+}
+
+} // namespace hamsterdb
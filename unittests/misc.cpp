@@ -20,6 +20,7 @@
 
 #include "utils.h"
 
+#include "1base/latency_histogram.h"
 #include "2page/page.h"
 #include "3btree/btree_index.h"
 #include "3btree/btree_node_proxy.h"
@@ -169,4 +170,48 @@ TEST_CASE("MiscFixture/copyKeyInt2PubFullTest",
   mt.copyKeyInt2PubFullTest();
 }
 
+TEST_CASE("Misc/latencyHistogramTest", "")
+{
+  // small values have their own bucket
+  for (uint64_t i = 0; i < 2 * LatencyHistogram::kSubBuckets; i++) {
+    REQUIRE((int)i == LatencyHistogram::get_bucket(i));
+    REQUIRE(i == LatencyHistogram::get_upper_bound((int)i));
+  }
+
+  // each bucket covers the values up to its upper bound
+  for (int i = 1; i < LatencyHistogram::kBuckets; i++) {
+    uint64_t lower = LatencyHistogram::get_upper_bound(i - 1) + 1;
+    uint64_t upper = LatencyHistogram::get_upper_bound(i);
+    REQUIRE(i == LatencyHistogram::get_bucket(lower));
+    REQUIRE(i == LatencyHistogram::get_bucket(upper));
+    bool precise = (upper - lower) * LatencyHistogram::kSubBuckets <= lower;
+    REQUIRE(precise);
+  }
+  int last = LatencyHistogram::kBuckets - 1;
+  REQUIRE(last == LatencyHistogram::get_bucket(0xffffffffffffull));
+
+  latency_metrics_t metrics;
+  LatencyHistogram histogram;
+  histogram.fill_metrics(&metrics);
+  REQUIRE(0u == metrics.count);
+  REQUIRE(0u == metrics.max_usec);
+
+  // 990 fast operations, 9 slow ones and one very slow one
+  for (int i = 0; i < 990; i++)
+    histogram.record(10);
+  for (int i = 0; i < 9; i++)
+    histogram.record(1000);
+  histogram.record(100000);
+  histogram.fill_metrics(&metrics);
+  REQUIRE(1000u == metrics.count);
+  uint64_t total = 990 * 10 + 9 * 1000 + 100000;
+  REQUIRE(total == metrics.total_usec);
+  REQUIRE(10u == metrics.p50_usec);
+  REQUIRE(10u == metrics.p99_usec);
+  bool p999 = metrics.p999_usec >= 1000 && metrics.p999_usec < 1125;
+  REQUIRE(p999);
+  bool max = metrics.max_usec >= 100000 && metrics.max_usec < 112500;
+  REQUIRE(max);
+}
+
 } // namespace hamsterdb
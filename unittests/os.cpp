@@ -119,6 +119,33 @@ TEST_CASE("OsTest/readWriteTest",
   }
 }
 
+TEST_CASE("OsTest/pwritevTest",
+           "Tests the operating system functions in os*")
+{
+  File f;
+  char buffer[3][128], orig[128];
+  IoRequest requests[3];
+
+  f.create(Utils::opath(".test"), 0664);
+  for (int i = 0; i < 3; i++) {
+    memset(buffer[i], i + 1, sizeof(buffer[i]));
+    requests[i].address = 0;
+    requests[i].buffer = buffer[i];
+    requests[i].size = sizeof(buffer[i]) - i;
+  }
+  f.pwritev(64, &requests[0], 3);
+
+  size_t offset = 64;
+  for (int i = 0; i < 3; i++) {
+    memset(orig, i + 1, sizeof(orig));
+    memset(buffer[0], 0, sizeof(buffer[0]));
+    f.pread(offset, buffer[0], requests[i].size);
+    REQUIRE(0 == memcmp(buffer[0], orig, requests[i].size));
+    offset += requests[i].size;
+  }
+  REQUIRE(offset == f.get_file_size());
+}
+
 TEST_CASE("OsTest/mmapTest",
            "Tests the operating system functions in os*")
 {
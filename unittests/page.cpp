@@ -19,9 +19,13 @@
 #include "utils.h"
 #include "os.hpp"
 
+#include "1base/crc32c.h"
+#include "1os/file.h"
 #include "2page/page.h"
 #include "2device/device.h"
-#include "4db/db.h"
+#include "3btree/btree_index.h"
+#include "3page_manager/page_manager.h"
+#include "4db/db_local.h"
 #include "4env/env_local.h"
 #include "4txn/txn.h"
 
@@ -175,3 +179,193 @@ TEST_CASE("Page-inmem/multipleAllocFree", "")
   f.multipleAllocFreeTest();
 }
 
+
+struct PageChecksumFixture {
+  ham_db_t *m_db;
+  ham_env_t *m_env;
+  uint32_t m_flags;
+  uint64_t m_root_address;
+
+  PageChecksumFixture(uint32_t flags = 0)
+    : m_db(0), m_env(0), m_flags(flags), m_root_address(0) {
+    REQUIRE(0 ==
+        ham_env_create(&m_env, Utils::opath(".test"),
+            m_flags | HAM_ENABLE_CRC32, 0644, 0));
+    REQUIRE(0 ==
+        ham_env_create_db(m_env, &m_db, 1, 0, 0));
+
+    for (int i = 0; i < 10; i++) {
+      ham_key_t key = ham_make_key(&i, sizeof(i));
+      ham_record_t rec = {0};
+      REQUIRE(0 == ham_db_insert(m_db, 0, &key, &rec, 0));
+    }
+
+    m_root_address = ((LocalDatabase *)m_db)->btree_index()->root_address();
+    REQUIRE(0 == ham_env_close(m_env, HAM_AUTO_CLEANUP));
+    m_env = 0;
+  }
+
+  ~PageChecksumFixture() {
+    if (m_env)
+      REQUIRE(0 == ham_env_close(m_env, HAM_AUTO_CLEANUP));
+  }
+
+  void reopen(uint32_t flags = 0) {
+    REQUIRE(0 ==
+        ham_env_open(&m_env, Utils::opath(".test"), m_flags | flags, 0));
+    REQUIRE(0 ==
+        ham_env_open_db(m_env, &m_db, 1, 0, 0));
+  }
+
+  ham_status_t find(int i) {
+    ham_key_t key = ham_make_key(&i, sizeof(i));
+    ham_record_t rec = {0};
+    return (ham_db_find(m_db, 0, &key, &rec, 0));
+  }
+
+  void corrupt(uint64_t address) {
+    File f;
+    uint8_t byte;
+    f.open(Utils::opath(".test"), false);
+    f.pread(address, &byte, 1);
+    byte ^= 0x01;
+    f.pwrite(address, &byte, 1);
+    f.close();
+  }
+
+  void crc32cTest() {
+    const char *s = "123456789";
+    REQUIRE(0xe3069283u == crc32c(0, s, 9));
+    uint32_t crc = crc32c(0, s, 4);
+    REQUIRE(0xe3069283u == crc32c(crc, s + 4, 5));
+    REQUIRE(0u == crc32c(0, s, 0));
+  }
+
+  void verifyTest() {
+    // the checksum setting is persistent
+    reopen();
+
+    ham_parameter_t params[] = {
+        {HAM_PARAM_FLAGS, 0},
+        {0, 0}
+    };
+    REQUIRE(0 == ham_env_get_parameters(m_env, &params[0]));
+    REQUIRE((params[0].value & HAM_ENABLE_CRC32) != 0);
+
+    for (int i = 0; i < 10; i++)
+      REQUIRE(0 == find(i));
+
+    ham_env_metrics_t metrics;
+    REQUIRE(0 == ham_env_get_metrics(m_env, &metrics));
+    REQUIRE(metrics.page_checksums_computed > 0);
+    REQUIRE(metrics.page_checksums_verified > 0);
+    REQUIRE(metrics.page_checksum_failures == 0);
+  }
+
+  void corruptedPageTest() {
+    corrupt(m_root_address + 100);
+    reopen();
+
+    REQUIRE(HAM_INTEGRITY_VIOLATED == find(0));
+
+    ham_env_metrics_t metrics;
+    REQUIRE(0 == ham_env_get_metrics(m_env, &metrics));
+    REQUIRE(metrics.page_checksum_failures == 1);
+  }
+
+  void corruptedHeaderTest() {
+    corrupt(100);
+    REQUIRE(HAM_INTEGRITY_VIOLATED ==
+        ham_env_open(&m_env, Utils::opath(".test"), m_flags, 0));
+    m_env = 0;
+  }
+
+  void skipMappedPagesTest() {
+    reopen();
+    REQUIRE(0 == find(0));
+
+    ham_env_metrics_t metrics0;
+    REQUIRE(0 == ham_env_get_metrics(m_env, &metrics0));
+
+    // purge the cache; the mapped root page is fetched again, but not
+    // verified again
+    ((LocalEnvironment *)m_env)->page_manager()->flush(true);
+    REQUIRE(0 == find(0));
+
+    ham_env_metrics_t metrics1;
+    REQUIRE(0 == ham_env_get_metrics(m_env, &metrics1));
+    REQUIRE(metrics1.page_checksums_verified
+                == metrics0.page_checksums_verified);
+    REQUIRE(metrics1.page_checksums_skipped
+                > metrics0.page_checksums_skipped);
+  }
+};
+
+TEST_CASE("Page-checksum/crc32c", "")
+{
+  PageChecksumFixture f;
+  f.crc32cTest();
+}
+
+TEST_CASE("Page-checksum/verify", "")
+{
+  PageChecksumFixture f;
+  f.verifyTest();
+}
+
+TEST_CASE("Page-checksum/corruptedPage", "")
+{
+  PageChecksumFixture f;
+  f.corruptedPageTest();
+}
+
+TEST_CASE("Page-checksum/corruptedHeader", "")
+{
+  PageChecksumFixture f;
+  f.corruptedHeaderTest();
+}
+
+TEST_CASE("Page-checksum/skipMappedPages", "")
+{
+  PageChecksumFixture f;
+  f.skipMappedPagesTest();
+}
+
+TEST_CASE("Page-checksum-nommap/verify", "")
+{
+  PageChecksumFixture f(HAM_DISABLE_MMAP);
+  f.verifyTest();
+}
+
+TEST_CASE("Page-checksum-nommap/corruptedPage", "")
+{
+  PageChecksumFixture f(HAM_DISABLE_MMAP);
+  f.corruptedPageTest();
+}
+
+TEST_CASE("Page-checksum/withoutChecksums", "")
+{
+  ham_env_t *env;
+  ham_db_t *db;
+  int i = 1;
+  ham_key_t key = ham_make_key(&i, sizeof(i));
+  ham_record_t rec = {0};
+
+  REQUIRE(0 == ham_env_create(&env, Utils::opath(".test"), 0, 0644, 0));
+  REQUIRE(0 == ham_env_create_db(env, &db, 1, 0, 0));
+  REQUIRE(0 == ham_db_insert(db, 0, &key, &rec, 0));
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+
+  // the flag is ignored if the file was created without checksums
+  REQUIRE(0 == ham_env_open(&env, Utils::opath(".test"),
+                          HAM_ENABLE_CRC32, 0));
+  ham_parameter_t params[] = {
+      {HAM_PARAM_FLAGS, 0},
+      {0, 0}
+  };
+  REQUIRE(0 == ham_env_get_parameters(env, &params[0]));
+  REQUIRE((params[0].value & HAM_ENABLE_CRC32) == 0);
+  REQUIRE(0 == ham_env_open_db(env, &db, 1, 0, 0));
+  REQUIRE(0 == ham_db_find(db, 0, &key, &rec, 0));
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+}
@@ -16,11 +16,19 @@
 
 #include "3rdparty/catch/catch.hpp"
 
+#include <vector>
+#include <utility>
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/thread.hpp>
+
 #include "utils.h"
 
 #include "1base/pickle.h"
 #include "2page/page.h"
+#include "2page/page_collection.h"
 #include "2device/device.h"
+#include "3cache/page_table.h"
 #include "3page_manager/page_manager.h"
 #include "3page_manager/page_manager_test.h"
 #include "4context/context.h"
@@ -37,17 +45,25 @@ struct PageManagerFixture {
   Device *m_device;
   ScopedPtr<Context> m_context;
 
-  PageManagerFixture(bool inmemorydb = false, uint32_t cachesize = 0)
+  PageManagerFixture(bool inmemorydb = false, uint32_t cachesize = 0,
+                  int cache_policy = HAM_CACHE_POLICY_LRU)
       : m_db(0), m_inmemory(inmemorydb), m_device(0) {
     uint32_t flags = 0;
 
     if (m_inmemory)
       flags |= HAM_IN_MEMORY;
 
-    ham_parameter_t params[2] = {{0, 0}, {0, 0}};
+    ham_parameter_t params[3] = {{0, 0}, {0, 0}, {0, 0}};
+    int p = 0;
     if (cachesize) {
-      params[0].name = HAM_PARAM_CACHE_SIZE;
-      params[0].value = cachesize;
+      params[p].name = HAM_PARAM_CACHE_SIZE;
+      params[p].value = cachesize;
+      p++;
+    }
+    if (cache_policy != HAM_CACHE_POLICY_LRU) {
+      params[p].name = HAM_PARAM_CACHE_POLICY;
+      params[p].value = cache_policy;
+      p++;
     }
 
     REQUIRE(0 ==
@@ -252,6 +268,166 @@ struct PageManagerFixture {
     REQUIRE(false == test.is_cache_full());
   }
 
+  struct IgnoreDirtyPages {
+    bool operator()(Page *page) {
+      return (false);
+    }
+  };
+
+  void cache2QTest() {
+    LocalEnvironment *lenv = (LocalEnvironment *)m_env;
+    PageManagerTest test = lenv->page_manager()->test();
+    Cache *cache = &test.state()->cache;
+    uint32_t page_size = lenv->config().page_size_bytes;
+    REQUIRE(cache->policy() == HAM_CACHE_POLICY_2Q);
+
+    // start with an empty cache
+    lenv->page_manager()->flush(true);
+    REQUIRE(0u == cache->current_elements());
+
+    ham_env_metrics_t metrics0;
+    REQUIRE(0 == ham_env_get_metrics(m_env, &metrics0));
+
+    // the cache has room for 16 pages; store 20 pages (the addresses are
+    // beyond the end of the file)
+    for (unsigned int i = 0; i < 20; i++) {
+      Page *p = new Page(lenv->device());
+      p->set_without_header(true);
+      p->assign_allocated_buffer(Memory::allocate<PPageData>(page_size),
+                      (i + 1000) * page_size);
+      test.store_page(p);
+    }
+    REQUIRE(0u == cache->hot_elements());
+
+    // access the first four pages again; they're moved to the hot queue
+    for (unsigned int i = 0; i < 4; i++)
+      REQUIRE(test.fetch_page((i + 1000) * page_size) != 0);
+    REQUIRE(4u == cache->hot_elements());
+
+    // purging the cache removes the oldest pages of the cold queue
+    IgnoreDirtyPages processor;
+    cache->purge(processor, 0);
+    REQUIRE(16u == cache->current_elements());
+    for (unsigned int i = 0; i < 4; i++)
+      REQUIRE(test.fetch_page((i + 1000) * page_size) != 0);
+    for (unsigned int i = 4; i < 8; i++)
+      REQUIRE((Page *)0 == test.fetch_page((i + 1000) * page_size));
+
+    ham_env_metrics_t metrics;
+    REQUIRE(0 == ham_env_get_metrics(m_env, &metrics));
+    REQUIRE(metrics.cache_policy == (uint32_t)HAM_CACHE_POLICY_2Q);
+    REQUIRE(metrics.cache_promotions == metrics0.cache_promotions + 4);
+    REQUIRE(metrics.cache_hits_cold == metrics0.cache_hits_cold + 4);
+    REQUIRE(metrics.cache_hits_hot == metrics0.cache_hits_hot + 4);
+
+    for (unsigned int i = 0; i < 20; i++) {
+      Page *p = test.fetch_page((i + 1000) * page_size);
+      if (p) {
+        test.remove_page(p);
+        delete p;
+      }
+    }
+  }
+
+  void pageTableTest() {
+    LocalEnvironment *lenv = (LocalEnvironment *)m_env;
+    PageTable table;
+    std::vector<Page *> pages;
+
+    // store enough pages to resize the shards a few times
+    for (unsigned int i = 0; i < 10000; i++) {
+      Page *p = new Page(lenv->device());
+      p->set_address((i + 1) * 1024);
+      pages.push_back(p);
+      table.put(p);
+    }
+    REQUIRE(10000u == table.size());
+
+    for (unsigned int i = 0; i < 10000; i++)
+      REQUIRE(pages[i] == table.get((i + 1) * 1024));
+    REQUIRE((Page *)0 == table.get(0));
+    REQUIRE((Page *)0 == table.get(10001 * 1024));
+
+    // remove every second page
+    for (unsigned int i = 0; i < 10000; i += 2)
+      REQUIRE(true == table.del((i + 1) * 1024));
+    REQUIRE(false == table.del(1024));
+    REQUIRE(5000u == table.size());
+
+    for (unsigned int i = 0; i < 10000; i++) {
+      if (i & 1)
+        REQUIRE(pages[i] == table.get((i + 1) * 1024));
+      else
+        REQUIRE((Page *)0 == table.get((i + 1) * 1024));
+    }
+
+    // storing the same page twice does not create a second entry
+    table.put(pages[1]);
+    REQUIRE(5000u == table.size());
+
+    table.release_retired();
+    for (unsigned int i = 0; i < 10000; i++)
+      delete pages[i];
+  }
+
+  // Compares the lookup latency of the PageTable with the linked bucket
+  // lists which were used by the Cache before
+  void pageTableBenchmark() {
+    LocalEnvironment *lenv = (LocalEnvironment *)m_env;
+    const unsigned int kPages = 1024 * 1024;
+    const unsigned int kLookups = 4 * 1024 * 1024;
+    const unsigned int kBuckets = 10317;
+    uint32_t page_size = lenv->config().page_size_bytes;
+
+    std::vector<Page *> pages;
+    PageTable table;
+    std::vector<PageCollection> buckets(kBuckets,
+                    PageCollection(Page::kListChangeset));
+    for (unsigned int i = 0; i < kPages; i++) {
+      Page *p = new Page(lenv->device());
+      p->set_address((uint64_t)(i + 1) * page_size);
+      pages.push_back(p);
+      table.put(p);
+      buckets[p->get_address() % kBuckets].put(p);
+    }
+
+    // the same pseudo-random sequence of addresses is used for both tests
+    std::vector<uint64_t> addresses(kLookups);
+    uint32_t seed = 1;
+    for (unsigned int i = 0; i < kLookups; i++) {
+      seed = seed * 1103515245 + 12345;
+      addresses[i] = (uint64_t)((seed >> 8) % kPages + 1) * page_size;
+    }
+
+    using namespace boost::posix_time;
+    size_t found = 0;
+    ptime start = microsec_clock::universal_time();
+    for (unsigned int i = 0; i < kLookups; i++)
+      found += table.get(addresses[i]) != 0;
+    time_duration table_time = microsec_clock::universal_time() - start;
+    REQUIRE(found == kLookups);
+
+    // the buckets can only handle a fraction of the lookups in reasonable
+    // time; the result is extrapolated
+    const unsigned int kBucketLookups = kLookups / 64;
+    found = 0;
+    start = microsec_clock::universal_time();
+    for (unsigned int i = 0; i < kBucketLookups; i++)
+      found += buckets[addresses[i] % kBuckets].get(addresses[i]) != 0;
+    time_duration bucket_time = microsec_clock::universal_time() - start;
+    REQUIRE(found == kBucketLookups);
+
+    printf("%u cached pages; avg. lookup latency: page table %.1f ns, "
+           "bucket lists %.1f ns\n", kPages,
+           table_time.total_microseconds() * 1000.0 / kLookups,
+           bucket_time.total_microseconds() * 1000.0 / kBucketLookups);
+
+    for (unsigned int i = 0; i < kBuckets; i++)
+      buckets[i].clear();
+    for (unsigned int i = 0; i < kPages; i++)
+      delete pages[i];
+  }
+
   void storeStateTest() {
     LocalEnvironment *lenv = (LocalEnvironment *)m_env;
     PageManagerTest test = lenv->page_manager()->test();
@@ -478,6 +654,25 @@ TEST_CASE("PageManager/cacheFullTest", "")
   f.cacheFullTest();
 }
 
+TEST_CASE("PageManager/cache2QTest", "")
+{
+  PageManagerFixture f(false, 16 * HAM_DEFAULT_PAGE_SIZE, HAM_CACHE_POLICY_2Q);
+  f.cache2QTest();
+}
+
+TEST_CASE("PageManager/pageTableTest", "")
+{
+  PageManagerFixture f;
+  f.pageTableTest();
+}
+
+// hidden test; run with ./test -t "./PageManager/pageTableBenchmark"
+TEST_CASE("./PageManager/pageTableBenchmark", "")
+{
+  PageManagerFixture f;
+  f.pageTableBenchmark();
+}
+
 TEST_CASE("PageManager/storeStateTest", "")
 {
   PageManagerFixture f(false, 16 * HAM_DEFAULT_PAGE_SIZE);
@@ -514,6 +709,285 @@ TEST_CASE("PageManager/allocMultiBlobs", "")
   f.allocMultiBlobs();
 }
 
+TEST_CASE("PageManager/readAheadTest", "")
+{
+  ham_env_t *env;
+  ham_db_t *db;
+  ham_cursor_t *cursor;
+  ham_key_t key = {0};
+  ham_record_t rec = {0};
+  ham_parameter_t env_params[] = {
+    {HAM_PARAM_PAGE_SIZE, 1024},
+    {0, 0}
+  };
+  ham_parameter_t db_params[] = {
+    {HAM_PARAM_KEY_TYPE, HAM_TYPE_UINT32},
+    {0, 0}
+  };
+
+  REQUIRE(0 == ham_env_create(&env, Utils::opath(".test"), 0, 0644,
+                          &env_params[0]));
+  REQUIRE(0 == ham_env_create_db(env, &db, 1, 0, &db_params[0]));
+  for (uint32_t i = 0; i < 20000; i++) {
+    key.data = &i;
+    key.size = sizeof(i);
+    REQUIRE(0 == ham_db_insert(db, 0, &key, &rec, 0));
+  }
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+
+  // reopen the file with read-ahead, then scan all keys
+  ham_parameter_t open_params[] = {
+    {HAM_PARAM_READAHEAD_PAGES, 8},
+    {0, 0}
+  };
+  REQUIRE(0 == ham_env_open(&env, Utils::opath(".test"), 0, &open_params[0]));
+  REQUIRE(0 == ham_env_get_parameters(env, &open_params[0]));
+  REQUIRE(8u == open_params[0].value);
+  REQUIRE(0 == ham_env_open_db(env, &db, 1, 0, 0));
+  REQUIRE(0 == ham_cursor_create(&cursor, db, 0, 0));
+  uint32_t count = 0;
+  while (0 == ham_cursor_move(cursor, &key, &rec, HAM_CURSOR_NEXT)) {
+    REQUIRE(count == *(uint32_t *)key.data);
+    count++;
+  }
+  REQUIRE(20000u == count);
+  REQUIRE(0 == ham_cursor_close(cursor));
+
+  // the pages are read asynchronously; wait till the worker thread
+  // picked up the requests
+  ham_env_metrics_t metrics;
+  for (int i = 0; i < 100; i++) {
+    REQUIRE(0 == ham_env_get_metrics(env, &metrics));
+    if (metrics.readahead_issued > 0)
+      break;
+    boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+  }
+  REQUIRE(metrics.readahead_issued > 0);
+  uint64_t used = metrics.readahead_hits + metrics.readahead_wasted;
+  REQUIRE(used <= metrics.readahead_issued);
+
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+}
+
+TEST_CASE("PageManager/flushWorkersTest", "")
+{
+  ham_env_t *env;
+  ham_db_t *db;
+  ham_key_t key = {0};
+  ham_record_t rec = {0};
+  char buffer[256] = {0};
+  ham_parameter_t env_params[] = {
+    {HAM_PARAM_CACHE_SIZE, 256 * 1024},
+    {HAM_PARAM_FLUSH_WORKERS, 4},
+    {HAM_PARAM_FLUSH_STALL_PERCENT, 10},
+    {0, 0}
+  };
+  ham_parameter_t db_params[] = {
+    {HAM_PARAM_KEY_TYPE, HAM_TYPE_UINT32},
+    {0, 0}
+  };
+
+  // invalid parameters
+  ham_parameter_t bad_params[] = {
+    {HAM_PARAM_FLUSH_WORKERS, 0},
+    {0, 0}
+  };
+  REQUIRE(HAM_INV_PARAMETER == ham_env_create(&env, Utils::opath(".test"),
+                          0, 0644, &bad_params[0]));
+  bad_params[0].value = HAM_MAX_FLUSH_WORKERS + 1;
+  REQUIRE(HAM_INV_PARAMETER == ham_env_create(&env, Utils::opath(".test"),
+                          0, 0644, &bad_params[0]));
+  bad_params[0].name = HAM_PARAM_FLUSH_STALL_PERCENT;
+  bad_params[0].value = 101;
+  REQUIRE(HAM_INV_PARAMETER == ham_env_create(&env, Utils::opath(".test"),
+                          0, 0644, &bad_params[0]));
+
+  REQUIRE(0 == ham_env_create(&env, Utils::opath(".test"), 0, 0644,
+                          &env_params[0]));
+  REQUIRE(0 == ham_env_get_parameters(env, &env_params[0]));
+  REQUIRE(4u == env_params[1].value);
+  REQUIRE(10u == env_params[2].value);
+  REQUIRE(0 == ham_env_create_db(env, &db, 1, 0, &db_params[0]));
+
+  // the records span more than 4 MB, therefore all flush threads
+  // are busy
+  rec.data = &buffer[0];
+  rec.size = sizeof(buffer);
+  for (uint32_t i = 0; i < 20000; i++) {
+    key.data = &i;
+    key.size = sizeof(i);
+    *(uint32_t *)&buffer[0] = i;
+    REQUIRE(0 == ham_db_insert(db, 0, &key, &rec, 0));
+  }
+
+  ham_env_metrics_t metrics;
+  REQUIRE(0 == ham_env_get_metrics(env, &metrics));
+  int busy = 0;
+  for (int i = 0; i < 4; i++) {
+    if (metrics.flush_worker_pages[i] > 0)
+      busy++;
+  }
+  REQUIRE(busy > 1);
+  for (int i = 4; i < HAM_MAX_FLUSH_WORKERS; i++)
+    REQUIRE(0u == metrics.flush_worker_pages[i]);
+  bool stalls_ok = metrics.flush_stalls > 0 || metrics.flush_stall_usec == 0;
+  REQUIRE(stalls_ok);
+
+  for (uint32_t i = 0; i < 20000; i++) {
+    key.data = &i;
+    key.size = sizeof(i);
+    REQUIRE(0 == ham_db_find(db, 0, &key, &rec, 0));
+    REQUIRE(sizeof(buffer) == rec.size);
+    REQUIRE(i == *(uint32_t *)rec.data);
+  }
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+
+  REQUIRE(0 == ham_env_open(&env, Utils::opath(".test"), 0, 0));
+  REQUIRE(0 == ham_env_open_db(env, &db, 1, 0, 0));
+  for (uint32_t i = 0; i < 20000; i += 97) {
+    key.data = &i;
+    key.size = sizeof(i);
+    REQUIRE(0 == ham_db_find(db, 0, &key, &rec, 0));
+    REQUIRE(i == *(uint32_t *)rec.data);
+  }
+  REQUIRE(0 == ham_db_check_integrity(db, 0));
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+}
+
+TEST_CASE("PageManager/checkpointTest", "")
+{
+  ham_env_t *env;
+  ham_db_t *db;
+  ham_key_t key = {0};
+  ham_record_t rec = {0};
+  char buffer[256] = {0};
+  ham_parameter_t env_params[] = {
+    {HAM_PARAM_CHECKPOINT_DIRTY_PERCENT, 10},
+    {HAM_PARAM_CHECKPOINT_AGE_LIMIT, 20},
+    {0, 0}
+  };
+
+  // invalid parameters
+  ham_parameter_t bad_params[] = {
+    {HAM_PARAM_CHECKPOINT_DIRTY_PERCENT, 101},
+    {0, 0}
+  };
+  REQUIRE(HAM_INV_PARAMETER == ham_env_create(&env, Utils::opath(".test"),
+                          0, 0644, &bad_params[0]));
+  bad_params[0].name = HAM_PARAM_CHECKPOINT_AGE_LIMIT;
+  bad_params[0].value = 3600 * 1000 + 1;
+  REQUIRE(HAM_INV_PARAMETER == ham_env_create(&env, Utils::opath(".test"),
+                          0, 0644, &bad_params[0]));
+
+  REQUIRE(0 == ham_env_create(&env, Utils::opath(".test"), 0, 0644,
+                          &env_params[0]));
+  REQUIRE(0 == ham_env_get_parameters(env, &env_params[0]));
+  REQUIRE(10u == env_params[0].value);
+  REQUIRE(20u == env_params[1].value);
+  REQUIRE(0 == ham_env_create_db(env, &db, 1, 0, 0));
+
+  rec.data = &buffer[0];
+  rec.size = sizeof(buffer);
+  for (uint32_t i = 0; i < 1000; i++) {
+    key.data = &i;
+    key.size = sizeof(i);
+    REQUIRE(0 == ham_db_insert(db, 0, &key, &rec, 0));
+  }
+
+  // the cache is not full, but the checkpointer writes the dirty pages
+  // in the background
+  ham_env_metrics_t metrics;
+  for (int i = 0; i < 500; i++) {
+    REQUIRE(0 == ham_env_get_metrics(env, &metrics));
+    if (metrics.checkpoint_pages > 0)
+      break;
+    boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+  }
+  REQUIRE(metrics.checkpoint_count > 0);
+  REQUIRE(metrics.checkpoint_pages > 0);
+
+  for (uint32_t i = 0; i < 1000; i++) {
+    key.data = &i;
+    key.size = sizeof(i);
+    REQUIRE(0 == ham_db_find(db, 0, &key, &rec, 0));
+    REQUIRE(sizeof(buffer) == rec.size);
+  }
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+
+  REQUIRE(0 == ham_env_open(&env, Utils::opath(".test"), 0, 0));
+  REQUIRE(0 == ham_env_open_db(env, &db, 1, 0, 0));
+  REQUIRE(0 == ham_db_check_integrity(db, 0));
+  REQUIRE(0 == ham_env_close(env, HAM_AUTO_CLEANUP));
+}
+
+// A Worker which records the payload of its messages
+struct RecordingWorker : public Worker
+{
+  typedef Queue::Message<std::pair<int, int> > TestMessage;
+
+  virtual void handle_message(MessageBase *message) {
+    received.push_back(((TestMessage *)message)->payload);
+  }
+
+  std::vector<std::pair<int, int> > received;
+};
+
+// Pushes |count| messages of |producer| to |worker|
+static void
+produce_messages(Worker *worker, int producer, int count)
+{
+  for (int i = 0; i < count; i++) {
+    RecordingWorker::TestMessage *message
+            = new RecordingWorker::TestMessage(1, 0);
+    message->payload = std::make_pair(producer, i);
+    worker->add_to_queue(message);
+    if (i % 1000 == 0)
+      boost::this_thread::yield();
+  }
+}
+
+TEST_CASE("PageManager/workerQueueTest", "")
+{
+  const int kProducers = 4;
+  const int kMessages = 20000;
+  RecordingWorker worker;
+
+  boost::thread_group threads;
+  for (int i = 0; i < kProducers; i++)
+    threads.create_thread(boost::bind(&produce_messages, &worker, i,
+                            kMessages));
+  threads.join_all();
+  worker.stop_and_join();
+
+  // all messages were received, and the messages of each producer are
+  // in order
+  REQUIRE((size_t)(kProducers * kMessages) == worker.received.size());
+  std::vector<int> next(kProducers, 0);
+  for (size_t i = 0; i < worker.received.size(); i++) {
+    std::pair<int, int> &p = worker.received[i];
+    REQUIRE(next[p.first] == p.second);
+    next[p.first]++;
+  }
+}
+
+TEST_CASE("PageManager/flushMessagePoolTest", "")
+{
+  PageManagerWorker worker(0);
+
+  FlushPageMessage *message = worker.allocate_flush_message(0);
+  worker.add_to_queue(message);
+  worker.stop_and_join();
+
+  // the processed message is recycled
+  REQUIRE(message == worker.allocate_flush_message(0));
+  REQUIRE(message->list.empty());
+  FlushPageMessage *other = worker.allocate_flush_message(0);
+  REQUIRE(message != other);
+
+  worker.release_flush_message(message);
+  worker.release_flush_message(other);
+}
+
 TEST_CASE("PageManager-inmem/allocPage", "")
 {
   PageManagerFixture f(true);
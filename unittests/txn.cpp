@@ -16,12 +16,16 @@
 
 #include "3rdparty/catch/catch.hpp"
 
+#include <vector>
+
 #include "utils.h"
 #include "os.hpp"
 
 #include <ham/hamsterdb.h>
 
 #include "1base/error.h"
+#include "1mem/arena.h"
+#include "1mem/memory_pool.h"
 #include "1os/os.h"
 #include "2page/page.h"
 #include "4txn/txn.h"
@@ -153,21 +157,21 @@ struct TxnFixture {
     ham_key_t key2 = ham_make_key((void *)"world", 5);
 
     REQUIRE(0 == ham_txn_begin(&txn, m_env, 0, 0, 0));
-    node1 = new TransactionNode(m_dbp, &key1);
+    node1 = m_dbp->txn_index()->create_node(&key1);
     m_dbp->txn_index()->store(node1);
     node2 = m_dbp->txn_index()->get(&key1, 0);
     REQUIRE(node1 == node2);
     node2 = m_dbp->txn_index()->get(&key2, 0);
     REQUIRE((TransactionNode *)NULL == node2);
-    node2 = new TransactionNode(m_dbp, &key2);
+    node2 = m_dbp->txn_index()->create_node(&key2);
     m_dbp->txn_index()->store(node2);
     REQUIRE(node1 != node2);
 
     // clean up
     m_dbp->txn_index()->remove(node1);
-    delete node1;
+    m_dbp->txn_index()->destroy_node(node1);
     m_dbp->txn_index()->remove(node2);
-    delete node2;
+    m_dbp->txn_index()->destroy_node(node2);
 
     REQUIRE(0 == ham_txn_commit(txn, 0));
   }
@@ -186,20 +190,20 @@ struct TxnFixture {
     key3.size = 5;
 
     REQUIRE(0 == ham_txn_begin(&txn, m_env, 0, 0, 0));
-    node1 = new TransactionNode(m_dbp, &key1);
+    node1 = m_dbp->txn_index()->create_node(&key1);
     m_dbp->txn_index()->store(node1);
-    node2 = new TransactionNode(m_dbp, &key2);
+    node2 = m_dbp->txn_index()->create_node(&key2);
     m_dbp->txn_index()->store(node2);
-    node3 = new TransactionNode(m_dbp, &key3);
+    node3 = m_dbp->txn_index()->create_node(&key3);
     m_dbp->txn_index()->store(node3);
 
     // clean up
     m_dbp->txn_index()->remove(node1);
-    delete node1;
+    m_dbp->txn_index()->destroy_node(node1);
     m_dbp->txn_index()->remove(node2);
-    delete node2;
+    m_dbp->txn_index()->destroy_node(node2);
     m_dbp->txn_index()->remove(node3);
-    delete node3;
+    m_dbp->txn_index()->destroy_node(node3);
 
     REQUIRE(0 == ham_txn_commit(txn, 0));
   }
@@ -212,7 +216,7 @@ struct TxnFixture {
     ham_record_t rec = ham_make_record((void *)"world", 5);
 
     REQUIRE(0 == ham_txn_begin(&txn, m_env, 0, 0, 0));
-    node = new TransactionNode(m_dbp, &key);
+    node = m_dbp->txn_index()->create_node(&key);
     m_dbp->txn_index()->store(node);
     op1 = node->append((LocalTransaction *)txn, 
                 0, TransactionOperation::kInsertDuplicate, 55, &key, &rec);
@@ -571,6 +575,100 @@ aber nicht)
           ham_db_erase(m_db, txn2, &key, 0));
     REQUIRE(0 == ham_txn_commit(txn2, 0));
   }
+
+  void memoryPoolTest() {
+    MemoryPool pool(4, 2);
+    REQUIRE(pool.get_block_size() == sizeof(void *));
+
+    void *p1 = pool.allocate();
+    void *p2 = pool.allocate();
+    void *p3 = pool.allocate();
+    pool.release(p1);
+    pool.release(p2);
+    REQUIRE(pool.get_free_count() == 2u);
+    // the free list is full; this block is released to the heap
+    pool.release(p3);
+    REQUIRE(pool.get_free_count() == 2u);
+
+    // released blocks are recycled
+    void *p4 = pool.allocate();
+    REQUIRE(p4 == p2);
+    REQUIRE(pool.get_free_count() == 1u);
+    pool.release(p4);
+  }
+
+  void arenaTest() {
+    MemoryPool pool(256, 2);
+    Arena arena(&pool);
+
+    // small allocations share a chunk and are aligned
+    uint8_t *p1 = (uint8_t *)arena.allocate(3);
+    uint8_t *p2 = (uint8_t *)arena.allocate(10);
+    REQUIRE(p2 == p1 + 8);
+    REQUIRE(((size_t)p2 & 7) == 0u);
+
+    // a large allocation gets its own chunk; the current chunk is
+    // still used afterwards
+    uint8_t *p3 = (uint8_t *)arena.allocate(1000);
+    ::memset(p3, 0, 1000);
+    uint8_t *p4 = (uint8_t *)arena.allocate(8);
+    REQUIRE(p4 == p2 + 16);
+
+    // this does not fit into the current chunk
+    uint8_t *p5 = (uint8_t *)arena.allocate(220);
+    ::memset(p5, 0, 220);
+    REQUIRE(pool.get_free_count() == 0u);
+
+    // the pooled chunks are returned to the pool
+    arena.release();
+    REQUIRE(pool.get_free_count() == 2u);
+
+    // and they are recycled
+    arena.allocate(8);
+    REQUIRE(pool.get_free_count() == 1u);
+  }
+
+  void insertAndFlush(int start, int count, uint32_t record_size) {
+    std::vector<uint8_t> data(record_size, 'x');
+    for (int i = start; i < start + count; i++) {
+      ham_txn_t *txn;
+      ham_key_t key = ham_make_key(&i, sizeof(i));
+      ham_record_t rec = ham_make_record(&data[0], record_size);
+      REQUIRE(0 == ham_txn_begin(&txn, m_env, 0, 0, 0));
+      REQUIRE(0 == ham_db_insert(m_db, txn, &key, &rec, 0));
+      REQUIRE(0 == ham_txn_commit(txn, 0));
+    }
+    REQUIRE(0 == ham_env_flush(m_env, HAM_FLUSH_COMMITTED_TRANSACTIONS));
+  }
+
+  void arenaRecyclingTest() {
+    LocalEnvironment *lenv = (LocalEnvironment *)m_env;
+    MemoryPool *pool = ((LocalTransactionManager *)lenv->txn_manager())
+                            ->get_arena_pool();
+    REQUIRE(pool->get_free_count() == 0u);
+
+    // the chunks of the flushed Transactions are cached...
+    insertAndFlush(0, 200, 16);
+    size_t free_chunks = pool->get_free_count();
+    REQUIRE(free_chunks > 0u);
+    REQUIRE(m_dbp->txn_index()->m_node_pool.get_free_count() > 0u);
+
+    // ... and recycled
+    insertAndFlush(200, 200, 16);
+    REQUIRE(pool->get_free_count() == free_chunks);
+
+    // large records do not fit into a chunk
+    insertAndFlush(400, 10, 3 * pool->get_block_size());
+    REQUIRE(pool->get_free_count() == free_chunks);
+
+    for (int i = 0; i < 410; i++) {
+      ham_key_t key = ham_make_key(&i, sizeof(i));
+      ham_record_t rec = {0};
+      REQUIRE(0 == ham_db_find(m_db, 0, &key, &rec, 0));
+      size_t size = i < 400 ? 16 : 3 * pool->get_block_size();
+      REQUIRE(rec.size == size);
+    }
+  }
 };
 
 TEST_CASE("Txn/checkIfLogCreatedTest", "")
@@ -711,6 +809,24 @@ TEST_CASE("Txn/txnInsertFindErase4Test", "")
   f.txnInsertFindErase4Test();
 }
 
+TEST_CASE("Txn/memoryPoolTest", "")
+{
+  TxnFixture f;
+  f.memoryPoolTest();
+}
+
+TEST_CASE("Txn/arenaTest", "")
+{
+  TxnFixture f;
+  f.arenaTest();
+}
+
+TEST_CASE("Txn/arenaRecyclingTest", "")
+{
+  TxnFixture f;
+  f.arenaRecyclingTest();
+}
+
 
 struct HighLevelTxnFixture {
   ham_db_t *m_db;